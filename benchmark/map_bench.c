@@ -0,0 +1,123 @@
+// Compares the chained hashmap against the flatmap on the same insert, lookup and delete workload,
+// using keys shaped like the texture cache keys, which are looked up for every sprite draw.
+
+#include "utils/flatmap.h"
+#include "utils/hashmap.h"
+#include <SDL.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct bench_key_t {
+    void *surface;
+    char *remap_table;
+    uint16_t w, h;
+    uint8_t pal_offset;
+} bench_key;
+
+#define BENCH_KEY_COUNT 4096
+#define BENCH_REMAP_COUNT 17
+
+static bench_key bench_keys[BENCH_KEY_COUNT];
+static char bench_surfaces[BENCH_KEY_COUNT];
+static char bench_remaps[BENCH_REMAP_COUNT];
+
+static void make_keys(void) {
+    // Keys are compared byte by byte, so the padding has to be zeroed
+    memset(bench_keys, 0, sizeof(bench_keys));
+    for(int i = 0; i < BENCH_KEY_COUNT; i++) {
+        bench_keys[i].surface = &bench_surfaces[i];
+        bench_keys[i].remap_table = (i % 3) ? NULL : &bench_remaps[i % BENCH_REMAP_COUNT];
+        bench_keys[i].w = 16 + i % 64;
+        bench_keys[i].h = 32 + i % 48;
+        bench_keys[i].pal_offset = i % 4;
+    }
+}
+
+static double ms_since(Uint64 start) {
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+int main(int argc, char *argv[]) {
+    int rounds = (argc > 1) ? atoi(argv[1]) : 50;
+    unsigned int found_hm = 0;
+    unsigned int found_fm = 0;
+    unsigned int vlen;
+    double hm_ms[3];
+    double fm_ms[3];
+    Uint64 start;
+    hashmap hm;
+    flatmap fm;
+    int *val;
+
+    if(rounds < 1) {
+        fprintf(stderr, "Usage: %s [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    make_keys();
+    hashmap_create(&hm, 6);
+    hashmap_set_opts(&hm, HASHMAP_AUTO_INC, 0.25, 0.75, 6, 16);
+    flatmap_create(&fm, sizeof(bench_key), sizeof(int));
+
+    start = SDL_GetPerformanceCounter();
+    for(int r = 0; r < rounds; r++) {
+        for(int i = 0; i < BENCH_KEY_COUNT; i++) {
+            hashmap_put(&hm, &bench_keys[i], sizeof(bench_key), &i, sizeof(int));
+        }
+    }
+    hm_ms[0] = ms_since(start);
+    start = SDL_GetPerformanceCounter();
+    for(int r = 0; r < rounds; r++) {
+        for(int i = 0; i < BENCH_KEY_COUNT; i++) {
+            flatmap_put(&fm, &bench_keys[i], &i);
+        }
+    }
+    fm_ms[0] = ms_since(start);
+
+    start = SDL_GetPerformanceCounter();
+    for(int r = 0; r < rounds * 4; r++) {
+        for(int i = 0; i < BENCH_KEY_COUNT; i++) {
+            if(hashmap_get(&hm, &bench_keys[i], sizeof(bench_key), (void **)&val, &vlen) == 0 && *val == i) {
+                found_hm++;
+            }
+        }
+    }
+    hm_ms[1] = ms_since(start);
+    start = SDL_GetPerformanceCounter();
+    for(int r = 0; r < rounds * 4; r++) {
+        for(int i = 0; i < BENCH_KEY_COUNT; i++) {
+            val = flatmap_get(&fm, &bench_keys[i]);
+            if(val != NULL && *val == i) {
+                found_fm++;
+            }
+        }
+    }
+    fm_ms[1] = ms_since(start);
+
+    start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < BENCH_KEY_COUNT; i++) {
+        hashmap_del(&hm, &bench_keys[i], sizeof(bench_key));
+    }
+    hm_ms[2] = ms_since(start);
+    start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < BENCH_KEY_COUNT; i++) {
+        flatmap_del(&fm, &bench_keys[i]);
+    }
+    fm_ms[2] = ms_since(start);
+
+    hashmap_free(&hm);
+    flatmap_free(&fm);
+
+    printf("%d keys:      %10s %10s\n", BENCH_KEY_COUNT, "hashmap", "flatmap");
+    printf("put x%-4d %7.2f ms %7.2f ms\n", rounds, hm_ms[0], fm_ms[0]);
+    printf("get x%-4d %7.2f ms %7.2f ms\n", rounds * 4, hm_ms[1], fm_ms[1]);
+    printf("del       %7.2f ms %7.2f ms\n", hm_ms[2], fm_ms[2]);
+
+    if(found_hm != (unsigned int)rounds * 4 * BENCH_KEY_COUNT || found_fm != found_hm) {
+        fprintf(stderr, "Error: the maps found %u and %u of the keys.\n", found_hm, found_fm);
+        return 1;
+    }
+    return 0;
+}
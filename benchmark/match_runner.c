@@ -0,0 +1,463 @@
+// Runs a round-robin tournament of AI controlled HARs headlessly, and reports the win rates,
+// match lengths and damage figures of every HAR and pilot combination as CSV.
+//
+// Every pairing of the selected HAR/pilot combinations is played once for each selected
+// difficulty, arena and seed, from both sides, so that neither entrant gets the player 1 side
+// more often than the other. The matches are spread over a pool of worker threads. Each worker
+// starts out with its own share of the matches, and takes matches from the other workers once it
+// runs out, so that the workers that happen to get the long matches do not hold up the rest.
+
+#include "engine.h"
+#include "game/common_defines.h"
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/objects/har.h"
+#include "game/utils/settings.h"
+#include "plugins/plugins.h"
+#include "resources/pathmanager.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include <SDL.h>
+#include <argtable2.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HAR_COUNT 11
+#define PILOT_COUNT 10
+#define ARENA_COUNT 5
+#define MAX_THREADS 256
+
+// Matches that have not finished by then are counted as draws
+#define DEFAULT_MAX_TICKS 100000
+
+typedef struct match_job_t {
+    int entrant[2]; ///< Indexes to the entrant table
+    int difficulty;
+    int arena;
+    unsigned int seed;
+} match_job;
+
+typedef struct match_result_t {
+    int failed;
+    int winner; ///< 0 or 1, or -1 for a draw
+    unsigned int ticks;
+    unsigned int damage_taken[2];
+} match_result;
+
+typedef struct entrant_t {
+    int har_id;
+    int pilot_id;
+} entrant;
+
+// Matches of one worker. The worker itself takes matches from the tail, and the other workers
+// steal from the head. Nothing is added once the workers have been started.
+typedef struct work_queue_t {
+    SDL_mutex *lock;
+    int *jobs;
+    unsigned int head;
+    unsigned int tail;
+} work_queue;
+
+typedef struct runner_t {
+    entrant *entrants;
+    match_job *jobs;
+    match_result *results;
+    unsigned int job_count;
+    unsigned int max_ticks;
+    work_queue queues[MAX_THREADS];
+    int thread_count;
+    SDL_atomic_t done;
+} runner;
+
+typedef struct worker_t {
+    runner *run;
+    int id;
+} worker;
+
+static int queue_pop(work_queue *q) {
+    int job = -1;
+    SDL_LockMutex(q->lock);
+    if(q->tail > q->head) {
+        job = q->jobs[--q->tail];
+    }
+    SDL_UnlockMutex(q->lock);
+    return job;
+}
+
+static int queue_steal(work_queue *q) {
+    int job = -1;
+    SDL_LockMutex(q->lock);
+    if(q->tail > q->head) {
+        job = q->jobs[q->head++];
+    }
+    SDL_UnlockMutex(q->lock);
+    return job;
+}
+
+static int next_job(runner *run, int id) {
+    int job = queue_pop(&run->queues[id]);
+    for(int i = 1; job < 0 && i < run->thread_count; i++) {
+        job = queue_steal(&run->queues[(id + i) % run->thread_count]);
+    }
+    return job;
+}
+
+// Adds up the health that the HARs lose. Health goes back up at the start of every round.
+static void track_damage(game_state *gs, int *last_health, match_result *res) {
+    for(int i = 0; i < 2; i++) {
+        object *obj = game_state_get_player(gs, i)->har;
+        if(obj == NULL) {
+            last_health[i] = -1;
+            continue;
+        }
+        har *h = object_get_userdata(obj);
+        if(last_health[i] >= 0 && h->health < last_health[i]) {
+            res->damage_taken[i] += last_health[i] - h->health;
+        }
+        last_health[i] = h->health;
+    }
+}
+
+static void run_match(const runner *run, const match_job *job, match_result *res) {
+    engine_match_setup setup;
+    for(int i = 0; i < 2; i++) {
+        setup.har_id[i] = run->entrants[job->entrant[i]].har_id;
+        setup.pilot_id[i] = run->entrants[job->entrant[i]].pilot_id;
+    }
+    setup.difficulty = job->difficulty;
+    setup.arena = job->arena;
+
+    engine_init_flags init_flags;
+    memset(&init_flags, 0, sizeof(engine_init_flags));
+    init_flags.net_mode = NET_MODE_NONE;
+    init_flags.headless = 1;
+    init_flags.seed = job->seed;
+    init_flags.match = &setup;
+
+    memset(res, 0, sizeof(match_result));
+    res->winner = -1;
+    game_state *gs = omf_calloc(1, sizeof(game_state));
+    if(game_state_create(gs, &init_flags)) {
+        game_state_free(&gs);
+        res->failed = 1;
+        return;
+    }
+
+    // Same virtual clock as the headless engine loop
+    int last_health[2] = {-1, -1};
+    int static_wait = 0;
+    while(game_state_is_running(gs) && res->ticks < run->max_ticks) {
+        game_state_tick_controllers(gs);
+        static_wait += game_state_ms_per_dyntick(gs);
+        while(static_wait > 10) {
+            game_state_static_tick(gs);
+            static_wait -= 10;
+        }
+        game_state_dynamic_tick(gs);
+        track_damage(gs, last_health, res);
+        res->ticks++;
+    }
+    for(int i = 0; i < 2; i++) {
+        if(game_player_get_score(game_state_get_player(gs, i))->wins > 0) {
+            res->winner = i;
+        }
+    }
+    game_state_free(&gs);
+}
+
+static int worker_thread(void *userdata) {
+    worker *w = userdata;
+    runner *run = w->run;
+    int job;
+    while((job = next_job(run, w->id)) >= 0) {
+        run_match(run, &run->jobs[job], &run->results[job]);
+        int done = SDL_AtomicAdd(&run->done, 1) + 1;
+        if(done % 100 == 0 || (unsigned int)done == run->job_count) {
+            fprintf(stderr, "%d/%u matches done\n", done, run->job_count);
+        }
+    }
+    return 0;
+}
+
+static void run_all(runner *run) {
+    // Deal the matches out like cards, so that every worker gets a similar mix to start with
+    for(int t = 0; t < run->thread_count; t++) {
+        work_queue *q = &run->queues[t];
+        q->lock = SDL_CreateMutex();
+        q->jobs = omf_calloc(run->job_count / run->thread_count + 1, sizeof(int));
+        q->head = 0;
+        q->tail = 0;
+    }
+    for(unsigned int i = 0; i < run->job_count; i++) {
+        work_queue *q = &run->queues[i % run->thread_count];
+        q->jobs[q->tail++] = i;
+    }
+
+    SDL_Thread *threads[MAX_THREADS];
+    worker workers[MAX_THREADS];
+    for(int t = 0; t < run->thread_count; t++) {
+        workers[t].run = run;
+        workers[t].id = t;
+        threads[t] = SDL_CreateThread(worker_thread, "match worker", &workers[t]);
+        if(threads[t] == NULL) {
+            fprintf(stderr, "Unable to start a worker thread: %s\n", SDL_GetError());
+        }
+    }
+
+    // A worker that failed to start still has its matches taken by the others. If none of them
+    // started, the matches are run right here.
+    int started = 0;
+    for(int t = 0; t < run->thread_count; t++) {
+        if(threads[t] != NULL) {
+            SDL_WaitThread(threads[t], NULL);
+            started++;
+        }
+    }
+    if(started == 0) {
+        worker_thread(&workers[0]);
+    }
+
+    for(int t = 0; t < run->thread_count; t++) {
+        SDL_DestroyMutex(run->queues[t].lock);
+        omf_free(run->queues[t].jobs);
+    }
+}
+
+typedef struct entrant_stats_t {
+    unsigned int matches;
+    unsigned int wins;
+    unsigned int losses;
+    unsigned int failed;
+    unsigned long long ticks;
+    unsigned long long damage_dealt;
+    unsigned long long damage_taken;
+} entrant_stats;
+
+static void write_csv(FILE *fp, const runner *run, int entrant_count, const int *difficulties, int difficulty_count) {
+    entrant_stats *stats = omf_calloc(entrant_count * NUMBER_OF_AI_DIFFICULTY_TYPES, sizeof(entrant_stats));
+    for(unsigned int i = 0; i < run->job_count; i++) {
+        const match_job *job = &run->jobs[i];
+        const match_result *res = &run->results[i];
+        for(int p = 0; p < 2; p++) {
+            entrant_stats *s = &stats[job->entrant[p] * NUMBER_OF_AI_DIFFICULTY_TYPES + job->difficulty];
+            if(res->failed) {
+                s->failed++;
+                continue;
+            }
+            s->matches++;
+            s->ticks += res->ticks;
+            s->damage_taken += res->damage_taken[p];
+            s->damage_dealt += res->damage_taken[1 - p];
+            if(res->winner == p) {
+                s->wins++;
+            } else if(res->winner == 1 - p) {
+                s->losses++;
+            }
+        }
+    }
+
+    fprintf(fp, "har,pilot,difficulty,matches,wins,losses,draws,failed,win_rate,avg_ticks,avg_damage_dealt,"
+                "avg_damage_taken\n");
+    for(int d = 0; d < difficulty_count; d++) {
+        for(int e = 0; e < entrant_count; e++) {
+            const entrant_stats *s = &stats[e * NUMBER_OF_AI_DIFFICULTY_TYPES + difficulties[d]];
+            double n = (s->matches > 0) ? s->matches : 1;
+            fprintf(fp, "%s,%s,%s,%u,%u,%u,%u,%u,%.4f,%.1f,%.1f,%.1f\n", har_get_name(run->entrants[e].har_id),
+                    pilot_get_name(run->entrants[e].pilot_id), ai_difficulty_get_name(difficulties[d]), s->matches,
+                    s->wins, s->losses, s->matches - s->wins - s->losses, s->failed, s->wins / n, s->ticks / n,
+                    s->damage_dealt / n, s->damage_taken / n);
+        }
+    }
+    omf_free(stats);
+}
+
+// Copies the values given for an option, or all values from 0 to max-1 if none were given.
+// Returns the number of values, or -1 if a value was out of range.
+static int get_values(const struct arg_int *arg, int max, int *values, const char *name) {
+    if(arg->count == 0) {
+        for(int i = 0; i < max; i++) {
+            values[i] = i;
+        }
+        return max;
+    }
+    for(int i = 0; i < arg->count; i++) {
+        if(arg->ival[i] < 0 || arg->ival[i] >= max) {
+            fprintf(stderr, "Invalid %s %d; must be between 0 and %d\n", name, arg->ival[i], max - 1);
+            return -1;
+        }
+        values[i] = arg->ival[i];
+    }
+    return arg->count;
+}
+
+int main(int argc, char *argv[]) {
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_int *hars = arg_intn("H", "har", "<id>", 0, HAR_COUNT, "HAR to include (default: all)");
+    struct arg_int *pilots = arg_intn("p", "pilot", "<id>", 0, PILOT_COUNT, "Pilot to include (default: all)");
+    struct arg_int *diffs =
+        arg_intn("d", "difficulty", "<n>", 0, NUMBER_OF_AI_DIFFICULTY_TYPES, "AI difficulty to play at (default: 4)");
+    struct arg_int *arenas = arg_intn("a", "arena", "<n>", 0, ARENA_COUNT, "Arena to play in (default: all)");
+    struct arg_int *seeds = arg_int0("s", "seeds", "<n>", "Seeds per pairing, arena and difficulty (default: 1)");
+    struct arg_int *seed_base = arg_int0(NULL, "seed-base", "<n>", "Random seed of the first match (default: 1)");
+    struct arg_int *threads = arg_int0("j", "threads", "<n>", "Worker threads (default: number of CPUs)");
+    struct arg_int *max_ticks = arg_int0(NULL, "max-ticks", "<n>", "Ticks before a match is called a draw");
+    struct arg_file *output = arg_file0("o", "output", "<file>", "Write the results here instead of stdout");
+    struct arg_end *end = arg_end(30);
+    void *argtable[] = {help, hars, pilots, diffs, arenas, seeds, seed_base, threads, max_ticks, output, end};
+    const char *progname = "openomf_match_runner";
+    int ret = 1;
+
+    if(arg_nullcheck(argtable) != 0) {
+        fprintf(stderr, "Error: insufficient memory\n");
+        goto exit_0;
+    }
+    int nerrors = arg_parse(argc, argv, argtable);
+    if(help->count > 0) {
+        fprintf(stderr, "Usage: %s", progname);
+        arg_print_syntax(stderr, argtable, "\n");
+        fprintf(stderr, "\nArguments:\n");
+        arg_print_glossary(stderr, argtable, "%-30s %s\n");
+        ret = 0;
+        goto exit_0;
+    }
+    if(nerrors > 0) {
+        arg_print_errors(stderr, end, progname);
+        fprintf(stderr, "Try '%s --help' for more information.\n", progname);
+        goto exit_0;
+    }
+
+    int har_ids[HAR_COUNT];
+    int pilot_ids[PILOT_COUNT];
+    int difficulties[NUMBER_OF_AI_DIFFICULTY_TYPES] = {AI_DIFFICULTY_CHAMPION};
+    int arena_ids[ARENA_COUNT];
+    int har_count = get_values(hars, HAR_COUNT, har_ids, "HAR");
+    int pilot_count = get_values(pilots, PILOT_COUNT, pilot_ids, "pilot");
+    int difficulty_count = 1;
+    if(diffs->count > 0) {
+        difficulty_count = get_values(diffs, NUMBER_OF_AI_DIFFICULTY_TYPES, difficulties, "difficulty");
+    }
+    int arena_count = get_values(arenas, ARENA_COUNT, arena_ids, "arena");
+    int seed_count = (seeds->count > 0) ? seeds->ival[0] : 1;
+    unsigned int first_seed = (seed_base->count > 0) ? seed_base->ival[0] : 1;
+    if(har_count < 0 || pilot_count < 0 || difficulty_count < 0 || arena_count < 0) {
+        goto exit_0;
+    }
+    if(seed_count < 1 || first_seed == 0) {
+        fprintf(stderr, "The number of seeds and the first seed must be at least 1\n");
+        goto exit_0;
+    }
+
+    runner run;
+    memset(&run, 0, sizeof(runner));
+    run.max_ticks = (max_ticks->count > 0) ? max_ticks->ival[0] : DEFAULT_MAX_TICKS;
+    run.thread_count = (threads->count > 0) ? threads->ival[0] : SDL_GetCPUCount();
+    if(run.thread_count < 1 || run.thread_count > MAX_THREADS) {
+        fprintf(stderr, "The number of threads must be between 1 and %d\n", MAX_THREADS);
+        goto exit_0;
+    }
+
+    // Every HAR and pilot combination plays against every other one
+    int entrant_count = har_count * pilot_count;
+    if(entrant_count < 2) {
+        fprintf(stderr, "At least two HAR and pilot combinations are needed for a match\n");
+        goto exit_0;
+    }
+    run.entrants = omf_calloc(entrant_count, sizeof(entrant));
+    for(int h = 0; h < har_count; h++) {
+        for(int p = 0; p < pilot_count; p++) {
+            run.entrants[h * pilot_count + p].har_id = har_ids[h];
+            run.entrants[h * pilot_count + p].pilot_id = pilot_ids[p];
+        }
+    }
+    // Pairings are ordered, since every pairing is played with both entrants as player 1
+    unsigned int pairings = entrant_count * (entrant_count - 1);
+    run.job_count = pairings * difficulty_count * arena_count * seed_count;
+    run.jobs = omf_calloc(run.job_count, sizeof(match_job));
+    run.results = omf_calloc(run.job_count, sizeof(match_result));
+    unsigned int n = 0;
+    for(int a = 0; a < entrant_count; a++) {
+        for(int b = 0; b < entrant_count; b++) {
+            if(a == b) {
+                continue;
+            }
+            for(int d = 0; d < difficulty_count; d++) {
+                for(int r = 0; r < arena_count; r++) {
+                    for(int s = 0; s < seed_count; s++) {
+                        match_job *job = &run.jobs[n++];
+                        job->entrant[0] = a;
+                        job->entrant[1] = b;
+                        job->difficulty = difficulties[d];
+                        job->arena = arena_ids[r];
+                        job->seed = first_seed + s;
+                    }
+                }
+            }
+        }
+    }
+
+    FILE *fp = stdout;
+    if(output->count > 0) {
+        fp = fopen(output->filename[0], "w");
+        if(fp == NULL) {
+            fprintf(stderr, "Unable to open %s for writing\n", output->filename[0]);
+            goto exit_1;
+        }
+    }
+
+    if(pm_init() != 0) {
+        fprintf(stderr, "Error: %s.\n", pm_get_errormsg());
+        goto exit_2;
+    }
+    if(log_init(0)) {
+        goto exit_3;
+    }
+    if(settings_init(pm_get_local_path(CONFIG_PATH))) {
+        goto exit_4;
+    }
+    settings_load();
+    plugins_init();
+    if(SDL_Init(SDL_INIT_TIMER)) {
+        fprintf(stderr, "SDL2 Initialization failed: %s\n", SDL_GetError());
+        goto exit_5;
+    }
+
+    // Everything shared by the game states is set up here, before the workers start
+    engine_init_flags init_flags;
+    memset(&init_flags, 0, sizeof(engine_init_flags));
+    init_flags.headless = 1;
+    if(engine_init(&init_flags)) {
+        goto exit_6;
+    }
+
+    fprintf(stderr, "Running %u matches on %d threads\n", run.job_count, run.thread_count);
+    Uint64 start = SDL_GetPerformanceCounter();
+    run_all(&run);
+    double secs = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+    fprintf(stderr, "Done in %.3f seconds (%.1f matches/sec)\n", secs, (secs > 0) ? run.job_count / secs : 0);
+
+    write_csv(fp, &run, entrant_count, difficulties, difficulty_count);
+    ret = 0;
+
+    engine_close();
+exit_6:
+    SDL_Quit();
+exit_5:
+    plugins_close();
+    settings_free();
+exit_4:
+    log_close();
+exit_3:
+    pm_free();
+exit_2:
+    if(fp != stdout) {
+        fclose(fp);
+    }
+exit_1:
+    omf_free(run.entrants);
+    omf_free(run.jobs);
+    omf_free(run.results);
+exit_0:
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return ret;
+}
@@ -0,0 +1,214 @@
+// Replays every REC file in a directory headlessly, and reports the simulation speed
+// along with per-phase timings and a hash of the final game state. A change in the
+// hash means that the simulation no longer replays the recordings identically.
+
+#include "engine.h"
+#include "formats/error.h"
+#include "formats/rec.h"
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/utils/phase_timings.h"
+#include "game/utils/serial.h"
+#include "game/utils/settings.h"
+#include "plugins/plugins.h"
+#include "resources/pathmanager.h"
+#include "utils/allocator.h"
+#include "utils/list.h"
+#include "utils/log.h"
+#include "utils/scandir.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifndef BENCH_RECS_DIR
+#define BENCH_RECS_DIR "testing/recs"
+#endif
+
+// All replays start from the same seed so that the results are comparable
+#define BENCH_RAND_SEED 1
+
+typedef struct {
+    unsigned int ticks;
+    double secs;
+    uint32_t hash;
+    phase_timings timings;
+} bench_result;
+
+static uint32_t fnv1a_hash(const char *data, size_t len) {
+    uint32_t hash = 2166136261U;
+    for(size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+static uint32_t hash_game_state(game_state *gs) {
+    // Game state can only be serialized if both HARs are still around
+    for(int i = 0; i < game_state_num_players(gs); i++) {
+        if(game_state_get_player(gs, i)->har == NULL) {
+            return 0;
+        }
+    }
+    serial ser;
+    serial_create(&ser);
+    game_state_serialize(gs, &ser);
+    uint32_t hash = fnv1a_hash(ser.data, ser.wpos);
+    serial_free(&ser);
+    return hash;
+}
+
+static int is_rec_file(const char *filename) {
+    size_t len = strlen(filename);
+    return len > 4 && strcasecmp(filename + len - 4, ".rec") == 0;
+}
+
+static int run_rec(const char *path, bench_result *res) {
+    engine_init_flags init_flags;
+    memset(&init_flags, 0, sizeof(engine_init_flags));
+    init_flags.net_mode = NET_MODE_NONE;
+    init_flags.headless = 1;
+    init_flags.seed = BENCH_RAND_SEED;
+    strncpy(init_flags.rec_file, path, 254);
+
+    memset(res, 0, sizeof(bench_result));
+
+    game_state *gs = omf_calloc(1, sizeof(game_state));
+    if(game_state_create(gs, &init_flags)) {
+        game_state_free(&gs);
+        return 1;
+    }
+    gs->timings = &res->timings;
+
+    // Same virtual clock as the headless engine loop
+    int static_wait = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    while(game_state_is_running(gs)) {
+        game_state_tick_controllers(gs);
+        static_wait += game_state_ms_per_dyntick(gs);
+        while(static_wait > 10) {
+            game_state_static_tick(gs);
+            static_wait -= 10;
+        }
+        game_state_dynamic_tick(gs);
+        res->ticks++;
+    }
+    res->secs = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+    res->hash = hash_game_state(gs);
+
+    gs->timings = NULL;
+    game_state_free(&gs);
+    return 0;
+}
+
+static void print_result(const char *name, int iteration, const bench_result *res) {
+    double rate = (res->secs > 0) ? res->ticks / res->secs : 0;
+    printf("%s [%d]: %u ticks in %.3f s (%.1f ticks/sec), state hash %08x\n", name, iteration, res->ticks,
+           res->secs, rate, res->hash);
+    for(int i = 0; i < PHASE_COUNT; i++) {
+        double ms = phase_timings_get_ms(&res->timings, i);
+        double us_per_call = res->timings.calls[i] ? ms * 1000.0 / res->timings.calls[i] : 0;
+        printf("    %-20s %10.3f ms %10.3f us/call\n", phase_timings_get_name(i), ms, us_per_call);
+    }
+}
+
+static int bench_rec(const char *dir, const char *filename, int iterations) {
+    char path[255];
+    snprintf(path, sizeof(path), "%s/%s", dir, filename);
+
+    // Make sure the recording is sane before handing it to the game
+    sd_rec_file rec;
+    sd_rec_create(&rec);
+    int ret = sd_rec_load(&rec, path);
+    sd_rec_free(&rec);
+    if(ret != SD_SUCCESS) {
+        fprintf(stderr, "%s: unable to load recording: %s\n", filename, sd_get_error(ret));
+        return 1;
+    }
+
+    uint32_t first_hash = 0;
+    int failed = 0;
+    for(int i = 0; i < iterations; i++) {
+        bench_result res;
+        if(run_rec(path, &res)) {
+            fprintf(stderr, "%s: unable to start replay\n", filename);
+            return 1;
+        }
+        print_result(filename, i, &res);
+        if(i == 0) {
+            first_hash = res.hash;
+        } else if(res.hash != first_hash) {
+            fprintf(stderr, "%s: replay desynced! hash %08x != %08x\n", filename, res.hash, first_hash);
+            failed = 1;
+        }
+    }
+    return failed;
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = (argc > 1) ? atoi(argv[1]) : 1;
+    const char *dir = (argc > 2) ? argv[2] : BENCH_RECS_DIR;
+    int ret = 1;
+
+    if(iterations < 1) {
+        fprintf(stderr, "Usage: %s [iterations] [rec directory]\n", argv[0]);
+        return 1;
+    }
+
+    if(pm_init() != 0) {
+        fprintf(stderr, "Error: %s.\n", pm_get_errormsg());
+        return 1;
+    }
+    if(log_init(0)) {
+        goto exit_0;
+    }
+    if(settings_init(pm_get_local_path(CONFIG_PATH))) {
+        goto exit_1;
+    }
+    settings_load();
+    plugins_init();
+    if(SDL_Init(SDL_INIT_TIMER)) {
+        fprintf(stderr, "SDL2 Initialization failed: %s\n", SDL_GetError());
+        goto exit_2;
+    }
+
+    engine_init_flags init_flags;
+    memset(&init_flags, 0, sizeof(engine_init_flags));
+    init_flags.headless = 1;
+    if(engine_init(&init_flags)) {
+        goto exit_3;
+    }
+
+    list files;
+    list_create(&files);
+    if(scan_directory(&files, dir)) {
+        fprintf(stderr, "Unable to read directory %s\n", dir);
+        goto exit_4;
+    }
+
+    ret = 0;
+    iterator it;
+    char *filename;
+    list_iter_begin(&files, &it);
+    while((filename = iter_next(&it)) != NULL) {
+        if(is_rec_file(filename)) {
+            ret |= bench_rec(dir, filename, iterations);
+        }
+    }
+
+exit_4:
+    list_free(&files);
+    engine_close();
+exit_3:
+    SDL_Quit();
+exit_2:
+    plugins_close();
+    settings_free();
+exit_1:
+    log_close();
+exit_0:
+    pm_free();
+    return ret;
+}
@@ -0,0 +1,368 @@
+// Plays a rollback netplay match between two headless game states in the same process, connected
+// through a loopback ENet host, and reports what the snapshots and the resimulation cost. Each end
+// only services its connection every few ticks, so the inputs of the peer arrive late and in
+// bursts, like they would over a slow network. The second end starts a few ticks after the first
+// one, like the peer that enters the arena last, so its peer's inputs are ahead of it. At the end,
+// the hashes of both game states have to match. The snapshots are then timed on their own, against
+// game_state_serialize().
+
+#include "controller/controller.h"
+#include "controller/net_controller.h"
+#include "engine.h"
+#include "game/common_defines.h"
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/protos/scene.h"
+#include "game/utils/rollback.h"
+#include "game/utils/serial.h"
+#include "game/utils/settings.h"
+#include "game/utils/snapshot.h"
+#include "plugins/plugins.h"
+#include "resources/pathmanager.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include "utils/random.h"
+#include <SDL.h>
+#include <enet/enet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_RAND_SEED 1
+#define BENCH_PORT 2098
+#define CONNECT_TIMEOUT_MS 2000
+#define SNAPSHOT_ITERATIONS 1000
+
+// Steps without either end simulating a tick, after which the match counts as stalled
+#define STALL_LIMIT 1000
+
+typedef struct input_script_t {
+    struct random_t rand;
+    int held;
+} input_script;
+
+static const int directions[] = {
+    ACT_STOP, ACT_LEFT, ACT_RIGHT, ACT_UP, ACT_DOWN, ACT_DOWN | ACT_LEFT, ACT_DOWN | ACT_RIGHT, ACT_UP | ACT_LEFT,
+    ACT_UP | ACT_RIGHT,
+};
+
+// Holds a direction for a while, like a player would, with a punch or a kick now and then
+static void script_tick(input_script *s, rollback *rb) {
+    if(random_int(&s->rand, 8) == 0) {
+        s->held = directions[random_int(&s->rand, sizeof(directions) / sizeof(directions[0]))];
+    }
+    if(random_int(&s->rand, 16) == 0) {
+        rollback_add_local_action(rb, random_int(&s->rand, 2) ? ACT_PUNCH : ACT_KICK);
+    }
+    rollback_add_local_action(rb, s->held);
+}
+
+static uint32_t fnv1a_hash(const char *data, size_t len) {
+    uint32_t hash = 2166136261U;
+    for(size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+static uint32_t hash_game_state(game_state *gs) {
+    serial ser;
+    serial_create(&ser);
+    game_state_serialize(gs, &ser);
+    uint32_t hash = fnv1a_hash(ser.data, serial_len(&ser));
+    serial_free(&ser);
+    return hash;
+}
+
+// Connects a client host to a server host. Returns 0 and the peers of both ends on success.
+static int connect_hosts(ENetHost *server, ENetHost *client, ENetPeer **server_peer, ENetPeer **client_peer) {
+    ENetAddress address;
+    enet_address_set_host(&address, "127.0.0.1");
+    address.port = BENCH_PORT;
+    *server_peer = NULL;
+    *client_peer = NULL;
+    if(enet_host_connect(client, &address, 2, 0) == NULL) {
+        return 1;
+    }
+    ENetEvent event;
+    Uint32 start = SDL_GetTicks();
+    while((*server_peer == NULL || *client_peer == NULL) && SDL_GetTicks() - start < CONNECT_TIMEOUT_MS) {
+        if(enet_host_service(server, &event, 1) > 0 && event.type == ENET_EVENT_TYPE_CONNECT) {
+            *server_peer = event.peer;
+        }
+        if(enet_host_service(client, &event, 1) > 0 && event.type == ENET_EVENT_TYPE_CONNECT) {
+            *client_peer = event.peer;
+        }
+    }
+    return *server_peer == NULL || *client_peer == NULL;
+}
+
+// Turns a headless AI match into a rollback netplay match, with the local player driven by the
+// bench and the remote one by a network controller. The arena owns the rollback state.
+static void setup_end(game_state *gs, int local, ENetHost *host, ENetPeer *peer) {
+    game_player *player = game_state_get_player(gs, local);
+    controller *ctrl = omf_calloc(1, sizeof(controller));
+    controller_init(ctrl);
+    ctrl->type = CTRL_TYPE_REC;
+    ctrl->har = player->har;
+    game_player_set_ctrl(player, ctrl);
+
+    game_player *remote = game_state_get_player(gs, !local);
+    ctrl = omf_calloc(1, sizeof(controller));
+    controller_init(ctrl);
+    net_controller_create(ctrl, host, peer, (local == 0) ? ROLE_SERVER : ROLE_CLIENT);
+    ctrl->har = remote->har;
+    game_player_set_ctrl(remote, ctrl);
+
+    gs->role = (local == 0) ? ROLE_SERVER : ROLE_CLIENT;
+    gs->rollback = omf_calloc(1, sizeof(rollback));
+    rollback_create(gs->rollback, local);
+    net_controller_set_rollback(ctrl, gs->rollback);
+}
+
+static double ticks_to_us(uint64_t ticks, unsigned int count) {
+    if(count == 0) {
+        return 0;
+    }
+    return (double)ticks * 1000000.0 / SDL_GetPerformanceFrequency() / count;
+}
+
+static void print_stats(int side, rollback *rb, unsigned int stalls) {
+    const rollback_stats *st = rollback_get_stats(rb);
+    printf("end %d: %u ticks, %u stalls, %u mispredictions, %u rollbacks (%u ticks again, at most %u)\n", side,
+           rollback_get_tick(rb), stalls, st->mispredictions, st->rollbacks, st->resim_ticks, st->max_depth);
+    printf("    save          %10.3f us/snapshot\n", ticks_to_us(st->save_time, st->saves));
+    printf("    restore       %10.3f us/rollback\n", ticks_to_us(st->restore_time, st->rollbacks));
+    printf("    resimulate    %10.3f us/tick\n", ticks_to_us(st->resim_time, st->resim_ticks));
+}
+
+static double elapsed_us(Uint64 start, int iterations) {
+    return ticks_to_us(SDL_GetPerformanceCounter() - start, iterations);
+}
+
+// Times the in-place snapshots against a round trip through game_state_serialize(), and checks
+// that restoring a snapshot gives back the same state. Returns 0 if it does.
+static int bench_snapshots(game_state *gs) {
+    snapshot snap;
+    serial ser;
+    snapshot_create(&snap);
+    serial_create(&ser);
+    uint32_t hash = hash_game_state(gs);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < SNAPSHOT_ITERATIONS; i++) {
+        snapshot_save(&snap, gs);
+    }
+    double save_us = elapsed_us(start, SNAPSHOT_ITERATIONS);
+    start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < SNAPSHOT_ITERATIONS; i++) {
+        snapshot_restore(&snap, gs);
+    }
+    double restore_us = elapsed_us(start, SNAPSHOT_ITERATIONS);
+    uint32_t restored_hash = hash_game_state(gs);
+
+    start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < SNAPSHOT_ITERATIONS; i++) {
+        serial_write_reset(&ser);
+        game_state_serialize(gs, &ser);
+    }
+    double serialize_us = elapsed_us(start, SNAPSHOT_ITERATIONS);
+    start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < SNAPSHOT_ITERATIONS; i++) {
+        serial_read_reset(&ser);
+        game_state_restore(gs, &ser);
+    }
+    double unserialize_us = elapsed_us(start, SNAPSHOT_ITERATIONS);
+
+    printf("snapshot (%zu bytes): save %.3f us, restore %.3f us\n", sizeof(snapshot), save_us, restore_us);
+    printf("serialized (%zu bytes): save %.3f us, restore %.3f us\n", serial_len(&ser), serialize_us, unserialize_us);
+    serial_free(&ser);
+    snapshot_free(&snap);
+    if(restored_hash != hash) {
+        fprintf(stderr, "Snapshot restore changed the state! hash %08x != %08x\n", restored_hash, hash);
+        return 1;
+    }
+    return 0;
+}
+
+static int in_arena(game_state *gs) {
+    return game_state_is_running(gs) && gs->rollback != NULL;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int max_ticks = (argc > 1) ? atoi(argv[1]) : 2000;
+    int lag = (argc > 2) ? atoi(argv[2]) : 6;
+    int head_start = (argc > 3) ? atoi(argv[3]) : ROLLBACK_FRAMES / 2;
+    int ret = 1;
+
+    if(max_ticks < 1 || lag < 1 || lag >= ROLLBACK_FRAMES || head_start < 0 || head_start >= ROLLBACK_FRAMES) {
+        fprintf(stderr, "Usage: %s [ticks] [lag in ticks, 1 to %d] [head start in ticks, 0 to %d]\n", argv[0],
+                ROLLBACK_FRAMES - 1, ROLLBACK_FRAMES - 1);
+        return 1;
+    }
+
+    if(pm_init() != 0) {
+        fprintf(stderr, "Error: %s.\n", pm_get_errormsg());
+        return 1;
+    }
+    if(log_init(0)) {
+        goto exit_0;
+    }
+    if(settings_init(pm_get_local_path(CONFIG_PATH))) {
+        goto exit_1;
+    }
+    settings_load();
+    plugins_init();
+    if(SDL_Init(SDL_INIT_TIMER)) {
+        fprintf(stderr, "SDL2 Initialization failed: %s\n", SDL_GetError());
+        goto exit_2;
+    }
+    if(enet_initialize() != 0) {
+        fprintf(stderr, "Failed to initialize ENet\n");
+        goto exit_3;
+    }
+
+    engine_init_flags init_flags;
+    memset(&init_flags, 0, sizeof(engine_init_flags));
+    init_flags.headless = 1;
+    if(engine_init(&init_flags)) {
+        goto exit_4;
+    }
+
+    ENetAddress address;
+    address.host = ENET_HOST_ANY;
+    address.port = BENCH_PORT;
+    ENetHost *hosts[2];
+    ENetPeer *peers[2];
+    hosts[0] = enet_host_create(&address, 1, 2, 0, 0);
+    hosts[1] = enet_host_create(NULL, 1, 2, 0, 0);
+    if(hosts[0] == NULL || hosts[1] == NULL || connect_hosts(hosts[0], hosts[1], &peers[0], &peers[1])) {
+        fprintf(stderr, "Unable to connect to port %d on loopback\n", BENCH_PORT);
+        goto exit_5;
+    }
+
+    // Both ends start from the same match and seed, like the arena does for netplay
+    engine_match_setup setup;
+    setup.har_id[0] = HAR_JAGUAR;
+    setup.har_id[1] = HAR_SHADOW;
+    setup.pilot_id[0] = 0;
+    setup.pilot_id[1] = 1;
+    setup.difficulty = 4;
+    setup.arena = 0;
+    engine_init_flags flags[2];
+    game_state *gs[2] = {NULL, NULL};
+    input_script scripts[2];
+    unsigned int stalls[2] = {0, 0};
+    for(int i = 0; i < 2; i++) {
+        memset(&flags[i], 0, sizeof(engine_init_flags));
+        flags[i].headless = 1;
+        flags[i].seed = BENCH_RAND_SEED;
+        flags[i].match = &setup;
+        gs[i] = omf_calloc(1, sizeof(game_state));
+        if(game_state_create(gs[i], &flags[i])) {
+            fprintf(stderr, "Unable to start game state %d\n", i);
+            goto exit_6;
+        }
+        // The host belongs to the network controller from here on
+        setup_end(gs[i], i, hosts[i], peers[i]);
+        hosts[i] = NULL;
+        random_seed(&scripts[i].rand, BENCH_RAND_SEED + 1 + i);
+        scripts[i].held = ACT_STOP;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    unsigned int idle_steps = 0;
+    for(unsigned int step = 0; in_arena(gs[0]) && in_arena(gs[1]); step++) {
+        int done = 1;
+        int advanced = 0;
+        for(int i = 0; i < 2; i++) {
+            rollback *rb = gs[i]->rollback;
+            if(rollback_get_tick(rb) >= max_ticks) {
+                continue;
+            }
+            done = 0;
+            if((step + i * lag / 2) % lag == 0) {
+                game_state_tick_controllers(gs[i]);
+            }
+            if(i == 1 && rollback_get_tick(gs[0]->rollback) < (unsigned int)head_start) {
+                advanced = 1;
+                continue;
+            }
+            if(rollback_can_advance(rb)) {
+                script_tick(&scripts[i], rb);
+                advanced = 1;
+            } else {
+                stalls[i]++;
+            }
+            game_state_dynamic_tick(gs[i]);
+        }
+        if(done) {
+            break;
+        }
+        idle_steps = advanced ? 0 : idle_steps + 1;
+        if(idle_steps > STALL_LIMIT) {
+            fprintf(stderr, "Both ends stalled at ticks %u and %u\n", rollback_get_tick(gs[0]->rollback),
+                    rollback_get_tick(gs[1]->rollback));
+            goto exit_6;
+        }
+    }
+
+    // Let the last inputs through, and bring both ends up to date with them
+    for(int n = 0; n < 1000 && in_arena(gs[0]) && in_arena(gs[1]); n++) {
+        if(gs[0]->rollback->confirmed_tick == rollback_get_tick(gs[1]->rollback) &&
+           gs[1]->rollback->confirmed_tick == rollback_get_tick(gs[0]->rollback)) {
+            break;
+        }
+        game_state_tick_controllers(gs[0]);
+        game_state_tick_controllers(gs[1]);
+        SDL_Delay(1);
+    }
+    if(!in_arena(gs[0]) || !in_arena(gs[1])) {
+        fprintf(stderr, "The match ended before %u ticks\n", max_ticks);
+        goto exit_6;
+    }
+    for(int i = 0; i < 2; i++) {
+        rollback_update(gs[i]->rollback, gs[i]);
+    }
+    double secs = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    printf("%u ticks with %d ticks of lag and a head start of %d ticks in %.3f s\n", max_ticks, lag, head_start,
+           secs);
+    for(int i = 0; i < 2; i++) {
+        print_stats(i, gs[i]->rollback, stalls[i]);
+    }
+    uint32_t hash[2] = {hash_game_state(gs[0]), hash_game_state(gs[1])};
+    if(hash[0] != hash[1]) {
+        fprintf(stderr, "Desynced! state hash %08x != %08x\n", hash[0], hash[1]);
+    } else {
+        printf("In sync, state hash %08x\n", hash[0]);
+        ret = bench_snapshots(gs[0]);
+    }
+
+exit_6:
+    for(int i = 0; i < 2; i++) {
+        if(gs[i] != NULL) {
+            game_state_free(&gs[i]);
+        }
+    }
+exit_5:
+    for(int i = 0; i < 2; i++) {
+        if(hosts[i] != NULL) {
+            enet_host_destroy(hosts[i]);
+        }
+    }
+    engine_close();
+exit_4:
+    enet_deinitialize();
+exit_3:
+    SDL_Quit();
+exit_2:
+    plugins_close();
+    settings_free();
+exit_1:
+    log_close();
+exit_0:
+    pm_free();
+    return ret;
+}
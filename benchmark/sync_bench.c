@@ -0,0 +1,226 @@
+// Sends the state of a headless AI match as state syncs from a server network controller to a
+// client one, over a loopback ENet host, the way the arena syncs a netplay client. Every sync that
+// arrives has to decode back to the state that was sent. Reports how much the delta encoding saves
+// and what the syncs cost to serialize, encode and decode.
+
+#include "controller/controller.h"
+#include "controller/net_controller.h"
+#include "engine.h"
+#include "game/common_defines.h"
+#include "game/game_state.h"
+#include "game/utils/serial.h"
+#include "game/utils/settings.h"
+#include "plugins/plugins.h"
+#include "resources/pathmanager.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include <SDL.h>
+#include <enet/enet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_RAND_SEED 1
+#define BENCH_PORT 2099
+#define CONNECT_TIMEOUT_MS 2000
+#define SYNC_TIMEOUT_MS 100
+
+// Connects a client host to a server host. Returns 0 and the peers of both ends on success.
+static int connect_hosts(ENetHost *server, ENetHost *client, ENetPeer **server_peer, ENetPeer **client_peer) {
+    ENetAddress address;
+    enet_address_set_host(&address, "127.0.0.1");
+    address.port = BENCH_PORT;
+    *server_peer = NULL;
+    *client_peer = NULL;
+    if(enet_host_connect(client, &address, 2, 0) == NULL) {
+        return 1;
+    }
+    ENetEvent event;
+    Uint32 start = SDL_GetTicks();
+    while((*server_peer == NULL || *client_peer == NULL) && SDL_GetTicks() - start < CONNECT_TIMEOUT_MS) {
+        if(enet_host_service(server, &event, 1) > 0 && event.type == ENET_EVENT_TYPE_CONNECT) {
+            *server_peer = event.peer;
+        }
+        if(enet_host_service(client, &event, 1) > 0 && event.type == ENET_EVENT_TYPE_CONNECT) {
+            *client_peer = event.peer;
+        }
+    }
+    return *server_peer == NULL || *client_peer == NULL;
+}
+
+// Services both ends until the client gets a state sync. Returns the sync, or NULL if none came.
+static serial *wait_sync(controller *server, controller *client, int tick) {
+    Uint32 start = SDL_GetTicks();
+    serial *ser = NULL;
+    while(ser == NULL && SDL_GetTicks() - start < SYNC_TIMEOUT_MS) {
+        ctrl_event *ev = NULL;
+        controller_tick(client, tick, &ev);
+        for(ctrl_event *i = ev; i != NULL; i = i->next) {
+            if(i->type == EVENT_TYPE_SYNC) {
+                ser = serial_calloc_copy(i->event_data.ser);
+            }
+        }
+        controller_free_chain(ev);
+
+        // The server gets the acknowledgements here
+        ev = NULL;
+        controller_tick(server, tick, &ev);
+        controller_free_chain(ev);
+    }
+    return ser;
+}
+
+static double ticks_to_us(uint64_t ticks, unsigned int count) {
+    if(count == 0) {
+        return 0;
+    }
+    return (double)ticks * 1000000.0 / SDL_GetPerformanceFrequency() / count;
+}
+
+int main(int argc, char *argv[]) {
+    int max_ticks = (argc > 1) ? atoi(argv[1]) : 3000;
+    int interval = (argc > 2) ? atoi(argv[2]) : 4;
+    int ret = 1;
+
+    if(max_ticks < 1 || interval < 1) {
+        fprintf(stderr, "Usage: %s [ticks] [ticks between syncs]\n", argv[0]);
+        return 1;
+    }
+
+    if(pm_init() != 0) {
+        fprintf(stderr, "Error: %s.\n", pm_get_errormsg());
+        return 1;
+    }
+    if(log_init(0)) {
+        goto exit_0;
+    }
+    if(settings_init(pm_get_local_path(CONFIG_PATH))) {
+        goto exit_1;
+    }
+    settings_load();
+    plugins_init();
+    if(SDL_Init(SDL_INIT_TIMER)) {
+        fprintf(stderr, "SDL2 Initialization failed: %s\n", SDL_GetError());
+        goto exit_2;
+    }
+    if(enet_initialize() != 0) {
+        fprintf(stderr, "Failed to initialize ENet\n");
+        goto exit_3;
+    }
+
+    engine_init_flags init_flags;
+    memset(&init_flags, 0, sizeof(engine_init_flags));
+    init_flags.headless = 1;
+    if(engine_init(&init_flags)) {
+        goto exit_4;
+    }
+
+    ENetAddress address;
+    address.host = ENET_HOST_ANY;
+    address.port = BENCH_PORT;
+    ENetHost *server_host = enet_host_create(&address, 1, 2, 0, 0);
+    ENetHost *client_host = enet_host_create(NULL, 1, 2, 0, 0);
+    ENetPeer *server_peer, *client_peer;
+    if(server_host == NULL || client_host == NULL ||
+       connect_hosts(server_host, client_host, &server_peer, &client_peer)) {
+        fprintf(stderr, "Unable to connect to port %d on loopback\n", BENCH_PORT);
+        if(server_host != NULL) {
+            enet_host_destroy(server_host);
+        }
+        if(client_host != NULL) {
+            enet_host_destroy(client_host);
+        }
+        goto exit_5;
+    }
+
+    // The controllers own the hosts from here on
+    controller server, client;
+    controller_init(&server);
+    controller_init(&client);
+    net_controller_create(&server, server_host, server_peer, ROLE_SERVER);
+    net_controller_create(&client, client_host, client_peer, ROLE_CLIENT);
+
+    engine_match_setup setup;
+    setup.har_id[0] = HAR_JAGUAR;
+    setup.har_id[1] = HAR_SHADOW;
+    setup.pilot_id[0] = 0;
+    setup.pilot_id[1] = 1;
+    setup.difficulty = 4;
+    setup.arena = 0;
+    engine_init_flags match_flags;
+    memset(&match_flags, 0, sizeof(engine_init_flags));
+    match_flags.headless = 1;
+    match_flags.seed = BENCH_RAND_SEED;
+    match_flags.match = &setup;
+    game_state *gs = omf_calloc(1, sizeof(game_state));
+    if(game_state_create(gs, &match_flags)) {
+        fprintf(stderr, "Unable to start the match\n");
+        goto exit_6;
+    }
+
+    unsigned int mismatches = 0;
+    unsigned int lost = 0;
+    for(int tick = 0; tick < max_ticks && game_state_is_running(gs); tick++) {
+        game_state_tick_controllers(gs);
+        game_state_dynamic_tick(gs);
+        if(tick % interval != 0) {
+            continue;
+        }
+
+        serial ser;
+        serial_create(&ser);
+        Uint64 start = SDL_GetPerformanceCounter();
+        game_state_serialize(gs, &ser);
+        net_controller_add_serialize_time(&server, SDL_GetPerformanceCounter() - start);
+        controller_update(&server, &ser);
+
+        serial *synced = wait_sync(&server, &client, tick);
+        if(synced == NULL) {
+            lost++;
+        } else {
+            if(serial_len(synced) != serial_len(&ser) || memcmp(synced->data, ser.data, serial_len(&ser)) != 0) {
+                mismatches++;
+            }
+            serial_free(synced);
+            omf_free(synced);
+        }
+        serial_free(&ser);
+    }
+
+    const net_sync_stats *sent = net_controller_get_sync_stats(&server);
+    const net_sync_stats *received = net_controller_get_sync_stats(&client);
+    printf("%u syncs sent (%u full, %u compressed, %u resent), %u received, %u dropped, %u lost\n", sent->sent,
+           sent->sent_full, sent->compressed, sent->resent, received->received, received->dropped, lost);
+    printf("    state         %10.1f bytes/sync\n", (double)sent->raw_bytes / (sent->sent ? sent->sent : 1));
+    printf("    packet        %10.1f bytes/sync (%.1f%%)\n", (double)sent->sent_bytes / (sent->sent ? sent->sent : 1),
+           sent->raw_bytes ? 100.0 * sent->sent_bytes / sent->raw_bytes : 0);
+    printf("    serialize     %10.3f us/sync\n", ticks_to_us(sent->serialize_time, sent->sent));
+    printf("    encode        %10.3f us/sync\n", ticks_to_us(sent->encode_time, sent->sent));
+    printf("    decode        %10.3f us/sync\n", ticks_to_us(received->decode_time, received->received));
+    if(mismatches > 0) {
+        fprintf(stderr, "%u syncs did not decode to the state that was sent!\n", mismatches);
+    } else if(received->received == 0) {
+        fprintf(stderr, "No syncs got through\n");
+    } else {
+        ret = 0;
+    }
+
+exit_6:
+    game_state_free(&gs);
+    net_controller_free(&client);
+    net_controller_free(&server);
+exit_5:
+    engine_close();
+exit_4:
+    enet_deinitialize();
+exit_3:
+    SDL_Quit();
+exit_2:
+    plugins_close();
+    settings_free();
+exit_1:
+    log_close();
+exit_0:
+    pm_free();
+    return ret;
+}
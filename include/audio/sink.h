@@ -3,7 +3,7 @@
 
 #include "audio/source.h"
 #include "audio/stream.h"
-#include "utils/hashmap.h"
+#include "utils/flatmap.h"
 
 #define VOLUME_DEFAULT 1.0f
 #define PANNING_DEFAULT 0.0f
@@ -25,7 +25,7 @@ typedef void (*sink_format_stream_cb)(audio_sink *sink, audio_stream *stream);
 typedef void (*sink_close_cb)(audio_sink *sink);
 
 struct audio_sink_t {
-    hashmap streams;
+    flatmap streams; ///< Playing streams by stream id
     void *userdata;
     sink_close_cb close;
     sink_format_stream_cb format_stream;
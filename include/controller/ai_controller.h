@@ -2,10 +2,11 @@
 #define AI_CONTROLLER_H
 
 #include "formats/pilot.h"
+#include "utils/random.h"
 
 typedef struct controller_t controller;
 
 void ai_controller_free(controller *ctrl);
-void ai_controller_create(controller *ctrl, int difficulty, sd_pilot *pilot, int pilot_id);
+void ai_controller_create(controller *ctrl, int difficulty, sd_pilot *pilot, int pilot_id, struct random_t *rand);
 
 #endif // AI_CONTROLLER_H
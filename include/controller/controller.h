@@ -33,7 +33,10 @@ enum
     EVENT_TYPE_ACTION,
     EVENT_TYPE_SYNC,
     EVENT_TYPE_HB,
-    EVENT_TYPE_CLOSE
+    EVENT_TYPE_CLOSE,
+    EVENT_TYPE_INPUT,
+    EVENT_TYPE_SYNC_ACK,
+    EVENT_TYPE_HANDSHAKE
 };
 
 typedef struct ctrl_event_t ctrl_event;
@@ -2,15 +2,53 @@
 #define NET_CONTROLLER_H
 
 #include "controller/controller.h"
+#include "game/utils/rollback.h"
 #include <SDL.h>
 #include <enet/enet.h>
+#include <stdint.h>
+
+// State syncs are sent as deltas against the latest state that the peer has acknowledged. Both
+// ends keep this many of the last states, so that the base of a delta is still around.
+#define SYNC_HISTORY 16
+
+// Upper limit for the size of a synced state. The receiver drops larger ones, so that a broken packet
+// can't blow the stack, and they are not sent either.
+#define SYNC_MAX_LEN 0x10000
+
+typedef struct net_sync_stats_t {
+    unsigned int sent;       ///< State syncs sent to the peer
+    unsigned int sent_full;  ///< Syncs sent without an acknowledged state to encode against
+    unsigned int resent;     ///< Syncs sent again, because the last one was not acknowledged
+    unsigned int compressed; ///< Syncs that were also run-length compressed
+    unsigned int received;   ///< State syncs received from the peer
+    unsigned int dropped;    ///< Received syncs that could not be decoded
+    uint64_t raw_bytes;      ///< Size of the sent states before encoding
+    uint64_t sent_bytes;     ///< Size of the sync packets sent
+    uint64_t serialize_time; ///< Performance counter ticks spent serializing the sent states
+    uint64_t encode_time;    ///< Performance counter ticks spent encoding the sent states
+    uint64_t decode_time;    ///< Performance counter ticks spent decoding the received states
+} net_sync_stats;
 
 void net_controller_create(controller *ctrl, ENetHost *host, ENetPeer *peer, int id);
 void net_controller_free(controller *ctrl);
 int net_controller_get_rtt(controller *ctrl);
 void net_controller_har_hook(int action, void *cb_data);
 
+// Returns 1 once the peers have agreed on the game settings and the round trip time is known, 0 while
+// waiting for that, and -1 if the peer runs with different settings and the connection is refused.
 int net_controller_ready(controller *ctrl);
 int net_controller_tick_offset(controller *ctrl);
 
+// In a rollback game, the controller exchanges the tick stamped inputs of the rollback buffer with
+// the peer, instead of sending actions and state as they happen. NULL switches back.
+void net_controller_set_rollback(controller *ctrl, rollback *rb);
+
+// Returns 1 if both peers run the game with rollback, and writes the random seed that the server
+// picked for it into seed. Only valid once net_controller_ready() has returned 1.
+int net_controller_get_rollback(controller *ctrl, uint32_t *seed);
+
+const net_sync_stats *net_controller_get_sync_stats(controller *ctrl);
+// Counts time spent serializing a state that is about to be sent with controller_update()
+void net_controller_add_serialize_time(controller *ctrl, uint64_t ticks);
+
 #endif // NET_CONTROLLER_H
@@ -1,13 +1,24 @@
 #ifndef ENGINE_H
 #define ENGINE_H
 
+// A headless AI vs. AI match between the given HARs and pilots
+typedef struct engine_match_setup_t {
+    int har_id[2];
+    int pilot_id[2];
+    int difficulty; // AI difficulty, as in the gameplay settings
+    int arena;      // 0 to 4
+} engine_match_setup;
+
 typedef struct engine_init_flags_t {
     unsigned int net_mode;
     unsigned int record;
+    unsigned int headless;
+    unsigned int seed;                // Random seed for the game; 0 picks one
+    const engine_match_setup *match; // Match for headless runs; NULL picks a random one
     char rec_file[255];
 } engine_init_flags;
 
-int engine_init();                              // Init window, audiodevice, etc.
+int engine_init(engine_init_flags *init_flags); // Init window, audiodevice, etc.
 void engine_run(engine_init_flags *init_flags); // Run game
 void engine_close();                            // Kill window, audiodev
 
@@ -12,11 +12,14 @@
 
 #include "formats/taglist.h"
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define SD_TAG_MASK_WORDS ((SD_TAG_COUNT + 31) / 32) ///< Size of the frame tag presence bitset in 32bit words
+
 /*! \brief Animation tag
  *
  * Describes a single tag in animation frame.
@@ -26,6 +29,7 @@ typedef struct {
     const char *desc; ///< Tag description
     int has_param;    ///< Tells if the tag has a parameter
     int value;        ///< Tag parameter value. Only valid if has_param = 1.
+    int id;           ///< Tag ID, see sd_tag_id
 } sd_script_tag;
 
 /*! \brief Animation frame
@@ -37,6 +41,7 @@ typedef struct {
     int tick_len;        ///< Length of the frame in ticks
     int tag_count;       ///< Amount of tags in this frame
     sd_script_tag *tags; ///< A list of tags in this frame
+    uint32_t tag_mask[SD_TAG_MASK_WORDS]; ///< Bitset of the tag IDs set in this frame
 } sd_script_frame;
 
 /*! \brief Animation script
@@ -47,6 +52,7 @@ typedef struct {
 typedef struct {
     int frame_count;         ///< Amount of frames in the string
     sd_script_frame *frames; ///< List of frames in this string
+    int *tick_pos;           ///< Start tick of each frame, plus the total length. Used for fast frame lookups.
 } sd_script;
 
 /*! \brief Initialize script parser
@@ -315,6 +321,27 @@ int sd_script_isset(const sd_script_frame *frame, const char *tag);
  */
 int sd_script_get(const sd_script_frame *frame, const char *tag);
 
+/*! \brief Tells if the tag is set in frame
+ *
+ * Same as sd_script_isset(), but takes an interned tag ID instead of the tag name.
+ * This does not do any string comparisons, so it should be preferred in the game loop.
+ *
+ * \param frame The frame structure to inspect. May be NULL.
+ * \param tag Tag ID to find
+ * \return 1 or 0
+ */
+int sd_script_isset_id(const sd_script_frame *frame, sd_tag_id tag);
+
+/*! \brief Returns the tag value in frame
+ *
+ * Same as sd_script_get(), but takes an interned tag ID instead of the tag name.
+ *
+ * \param frame The frame structure to inspect. May be NULL.
+ * \param tag Tag ID to find
+ * \return Tag parameter value or 0.
+ */
+int sd_script_get_id(const sd_script_frame *frame, sd_tag_id tag);
+
 /*! \brief Returns the next frame number with a given sprite ID
  *
  * Returns the next frame number with the given sprite number. Sprite numbers start from 0 and go to
@@ -351,6 +378,17 @@ int sd_script_next_frame_with_sprite(const sd_script *script, int sprite_id, int
  */
 int sd_script_next_frame_with_tag(const sd_script *script, const char *tag, int current_tick);
 
+/*! \brief Returns the next frame number with a given tag ID
+ *
+ * Same as sd_script_next_frame_with_tag(), but looks the tag up from the frame tag bitsets.
+ *
+ * \param script Script structure to search through
+ * \param tag Tag ID to search for
+ * \param current_tick Current tick time
+ * \return Frame ID or -1 on error
+ */
+int sd_script_next_frame_with_tag_id(const sd_script *script, sd_tag_id tag, int current_tick);
+
 /*! \brief Sets a tag for the given frame
  *
  * Sets the tag for the given frame. If the tag has not been set previously, a new tag
@@ -24,6 +24,169 @@ typedef struct {
     const char *description; ///< A short description for the tag.
 } sd_tag;
 
+/*! \brief Tag identifiers
+ *
+ * Indexes to the global tag list. Tags in decoded animation scripts are interned
+ * to these, so that they can be looked up without string comparisons.
+ * Must be kept in the same order as sd_taglist.
+ */
+typedef enum
+{
+    TAG_AA,
+    TAG_AB,
+    TAG_AC,
+    TAG_AD,
+    TAG_AE,
+    TAG_AF,
+    TAG_AG,
+    TAG_AI,
+    TAG_AM,
+    TAG_AO,
+    TAG_AS,
+    TAG_AT,
+    TAG_AW,
+    TAG_AX,
+    TAG_AR,
+    TAG_AL,
+    TAG_B,
+    TAG_B1,
+    TAG_B2,
+    TAG_BB,
+    TAG_BE,
+    TAG_BF,
+    TAG_BH,
+    TAG_BL,
+    TAG_BM,
+    TAG_BJ,
+    TAG_BS,
+    TAG_BU,
+    TAG_BW,
+    TAG_BX,
+    TAG_BPD,
+    TAG_BPS,
+    TAG_BPN,
+    TAG_BPF,
+    TAG_BPP,
+    TAG_BPB,
+    TAG_BPO,
+    TAG_BZ,
+    TAG_BA,
+    TAG_BC,
+    TAG_BD,
+    TAG_BG,
+    TAG_BI,
+    TAG_BK,
+    TAG_BN,
+    TAG_BO,
+    TAG_BR,
+    TAG_BT,
+    TAG_BY,
+    TAG_CF,
+    TAG_CG,
+    TAG_CL,
+    TAG_CP,
+    TAG_CW,
+    TAG_CX,
+    TAG_CY,
+    TAG_D,
+    TAG_E,
+    TAG_F,
+    TAG_G,
+    TAG_H,
+    TAG_I,
+    TAG_JF2,
+    TAG_JF,
+    TAG_JG,
+    TAG_JH,
+    TAG_JJ,
+    TAG_JL,
+    TAG_JM,
+    TAG_JP,
+    TAG_JZ,
+    TAG_JN,
+    TAG_K,
+    TAG_L,
+    TAG_MA,
+    TAG_MC,
+    TAG_MD,
+    TAG_MG,
+    TAG_MI,
+    TAG_MM,
+    TAG_MN,
+    TAG_MO,
+    TAG_MP,
+    TAG_MRX,
+    TAG_MRY,
+    TAG_MS,
+    TAG_MU,
+    TAG_MX,
+    TAG_MY,
+    TAG_M,
+    TAG_N,
+    TAG_OX,
+    TAG_OY,
+    TAG_PA,
+    TAG_PB,
+    TAG_PC,
+    TAG_PD,
+    TAG_PE,
+    TAG_PH,
+    TAG_PP,
+    TAG_PS,
+    TAG_PTD,
+    TAG_PTP,
+    TAG_PTR,
+    TAG_Q,
+    TAG_R,
+    TAG_S,
+    TAG_SA,
+    TAG_SB,
+    TAG_SC,
+    TAG_SD,
+    TAG_SE,
+    TAG_SF,
+    TAG_SL,
+    TAG_SMF,
+    TAG_SMO,
+    TAG_SP,
+    TAG_SW,
+    TAG_T,
+    TAG_UA,
+    TAG_UB,
+    TAG_UC,
+    TAG_UD,
+    TAG_UE,
+    TAG_UF,
+    TAG_UG,
+    TAG_UH,
+    TAG_UJ,
+    TAG_UL,
+    TAG_UN,
+    TAG_UR,
+    TAG_US,
+    TAG_UZ,
+    TAG_V,
+    TAG_VSX,
+    TAG_VSY,
+    TAG_W,
+    TAG_X_MINUS,
+    TAG_X_PLUS,
+    TAG_X_EQ,
+    TAG_X,
+    TAG_Y_MINUS,
+    TAG_Y_PLUS,
+    TAG_Y_EQ,
+    TAG_Y,
+    TAG_ZG,
+    TAG_ZH,
+    TAG_ZJ,
+    TAG_ZL,
+    TAG_ZM,
+    TAG_ZP,
+    TAG_ZZ,
+    SD_TAG_COUNT
+} sd_tag_id;
+
 extern const sd_tag sd_taglist[]; ///< A global list of tags
 extern const int sd_taglist_size; ///< Taglist size
 
@@ -43,6 +206,15 @@ extern const int sd_taglist_size; ///< Taglist size
  */
 int sd_tag_info(const char *search_tag, int *req_param, const char **tag, const char **desc);
 
+/*! \brief Find the ID of a tag
+ *
+ * Returns the index of the tag in the global tag list.
+ *
+ * \param search_tag A Tag to look for
+ * \return Tag ID (see sd_tag_id), or -1 if the tag does not exist.
+ */
+int sd_tag_find(const char *search_tag);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,6 +1,8 @@
 #ifndef COMMON_DEFINES_H
 #define COMMON_DEFINES_H
 
+#include "utils/random.h"
+
 const char *ai_difficulty_get_name(unsigned int id);
 const char *har_get_name(unsigned int id);
 const char *pilot_get_name(unsigned int id);
@@ -10,7 +12,7 @@ const char *scene_get_name(unsigned int id);
 int har_to_resource(unsigned int id);
 int scene_to_resource(unsigned int id);
 
-int rand_arena();
+int rand_arena(struct random_t *rand);
 
 extern const char *ai_difficulty_names[];
 extern const char *round_type_names[];
@@ -11,6 +11,9 @@ typedef struct scene_t scene;
 typedef struct game_player_t game_player;
 typedef struct object_t object;
 
+// Game states do not share any simulation state with each other. Headless game states also leave
+// the video and input state alone, so several of them may be ticked at once on separate threads,
+// as long as each one is only ever ticked by one thread at a time.
 int game_state_create(game_state *gs, engine_init_flags *init_flags);
 void game_state_free(game_state **gs);
 int game_state_handle_event(game_state *gs, SDL_Event *event);
@@ -28,11 +31,23 @@ void game_state_set_next(game_state *gs, unsigned int next_scene_id);
 game_player *game_state_get_player(game_state *gs, int player_id);
 int game_state_num_players(game_state *gs);
 void game_state_init_demo(game_state *gs);
+void game_state_init_match(game_state *gs, const engine_match_setup *match);
 int game_state_ms_per_dyntick(game_state *gs);
 ticktimer *game_state_get_ticktimer(game_state *gs);
 int game_state_serialize(game_state *gs, serial *ser);
 int game_state_unserialize(game_state *gs, serial *ser, int rtt);
 
+// Restores a state written by game_state_serialize() as it was, without catching up to the peer
+int game_state_restore(game_state *gs, serial *ser);
+
+// Writes the projectiles of the game state, and returns how many there were
+unsigned int game_state_serialize_projectiles(game_state *gs, serial *ser);
+// Replaces the projectiles of the game state with the ones written by the above
+void game_state_unserialize_projectiles(game_state *gs, serial *ser, unsigned int count);
+
+// Runs a tick of a rollback game again, after its snapshot has been restored. See rollback.h.
+void game_state_resim_tick(game_state *gs);
+
 void _setup_keyboard(game_state *gs, int player_id);
 void _setup_ai(game_state *gs, int player_id);
 int _setup_joystick(game_state *gs, int player_id, const char *joyname, int offset);
@@ -46,9 +61,15 @@ void game_state_slowdown(game_state *gs, int ticks, int rate);
 void game_state_set_speed(game_state *gs, int speed);
 unsigned int game_state_get_speed(game_state *gs);
 
+object *game_state_alloc_object(game_state *gs);
+void game_state_release_object(game_state *gs, object *obj);
+void *game_state_alloc_userdata(game_state *gs, size_t size);
+void game_state_release_userdata(game_state *gs, void *ptr);
+
 int game_state_add_object(game_state *gs, object *obj, int layer, int singleton, int persistent);
 void game_state_del_object(game_state *gs, object *obj);
 void game_state_del_animation(game_state *gs, int anim_id);
+object *game_state_find_object(game_state *gs, slot_handle handle);
 void game_state_get_projectiles(game_state *gs, vector *obj_proj);
 void game_state_clear_hazards_projectiles(game_state *gs);
 
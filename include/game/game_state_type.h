@@ -2,13 +2,18 @@
 #define GAME_STATE_TYPE_H
 
 #include "engine.h"
+#include "game/utils/render_queue.h"
+#include "utils/pool.h"
+#include "utils/random.h"
+#include "utils/slotmap.h"
 #include "utils/vector.h"
 
 enum
 {
     RENDER_LAYER_BOTTOM = 0,
     RENDER_LAYER_MIDDLE,
-    RENDER_LAYER_TOP
+    RENDER_LAYER_TOP,
+    RENDER_LAYER_COUNT
 };
 
 enum
@@ -27,6 +32,8 @@ enum
 typedef struct scene_t scene;
 typedef struct game_player_t game_player;
 typedef struct ticktimer_t ticktimer;
+typedef struct phase_timings_t phase_timings;
+typedef struct rollback_t rollback;
 
 typedef struct game_state_t {
     unsigned int run;
@@ -58,8 +65,14 @@ typedef struct game_state_t {
     int next_requires_refresh; // If next frame requires a texture refresh, this should be set to 1
     int net_mode;              // NET_MODE_NONE, NET_MODE_CLIENT, NET_MODE_SERVER
     scene *sc;
-    vector objects;
+    slotmap objects;           ///< Objects of the scene, in the order they were added
+    render_queue render_queue; ///< Objects to draw in the current frame, rebuilt every frame
+    pool object_pool;          ///< Memory for the objects spawned during play
+    pool userdata_pool;        ///< Memory for the userdata of those objects
     game_player *players[2];
+    struct random_t rand;   // Random numbers for everything that happens in the game
+    phase_timings *timings; // Per-phase tick timings, if enabled. NULL otherwise.
+    rollback *rollback;     // Rollback netplay state, if enabled. NULL otherwise.
 } game_state;
 
 #endif // GAME_STATE_TYPE_H
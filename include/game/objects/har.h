@@ -171,6 +171,12 @@ typedef struct har_t {
 #endif
 } har;
 
+// State of a HAR at some point, for restoring it in place later
+typedef struct har_snapshot_t {
+    object_snapshot obj; ///< State of the HAR object
+    har h;               ///< Copy of the HAR specific state
+} har_snapshot;
+
 void har_install_action_hook(har *h, har_action_hook_cb hook, void *data);
 void har_install_hook(har *h, har_hook_cb hook, void *data);
 void har_bootstrap(object *obj);
@@ -182,4 +188,9 @@ int har_is_walking(har *h);
 int har_is_blocking(har *h, af_move *move);
 void har_copy_actions(object *new, object *old);
 
+void har_snapshot_create(har_snapshot *snap);
+void har_snapshot_free(har_snapshot *snap);
+void har_snapshot_save(const object *obj, har_snapshot *snap);
+void har_snapshot_restore(object *obj, const har_snapshot *snap);
+
 #endif // HAR_H
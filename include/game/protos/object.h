@@ -7,6 +7,7 @@
 #include "resources/sprite.h"
 #include "utils/hashmap.h"
 #include "utils/random.h"
+#include "utils/slotmap.h"
 #include "utils/vec.h"
 #include "video/screen_palette.h"
 #include "video/surface.h"
@@ -59,6 +60,8 @@ typedef int (*object_palette_transform_cb)(object *obj, screen_palette *pal);
 
 struct object_t {
     game_state *gs;
+    // Handle of the object in the game state, SLOT_HANDLE_NONE if it has not been added to it
+    slot_handle handle;
 
     vec2f start;
     vec2f pos;
@@ -129,6 +132,14 @@ struct object_t {
     object_palette_transform_cb pal_transform;
 };
 
+// State of an object at some point, for restoring it in place later
+typedef struct object_snapshot_t {
+    object obj;             ///< Copy of the object
+    char *custom_str;       ///< Copy of the custom animation string, if has_custom_str is set
+    size_t custom_str_size; ///< Size of the custom_str buffer
+    int has_custom_str;     ///< Whether the object had a custom animation string
+} object_snapshot;
+
 void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel);
 void object_render(object *obj);
 void object_render_shadow(object *obj);
@@ -147,6 +158,11 @@ void object_free(object *obj);
 int object_serialize(object *obj, serial *ser);
 int object_unserialize(object *obj, serial *ser, game_state *gs);
 
+void object_snapshot_create(object_snapshot *snap);
+void object_snapshot_free(object_snapshot *snap);
+void object_snapshot_save(const object *obj, object_snapshot *snap);
+void object_snapshot_restore(object *obj, const object_snapshot *snap);
+
 void object_attach_to(object *obj, const object *attach_to);
 
 void object_set_stride(object *obj, int stride);
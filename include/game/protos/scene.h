@@ -24,11 +24,15 @@ typedef void (*scene_tick_cb)(scene *scene, int paused);
 typedef void (*scene_input_poll_cb)(scene *scene);
 typedef void (*scene_startup_cb)(scene *scene, int anim_id, int *m_load, int *m_repeat);
 typedef int (*scene_anim_prio_override_cb)(scene *scene, int anim_id);
+typedef void (*scene_serialize_cb)(scene *scene, serial *ser);
+typedef void (*scene_unserialize_cb)(scene *scene, serial *ser);
 
 struct scene_t {
     game_state *gs;
     int id;
-    bk bk_data;
+    bk *bk_data;        ///< Shared through the resource cache, and must not be modified
+    char stl[30];       ///< Sound translation table of the scene, copied from the BK
+    surface background; ///< Background of the scene, copied from the BK
     af *af_data[2];
     void *userdata;
 
@@ -41,6 +45,8 @@ struct scene_t {
     scene_input_poll_cb input_poll;
     scene_startup_cb startup;
     scene_anim_prio_override_cb prio_override;
+    scene_serialize_cb serialize;
+    scene_unserialize_cb unserialize;
     ticktimer tick_timer;
 };
 
@@ -72,6 +78,8 @@ void scene_set_static_tick_cb(scene *scene, scene_tick_cb cbfunc);
 void scene_set_input_poll_cb(scene *scene, scene_input_poll_cb cbfunc);
 void scene_set_startup_cb(scene *scene, scene_startup_cb cbfunc);
 void scene_set_anim_prio_override_cb(scene *scene, scene_anim_prio_override_cb cbfunc);
+void scene_set_serialize_cb(scene *scene, scene_serialize_cb cbfunc);
+void scene_set_unserialize_cb(scene *scene, scene_unserialize_cb cbfunc);
 void cb_scene_spawn_object(object *parent, int id, vec2i pos, vec2f vel, uint8_t flags, int s, int g, void *userdata);
 void cb_scene_destroy_object(object *parent, int id, void *userdata);
 
@@ -0,0 +1,40 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <stdint.h>
+
+// Records how long each part of the main loop takes, for the last few hundred frames. The recorded
+// frames can be shown as a graph on top of the game, or written out for inspection elsewhere.
+
+typedef enum
+{
+    FRAME_SECTION_EVENTS = 0,
+    FRAME_SECTION_CONTROLLERS,
+    FRAME_SECTION_STATIC_TICK,
+    FRAME_SECTION_DYNAMIC_TICK,
+    FRAME_SECTION_AUDIO,
+    FRAME_SECTION_RENDER,
+    FRAME_SECTION_CONSOLE,
+    FRAME_SECTION_PRESENT,
+    FRAME_SECTION_COUNT
+} frame_section;
+
+void frame_profiler_close();
+
+void frame_profiler_begin_frame();
+void frame_profiler_end_frame();
+
+// A section may be run several times during a frame; the time of all the runs is added up.
+uint64_t frame_profiler_begin();
+void frame_profiler_end(frame_section section, uint64_t start);
+
+void frame_profiler_toggle_overlay();
+void frame_profiler_render();
+
+// Write the recorded frames out. Returns 0 on success.
+int frame_profiler_write_csv(const char *filename);
+int frame_profiler_write_trace(const char *filename);
+
+const char *frame_profiler_get_name(frame_section section);
+
+#endif // FRAME_PROFILER_H
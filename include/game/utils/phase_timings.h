@@ -0,0 +1,28 @@
+#ifndef PHASE_TIMINGS_H
+#define PHASE_TIMINGS_H
+
+#include <stdint.h>
+
+typedef enum
+{
+    PHASE_CLEANUP = 0,
+    PHASE_CALL_MOVE,
+    PHASE_CALL_COLLIDE,
+    PHASE_CALL_TICK,
+    PHASE_SCENE_DYNAMIC_TICK,
+    PHASE_RENDER,
+    PHASE_COUNT
+} phase_id;
+
+typedef struct phase_timings_t {
+    uint64_t total[PHASE_COUNT]; ///< Accumulated performance counter ticks per phase
+    uint64_t calls[PHASE_COUNT]; ///< Number of times each phase has been run
+} phase_timings;
+
+void phase_timings_reset(phase_timings *t);
+uint64_t phase_timings_begin(const phase_timings *t);
+void phase_timings_end(phase_timings *t, phase_id phase, uint64_t start);
+double phase_timings_get_ms(const phase_timings *t, phase_id phase);
+const char *phase_timings_get_name(phase_id phase);
+
+#endif // PHASE_TIMINGS_H
@@ -0,0 +1,35 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "utils/vector.h"
+
+// Objects are queued for rendering into bands, which are drawn in the order below. Within a band,
+// objects are drawn in the order they were queued, so queueing the objects in game state order
+// yields a queue sorted by (band, insertion order) without any sorting.
+typedef enum
+{
+    RENDER_BAND_BOTTOM = 0,   ///< Objects on the bottom layer
+    RENDER_BAND_SHADOWS,      ///< Shadows of all objects, HARs included
+    RENDER_BAND_PASSIVE_HARS, ///< HARs that are not attacking, in player order
+    RENDER_BAND_MIDDLE,       ///< Objects on the middle layer
+    RENDER_BAND_ACTIVE_HARS,  ///< Attacking HARs, in player order
+    RENDER_BAND_TOP,          ///< Objects on the top layer
+    RENDER_BAND_COUNT
+} render_band;
+
+typedef struct object_t object;
+
+typedef struct render_queue_t {
+    vector bands[RENDER_BAND_COUNT]; ///< Queued object pointers per band
+} render_queue;
+
+void render_queue_create(render_queue *queue);
+void render_queue_free(render_queue *queue);
+void render_queue_clear(render_queue *queue);
+void render_queue_add(render_queue *queue, render_band band, object *obj);
+unsigned int render_queue_size(const render_queue *queue);
+
+// Draws everything in the queue. Sprites end up in the video draw list in queue order.
+void render_queue_render(const render_queue *queue);
+
+#endif // RENDER_QUEUE_H
@@ -0,0 +1,92 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include "game/utils/snapshot.h"
+#include <stdint.h>
+
+// Rollback netplay. Both peers run the whole simulation, and only the inputs are sent over the
+// network, tagged with the tick they belong to. Inputs of the remote player that have not arrived
+// yet are guessed by repeating the last known one. When a late input turns out to differ from the
+// guess, the game state is restored from the snapshot taken at the start of that tick, and the
+// ticks since then are simulated again with the right inputs.
+//
+// Snapshots are taken in place, see snapshot.h. Objects that are left out of those (eg. round
+// markers) are not rolled back.
+
+// Number of ticks kept in the buffer. The simulation never runs more ticks ahead of the inputs of
+// the remote player than this, since it would not be able to roll back that far.
+#define ROLLBACK_FRAMES 32
+
+// Number of remote inputs kept. The peer's inputs may run up to ROLLBACK_FRAMES - 1 ticks ahead of
+// the simulation, and the inputs of the ticks that may still be rolled back must stay around too.
+#define ROLLBACK_REMOTE_FRAMES (2 * ROLLBACK_FRAMES)
+
+// Actions a player may make during a single tick
+#define ROLLBACK_MAX_ACTIONS 4
+
+typedef struct rollback_input_t {
+    uint8_t count;
+    uint16_t actions[ROLLBACK_MAX_ACTIONS];
+} rollback_input;
+
+typedef struct rollback_frame_t {
+    unsigned int tick;       ///< Tick of the frame
+    snapshot snapshot;       ///< Game state at the start of the tick, before any input
+    rollback_input input[2]; ///< Inputs applied on the tick. The remote one may be a guess.
+} rollback_frame;
+
+typedef struct rollback_stats_t {
+    unsigned int saves;          ///< Snapshots taken
+    unsigned int rollbacks;      ///< Times the game state was restored
+    unsigned int resim_ticks;    ///< Ticks simulated again after a restore
+    unsigned int max_depth;      ///< Most ticks simulated again after a single restore
+    unsigned int mispredictions; ///< Remote inputs that did not match the guess
+    uint64_t save_time;          ///< Performance counter ticks spent taking snapshots
+    uint64_t restore_time;       ///< Performance counter ticks spent restoring snapshots
+    uint64_t resim_time;         ///< Performance counter ticks spent simulating ticks again
+} rollback_stats;
+
+typedef struct rollback_t {
+    rollback_frame frames[ROLLBACK_FRAMES];
+    rollback_input remote[ROLLBACK_REMOTE_FRAMES]; ///< Inputs received from the remote player, by tick
+    rollback_input local_input;                    ///< Local actions of the tick being gathered
+    int local;                                     ///< Player id of the local player
+    unsigned int tick;                             ///< Next tick to simulate
+    unsigned int confirmed_tick;                   ///< Remote inputs are known up to this tick
+    unsigned int rollback_tick;                    ///< First mispredicted tick, if any
+    int mispredicted;                              ///< Set when the state needs to be rolled back
+    int resimulating;                              ///< Set while ticks are being simulated again
+    unsigned int resim_tick;                       ///< Tick being simulated again
+    rollback_stats stats;
+} rollback;
+
+void rollback_create(rollback *rb, int local_player);
+void rollback_free(rollback *rb);
+int rollback_get_local(const rollback *rb);
+unsigned int rollback_get_tick(const rollback *rb);
+
+// Returns 0 if the next tick cannot be simulated yet, because the remote player is too far behind.
+int rollback_can_advance(const rollback *rb);
+
+// Adds an action of the local player for the tick that is being gathered.
+void rollback_add_local_action(rollback *rb, int action);
+
+// Copies the local input of a tick that has been simulated, for sending it to the peer.
+// Returns 0 on success, 1 if the tick is not in the buffer.
+int rollback_get_local_input(const rollback *rb, unsigned int tick, rollback_input *input);
+
+// Adds the input of the remote player for a tick. Inputs must be added in order, one per tick.
+// Returns 0 on success, 1 if the input is not the next one expected, or too far ahead of the simulation.
+int rollback_add_remote_input(rollback *rb, unsigned int tick, const rollback_input *input);
+
+// Called by the game state at the start of every simulated tick. Rolls back and simulates again
+// if a misprediction has been found, and then takes the snapshot of the tick.
+void rollback_update(rollback *rb, game_state *gs);
+void rollback_save(rollback *rb, game_state *gs);
+
+// Called by the game state before the objects are ticked. Applies the inputs of both players.
+void rollback_apply_inputs(rollback *rb, game_state *gs);
+
+const rollback_stats *rollback_get_stats(const rollback *rb);
+
+#endif // ROLLBACK_H
@@ -35,6 +35,13 @@ typedef struct chr_score_t {
     int destruction;
 } chr_score;
 
+// State of a score at some point, for restoring it in place later
+typedef struct chr_score_snapshot_t {
+    chr_score score;         ///< Copy of the counters. Its list of texts is not used.
+    unsigned int text_count; ///< Number of texts in the buffer below
+    serial texts;            ///< Texts that were still sliding, along with the points they add
+} chr_score_snapshot;
+
 void chr_score_create(chr_score *score);
 void chr_score_set_difficulty(chr_score *score, int difficulty);
 void chr_score_reset(chr_score *score, int wipe);
@@ -58,4 +65,9 @@ int chr_score_interrupt(chr_score *score, vec2i pos);
 void chr_score_serialize(chr_score *score, serial *ser);
 void chr_score_unserialize(chr_score *score, serial *ser);
 
+void chr_score_snapshot_create(chr_score_snapshot *snap);
+void chr_score_snapshot_free(chr_score_snapshot *snap);
+void chr_score_snapshot_save(const chr_score *score, chr_score_snapshot *snap);
+void chr_score_snapshot_restore(chr_score *score, chr_score_snapshot *snap);
+
 #endif // SCORE_H
@@ -53,6 +53,7 @@ typedef struct {
     int crossfade_on;
     char *scaler;
     int scale_factor;
+    int texture_budget; ///< Texture cache size in megabytes
 } settings_video;
 
 typedef struct {
@@ -118,6 +119,8 @@ typedef struct {
     char *net_connect_ip;
     int net_connect_port;
     int net_listen_port;
+    int net_rollback;      ///< Run the game on both ends with rollback. A peer with a different setting is refused.
+    int net_sync_compress; ///< Run-length compress state syncs when that makes them smaller
 } settings_network;
 
 typedef struct {
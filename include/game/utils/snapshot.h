@@ -0,0 +1,39 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "game/objects/har.h"
+#include "game/utils/score.h"
+#include "game/utils/serial.h"
+#include <stdint.h>
+
+// Snapshot of the simulation state, restored in place. Unlike game_state_serialize() and
+// game_state_restore(), the HARs are copied as they are into preallocated memory, and written
+// back over the same objects without freeing them or looking up their animations again. This
+// makes saving and restoring cheap enough to do on every tick.
+//
+// Projectiles come and go, so they are still serialized. There usually are none, in which case
+// they cost next to nothing. Objects that game_state_serialize() leaves out are left out here too.
+
+typedef struct game_state_t game_state;
+
+typedef struct snapshot_t {
+    unsigned int tick;             ///< Tick of the game state
+    uint32_t seed;                 ///< Seed of the random number generator of the game state
+    unsigned int paused;           ///< Whether the game state was paused
+    har_snapshot hars[2];          ///< State of the HARs of both players
+    chr_score_snapshot scores[2];  ///< Scores of both players
+    unsigned int projectile_count; ///< Number of projectiles in the buffer below
+    serial projectiles;            ///< Projectiles, as written by object_serialize()
+    serial scene;                  ///< State of the scene, as written by scene_serialize()
+} snapshot;
+
+void snapshot_create(snapshot *snap);
+void snapshot_free(snapshot *snap);
+
+// Takes a snapshot of the game state. Both players must have a HAR.
+void snapshot_save(snapshot *snap, game_state *gs);
+
+// Restores the game state from a snapshot taken of it during the same scene.
+void snapshot_restore(snapshot *snap, game_state *gs);
+
+#endif // SNAPSHOT_H
@@ -2,6 +2,20 @@
 #define AF_H
 
 #include "resources/af_move.h"
+#include <stdint.h>
+
+#define AF_MOVE_COUNT 70
+#define AF_MOVE_MASK_WORDS ((AF_MOVE_COUNT + 31) / 32)
+#define AF_MOVE_CATEGORIES 16
+
+// Node of the move string trie. Children are kept as a sibling list, since only a handful
+// of different input characters ever follow any given prefix.
+typedef struct af_move_node_t {
+    char c;
+    int16_t child;
+    int16_t sibling;
+    uint32_t moves[AF_MOVE_MASK_WORDS]; ///< Moves whose move string ends at this node
+} af_move_node;
 
 typedef struct af_t {
     unsigned int id;
@@ -11,12 +25,24 @@ typedef struct af_t {
     float reverse_speed;
     float jump_speed;
     float fall_speed;
-    af_move moves[70];
+    af_move moves[AF_MOVE_COUNT];
     char sound_translation_table[30];
+    af_move_node *move_nodes;
+    int move_node_count;
+    uint32_t category_moves[AF_MOVE_CATEGORIES][AF_MOVE_MASK_WORDS];
 } af;
 
 void af_create(af *a, void *src);
 af_move *af_get_move(af *a, int id);
 void af_free(af *a);
 
+// Sets the bits of all moves whose move string is a prefix of the given input buffer
+void af_match_moves(const af *a, const char *inputs, uint32_t mask[AF_MOVE_MASK_WORDS]);
+
+// Sets the bits of all moves belonging to the given category
+void af_category_moves(const af *a, int category, uint32_t mask[AF_MOVE_MASK_WORDS]);
+
+// Returns the first move id in the mask that is >= from, or -1 if there are no more.
+int af_next_move(const uint32_t mask[AF_MOVE_MASK_WORDS], int from);
+
 #endif // AF_H
@@ -4,5 +4,6 @@
 #include "resources/af.h"
 
 int load_af_file(af *a, int id);
+int load_af_path(af *a, const char *filename);
 
 #endif // AF_LOADER_H
@@ -0,0 +1,31 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include "resources/af.h"
+#include "resources/bk.h"
+
+// Asset packs hold BK and AF files in the form the game uses them in memory: sprites are stored
+// as decoded 8-bit pixels with their stencils, and HARs come with their move lookup tables. Packs
+// are baked from the original game files with packtool, and contain an index of the resources in
+// the header so that each resource can be read with a single seek.
+//
+// Packs are written in the byte order of the machine that baked them, and are tied to a format
+// version. Packs that do not match are ignored, and resources are then decoded from the game files.
+
+#define ASSET_PACK_VERSION 1
+
+typedef struct asset_pack_writer_t asset_pack_writer;
+
+int asset_pack_open(const char *filename);
+void asset_pack_close();
+
+// Both return 0 if the resource was found in the pack and loaded, 1 otherwise.
+int asset_pack_load_bk(bk *b, int resource_id);
+int asset_pack_load_af(af *a, int resource_id);
+
+asset_pack_writer *asset_pack_writer_open(const char *filename);
+void asset_pack_write_bk(asset_pack_writer *writer, int resource_id, const bk *b);
+void asset_pack_write_af(asset_pack_writer *writer, int resource_id, const af *a);
+int asset_pack_writer_close(asset_pack_writer *writer);
+
+#endif // ASSET_PACK_H
@@ -4,5 +4,6 @@
 #include "resources/bk.h"
 
 int load_bk_file(bk *b, int id);
+int load_bk_path(bk *b, const char *filename);
 
 #endif // BK_LOADER_H
@@ -0,0 +1,41 @@
+#ifndef RESOURCE_CACHE_H
+#define RESOURCE_CACHE_H
+
+#include "resources/af.h"
+#include "resources/bk.h"
+#include <stddef.h>
+
+// Decoded BK and AF files are shared between scenes, and kept around after their last user
+// is gone until the memory budget runs out. Instances handed out by the cache must be treated
+// as read-only, and given back with the matching release function.
+//
+// Resources that will be needed soon can be prefetched. They are then decoded on a loader
+// thread, and a later get only has to pick up the finished result.
+//
+// The cache may be used by game states running on several threads at once. Resources are decoded
+// without holding the cache lock, so different resources can be loaded in parallel.
+
+#define RESOURCE_CACHE_BUDGET (48 * 1024 * 1024)
+
+typedef struct resource_cache_stats_t {
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions;
+    unsigned int prefetches; ///< Resources decoded ahead of time by the loader thread
+    unsigned int entries;
+    size_t bytes; ///< Approximate memory held by the cached resources
+} resource_cache_stats;
+
+void resource_cache_init(size_t budget);
+void resource_cache_close();
+
+bk *resource_cache_get_bk(int resource_id);
+af *resource_cache_get_af(int resource_id);
+void resource_cache_prefetch_bk(int resource_id);
+void resource_cache_prefetch_af(int resource_id);
+void resource_cache_release_bk(bk *b);
+void resource_cache_release_af(af *a);
+
+void resource_cache_get_stats(resource_cache_stats *stats);
+
+#endif // RESOURCE_CACHE_H
@@ -0,0 +1,36 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <stddef.h>
+
+// Delta encoding of a buffer against an older version of it, for sending state that mostly stays
+// the same. The buffers are compared in blocks of 8 bytes. Every block gets a bit telling whether
+// it has changed, and changed blocks get a mask of their changed bytes followed by those bytes
+// XORed with the base. All of it is packed into a bitstream, so an unchanged block costs a
+// single bit. Without a base, the buffer is encoded against zeroes, which skips the zero bytes.
+//
+// The encoded data can further be run-length compressed. This is cheap, but only helps when the
+// changes repeat, so it is up to the caller whether it is worth it.
+
+// Largest size that delta_encode() may write for a buffer of len bytes.
+size_t delta_encode_bound(size_t len);
+
+// Encodes len bytes of data against base_len bytes of base into out, and returns the size
+// written. Base may be NULL if base_len is 0. Bytes past the end of the base count as zeroes.
+size_t delta_encode(const char *base, size_t base_len, const char *data, size_t len, char *out);
+
+// Decodes len bytes from in_len bytes of encoded data, against the base they were encoded with.
+// Returns 0 on success, 1 if the encoded data is cut short or corrupt.
+int delta_decode(const char *base, size_t base_len, const char *in, size_t in_len, char *out, size_t len);
+
+// Largest size that delta_compress() may write for len bytes of input.
+size_t delta_compress_bound(size_t len);
+
+// Run-length compresses len bytes of in into out, and returns the size written.
+size_t delta_compress(const char *in, size_t len, char *out);
+
+// Decompresses in_len bytes of in into out, which can hold out_len bytes. Returns the size
+// written, or 0 if the compressed data is corrupt or does not fit.
+size_t delta_decompress(const char *in, size_t in_len, char *out, size_t out_len);
+
+#endif // DELTA_H
@@ -0,0 +1,47 @@
+#ifndef FLATMAP_H
+#define FLATMAP_H
+
+#include "utils/iterator.h"
+#include <stdint.h>
+
+// Hash table for fixed size keys and values. Entries are stored inline in a single table with
+// open addressing (robin hood probing, backward shift deletion), so inserts do not allocate
+// except when the table grows, and lookups touch a few neighbouring entries instead of a chain
+// of nodes. Keys are compared byte by byte, so any padding in a key struct must be zeroed.
+//
+// Value pointers returned by the functions below are only valid until the next put or delete,
+// since both may move entries around.
+
+typedef struct flatmap_t {
+    char *data;              ///< Entry table; each entry holds the hash, the key and the value
+    char *scratch;           ///< Room for two entries, used when entries are swapped around
+    unsigned int key_size;   ///< Size of a key
+    unsigned int val_size;   ///< Size of a value
+    unsigned int val_offset; ///< Offset of the value in an entry
+    unsigned int entry_size; ///< Size of an entry
+    unsigned int capacity;   ///< Entries in the table; always a power of two
+    unsigned int count;      ///< Entries in use
+} flatmap;
+
+void flatmap_create(flatmap *map, unsigned int key_size, unsigned int val_size);
+void flatmap_free(flatmap *map);
+void flatmap_clear(flatmap *map);
+unsigned int flatmap_size(const flatmap *map);
+unsigned int flatmap_capacity(const flatmap *map);
+
+// Inserts or replaces the value of the key. Returns a pointer to the stored value.
+void *flatmap_put(flatmap *map, const void *key, const void *val);
+
+// Returns a pointer to the value of the key, or NULL if the key is not in the map.
+void *flatmap_get(const flatmap *map, const void *key);
+
+// Returns 0 if the key was removed, 1 if it was not in the map.
+int flatmap_del(flatmap *map, const void *key);
+
+// Iterators return pointers to values. Entries may be removed with flatmap_delete() while
+// iterating, but nothing may be inserted.
+void flatmap_iter_begin(const flatmap *map, iterator *iter);
+const void *flatmap_iter_key(const flatmap *map, const iterator *iter);
+int flatmap_delete(flatmap *map, iterator *iter);
+
+#endif // FLATMAP_H
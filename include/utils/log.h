@@ -13,8 +13,15 @@
 #define INFO(...) log_print('I', NULL, __VA_ARGS__)
 #endif
 
+// Each thread that ticks a game state logs its own tick
+#if defined(_MSC_VER)
+#define LOG_THREAD_LOCAL __declspec(thread)
+#else
+#define LOG_THREAD_LOCAL _Thread_local
+#endif
+
 #define LOGTICK(x) _log_tick = x;
-extern unsigned int _log_tick;
+extern LOG_THREAD_LOCAL unsigned int _log_tick;
 
 void log_hide(char mode, const char *fn, const char *fmt, ...); // no-op
 void log_print(char mode, const char *fn, const char *fmt, ...);
@@ -0,0 +1,36 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "utils/vector.h"
+
+// Fixed size allocator for objects that are created and destroyed at a high rate. Memory is
+// taken from the system in slabs of several items, and released items are recycled in O(1)
+// through a free list. Slabs are only returned to the system when the whole pool is freed.
+//
+// In debug builds released items are poisoned, and writes to released items are reported
+// when the item is handed out again.
+
+typedef struct pool_stats_t {
+    unsigned int allocs;   ///< Items handed out in total
+    unsigned int releases; ///< Items given back in total
+    unsigned int in_use;   ///< Items currently handed out
+    unsigned int peak;     ///< Highest number of items in use at once
+    unsigned int slabs;    ///< Slabs taken from the system
+} pool_stats;
+
+typedef struct pool_t {
+    unsigned int item_size;
+    unsigned int slab_items;
+    vector slabs;
+    void *free_list;
+    pool_stats stats;
+} pool;
+
+void pool_create(pool *pool, unsigned int item_size, unsigned int slab_items);
+void pool_free(pool *pool);
+void *pool_alloc(pool *pool);
+void pool_release(pool *pool, void *ptr);
+int pool_owns(const pool *pool, const void *ptr);
+void pool_get_stats(const pool *pool, pool_stats *stats);
+
+#endif // POOL_H
@@ -0,0 +1,53 @@
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+
+#include "utils/iterator.h"
+#include <stdint.h>
+
+// Container for items that are referred to by handles. Items are kept in insertion order, and a
+// handle stays valid until its item is removed; handles of removed items are detected through
+// the generation counter of the slot, even if the slot has been reused since.
+//
+// Removing an item only leaves a tombstone in its place, so it is O(1) and safe to do while
+// iterating. The tombstones are dropped by slotmap_compact(), which keeps the order of the
+// remaining items. Item pointers are valid until the next insert or compaction.
+
+typedef uint32_t slot_handle;
+
+#define SLOT_HANDLE_NONE 0
+
+typedef struct slotmap_slot_t slotmap_slot;
+
+typedef struct slotmap_t {
+    char *items;                ///< Items in insertion order, including the removed ones
+    unsigned int *owners;       ///< Slot of each item, or NO_SLOT if the item has been removed
+    unsigned int item_size;     ///< Size of a single item
+    unsigned int count;         ///< Items in the item table, including the removed ones
+    unsigned int reserved;      ///< Space in the item table
+    unsigned int removed;       ///< Removed items that are waiting for compaction
+    slotmap_slot *slots;        ///< Slot table
+    unsigned int slot_count;    ///< Slots taken into use
+    unsigned int slot_reserved; ///< Space in the slot table
+    unsigned int free_slot;     ///< First slot in the free list
+} slotmap;
+
+void slotmap_create(slotmap *map, unsigned int item_size);
+void slotmap_free(slotmap *map);
+void slotmap_clear(slotmap *map);
+slot_handle slotmap_insert(slotmap *map, const void *item);
+void *slotmap_get(const slotmap *map, slot_handle handle);
+int slotmap_remove(slotmap *map, slot_handle handle);
+void slotmap_compact(slotmap *map);
+unsigned int slotmap_size(const slotmap *map);
+
+// Items can also be visited by position. Positions of removed items return NULL.
+unsigned int slotmap_span(const slotmap *map);
+void *slotmap_get_at(const slotmap *map, unsigned int pos);
+
+// Iterators visit the items in insertion order. Items that are inserted during iteration are visited
+// as well, unless the iterator has already passed the last item.
+void slotmap_iter_begin(const slotmap *map, iterator *iter);
+slot_handle slotmap_iter_handle(const slotmap *map, const iterator *iter);
+int slotmap_delete(slotmap *map, iterator *iter);
+
+#endif // SLOTMAP_H
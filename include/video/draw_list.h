@@ -0,0 +1,34 @@
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include <SDL.h>
+
+// Sprite draws are recorded into a list instead of being submitted to the renderer right away.
+// Consecutive quads that share a target, texture and blend mode are submitted with a single
+// geometry call when the list is flushed. Draw order is always preserved.
+
+typedef struct draw_list_stats_t {
+    unsigned int draws;       ///< Quads recorded
+    unsigned int submissions; ///< Geometry submissions to the renderer
+    unsigned int flushes;     ///< Times the list was flushed
+} draw_list_stats;
+
+void draw_list_init(SDL_Renderer *renderer);
+void draw_list_reinit(SDL_Renderer *renderer);
+void draw_list_close();
+
+void draw_list_add(SDL_Texture *target, SDL_Texture *tex, SDL_BlendMode blend_mode, const SDL_Rect *src,
+                   const SDL_Rect *dst, SDL_RendererFlip flip, SDL_Color color);
+
+// Submits all recorded quads. Must be called before anything reads or changes the render
+// targets or textures referenced by the list.
+void draw_list_flush();
+
+// Drops all recorded quads without rendering them
+void draw_list_discard();
+
+// Ends the current frame; the statistics of the frame can then be read with draw_list_get_stats.
+void draw_list_end_frame();
+void draw_list_get_stats(draw_list_stats *stats);
+
+#endif // DRAW_LIST_H
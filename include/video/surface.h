@@ -13,6 +13,7 @@ typedef struct {
     char *data;
     char *stencil;
     uint8_t force_refresh;
+    uint32_t guid; ///< Unique for every created surface
 } surface;
 
 enum
@@ -41,6 +42,7 @@ void surface_sub(surface *dst, surface *src, int dst_x, int dst_y, int src_x, in
 void surface_convert_to_rgba(surface *sur, screen_palette *pal, int pal_offset);
 int surface_get_type(surface *sur);
 void surface_to_rgba(surface *sur, char *dst, screen_palette *pal, char *remap_table, uint8_t pal_offset);
+void surface_to_rgba_scalar(surface *sur, char *dst, screen_palette *pal, char *remap_table, uint8_t pal_offset);
 void surface_additive_blit(surface *dst, surface *src, int dst_x, int dst_y, palette *remap_pal, SDL_RendererFlip flip);
 void surface_rgba_blit(surface *dst, const surface *src, int dst_x, int dst_y);
 void surface_alpha_blit(surface *dst, surface *src, int dst_x, int dst_y, SDL_RendererFlip flip);
@@ -6,11 +6,28 @@
 #include "video/surface.h"
 #include <SDL.h>
 
+typedef struct tcache_stats_t {
+    unsigned int hits;    ///< Lookups that found a valid texture
+    unsigned int misses;  ///< Lookups that had to create a new texture
+    unsigned int uploads; ///< Texture updates, both for new textures and for changed surfaces
+} tcache_stats;
+
 void tcache_init(SDL_Renderer *renderer, int scale_factor, scaler_plugin *scaler);
 void tcache_reinit(SDL_Renderer *renderer, int scale_factor, scaler_plugin *scaler);
 void tcache_close();
 void tcache_clear();
-SDL_Texture *tcache_get(surface *sur, screen_palette *pal, char *remap_table, uint8_t pal_offset);
-void tcache_tick();
+// Returns the texture holding the surface, and the area of the texture it occupies in rect.
+// Small surfaces are packed into shared atlas textures, so the rect must always be used as the
+// source rectangle when rendering.
+SDL_Texture *tcache_get(surface *sur, screen_palette *pal, char *remap_table, uint8_t pal_offset, SDL_Rect *rect);
+
+// Sets the amount of texture memory the cache may hold before old textures are evicted
+void tcache_set_budget(size_t bytes);
+
+// Advances the frame counter used for eviction. Must be called after the draw list has been flushed.
+void tcache_end_frame();
+
+// Returns the counters accumulated since the cache was created
+void tcache_get_stats(tcache_stats *stats);
 
 #endif // TCACHE_H
@@ -26,6 +26,8 @@ enum VIDEO_FLIP_MODE
 };
 
 int video_init(int window_w, int window_h, int fullscreen, int vsync, const char *scaler_name, int scale_factor);
+int video_init_null();
+int video_is_null();
 int video_reinit(int window_w, int window_h, int fullscreen, int vsync, const char *scaler_name, int scale_factor);
 void video_reinit_renderer();
 void video_get_state(int *w, int *h, int *fs, int *vsync);
@@ -46,7 +48,7 @@ void video_render_sprite_flip_scale_opacity(surface *sur, int x, int y, unsigned
 void video_render_sprite_flip_scale_opacity_tint(surface *sur, int x, int y, unsigned int render_mode, int pal_offset,
                                                  unsigned int flip_mode, float y_percent, uint8_t opacity, color tint);
 
-void video_tick();
+void video_set_texture_budget(unsigned int megabytes);
 void video_render_background(surface *sur);
 void video_render_prepare();
 void video_render_finish();
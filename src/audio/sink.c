@@ -7,9 +7,8 @@ audio_stream *sink_get_stream(audio_sink *sink, unsigned int sid) {
         return NULL;
     if(sink == NULL)
         return NULL;
-    audio_stream **s;
-    unsigned int len;
-    if(hashmap_iget(&sink->streams, sid, (void **)&s, &len) != 0) {
+    audio_stream **s = flatmap_get(&sink->streams, &sid);
+    if(s == NULL) {
         return NULL;
     }
     return *s;
@@ -19,7 +18,7 @@ void sink_init(audio_sink *sink) {
     sink->userdata = NULL;
     sink->close = NULL;
     sink->format_stream = NULL;
-    hashmap_create(&sink->streams, 6);
+    flatmap_create(&sink->streams, sizeof(unsigned int), sizeof(audio_stream *));
 }
 
 void sink_format_stream(audio_sink *sink, audio_stream *stream) {
@@ -41,7 +40,8 @@ void sink_play(audio_sink *sink, audio_source *src, int id, float volume, float
     stream->panning = panning;
     stream->pitch = pitch;
     stream_play(stream);
-    hashmap_iput(&sink->streams, id, &stream, sizeof(audio_stream *));
+    unsigned int sid = id;
+    flatmap_put(&sink->streams, &sid, &stream);
 }
 
 void sink_stop(audio_sink *sink, int sid) {
@@ -50,15 +50,16 @@ void sink_stop(audio_sink *sink, int sid) {
     stream_stop(s);
     stream_free(s);
     omf_free(s);
-    hashmap_idel(&sink->streams, sid);
+    unsigned int key = sid;
+    flatmap_del(&sink->streams, &key);
 }
 
 void sink_render(audio_sink *sink) {
     iterator it;
-    hashmap_iter_begin(&sink->streams, &it);
-    hashmap_pair *pair;
-    while((pair = iter_next(&it)) != NULL) {
-        audio_stream *stream = *((audio_stream **)pair->val);
+    audio_stream **s;
+    flatmap_iter_begin(&sink->streams, &it);
+    while((s = iter_next(&it)) != NULL) {
+        audio_stream *stream = *s;
         stream_render(stream);
 
         // If stream is done, free it here.
@@ -66,7 +67,7 @@ void sink_render(audio_sink *sink) {
             stream_stop(stream);
             stream_free(stream);
             omf_free(stream);
-            hashmap_delete(&sink->streams, &it);
+            flatmap_delete(&sink->streams, &it);
         }
     }
 }
@@ -74,15 +75,15 @@ void sink_render(audio_sink *sink) {
 void sink_free(audio_sink *sink) {
     // Free streams
     iterator it;
-    hashmap_iter_begin(&sink->streams, &it);
-    hashmap_pair *pair;
-    while((pair = iter_next(&it)) != NULL) {
-        audio_stream *stream = *((audio_stream **)pair->val);
+    audio_stream **s;
+    flatmap_iter_begin(&sink->streams, &it);
+    while((s = iter_next(&it)) != NULL) {
+        audio_stream *stream = *s;
         stream_stop(stream);
         stream_free(stream);
         omf_free(stream);
     }
-    hashmap_free(&sink->streams);
+    flatmap_free(&sink->streams);
 
     // Close sink
     if(sink->close != NULL) {
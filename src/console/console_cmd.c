@@ -1,7 +1,10 @@
 #include "audio/music.h"
 #include "console/console.h"
 #include "console/console_type.h"
+#include "controller/net_controller.h"
+#include "game/game_player.h"
 #include "game/scenes/arena.h"
+#include "game/utils/frame_profiler.h"
 #include "resources/ids.h"
 #include "utils/allocator.h"
 #include "video/video.h"
@@ -229,6 +232,57 @@ int console_cmd_music(game_state *gs, int argc, char **argv) {
     return 0;
 }
 
+int console_cmd_profile(game_state *gs, int argc, char **argv) {
+    if(argc == 1) {
+        frame_profiler_toggle_overlay();
+        return 0;
+    }
+    if(argc == 3 && strcmp(argv[1], "csv") == 0) {
+        return frame_profiler_write_csv(argv[2]);
+    }
+    if(argc == 3 && strcmp(argv[1], "trace") == 0) {
+        return frame_profiler_write_trace(argv[2]);
+    }
+    return 1;
+}
+
+static double ticks_per_call_us(uint64_t ticks, unsigned int calls) {
+    if(calls == 0) {
+        return 0;
+    }
+    return (double)ticks * 1000000.0 / SDL_GetPerformanceFrequency() / calls;
+}
+
+int console_cmd_netstats(game_state *gs, int argc, char **argv) {
+    char buf[64];
+    int found = 0;
+    for(int i = 0; i < game_state_num_players(gs); i++) {
+        controller *ctrl = game_player_get_ctrl(game_state_get_player(gs, i));
+        if(ctrl == NULL || ctrl->type != CTRL_TYPE_NETWORK) {
+            continue;
+        }
+        found = 1;
+        const net_sync_stats *st = net_controller_get_sync_stats(ctrl);
+        double ratio = st->raw_bytes ? 100.0 * st->sent_bytes / st->raw_bytes : 0;
+        snprintf(buf, sizeof(buf), "Syncs sent: %u, %u full, %u compressed, %u resent", st->sent, st->sent_full,
+                 st->compressed, st->resent);
+        console_output_addline(buf);
+        snprintf(buf, sizeof(buf), "Sent %llu of %llu bytes (%.1f%%)", (unsigned long long)st->sent_bytes,
+                 (unsigned long long)st->raw_bytes, ratio);
+        console_output_addline(buf);
+        snprintf(buf, sizeof(buf), "Serialize %.1f us, encode %.1f us", ticks_per_call_us(st->serialize_time, st->sent),
+                 ticks_per_call_us(st->encode_time, st->sent));
+        console_output_addline(buf);
+        snprintf(buf, sizeof(buf), "Syncs received: %u, %u dropped, decode %.1f us", st->received, st->dropped,
+                 ticks_per_call_us(st->decode_time, st->received));
+        console_output_addline(buf);
+    }
+    if(!found) {
+        console_output_addline("Not in a network game");
+    }
+    return 0;
+}
+
 void console_init_cmd() {
     // Add console commands
     console_add_cmd("h", &console_cmd_history, "show command history");
@@ -248,4 +302,7 @@ void console_init_cmd() {
     console_add_cmd("kreissack", &console_kreissack, "Fight Kreissack");
     console_add_cmd("ez-destruct", &console_cmd_ez_destruct, "Punch = destruction, kick = scrap");
     console_add_cmd("warp", &console_toggle_warp, "Toggle warp speed");
+    console_add_cmd("profile", &console_cmd_profile,
+                    "Toggle frame time graph. usage: profile, profile csv <file>, profile trace <file>");
+    console_add_cmd("netstats", &console_cmd_netstats, "Show the state sync bandwidth of a network game");
 }
@@ -74,6 +74,7 @@ typedef struct ai_t {
     int cur_act;
     int input_lag; // number of ticks to wait per input
     int input_lag_timer;
+    struct random_t *rand; // random number source of the game state
 
     // move stats
     af_move *selected_move;
@@ -219,23 +220,25 @@ void chain_controller_cmd(controller *ctrl, int commands[], size_t n_commands, c
 /**
  * \brief Convenience method to roll '1 in x' chance.
  *
+ * \param a Pointer to the AI; the roll is taken from its random number source.
  * \param roll_x An integer indicating number of numbers in roll.
  *
  * \return A boolean indicating whether the roll passed.
  */
-bool roll_chance(int roll_x) {
-    return roll_x <= 1 ? true : rand_int(roll_x) == 1;
+bool roll_chance(const ai *a, int roll_x) {
+    return roll_x <= 1 ? true : random_int(a->rand, roll_x) == 1;
 }
 
 /**
  * \brief Roll chance for pilot preference.
  *
+ * \param a Pointer to the AI; the roll is taken from its random number source.
  * \param pref_val The value of the pilot preference (-100 to 100)
  *
  * \return A boolean indicating whether the preference is confirmed.
  */
-bool roll_pref(int pref_val) {
-    int rand_roll = rand_int(200);
+bool roll_pref(const ai *a, int pref_val) {
+    int rand_roll = random_int(a->rand, 200);
     int pref_thresh = pref_val + 100;
     return rand_roll <= pref_thresh;
 }
@@ -250,9 +253,9 @@ bool roll_pref(int pref_val) {
 bool smart_usually(const ai *a) {
     if(a->difficulty == 6) {
         // at highest difficulty 92% chance to be smart
-        return !roll_chance(12);
+        return !roll_chance(a, 12);
     } else if(a->difficulty >= 3) {
-        return roll_chance(7 - a->difficulty);
+        return roll_chance(a, 7 - a->difficulty);
     } else {
         return false;
     }
@@ -268,10 +271,10 @@ bool smart_usually(const ai *a) {
 bool dumb_usually(const ai *a) {
     if(a->difficulty == 1) {
         // at lowest difficulty 92% chance to be dumb
-        return !roll_chance(12);
+        return !roll_chance(a, 12);
     }
     if(a->difficulty <= 2) {
-        return roll_chance(a->difficulty + 1);
+        return roll_chance(a, a->difficulty + 1);
     } else {
         return false;
     }
@@ -286,7 +289,7 @@ bool dumb_usually(const ai *a) {
  */
 bool smart_sometimes(const ai *a) {
     if(a->difficulty >= 2) {
-        return roll_chance(10 - a->difficulty);
+        return roll_chance(a, 10 - a->difficulty);
     } else {
         return false;
     }
@@ -301,7 +304,7 @@ bool smart_sometimes(const ai *a) {
  */
 bool dumb_sometimes(const ai *a) {
     if(a->difficulty <= 2) {
-        return roll_chance(a->difficulty + 2);
+        return roll_chance(a, a->difficulty + 2);
     } else {
         return false;
     }
@@ -315,7 +318,7 @@ bool dumb_sometimes(const ai *a) {
  * \return A boolean indicating whether the AI should proceed with an action.
  */
 bool diff_scale(const ai *a) {
-    int roll = rand_int(36);
+    int roll = random_int(a->rand, 36);
     return roll <= (a->difficulty * a->difficulty);
 }
 
@@ -327,7 +330,7 @@ bool diff_scale(const ai *a) {
  * \return A boolean indicating whether the AI should learn.
  */
 bool learning_moment(const ai *a) {
-    float roll = (float)rand_int(diff_scale(a) ? 8 : 15);
+    float roll = (float)random_int(a->rand, diff_scale(a) ? 8 : 15);
     return roll <= a->pilot->learning;
 }
 
@@ -339,7 +342,7 @@ bool learning_moment(const ai *a) {
  * \return A boolean indicating whether the AI should forget.
  */
 bool forgetful(const ai *a) {
-    float roll = (float)rand_int(diff_scale(a) ? 3 : 2);
+    float roll = (float)random_int(a->rand, diff_scale(a) ? 3 : 2);
     return roll <= a->pilot->forget;
 }
 
@@ -470,7 +473,7 @@ bool likes_tactic(const controller *ctrl, int tactic_type) {
     har *h = object_get_userdata(o);
     sd_pilot *pilot = a->pilot;
 
-    if((a->tactic->last_tactic == tactic_type && roll_chance(2)) || h->state == STATE_JUMPING) {
+    if((a->tactic->last_tactic == tactic_type && roll_chance(a, 2)) || h->state == STATE_JUMPING) {
         return false;
     }
 
@@ -480,7 +483,7 @@ bool likes_tactic(const controller *ctrl, int tactic_type) {
 
     switch(tactic_type) {
         case TACTIC_SHOOT:
-            if(har_has_projectiles(h->id) && roll_pref(pilot->att_sniper) && enemy_range > RANGE_CRAMPED &&
+            if(har_has_projectiles(h->id) && roll_pref(a, pilot->att_sniper) && enemy_range > RANGE_CRAMPED &&
                (h->id != HAR_SHREDDER || ((enemy_range <= RANGE_MID && smart_usually(a)) ||
                                           dumb_sometimes(a)) // shredder prefers to be close-mid range
                 )) {
@@ -488,44 +491,46 @@ bool likes_tactic(const controller *ctrl, int tactic_type) {
             }
             break;
         case TACTIC_CLOSE:
-            if(enemy_range > RANGE_CRAMPED && (har_has_charge(h->id) || roll_chance(4)) &&
-               roll_pref(pilot->att_hyper)) {
+            if(enemy_range > RANGE_CRAMPED && (har_has_charge(h->id) || roll_chance(a, 4)) &&
+               roll_pref(a, pilot->att_hyper)) {
                 return true;
             }
             break;
         case TACTIC_QUICK:
             if(enemy_range > RANGE_CRAMPED && enemy_range < RANGE_FAR &&
-               ((roll_pref(pilot->att_sniper) && roll_chance(3)) || (roll_pref(pilot->att_hyper) && roll_chance(6)) ||
-                (roll_pref(pilot->att_normal) && roll_chance(8)))) {
+               ((roll_pref(a, pilot->att_sniper) && roll_chance(a, 3)) ||
+                (roll_pref(a, pilot->att_hyper) && roll_chance(a, 6)) ||
+                (roll_pref(a, pilot->att_normal) && roll_chance(a, 8)))) {
                 return true;
             }
             break;
         case TACTIC_GRAB:
-            if((a->thrown <= MAX_TIMES_THROWN || roll_chance(2)) &&
-               ((roll_pref(pilot->att_hyper) && roll_chance(3)) ||
-                ((h->id == HAR_FLAIL || h->id == HAR_THORN) && roll_chance(3)))) {
+            if((a->thrown <= MAX_TIMES_THROWN || roll_chance(a, 2)) &&
+               ((roll_pref(a, pilot->att_hyper) && roll_chance(a, 3)) ||
+                ((h->id == HAR_FLAIL || h->id == HAR_THORN) && roll_chance(a, 3)))) {
                 return true;
             }
             break;
         case TACTIC_TURTLE:
-            if(a->thrown <= MAX_TIMES_THROWN && ((roll_pref(pilot->att_def) && roll_chance(3)))) {
+            if(a->thrown <= MAX_TIMES_THROWN && ((roll_pref(a, pilot->att_def) && roll_chance(a, 3)))) {
                 return true;
             }
             break;
         case TACTIC_COUNTER:
-            if(a->thrown < MAX_TIMES_THROWN && roll_pref(pilot->att_def) && roll_chance(3)) {
+            if(a->thrown < MAX_TIMES_THROWN && roll_pref(a, pilot->att_def) && roll_chance(a, 3)) {
                 return true;
             }
             break;
         case TACTIC_ESCAPE:
-            if((roll_pref(pilot->att_jump) && roll_chance(3)) || (roll_pref(pilot->att_def) && roll_chance(5))) {
+            if((roll_pref(a, pilot->att_jump) && roll_chance(a, 3)) ||
+               (roll_pref(a, pilot->att_def) && roll_chance(a, 5))) {
                 return true;
             }
             break;
         case TACTIC_FLY:
-            if((roll_pref(a->pilot->att_jump) || (a->shot > MAX_TIMES_SHOT && learning_moment(a)) ||
+            if((roll_pref(a, a->pilot->att_jump) || (a->shot > MAX_TIMES_SHOT && learning_moment(a)) ||
                 (h->id == HAR_GARGOYLE || h->id == HAR_PYROS)) &&
-               ((wall_close && roll_chance(2)) || roll_chance(4))) {
+               ((wall_close && roll_chance(a, 2)) || roll_chance(a, 4))) {
                 return true;
             }
             break;
@@ -533,19 +538,21 @@ bool likes_tactic(const controller *ctrl, int tactic_type) {
             if((enemy_range <= RANGE_CLOSE ||
                 ((h->id == HAR_THORN || h->id == HAR_KATANA) && enemy_range <= RANGE_MID)) &&
                ((har_has_push(h->id) && smart_usually(a)) &&
-                ((roll_pref(pilot->att_hyper) && roll_chance(2)) || (roll_pref(pilot->att_def) && roll_chance(4)) ||
-                 (wall_close && roll_chance(5))))) {
+                ((roll_pref(a, pilot->att_hyper) && roll_chance(a, 2)) ||
+                 (roll_pref(a, pilot->att_def) && roll_chance(a, 4)) || (wall_close && roll_chance(a, 5))))) {
                 return true;
             }
             break;
         case TACTIC_TRIP:
             if(enemy_range <= RANGE_MID &&
-               ((roll_pref(pilot->att_def) && roll_chance(4)) || (roll_pref(pilot->att_sniper) && roll_chance(6)))) {
+               ((roll_pref(a, pilot->att_def) && roll_chance(a, 4)) ||
+                (roll_pref(a, pilot->att_sniper) && roll_chance(a, 6)))) {
                 return true;
             }
             break;
         case TACTIC_SPAM:
-            if((enemy_close || dumb_usually(a)) && (wall_close || roll_chance(6)) && roll_pref(pilot->att_normal)) {
+            if((enemy_close || dumb_usually(a)) && (wall_close || roll_chance(a, 6)) &&
+               roll_pref(a, pilot->att_normal)) {
                 return true;
             }
             break;
@@ -622,12 +629,12 @@ void queue_tactic(controller *ctrl, int tactic_type) {
         case TACTIC_CLOSE:
             if(enemy_close) {
                 a->tactic->move_type = 0;
-            } else if((tactic_type == TACTIC_CLOSE || (tactic_type == TACTIC_QUICK && roll_chance(3))) &&
+            } else if((tactic_type == TACTIC_CLOSE || (tactic_type == TACTIC_QUICK && roll_chance(a, 3))) &&
                       smart_usually(a) && har_has_charge(h->id)) {
                 // smart AI will try to use charge attacks
                 a->tactic->move_type = 0;
                 do_charge = true;
-            } else if(smart_usually(a) && roll_pref(a->pilot->pref_jump)) {
+            } else if(smart_usually(a) && roll_pref(a, a->pilot->pref_jump)) {
                 // smart AI that likes to jump will close via jump
                 a->tactic->move_type = MOVE_JUMP;
             } else {
@@ -721,7 +728,7 @@ void queue_tactic(controller *ctrl, int tactic_type) {
                 }
                 break;
             case TACTIC_COUNTER:
-                a->tactic->attack_type = roll_chance(3) ? ATTACK_TRIP : ATTACK_HEAVY;
+                a->tactic->attack_type = roll_chance(a, 3) ? ATTACK_TRIP : ATTACK_HEAVY;
                 // we only wait for block if they're not in range to grab/throw
                 if(enemy_range > RANGE_CRAMPED) {
                     a->tactic->attack_on = HAR_EVENT_BLOCK;
@@ -984,7 +991,7 @@ void reset_pilot_personality(sd_pilot *pilot) {
  * \return Void.
  */
 void reset_act_timer(ai *a) {
-    a->act_timer = BASE_ACT_TIMER - (a->difficulty * 2) - rand_int(3);
+    a->act_timer = BASE_ACT_TIMER - (a->difficulty * 2) - random_int(a->rand, 3);
 }
 
 /**
@@ -999,32 +1006,32 @@ bool dislikes_move(const ai *a, const af_move *move) {
     // check for non-projectile special moves
     if(is_special_move(move)) {
         // pilots with bad special ability dislike special moves
-        return !roll_pref(a->pilot->ap_special);
+        return !roll_pref(a, a->pilot->ap_special);
     }
 
     switch(move->category) {
         case CAT_BASIC:
             // smart AI dislike basic moves
-            return !roll_pref(a->pilot->att_normal) && smart_usually(a);
+            return !roll_pref(a, a->pilot->att_normal) && smart_usually(a);
         case CAT_LOW:
             // pilots with bad low ability dislike low moves
-            return !roll_pref(a->pilot->att_normal) && !roll_pref(a->pilot->ap_low);
+            return !roll_pref(a, a->pilot->att_normal) && !roll_pref(a, a->pilot->ap_low);
         case CAT_MEDIUM:
             // pilots with bad middle ability dislike middle moves
-            return !roll_pref(a->pilot->att_normal) && !roll_pref(a->pilot->ap_middle);
+            return !roll_pref(a, a->pilot->att_normal) && !roll_pref(a, a->pilot->ap_middle);
         case CAT_HIGH:
             // pilots with bad high ability dislike high moves
-            return !roll_pref(a->pilot->att_normal) && !roll_pref(a->pilot->ap_high);
+            return !roll_pref(a, a->pilot->att_normal) && !roll_pref(a, a->pilot->ap_high);
         case CAT_THROW:
         case CAT_CLOSE:
             // non-hyper pilots with bad throw ability dislike throw moves
-            return !roll_pref(a->pilot->att_hyper) && !roll_pref(a->pilot->ap_throw);
+            return !roll_pref(a, a->pilot->att_hyper) && !roll_pref(a, a->pilot->ap_throw);
         case CAT_JUMPING:
             // non-jumper pilots with bad jump ability dislike jump moves
-            return !roll_pref(a->pilot->att_jump) && !roll_pref(a->pilot->ap_jump);
+            return !roll_pref(a, a->pilot->att_jump) && !roll_pref(a, a->pilot->ap_jump);
         case CAT_PROJECTILE:
             // non-sniper pilots with bad special ability dislike projectile moves
-            return !roll_pref(a->pilot->att_sniper) && !roll_pref(a->pilot->ap_special);
+            return !roll_pref(a, a->pilot->att_sniper) && !roll_pref(a, a->pilot->ap_special);
     }
 
     return false;
@@ -1058,7 +1065,7 @@ int ai_har_event(controller *ctrl, har_event event) {
                 if(a->tactic->tactic_type != TACTIC_COUNTER && a->tactic->tactic_type != TACTIC_TURTLE &&
                    a->tactic->tactic_type != TACTIC_TRIP && a->tactic->tactic_type != TACTIC_PUSH &&
                    a->tactic->tactic_type != TACTIC_SPAM && a->tactic->tactic_type != TACTIC_FLY &&
-                   (a->tactic->tactic_type != TACTIC_GRAB || roll_chance(2)) &&
+                   (a->tactic->tactic_type != TACTIC_GRAB || roll_chance(a, 2)) &&
                    (a->tactic->chain_hit_on == 0 || a->tactic->chain_hit_on != event.move->category)) {
                     reset_tactic_state(a);
                     has_queued_tactic = false;
@@ -1104,7 +1111,7 @@ int ai_har_event(controller *ctrl, har_event event) {
             ms = &a->move_stats[event.move->id];
 
             // in the heat of the moment they might forget what they have learnt
-            if(roll_chance(2) && forgetful(a)) {
+            if(roll_chance(a, 2) && forgetful(a)) {
                 reset_pilot_personality(pilot);
                 a->blocked = 0;
                 a->thrown = 0;
@@ -1449,14 +1456,11 @@ bool assign_move_by_cat(controller *ctrl, int category, bool highest_damage) {
     int top_value = 0;
 
     // Attack
-    for(int i = 0; i < 70; i++) {
+    uint32_t moves[AF_MOVE_MASK_WORDS] = {0};
+    af_category_moves(h->af_data, category, moves);
+    for(int i = af_next_move(moves, 0); i >= 0; i = af_next_move(moves, i + 1)) {
         af_move *move = NULL;
         if((move = af_get_move(h->af_data, i))) {
-            // category filter
-            if(category != move->category) {
-                continue;
-            }
-
             move_stat *ms = &a->move_stats[i];
             if(is_valid_move(move, h, true)) {
                 int value;
@@ -1465,7 +1469,7 @@ bool assign_move_by_cat(controller *ctrl, int category, bool highest_damage) {
                     value = (int)move->damage * 10;
                 } else {
                     // evaluate the move based on learning reinforcement
-                    value = ms->value + rand_int(10);
+                    value = ms->value + random_int(a->rand, 10);
                     if(learning_moment(a) && ms->min_hit_dist != -1) {
                         if(ms->last_dist < ms->max_hit_dist + 5 && ms->last_dist > ms->min_hit_dist + 5) {
                             value += 2;
@@ -1518,20 +1522,16 @@ bool assign_move_by_id(controller *ctrl, int move_id) {
     object *o = ctrl->har;
     har *h = object_get_userdata(o);
 
-    for(int i = 0; i < 70; i++) {
-        af_move *move = NULL;
-        if((move = af_get_move(h->af_data, i))) {
-            if(is_valid_move(move, h, true)) {
-                // move_id filter
-                if(move_id != move->id) {
-                    continue;
-                }
+    // Moves are stored in the slot matching their id
+    if(move_id < 0 || move_id >= AF_MOVE_COUNT) {
+        return false;
+    }
 
-                // DEBUG("=== assign_move_by_id === id %d", move_id);
-                set_selected_move(ctrl, move);
-                return true;
-            }
-        }
+    af_move *move = NULL;
+    if((move = af_get_move(h->af_data, move_id)) && is_valid_move(move, h, true)) {
+        // DEBUG("=== assign_move_by_id === id %d", move_id);
+        set_selected_move(ctrl, move);
+        return true;
     }
 
     return false;
@@ -1650,23 +1650,23 @@ void handle_movement(controller *ctrl, ctrl_event **ev) {
 
     // default mid-action jump chance
     int jump_chance = 100;
-    if(roll_pref(a->pilot->pref_jump))
+    if(roll_pref(a, a->pilot->pref_jump))
         jump_chance -= 10;
     if(diff_scale(a))
         jump_chance -= 10;
 
     // Change action after act_timer runs out
-    if(a->act_timer <= 0 && (roll_chance(BASE_ACT_CHANCE) || diff_scale(a))) {
+    if(a->act_timer <= 0 && (roll_chance(a, BASE_ACT_CHANCE) || diff_scale(a))) {
         int enemy_range = get_enemy_range(ctrl);
 
         int move_dir = MOVE_DIR_STILL;
         if(!h->is_wallhugging && enemy_range == RANGE_CRAMPED) {
             // we are face-hugging already so no need to go forward
-            move_dir = roll_pref(a->pilot->pref_back) ? MOVE_DIR_BACK : MOVE_DIR_STILL;
-        } else if(roll_pref(a->pilot->pref_fwd)) {
+            move_dir = roll_pref(a, a->pilot->pref_back) ? MOVE_DIR_BACK : MOVE_DIR_STILL;
+        } else if(roll_pref(a, a->pilot->pref_fwd)) {
             // pilot prefers forward
             move_dir = MOVE_DIR_FWD;
-        } else if(!h->is_wallhugging && roll_pref(a->pilot->pref_back)) {
+        } else if(!h->is_wallhugging && roll_pref(a, a->pilot->pref_back)) {
             // pilot prefers backward
             move_dir = MOVE_DIR_BACK;
         } else if((h->id == HAR_FLAIL || h->id == HAR_THORN || h->id == HAR_NOVA) && smart_usually(a)) {
@@ -1691,7 +1691,7 @@ void handle_movement(controller *ctrl, ctrl_event **ev) {
                 break;
             case MOVE_DIR_STILL:
             default:
-                if(smart_usually(a) || roll_pref(a->pilot->att_def)) {
+                if(smart_usually(a) || roll_pref(a, a->pilot->att_def)) {
                     // crouch and block
                     a->cur_act = (o->direction == OBJECT_FACE_RIGHT ? ACT_DOWN | ACT_LEFT : ACT_DOWN | ACT_RIGHT);
                     jump_chance = 0;
@@ -1710,9 +1710,9 @@ void handle_movement(controller *ctrl, ctrl_event **ev) {
     }
 
     // Jump once in a while if they like to jump
-    if(jump_chance > 0 && roll_chance(jump_chance) && roll_pref(a->pilot->pref_jump)) {
+    if(jump_chance > 0 && roll_chance(a, jump_chance) && roll_pref(a, a->pilot->pref_jump)) {
         // DEBUG("\e[35mJump chance\e[0m %d", jump_chance);
-        if(smart_usually(a) && roll_pref(a->pilot->att_jump)) {
+        if(smart_usually(a) && roll_pref(a, a->pilot->att_jump)) {
             // double jump
             controller_cmd(ctrl, ACT_DOWN, ev);
         }
@@ -1764,7 +1764,7 @@ bool attempt_attack(controller *ctrl, bool highest_damage) {
                     value = (int)move->damage * 10;
                 } else {
                     // evaluate the move based on learning reinforcement
-                    value = ms->value + rand_int(10);
+                    value = ms->value + random_int(a->rand, 10);
                     if(learning_moment(a) && ms->min_hit_dist != -1) {
                         if(ms->last_dist < ms->max_hit_dist + 5 && ms->last_dist > ms->min_hit_dist + 5) {
                             value += 2;
@@ -1775,7 +1775,7 @@ bool attempt_attack(controller *ctrl, bool highest_damage) {
 
                     // AI is less likely to use exact same move as last attack
                     if(a->last_move_id > 0 && a->last_move_id == move->id) {
-                        value -= rand_int(10);
+                        value -= random_int(a->rand, 10);
                     }
 
                     // smart AI will slightly favor high damage moves
@@ -1785,7 +1785,7 @@ bool attempt_attack(controller *ctrl, bool highest_damage) {
 
                     // AI is less likely to use disliked moves
                     if(dislikes_move(a, move)) {
-                        value -= rand_int(10);
+                        value -= random_int(a->rand, 10);
                     }
 
                     value -= ms->attempts / 2;
@@ -1854,7 +1854,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
     switch(h->id) {
         case HAR_JAGUAR: {
             // DEBUG("\e[35mJaguar move:\e[0m Leap");
-            if(enemy_range >= RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range >= RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // Shadow Leap : B,D,F+P
                 int cmds[] = {(o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT : ACT_RIGHT),
                               (o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT | ACT_DOWN : ACT_RIGHT | ACT_DOWN)};
@@ -1872,7 +1872,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
             chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
         } break;
         case HAR_KATANA: {
-            if(roll_chance(2) && roll_pref(a->pilot->ap_low)) {
+            if(roll_chance(a, 2) && roll_pref(a, a->pilot->ap_low)) {
                 // DEBUG("\e[35mKatana move:\e[0m Trip-slide");
                 // Trip-Slide attack : D+B+K
                 int cmds[] = {ACT_DOWN,
@@ -1880,7 +1880,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
                               ACT_KICK};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
             } else {
-                if(enemy_range >= RANGE_MID && roll_chance(2)) {
+                if(enemy_range >= RANGE_MID && roll_chance(a, 2)) {
                     // DEBUG("\e[35mKatana move:\e[0m Foward Razor Spin");
                     // Foward Razor Spin : D,F+K
                     int cmds[] = {ACT_DOWN, (o->direction == OBJECT_FACE_RIGHT ? ACT_RIGHT : ACT_LEFT),
@@ -1889,7 +1889,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
                     chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
                 } else {
                     // DEBUG("\e[35mKatana move:\e[0m Rising Blade ");
-                    if(enemy_range >= RANGE_CLOSE && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+                    if(enemy_range >= RANGE_CLOSE && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                         // Triple Blade : B,D,F+P
                         int cmds[] = {(o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT : ACT_RIGHT),
                                       (o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT | ACT_DOWN : ACT_RIGHT | ACT_DOWN)};
@@ -1906,7 +1906,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
         } break;
         case HAR_FLAIL: {
             // DEBUG("\e[35mFlail move:\e[0m Charging Punch");
-            if(enemy_range > RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range > RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // Shadow Punch : D,B,B,P
                 int cmds[] = {ACT_DOWN,
                               (o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT | ACT_DOWN : ACT_RIGHT | ACT_DOWN)};
@@ -1930,7 +1930,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
         } break;
         case HAR_PYROS: {
             // DEBUG("\e[35mPyros move:\e[0m Thrust");
-            if(enemy_range > RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range > RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // Shadow Thrust : F,F,F+P
                 int cmds[] = {(o->direction == OBJECT_FACE_RIGHT ? ACT_RIGHT : ACT_LEFT), ACT_STOP};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
@@ -1944,7 +1944,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
         } break;
         case HAR_ELECTRA: {
             // DEBUG("\e[35mElectra move:\e[0m Rolling Thunder");
-            if(enemy_range >= RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range >= RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // Super R.T. : B,D,F,F+P
                 int cmds[] = {(o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT : ACT_RIGHT), ACT_DOWN};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
@@ -1957,7 +1957,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
             chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
         } break;
         case HAR_CHRONOS: {
-            if(enemy_range >= RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range >= RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // DEBUG("\e[35mChronos move:\e[0m Teleport");
                 // Teleportation : D,P
                 int cmds[] = {ACT_DOWN, ACT_STOP, ACT_PUNCH};
@@ -1975,14 +1975,14 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
             }
         } break;
         case HAR_SHREDDER: {
-            if(enemy_range > RANGE_MID && roll_pref(a->pilot->att_jump) && diff_scale(a)) {
+            if(enemy_range > RANGE_MID && roll_pref(a, a->pilot->att_jump) && diff_scale(a)) {
                 // DEBUG("\e[35mShredder move:\e[0m Flip-kick");
                 // Flip Kick : D,D+K
                 int cmds[] = {ACT_DOWN, ACT_STOP, ACT_DOWN, ACT_DOWN | ACT_KICK, ACT_KICK};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
             } else {
                 // DEBUG("\e[35mShredder move:\e[0m Head-butt");
-                if(enemy_range >= RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+                if(enemy_range >= RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                     // Shadow Head-Butt : B,D,F+P
                     int cmds[] = {(o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT : ACT_RIGHT),
                                   (o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT | ACT_DOWN : ACT_RIGHT | ACT_DOWN)};
@@ -1997,7 +1997,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
             }
         } break;
         case HAR_GARGOYLE: {
-            if(enemy_range > RANGE_MID && roll_pref(a->pilot->att_jump) && diff_scale(a)) {
+            if(enemy_range > RANGE_MID && roll_pref(a, a->pilot->att_jump) && diff_scale(a)) {
                 // DEBUG("\e[35mGargoyle move:\e[0m Wing-charge");
                 // Wing Charge : F,F,P
                 int cmds[] = {(o->direction == OBJECT_FACE_RIGHT ? ACT_RIGHT : ACT_LEFT),
@@ -2009,7 +2009,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
                 // DEBUG("\e[35mGargoyle move:\e[0m Talon");
                 int cmds[] = {(o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT : ACT_RIGHT),
                               (o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT | ACT_DOWN : ACT_RIGHT | ACT_DOWN)};
-                if(enemy_range >= RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+                if(enemy_range >= RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                     // Shadow Talon : B,D,F,P
                     chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
                 }
@@ -2065,7 +2065,7 @@ bool attempt_push_attack(controller *ctrl, ctrl_event **ev) {
         } break;
         case HAR_KATANA: {
             // DEBUG("\e[35mKatana move:\e[0m Rising Blade");
-            if(enemy_range >= RANGE_CLOSE && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range >= RANGE_CLOSE && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // Triple Blade : B,D,F+P
                 int cmds[] = {(o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT : ACT_RIGHT),
                               (o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT | ACT_DOWN : ACT_RIGHT | ACT_DOWN)};
@@ -2077,7 +2077,7 @@ bool attempt_push_attack(controller *ctrl, ctrl_event **ev) {
             chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
         } break;
         case HAR_FLAIL: {
-            if(roll_chance(3)) {
+            if(roll_chance(a, 3)) {
                 // DEBUG("\e[35mFlail move:\e[0m Slow Swing Chains");
                 // Slow Swing Chain : D,K
                 int cmds[] = {ACT_DOWN, ACT_STOP, ACT_KICK};
@@ -2091,7 +2091,7 @@ bool attempt_push_attack(controller *ctrl, ctrl_event **ev) {
         } break;
         case HAR_THORN: {
             // DEBUG("\e[35mThorn move:\e[0m Speed Kick");
-            if(enemy_range >= RANGE_CLOSE && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range >= RANGE_CLOSE && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // Shadow Kick : B,D,F+K
                 int cmds[] = {(o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT : ACT_RIGHT),
                               (o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT | ACT_DOWN : ACT_RIGHT | ACT_DOWN)};
@@ -2181,6 +2181,7 @@ bool attempt_trip_attack(controller *ctrl, ctrl_event **ev) {
  * \return Boolean indicating whether an attack was initiated.
  */
 bool attempt_projectile_attack(controller *ctrl, ctrl_event **ev) {
+    ai *a = ctrl->data;
     object *o = ctrl->har;
     har *h = object_get_userdata(o);
 
@@ -2205,7 +2206,7 @@ bool attempt_projectile_attack(controller *ctrl, ctrl_event **ev) {
             int cmds[] = {ACT_DOWN, (o->direction == OBJECT_FACE_RIGHT ? ACT_DOWN | ACT_LEFT : ACT_DOWN | ACT_RIGHT),
                           (o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT : ACT_RIGHT)};
             chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
-            if(roll_chance(2)) {
+            if(roll_chance(a, 2)) {
                 // Shadow Punch : D,B+P
                 int cmds[] = {(o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT | ACT_PUNCH : ACT_RIGHT | ACT_PUNCH),
                               ACT_PUNCH};
@@ -2225,7 +2226,7 @@ bool attempt_projectile_attack(controller *ctrl, ctrl_event **ev) {
         } break;
         case HAR_NOVA: {
             controller_cmd(ctrl, ACT_DOWN, ev);
-            if(roll_chance(3)) {
+            if(roll_chance(a, 3)) {
                 // Mini-Grenade : D, B, P
                 int cmds[] = {(o->direction == OBJECT_FACE_RIGHT ? ACT_DOWN | ACT_LEFT : ACT_DOWN | ACT_RIGHT),
                               (o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT : ACT_RIGHT)};
@@ -2284,7 +2285,7 @@ bool handle_queued_tactic(controller *ctrl, ctrl_event **ev) {
                     tactic->move_timer = 0;
                     acted = true;
                 } else {
-                    if(enemy_range == RANGE_CRAMPED || !roll_pref(a->pilot->pref_jump)) {
+                    if(enemy_range == RANGE_CRAMPED || !roll_pref(a, a->pilot->pref_jump)) {
                         // take a step away
                         a->cur_act = o->direction == OBJECT_FACE_RIGHT ? ACT_LEFT : ACT_RIGHT;
                     } else {
@@ -2312,13 +2313,13 @@ bool handle_queued_tactic(controller *ctrl, ctrl_event **ev) {
                     // jump closer
                     a->cur_act = (o->direction == OBJECT_FACE_RIGHT ? ACT_RIGHT : ACT_LEFT) | ACT_UP;
                     controller_cmd(ctrl, a->cur_act, ev);
-                    if(roll_pref(a->pilot->pref_jump)) {
+                    if(roll_pref(a, a->pilot->pref_jump)) {
                         tactic->move_timer--;
                     } else {
                         tactic->move_timer = 0;
                     }
                 } else if(tactic->tactic_type == TACTIC_FLY) {
-                    if(roll_pref(a->pilot->att_jump) && smart_sometimes(a)) {
+                    if(roll_pref(a, a->pilot->att_jump) && smart_sometimes(a)) {
                         // do high jump
                         controller_cmd(ctrl, ACT_DOWN, ev);
                     }
@@ -2420,7 +2421,7 @@ bool handle_queued_tactic(controller *ctrl, ctrl_event **ev) {
                     if(!in_attempt_range)
                         break;
 
-                    int light_cat = roll_chance(2) ? CAT_BASIC : CAT_MEDIUM;
+                    int light_cat = roll_chance(a, 2) ? CAT_BASIC : CAT_MEDIUM;
                     if(assign_move_by_cat(ctrl, light_cat, false)) {
                         reset_tactic_state(a);
                         // DEBUG("\e[32mLight attack success\e[0m: %d", h->id);
@@ -2447,7 +2448,7 @@ bool handle_queued_tactic(controller *ctrl, ctrl_event **ev) {
                     if(!in_attempt_range)
                         break;
 
-                    int heavy_cat = roll_chance(2) ? CAT_MEDIUM : CAT_HIGH;
+                    int heavy_cat = roll_chance(a, 2) ? CAT_MEDIUM : CAT_HIGH;
                     if(assign_move_by_cat(ctrl, heavy_cat, true)) {
                         reset_tactic_state(a);
                         // DEBUG("\e[32mHeavy attack success\e[0m: %d", h->id);
@@ -2664,7 +2665,7 @@ int ai_controller_poll(controller *ctrl, ctrl_event **ev) {
     int enemy_range = get_enemy_range(ctrl);
 
     // attempt a random attack
-    if((roll_chance(RANDOM_ATTACK_CHANCE) || diff_scale(a)) && (enemy_range <= RANGE_CLOSE || dumb_sometimes(a)) &&
+    if((roll_chance(a, RANDOM_ATTACK_CHANCE) || diff_scale(a)) && (enemy_range <= RANGE_CLOSE || dumb_sometimes(a)) &&
        attempt_attack(ctrl, false)) {
         // DEBUG("\e[32mRandom attack\e[0m: %d", h->id);
         // reset movement act timer
@@ -2678,7 +2679,7 @@ int ai_controller_poll(controller *ctrl, ctrl_event **ev) {
     // DEBUG("=== POLL === handle_movement");
 
     // queue a random tactic for next poll
-    if(a->last_move_id > 0 && (roll_chance(RANDOM_ATTACK_CHANCE) && diff_scale(a)) && a->tactic->tactic_type == 0 &&
+    if(a->last_move_id > 0 && (roll_chance(a, RANDOM_ATTACK_CHANCE) && diff_scale(a)) && a->tactic->tactic_type == 0 &&
        can_move) {
         // DEBUG("\e[35mAttempt to queue random tactic[0m");
         int tacs[] = {TACTIC_SHOOT, TACTIC_CLOSE, TACTIC_FLY, TACTIC_PUSH, TACTIC_TRIP, TACTIC_GRAB, TACTIC_QUICK};
@@ -2688,8 +2689,9 @@ int ai_controller_poll(controller *ctrl, ctrl_event **ev) {
     return 0;
 }
 
-void ai_controller_create(controller *ctrl, int difficulty, sd_pilot *pilot, int pilot_id) {
+void ai_controller_create(controller *ctrl, int difficulty, sd_pilot *pilot, int pilot_id, struct random_t *rand) {
     ai *a = omf_calloc(1, sizeof(ai));
+    a->rand = rand;
     a->har_event_hooked = 0;
     a->difficulty = difficulty + 1;
     a->act_timer = 0;
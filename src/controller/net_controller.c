@@ -2,9 +2,34 @@
 #include <stdio.h>
 
 #include "controller/net_controller.h"
+#include "game/game_state_type.h"
 #include "game/utils/serial.h"
+#include "game/utils/settings.h"
 #include "utils/allocator.h"
+#include "utils/delta.h"
 #include "utils/log.h"
+#include "utils/random.h"
+
+// Size of an input packet without the actions: type, tick and action count
+#define INPUT_HEADER_LEN 6
+
+// Ticks on top of the round trip time to wait for the acknowledgement of a sync before sending it again
+#define SYNC_RESEND_TICKS 5
+
+// Sync packet flags
+#define SYNC_COMPRESSED 0x1
+
+enum
+{
+    HANDSHAKE_WAITING,
+    HANDSHAKE_DONE,
+    HANDSHAKE_REFUSED
+};
+
+typedef struct sync_state_t {
+    unsigned int seq; ///< Sequence number of the state, 0 if the slot is empty
+    serial state;
+} sync_state;
 
 typedef struct wtf_t {
     ENetHost *host;
@@ -18,6 +43,19 @@ typedef struct wtf_t {
     int rttpos;
     int rttfilled;
     int tick_offset;
+    int handshake;          ///< One of HANDSHAKE_*
+    int rollback_enabled;   ///< Rollback setting of this end, the peer must have the same
+    uint32_t rollback_seed; ///< Random seed of a rollback game, picked by the server
+    rollback *rollback;
+    rollback_input pending[ROLLBACK_FRAMES]; ///< Remote inputs received before the rollback buffer was set
+    unsigned int pending_count;              ///< Remote inputs of the ticks before this are pending
+    unsigned int sent_tick;                  ///< Local inputs of the ticks before this have been sent
+    unsigned int sync_seq;  ///< Sequence number of the last state sent
+    unsigned int acked_seq; ///< Latest state acknowledged by the peer, 0 if none
+    int sync_tick;          ///< Tick when the last state was sent, -1 until the next tick
+    sync_state sent[SYNC_HISTORY];
+    sync_state received[SYNC_HISTORY];
+    net_sync_stats sync_stats;
 } wtf;
 
 // simple standard deviation calculation
@@ -53,7 +91,10 @@ int avg_rtt(int data[], int n) {
 
 int net_controller_ready(controller *ctrl) {
     wtf *data = ctrl->data;
-    return data->rttfilled;
+    if(data->handshake == HANDSHAKE_REFUSED) {
+        return -1;
+    }
+    return data->handshake == HANDSHAKE_DONE && data->rttfilled;
 }
 
 int net_controller_tick_offset(controller *ctrl) {
@@ -85,6 +126,10 @@ void net_controller_free(controller *ctrl) {
         }
     }
 done:
+    for(int i = 0; i < SYNC_HISTORY; i++) {
+        serial_free(&data->sent[i].state);
+        serial_free(&data->received[i].state);
+    }
     if(data->host) {
         enet_host_destroy(data->host);
         data->host = NULL;
@@ -94,12 +139,285 @@ done:
     }
 }
 
+void net_controller_set_rollback(controller *ctrl, rollback *rb) {
+    wtf *data = ctrl->data;
+    data->rollback = rb;
+    data->sent_tick = 0;
+    if(rb != NULL) {
+        for(unsigned int i = 0; i < data->pending_count; i++) {
+            rollback_add_remote_input(rb, i, &data->pending[i]);
+        }
+    }
+    data->pending_count = 0;
+}
+
+int net_controller_get_rollback(controller *ctrl, uint32_t *seed) {
+    wtf *data = ctrl->data;
+    *seed = data->rollback_seed;
+    return data->handshake == HANDSHAKE_DONE && data->rollback_enabled;
+}
+
+const net_sync_stats *net_controller_get_sync_stats(controller *ctrl) {
+    wtf *data = ctrl->data;
+    return &data->sync_stats;
+}
+
+void net_controller_add_serialize_time(controller *ctrl, uint64_t ticks) {
+    wtf *data = ctrl->data;
+    data->sync_stats.serialize_time += ticks;
+}
+
+static void store_state(sync_state *slot, unsigned int seq, const char *state, size_t len) {
+    slot->seq = seq;
+    serial_write_reset(&slot->state);
+    serial_write(&slot->state, state, len);
+}
+
+// Returns the state acknowledged by the peer, if it is still recent enough for the peer to have it
+static sync_state *get_acked_state(wtf *data, unsigned int next_seq) {
+    if(data->acked_seq == 0 || next_seq - data->acked_seq >= SYNC_HISTORY) {
+        return NULL;
+    }
+    sync_state *base = &data->sent[data->acked_seq % SYNC_HISTORY];
+    return (base->seq == data->acked_seq) ? base : NULL;
+}
+
+static void read_sync(controller *ctrl, wtf *data, serial *ser, ctrl_event **ev) {
+    uint64_t start = SDL_GetPerformanceCounter();
+    unsigned int seq = serial_read_int32(ser);
+    unsigned int base_seq = serial_read_int32(ser);
+    size_t len = (uint32_t)serial_read_int32(ser);
+    int flags = serial_read_int8(ser);
+    const char *payload = ser->data + ser->rpos;
+    size_t payload_len = serial_len(ser) - ser->rpos;
+
+    sync_state *base = NULL;
+    if(base_seq != 0) {
+        base = &data->received[base_seq % SYNC_HISTORY];
+        if(base->seq != base_seq) {
+            DEBUG("dropped state sync %u, its base %u is gone", seq, base_seq);
+            data->sync_stats.dropped++;
+            return;
+        }
+    }
+    if(seq == 0 || len == 0 || len > SYNC_MAX_LEN) {
+        data->sync_stats.dropped++;
+        return;
+    }
+
+    char encoded[delta_encode_bound(len)];
+    if(flags & SYNC_COMPRESSED) {
+        payload_len = delta_decompress(payload, payload_len, encoded, sizeof(encoded));
+        payload = encoded;
+    }
+    char state[len];
+    if(delta_decode(base ? base->state.data : NULL, base ? serial_len(&base->state) : 0, payload, payload_len,
+                    state, len)) {
+        DEBUG("dropped corrupt state sync %u", seq);
+        data->sync_stats.dropped++;
+        return;
+    }
+    store_state(&data->received[seq % SYNC_HISTORY], seq, state, len);
+
+    // Let the peer know that it can send the next states against this one
+    serial ack;
+    serial_create(&ack);
+    serial_write_int8(&ack, EVENT_TYPE_SYNC_ACK);
+    serial_write_int32(&ack, seq);
+    ENetPacket *packet = enet_packet_create(ack.data, serial_len(&ack), ENET_PACKET_FLAG_UNSEQUENCED);
+    serial_free(&ack);
+    enet_peer_send(data->peer, 0, packet);
+    enet_host_flush(data->host);
+
+    data->sync_stats.received++;
+    data->sync_stats.decode_time += SDL_GetPerformanceCounter() - start;
+
+    serial synced;
+    serial_create_from(&synced, state, len);
+    controller_sync(ctrl, &synced, ev);
+    serial_free(&synced);
+}
+
+// Both ends send their settings when the connection is up. Running with different rollback settings
+// would desync silently, so such a peer is refused. The client takes the seed of the server.
+static void send_handshake(wtf *data) {
+    serial ser;
+    serial_create(&ser);
+    serial_write_int8(&ser, EVENT_TYPE_HANDSHAKE);
+    serial_write_int8(&ser, data->rollback_enabled);
+    serial_write_int32(&ser, data->rollback_seed);
+    ENetPacket *packet = enet_packet_create(ser.data, serial_len(&ser), ENET_PACKET_FLAG_RELIABLE);
+    serial_free(&ser);
+    enet_peer_send(data->peer, 0, packet);
+    enet_host_flush(data->host);
+}
+
+static void read_handshake(wtf *data, serial *ser) {
+    int rollback_enabled = serial_read_int8(ser);
+    uint32_t seed = serial_read_int32(ser);
+    if(data->handshake != HANDSHAKE_WAITING) {
+        return;
+    }
+    if(rollback_enabled != data->rollback_enabled) {
+        PERROR("refusing peer, rollback is %s here and %s there", data->rollback_enabled ? "on" : "off",
+               rollback_enabled ? "on" : "off");
+        data->handshake = HANDSHAKE_REFUSED;
+        enet_peer_disconnect(data->peer, 0);
+        return;
+    }
+    if(data->id == ROLE_CLIENT) {
+        data->rollback_seed = seed;
+    }
+    data->handshake = HANDSHAKE_DONE;
+}
+
+static void read_sync_ack(wtf *data, serial *ser) {
+    unsigned int seq = serial_read_int32(ser);
+    if(seq > data->acked_seq && seq <= data->sync_seq) {
+        data->acked_seq = seq;
+    }
+}
+
+// Inputs come in order on a reliable channel, so a gap in the ticks means that the stream is broken,
+// and the game would wait forever for the missing tick. Returns 1 then, or if the packet is malformed.
+static int read_input(wtf *data, serial *ser) {
+    rollback_input input;
+    if(serial_len(ser) < INPUT_HEADER_LEN) {
+        PERROR("got a truncated input packet");
+        return 1;
+    }
+    unsigned int tick = serial_read_int32(ser);
+    input.count = serial_read_int8(ser);
+    if(input.count > ROLLBACK_MAX_ACTIONS || serial_len(ser) - ser->rpos != input.count * sizeof(uint16_t)) {
+        PERROR("got a malformed input packet for tick %u", tick);
+        return 1;
+    }
+    for(int i = 0; i < input.count; i++) {
+        input.actions[i] = serial_read_int16(ser);
+    }
+
+    if(data->rollback == NULL) {
+        // The peer has started the game first. Every game starts from tick 0, so any inputs before
+        // that are left over from the last one.
+        if(tick == 0) {
+            data->pending_count = 0;
+        } else if(data->pending_count == 0) {
+            return 0;
+        }
+        if(tick != data->pending_count || data->pending_count >= ROLLBACK_FRAMES) {
+            PERROR("got input for tick %u, expected tick %u", tick, data->pending_count);
+            return 1;
+        }
+        data->pending[data->pending_count++] = input;
+        return 0;
+    }
+    if(rollback_add_remote_input(data->rollback, tick, &input)) {
+        PERROR("got input for tick %u, expected tick %u", tick, data->rollback->confirmed_tick);
+        return 1;
+    }
+    return 0;
+}
+
+// Sends the local inputs of the ticks that have been simulated since the last call. They go on the
+// reliable channel, so the peer gets every tick in order.
+static void send_inputs(wtf *data) {
+    rollback_input input;
+    while(data->sent_tick < rollback_get_tick(data->rollback)) {
+        if(rollback_get_local_input(data->rollback, data->sent_tick, &input)) {
+            PERROR("local input of tick %u is gone before it was sent", data->sent_tick);
+            data->sent_tick = rollback_get_tick(data->rollback);
+            break;
+        }
+        serial ser;
+        serial_create(&ser);
+        serial_write_int8(&ser, EVENT_TYPE_INPUT);
+        serial_write_int32(&ser, data->sent_tick);
+        serial_write_int8(&ser, input.count);
+        for(int i = 0; i < input.count; i++) {
+            serial_write_int16(&ser, input.actions[i]);
+        }
+        ENetPacket *packet = enet_packet_create(ser.data, serial_len(&ser), ENET_PACKET_FLAG_RELIABLE);
+        serial_free(&ser);
+        enet_peer_send(data->peer, 1, packet);
+        data->sent_tick++;
+    }
+    enet_host_flush(data->host);
+}
+
+// Sends a state to the peer as a delta against the state it has acknowledged last
+static void send_sync(wtf *data, const char *state, size_t len) {
+    uint64_t start = SDL_GetPerformanceCounter();
+    unsigned int seq = data->sync_seq + 1;
+    sync_state *base = get_acked_state(data, seq);
+
+    char encoded[delta_encode_bound(len)];
+    size_t encoded_len =
+        delta_encode(base ? base->state.data : NULL, base ? serial_len(&base->state) : 0, state, len, encoded);
+    const char *payload = encoded;
+    size_t payload_len = encoded_len;
+    int flags = 0;
+    char compressed[delta_compress_bound(encoded_len)];
+    if(settings_get()->net.net_sync_compress) {
+        size_t compressed_len = delta_compress(encoded, encoded_len, compressed);
+        if(compressed_len < encoded_len) {
+            payload = compressed;
+            payload_len = compressed_len;
+            flags |= SYNC_COMPRESSED;
+        }
+    }
+
+    serial ser;
+    serial_create(&ser);
+    serial_write_int8(&ser, EVENT_TYPE_SYNC);
+    serial_write_int32(&ser, seq);
+    serial_write_int32(&ser, base ? base->seq : 0);
+    serial_write_int32(&ser, len);
+    serial_write_int8(&ser, flags);
+    serial_write(&ser, payload, payload_len);
+    ENetPacket *packet = enet_packet_create(ser.data, serial_len(&ser), 0);
+
+    data->sync_seq = seq;
+    data->sync_tick = -1;
+    store_state(&data->sent[seq % SYNC_HISTORY], seq, state, len);
+    data->sync_stats.sent++;
+    data->sync_stats.sent_full += (base == NULL);
+    data->sync_stats.compressed += (flags & SYNC_COMPRESSED) != 0;
+    data->sync_stats.raw_bytes += len;
+    data->sync_stats.sent_bytes += serial_len(&ser);
+    data->sync_stats.encode_time += SDL_GetPerformanceCounter() - start;
+    serial_free(&ser);
+
+    enet_peer_send(data->peer, 1, packet);
+    enet_host_flush(data->host);
+}
+
+// Syncs go unreliable, and the next one only comes with the next event that needs it. A lost sync
+// would leave the peer diverged until then, so the last state is sent again until it is acknowledged.
+static void resend_sync(controller *ctrl, wtf *data, int ticks) {
+    if(data->sync_seq == 0 || data->acked_seq == data->sync_seq) {
+        return;
+    }
+    if(data->sync_tick == -1) {
+        data->sync_tick = ticks;
+        return;
+    }
+    if(ticks - data->sync_tick <= ctrl->rtt + SYNC_RESEND_TICKS) {
+        return;
+    }
+    sync_state *last = &data->sent[data->sync_seq % SYNC_HISTORY];
+    DEBUG("state sync %u was not acknowledged, sending it again", data->sync_seq);
+    send_sync(data, last->state.data, serial_len(&last->state));
+    data->sync_tick = ticks;
+    data->sync_stats.resent++;
+}
+
 int net_controller_tick(controller *ctrl, int ticks, ctrl_event **ev) {
     ENetEvent event;
     wtf *data = ctrl->data;
     ENetHost *host = data->host;
     ENetPeer *peer = data->peer;
     serial ser;
+    int broken = 0;
     while(enet_host_service(host, &event, 0) > 0) {
         switch(event.type) {
             case ENET_EVENT_TYPE_RECEIVE:
@@ -142,7 +460,16 @@ int net_controller_tick(controller *ctrl, int ticks, ctrl_event **ev) {
                         }
                     } break;
                     case EVENT_TYPE_SYNC:
-                        controller_sync(ctrl, &ser, ev);
+                        read_sync(ctrl, data, &ser, ev);
+                        break;
+                    case EVENT_TYPE_SYNC_ACK:
+                        read_sync_ack(data, &ser);
+                        break;
+                    case EVENT_TYPE_INPUT:
+                        broken = read_input(data, &ser);
+                        break;
+                    case EVENT_TYPE_HANDSHAKE:
+                        read_handshake(data, &ser);
                         break;
                     default:
                         // Event type is unknown or we don't care about it
@@ -150,6 +477,11 @@ int net_controller_tick(controller *ctrl, int ticks, ctrl_event **ev) {
                 }
                 serial_free(&ser);
                 enet_packet_destroy(event.packet);
+                if(broken) {
+                    // Drop the peer rather than stall, the closing disconnects it
+                    controller_close(ctrl, ev);
+                    return 1;
+                }
                 break;
             case ENET_EVENT_TYPE_DISCONNECT:
                 DEBUG("peer disconnected!");
@@ -163,6 +495,13 @@ int net_controller_tick(controller *ctrl, int ticks, ctrl_event **ev) {
         }
     }
 
+    if(data->rollback != NULL && peer) {
+        send_inputs(data);
+    }
+    if(peer) {
+        resend_sync(ctrl, data, ticks);
+    }
+
     int tick_interval = 5;
     if(data->rttfilled) {
         tick_interval = 20;
@@ -196,19 +535,15 @@ int net_controller_tick(controller *ctrl, int ticks, ctrl_event **ev) {
 
 int net_controller_update(controller *ctrl, serial *original) {
     wtf *data = ctrl->data;
-    ENetPeer *peer = data->peer;
-    ENetHost *host = data->host;
-    ENetPacket *packet;
 
-    if(peer) {
-        serial ser;
-        serial_create(&ser);
-        serial_write_int8(&ser, EVENT_TYPE_SYNC);
-        serial_write(&ser, original->data, original->len);
-        packet = enet_packet_create(ser.data, ser.len, 0);
-        serial_free(&ser);
-        enet_peer_send(peer, 1, packet);
-        enet_host_flush(host);
+    size_t len = serial_len(original);
+    if(len == 0 || len > SYNC_MAX_LEN) {
+        PERROR("not syncing a state of %zu bytes", len);
+        return 1;
+    }
+
+    if(data->peer) {
+        send_sync(data, original->data, len);
     } else {
         DEBUG("peer is null~");
     }
@@ -222,6 +557,9 @@ void controller_hook(controller *ctrl, int action) {
     ENetPeer *peer = data->peer;
     ENetHost *host = data->host;
     ENetPacket *packet;
+    if(data->rollback != NULL) {
+        return;
+    }
     if(action == ACT_STOP && data->last_action == ACT_STOP) {
         data->last_action = -1;
         return;
@@ -250,6 +588,9 @@ void net_controller_har_hook(int action, void *cb_data) {
     ENetPeer *peer = data->peer;
     ENetHost *host = data->host;
     ENetPacket *packet;
+    if(data->rollback != NULL) {
+        return;
+    }
     if(action == ACT_STOP && data->last_action == ACT_STOP) {
         data->last_action = -1;
         return;
@@ -286,9 +627,27 @@ void net_controller_create(controller *ctrl, ENetHost *host, ENetPeer *peer, int
     data->rttpos = 0;
     data->tick_offset = 0;
     data->rttfilled = 0;
+    data->handshake = HANDSHAKE_WAITING;
+    data->rollback_enabled = settings_get()->net.net_rollback != 0;
+    data->rollback_seed = (id == ROLE_SERVER) ? rand_intmax() : 0;
+    data->rollback = NULL;
+    data->pending_count = 0;
+    data->sent_tick = 0;
+    data->sync_seq = 0;
+    data->acked_seq = 0;
+    data->sync_tick = -1;
+    for(int i = 0; i < SYNC_HISTORY; i++) {
+        data->sent[i].seq = 0;
+        serial_create(&data->sent[i].state);
+        data->received[i].seq = 0;
+        serial_create(&data->received[i].state);
+    }
     ctrl->data = data;
     ctrl->type = CTRL_TYPE_NETWORK;
     ctrl->tick_fun = &net_controller_tick;
     ctrl->update_fun = &net_controller_update;
     ctrl->controller_hook = &controller_hook;
+    if(peer) {
+        send_handshake(data);
+    }
 }
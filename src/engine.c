@@ -5,8 +5,12 @@
 #include "formats/altpal.h"
 #include "game/game_state.h"
 #include "game/gui/text_render.h"
+#include "game/utils/frame_profiler.h"
 #include "game/utils/settings.h"
+#include "resources/asset_pack.h"
 #include "resources/languages.h"
+#include "resources/pathmanager.h"
+#include "resources/resource_cache.h"
 #include "resources/sounds_loader.h"
 #include "utils/allocator.h"
 #include "utils/log.h"
@@ -21,7 +25,7 @@ static int take_screenshot = 0;
 static int enable_screen_updates = 1;
 static char screenshot_filename[128];
 
-int engine_init() {
+int engine_init(engine_init_flags *init_flags) {
     settings *setting = settings_get();
 
     int w = setting->video.screen_w;
@@ -32,11 +36,21 @@ int engine_init() {
     char *scaler = setting->video.scaler;
     const char *audiosink = setting->sound.sink;
 
+    // Headless mode runs with the null video backend and no audio sink.
+    if(init_flags->headless) {
+        audiosink = NULL;
+    }
+
     // Initialize everything.
-    if(video_init(w, h, fs, vsync, scaler, scale_factor)) {
+    if(init_flags->headless) {
+        if(video_init_null()) {
+            goto exit_0;
+        }
+    } else if(video_init(w, h, fs, vsync, scaler, scale_factor)) {
         goto exit_0;
     }
-    if(!audio_is_sink_available(audiosink)) {
+    video_set_texture_budget(setting->video.texture_budget);
+    if(audiosink != NULL && !audio_is_sink_available(audiosink)) {
         const char *prev_sink = audiosink;
         audiosink = audio_get_first_sink_name();
         if(audiosink == NULL) {
@@ -66,6 +80,8 @@ int engine_init() {
     if(console_init()) {
         goto exit_6;
     }
+    asset_pack_open(pm_get_local_path(ASSET_PACK_PATH));
+    resource_cache_init(RESOURCE_CACHE_BUDGET);
 
     // Return successfully
     run = 1;
@@ -89,6 +105,33 @@ exit_0:
     return 1;
 }
 
+// Runs the game simulation as fast as possible without rendering or polling for events.
+// Time is advanced virtually so that static and dynamic ticks interleave exactly as
+// they would in a real-time run. Ends when the game state stops running (eg. the REC
+// file or the AI match is over).
+static void engine_run_headless(game_state *gs) {
+    unsigned int ticks = 0;
+    int static_wait = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    while(run && game_state_is_running(gs)) {
+        game_state_tick_controllers(gs);
+
+        // Advance the virtual clock by exactly one dynamic tick
+        static_wait += game_state_ms_per_dyntick(gs);
+        while(static_wait > 10) {
+            game_state_static_tick(gs);
+            console_tick();
+            static_wait -= 10;
+        }
+        game_state_dynamic_tick(gs);
+        ticks++;
+    }
+    double secs = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+    double rate = (secs > 0) ? ticks / secs : 0;
+    INFO("Headless run: %u ticks in %.3f seconds (%.1f ticks/sec)", ticks, secs, rate);
+    printf("%u ticks in %.3f seconds (%.1f ticks/sec)\n", ticks, secs, rate);
+}
+
 void engine_run(engine_init_flags *init_flags) {
     SDL_Event e;
     int visual_debugger = 0;
@@ -103,7 +146,7 @@ void engine_run(engine_init_flags *init_flags) {
     // Game start timeout.
     // Wait a moment so that people are mentally prepared
     // (with the recording software on) for the game to start :)
-    if(!settings_get()->video.crossfade_on) {
+    if(!settings_get()->video.crossfade_on || init_flags->headless) {
         start_timeout = 0;
     }
     while(start_timeout > 0) {
@@ -127,13 +170,24 @@ void engine_run(engine_init_flags *init_flags) {
         return;
     }
 
+    if(init_flags->headless) {
+        engine_run_headless(gs);
+        game_state_free(&gs);
+        INFO(" --- END GAME LOG ---");
+        return;
+    }
+
     // Game loop
     int frame_start = SDL_GetTicks();
     int dynamic_wait = 0;
     int static_wait = 0;
+    uint64_t section_start;
     while(run && game_state_is_running(gs)) {
+        frame_profiler_begin_frame();
+
         // Handle events
         int check_fs;
+        section_start = frame_profiler_begin();
         while(SDL_PollEvent(&e)) {
             // Handle other events
             switch(e.type) {
@@ -153,6 +207,9 @@ void engine_run(engine_init_flags *init_flags) {
                     if(e.key.keysym.sym == SDLK_F6) {
                         debugger_render = !debugger_render;
                     }
+                    if(e.key.keysym.sym == SDLK_F7) {
+                        frame_profiler_toggle_overlay();
+                    }
                     break;
                 case SDL_MOUSEMOTION:
                     mouse_visible_ticks = 1000;
@@ -210,6 +267,7 @@ void engine_run(engine_init_flags *init_flags) {
                 game_state_handle_event(gs, &e);
             }
         }
+        frame_profiler_end(FRAME_SECTION_EVENTS, section_start);
 
         // hide mouse after n ticks
         if(mouse_visible_ticks > 0) {
@@ -220,7 +278,9 @@ void engine_run(engine_init_flags *init_flags) {
         }
 
         // Tick controllers
+        section_start = frame_profiler_begin();
         game_state_tick_controllers(gs);
+        frame_profiler_end(FRAME_SECTION_CONTROLLERS, section_start);
 
         // Render scene
         int dt = (SDL_GetTicks() - frame_start);
@@ -234,40 +294,54 @@ void engine_run(engine_init_flags *init_flags) {
             debugger_proceed = 0;
         }
         while(static_wait > 10) {
+            section_start = frame_profiler_begin();
+
             // Static tick for gamestate
             game_state_static_tick(gs);
 
             // Tick console
             console_tick();
 
-            // Tick video (tcache)
-            video_tick();
-
             static_wait -= 10;
+            frame_profiler_end(FRAME_SECTION_STATIC_TICK, section_start);
         }
         while(dynamic_wait > game_state_ms_per_dyntick(gs)) {
+            section_start = frame_profiler_begin();
+
             // Tick scene
             game_state_dynamic_tick(gs);
 
             // Handle waiting period leftover time
             dynamic_wait -= game_state_ms_per_dyntick(gs);
+            frame_profiler_end(FRAME_SECTION_DYNAMIC_TICK, section_start);
         }
 
         // Handle audio
         if(!visual_debugger) {
+            section_start = frame_profiler_begin();
             audio_render();
+            frame_profiler_end(FRAME_SECTION_AUDIO, section_start);
         }
 
         // Do the actual video rendering jobs
         if(enable_screen_updates) {
 
+            section_start = frame_profiler_begin();
             video_render_prepare();
             game_state_render(gs);
             if(debugger_render) {
                 game_state_debug(gs);
             }
+            frame_profiler_end(FRAME_SECTION_RENDER, section_start);
+
+            section_start = frame_profiler_begin();
             console_render();
+            frame_profiler_render();
+            frame_profiler_end(FRAME_SECTION_CONSOLE, section_start);
+
+            section_start = frame_profiler_begin();
             video_render_finish();
+            frame_profiler_end(FRAME_SECTION_PRESENT, section_start);
 
             // If screenshot requested, do it here.
             if(take_screenshot) {
@@ -290,6 +364,7 @@ void engine_run(engine_init_flags *init_flags) {
             // If screen updates are disabled, then wait
             SDL_Delay(1);
         }
+        frame_profiler_end_frame();
     }
 
     // Free scene object
@@ -299,6 +374,9 @@ void engine_run(engine_init_flags *init_flags) {
 }
 
 void engine_close() {
+    frame_profiler_close();
+    resource_cache_close();
+    asset_pack_close();
     console_close();
     altpals_close();
     fonts_close();
@@ -5,50 +5,52 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "formats/internal/memreader.h"
 #include "formats/internal/reader.h"
 #include "utils/allocator.h"
 
+// The whole file is read into memory with a single fread when it is opened, and the file is closed
+// right away. All the sd_read_* calls are then served from the buffer by a memreader. The
+// end-of-file flag follows the stdio semantics, so callers checking sd_reader_ok() behave exactly as
+// they did with direct stdio reads.
 struct sd_reader {
-    FILE *handle;
-    long filesize;
+    memreader *mem;
+    int eof;
     int sd_errno;
 };
 
 sd_reader *sd_reader_open(const char *file) {
-    sd_reader *reader = omf_calloc(1, sizeof(sd_reader));
-
-    reader->sd_errno = 0;
-
     // Attempt to open file (note: Binary mode!)
-    reader->handle = fopen(file, "rb");
-    if(!reader->handle) {
-        omf_free(reader);
+    FILE *handle = fopen(file, "rb");
+    if(!handle) {
         return 0;
     }
 
     // Find file size
-    if(fseek(reader->handle, 0, SEEK_END) == -1) {
-        goto error;
-    }
-    reader->filesize = ftell(reader->handle);
-    if(reader->filesize == -1) {
-        goto error;
+    long filesize;
+    if(fseek(handle, 0, SEEK_END) == -1 || (filesize = ftell(handle)) == -1 || fseek(handle, 0, SEEK_SET) == -1) {
+        fclose(handle);
+        return 0;
     }
-    if(fseek(reader->handle, 0, SEEK_SET) == -1) {
-        goto error;
+
+    // Slurp the whole thing. The extra zero at the end lets sd_read_scan parse the buffer as a string.
+    char *buf = omf_calloc(1, filesize + 1);
+    if(fread(buf, 1, filesize, handle) != (size_t)filesize) {
+        fclose(handle);
+        omf_free(buf);
+        return 0;
     }
+    fclose(handle);
 
-    // All done.
+    sd_reader *reader = omf_calloc(1, sizeof(sd_reader));
+    reader->mem = memreader_open(buf, filesize);
+    reader->mem->owned = 1;
+    reader->sd_errno = 0;
     return reader;
-
-error:
-    fclose(reader->handle);
-    omf_free(reader);
-    return 0;
 }
 
 long sd_reader_filesize(const sd_reader *reader) {
-    return reader->filesize;
+    return memreader_size(reader->mem);
 }
 
 int sd_reader_errno(const sd_reader *reader) {
@@ -56,47 +58,54 @@ int sd_reader_errno(const sd_reader *reader) {
 }
 
 void sd_reader_close(sd_reader *reader) {
-    fclose(reader->handle);
+    memreader_close(reader->mem);
     omf_free(reader);
 }
 
 int sd_reader_set(sd_reader *reader, long offset) {
-    if(fseek(reader->handle, offset, SEEK_SET) != 0) {
-        reader->sd_errno = errno;
+    if(offset < 0) {
+        reader->sd_errno = EINVAL;
         return 0;
     }
+    reader->mem->pos = offset;
+    reader->eof = 0;
     return 1;
 }
 
 int sd_reader_ok(const sd_reader *reader) {
-    if(feof(reader->handle)) {
+    if(reader->eof) {
         return 0;
     }
     return 1;
 }
 
 long sd_reader_pos(sd_reader *reader) {
-    long res = ftell(reader->handle);
-    if(res == -1) {
-        reader->sd_errno = errno;
-    }
-    return res;
+    return memreader_pos(reader->mem);
 }
 
 int sd_read_buf(sd_reader *reader, char *buf, int len) {
-    if(fread(buf, 1, len, reader->handle) != len) {
-        reader->sd_errno = ferror(reader->handle);
-        return 0;
+    if(memread_buf(reader->mem, buf, len)) {
+        return 1;
     }
-    return 1;
+
+    // Short read; copy what there is, like fread would.
+    long left = memreader_size(reader->mem) - memreader_pos(reader->mem);
+    if(left > 0) {
+        memread_buf(reader->mem, buf, left);
+    }
+    reader->eof = 1;
+    return 0;
 }
 
 int sd_peek_buf(sd_reader *reader, char *buf, int len) {
     if(sd_read_buf(reader, buf, len)) {
         return 0;
     }
-    if(fseek(reader->handle, ftell(reader->handle) - len, SEEK_SET) == -1) {
-        reader->sd_errno = errno;
+    if(memreader_pos(reader->mem) - len < 0) {
+        reader->sd_errno = EINVAL;
+    } else {
+        reader->mem->pos -= len;
+        reader->eof = 0;
     }
     return 1;
 }
@@ -194,23 +203,74 @@ int sd_match(sd_reader *reader, const char *buf, unsigned int nbytes) {
 }
 
 void sd_skip(sd_reader *reader, unsigned int nbytes) {
-    if(fseek(reader->handle, nbytes, SEEK_CUR) == -1) {
-        reader->sd_errno = errno;
+    sd_mskip(reader->mem, nbytes);
+    reader->eof = 0;
+}
+
+// Returns how many characters of str the format matches, or -1 if it does not match all the way.
+// Every conversion is suppressed, so that no arguments are needed for them.
+static int scan_length(const char *str, const char *format) {
+    size_t len = strlen(format);
+    char skip[len * 2 + 3];
+    size_t n = 0;
+    for(size_t i = 0; i < len; i++) {
+        skip[n++] = format[i];
+        if(format[i] != '%') {
+            continue;
+        }
+        if(format[i + 1] == '%') {
+            skip[n++] = format[++i];
+        } else if(format[i + 1] != '*') {
+            skip[n++] = '*';
+        }
     }
+    memcpy(skip + n, "%n", 3);
+    int consumed = -1;
+    sscanf(str, skip, &consumed);
+    return consumed;
 }
 
-int sd_read_scan(const sd_reader *reader, const char *format, ...) {
+int sd_read_scan(sd_reader *reader, const char *format, ...) {
+    // Parse from the buffer position, and then skip what the format matched
+    memreader *mem = reader->mem;
+    if(mem->pos >= mem->len) {
+        reader->eof = 1;
+        return EOF;
+    }
+    const char *str = mem->buf + mem->pos;
     va_list argp;
     va_start(argp, format);
-    int ret = fscanf(reader->handle, format, argp);
+    int ret = vsscanf(str, format, argp);
     va_end(argp);
+    int consumed = scan_length(str, format);
+    if(consumed > 0) {
+        sd_mskip(mem, consumed);
+    }
+    if(ret == EOF || mem->pos >= mem->len) {
+        reader->eof = 1;
+    }
     return ret;
 }
 
-int sd_read_line(const sd_reader *reader, char *buffer, int maxlen) {
-    if(fgets(buffer, maxlen, reader->handle) == NULL) {
+int sd_read_line(sd_reader *reader, char *buffer, int maxlen) {
+    // Same as fgets, but from the buffer
+    memreader *mem = reader->mem;
+    int n = 0;
+    while(n < maxlen - 1) {
+        if(mem->pos >= mem->len) {
+            reader->eof = 1;
+            break;
+        }
+        char c = mem->buf[mem->pos++];
+        buffer[n++] = c;
+        if(c == '\n') {
+            break;
+        }
+    }
+    if(n == 0 && maxlen > 1) {
         return 1;
     }
+    buffer[n] = 0;
     return 0;
 }
 
@@ -8,6 +8,10 @@
 
 static void _create_frame(sd_script *script, int number);
 static void _create_tag(sd_script_frame *frame, int number);
+static void _update_tick_pos(sd_script *script, int from);
+
+#define TAG_MASK_WORD(id) ((id) / 32)
+#define TAG_MASK_BIT(id) (1U << ((id) % 32))
 
 static int read_next_int(const char *str, int *pos) {
     int opos = 0;
@@ -47,6 +51,7 @@ void sd_script_free(sd_script *script) {
         omf_free(script->frames[i].tags);
     }
     omf_free(script->frames);
+    omf_free(script->tick_pos);
 }
 
 int sd_script_append_frame(sd_script *script, int tick_len, int sprite_id) {
@@ -58,6 +63,7 @@ int sd_script_append_frame(sd_script *script, int tick_len, int sprite_id) {
     script->frames[script->frame_count].tick_len = tick_len;
     script->frames[script->frame_count].sprite = sprite_id;
     script->frame_count++;
+    _update_tick_pos(script, script->frame_count - 1);
     return SD_SUCCESS;
 }
 
@@ -69,6 +75,7 @@ int sd_script_clear_tags(sd_script *script, int frame_id) {
     // Clear out old tags
     omf_free(script->frames[frame_id].tags);
     script->frames[frame_id].tag_count = 0;
+    memset(script->frames[frame_id].tag_mask, 0, sizeof(script->frames[frame_id].tag_mask));
     return SD_SUCCESS;
 }
 
@@ -78,6 +85,7 @@ int sd_script_set_tick_len_at_frame(sd_script *script, int frame_id, int duratio
     }
 
     script->frames[frame_id].tick_len = duration;
+    _update_tick_pos(script, frame_id);
     return SD_SUCCESS;
 }
 
@@ -97,6 +105,9 @@ int sd_script_get_total_ticks(const sd_script *script) {
 int sd_script_get_tick_pos_at_frame(const sd_script *script, int frame_id) {
     if(script == NULL)
         return 0;
+    if(script->tick_pos != NULL && frame_id >= 0 && frame_id <= script->frame_count) {
+        return script->tick_pos[frame_id];
+    }
     int len = 0;
     for(int i = 0; i < frame_id; i++) {
         len += script->frames[i].tick_len;
@@ -128,6 +139,30 @@ static void _create_frame(sd_script *script, int number) {
     memset(&script->frames[number], 0, sizeof(sd_script_frame));
 }
 
+// Refreshes the cumulative tick table, starting from the given frame. The table
+// has frame_count + 1 entries; tick_pos[i] is the tick at which frame i starts,
+// and the last entry is the total length of the script. If any of the frames
+// has a negative length the table would not be sorted, so we drop it and the
+// lookups fall back to walking the frames.
+static void _update_tick_pos(sd_script *script, int from) {
+    if(script->tick_pos == NULL) {
+        from = 0;
+    }
+    for(int i = from; i < script->frame_count; i++) {
+        if(script->frames[i].tick_len < 0) {
+            omf_free(script->tick_pos);
+            return;
+        }
+    }
+    script->tick_pos = omf_realloc(script->tick_pos, sizeof(int) * (script->frame_count + 1));
+    if(from == 0) {
+        script->tick_pos[0] = 0;
+    }
+    for(int i = from; i < script->frame_count; i++) {
+        script->tick_pos[i + 1] = script->tick_pos[i] + script->frames[i].tick_len;
+    }
+}
+
 int sd_script_decode(sd_script *script, const char *str, int *inv_pos) {
     if(script == NULL || str == NULL)
         return SD_INVALID_INPUT;
@@ -169,7 +204,11 @@ int sd_script_decode(sd_script *script, const char *str, int *inv_pos) {
                 test[k] = 0;
 
                 // See if the current tag matches with anything.
-                if(sd_tag_info(test, &req_param, &tag, &desc) == 0) {
+                int tag_id = sd_tag_find(test);
+                if(tag_id >= 0) {
+                    tag = sd_taglist[tag_id].tag;
+                    desc = sd_taglist[tag_id].description;
+                    req_param = sd_taglist[tag_id].has_param;
                     has_end = 0;
                     i += k;
                     found = 1;
@@ -183,6 +222,8 @@ int sd_script_decode(sd_script *script, const char *str, int *inv_pos) {
                     frame->tags[tag_number].key = tag;
                     frame->tags[tag_number].desc = desc;
                     frame->tags[tag_number].has_param = req_param;
+                    frame->tags[tag_number].id = tag_id;
+                    frame->tag_mask[TAG_MASK_WORD(tag_id)] |= TAG_MASK_BIT(tag_id);
                     if(req_param) {
                         frame->tags[tag_number].value = read_next_int(str, &i);
                     }
@@ -230,6 +271,7 @@ int sd_script_decode(sd_script *script, const char *str, int *inv_pos) {
         script->frame_count += 1; // Make sure our last entry is freed
         return SD_ANIM_INVALID_STRING;
     }
+    _update_tick_pos(script, 0);
     return SD_SUCCESS;
 }
 
@@ -286,21 +328,10 @@ int sd_script_encoded_length(const sd_script *script) {
 }
 
 const sd_script_frame *sd_script_get_frame_at(const sd_script *script, int ticks) {
-    if(script == NULL)
+    int index = sd_script_get_frame_index_at(script, ticks);
+    if(index < 0)
         return NULL;
-    if(ticks < 0)
-        return NULL;
-
-    int pos = 0;
-    int next = 0;
-    for(int i = 0; i < script->frame_count; i++) {
-        next = pos + script->frames[i].tick_len;
-        if(pos <= ticks && ticks < next) {
-            return &script->frames[i];
-        }
-        pos = next;
-    }
-    return NULL;
+    return &script->frames[index];
 }
 
 const sd_script_frame *sd_script_get_frame(const sd_script *script, int frame_number) {
@@ -335,6 +366,25 @@ int sd_script_get_frame_index_at(const sd_script *script, int ticks) {
     if(script == NULL || ticks < 0)
         return -1;
 
+    // Binary search for the last frame starting at or before the tick. Zero length
+    // frames share their start position with the next frame, so they are skipped
+    // over just like in the linear scan below.
+    if(script->tick_pos != NULL) {
+        if(ticks >= script->tick_pos[script->frame_count])
+            return -1;
+        int lo = 0;
+        int hi = script->frame_count;
+        while(lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if(script->tick_pos[mid + 1] <= ticks) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
     int pos = 0;
     int next = 0;
     for(int i = 0; i < script->frame_count; i++) {
@@ -406,6 +456,25 @@ int sd_script_get(const sd_script_frame *frame, const char *tag) {
     return stag->value;
 }
 
+int sd_script_isset_id(const sd_script_frame *frame, sd_tag_id tag) {
+    if(frame == NULL) {
+        return 0;
+    }
+    return (frame->tag_mask[TAG_MASK_WORD(tag)] & TAG_MASK_BIT(tag)) != 0;
+}
+
+int sd_script_get_id(const sd_script_frame *frame, sd_tag_id tag) {
+    if(!sd_script_isset_id(frame, tag)) {
+        return 0;
+    }
+    for(int i = 0; i < frame->tag_count; i++) {
+        if(frame->tags[i].id == tag) {
+            return frame->tags[i].value;
+        }
+    }
+    return 0;
+}
+
 int sd_script_next_frame_with_sprite(const sd_script *script, int sprite_id, int current_tick) {
     if(script == NULL)
         return -1;
@@ -446,6 +515,25 @@ int sd_script_next_frame_with_tag(const sd_script *script, const char *tag, int
     return -1;
 }
 
+int sd_script_next_frame_with_tag_id(const sd_script *script, sd_tag_id tag, int current_tick) {
+    if(script == NULL || tag < 0 || tag >= SD_TAG_COUNT)
+        return -1;
+    if(current_tick > sd_script_get_total_ticks(script))
+        return -1;
+
+    int pos = 0;
+    int next = 0;
+    for(int i = 0; i < script->frame_count; i++) {
+        next = pos + script->frames[i].tick_len;
+        if(current_tick < pos && sd_script_isset_id(&script->frames[i], tag)) {
+            return i;
+        }
+        pos = next;
+    }
+
+    return -1;
+}
+
 int sd_script_delete_tag(sd_script *script, int frame_id, const char *tag) {
     if(script == NULL || tag == NULL)
         return SD_INVALID_INPUT;
@@ -468,6 +556,7 @@ int sd_script_delete_tag(sd_script *script, int frame_id, const char *tag) {
     if(tag_num < 0) {
         return SD_SUCCESS; // No tag, stop here
     }
+    int tag_id = frame->tags[tag_num].id;
 
     // Move if this is not the last entry
     if(tag_num + 1 < frame->tag_count) {
@@ -477,6 +566,11 @@ int sd_script_delete_tag(sd_script *script, int frame_id, const char *tag) {
         memmove(dst, src, len);
     }
     frame->tag_count--;
+
+    // Only clear the presence bit if the tag is not set twice in the frame
+    if(_sd_script_get_tag(frame, tag) == NULL) {
+        frame->tag_mask[TAG_MASK_WORD(tag_id)] &= ~TAG_MASK_BIT(tag_id);
+    }
     return SD_SUCCESS;
 }
 
@@ -490,12 +584,13 @@ int sd_script_set_tag(sd_script *script, int frame_id, const char *tag, int valu
     sd_script_frame *frame = &script->frames[frame_id];
 
     // Get tag information
-    const char *r_tag;
-    const char *r_desc;
-    int req_param;
-    if(sd_tag_info(tag, &req_param, &r_tag, &r_desc) != SD_SUCCESS) {
+    int tag_id = sd_tag_find(tag);
+    if(tag_id < 0) {
         return SD_INVALID_INPUT;
     }
+    const char *r_tag = sd_taglist[tag_id].tag;
+    const char *r_desc = sd_taglist[tag_id].description;
+    int req_param = sd_taglist[tag_id].has_param;
 
     // See if old tag has been set
     sd_script_tag *old_tag = _sd_script_get_tag(frame, r_tag);
@@ -506,6 +601,8 @@ int sd_script_set_tag(sd_script *script, int frame_id, const char *tag, int valu
         frame->tags[frame->tag_count].desc = r_desc;
         frame->tags[frame->tag_count].has_param = req_param;
         frame->tags[frame->tag_count].value = value;
+        frame->tags[frame->tag_count].id = tag_id;
+        frame->tag_mask[TAG_MASK_WORD(tag_id)] |= TAG_MASK_BIT(tag_id);
         frame->tag_count++;
     } else if(req_param) {
         // If the tag exists and requires a value, set it.
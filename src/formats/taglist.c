@@ -159,3 +159,5 @@ const sd_tag sd_taglist[] = {
 };
 
 const int sd_taglist_size = 152;
+
+_Static_assert(sizeof(sd_taglist) / sizeof(sd_tag) == SD_TAG_COUNT, "sd_tag_id and sd_taglist are out of sync");
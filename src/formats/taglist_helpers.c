@@ -3,17 +3,25 @@
 #include <stdlib.h>
 #include <string.h>
 
-int sd_tag_info(const char *search_tag, int *req_param, const char **tag, const char **desc) {
+int sd_tag_find(const char *search_tag) {
     for(int i = 0; i < sd_taglist_size; i++) {
         if(strcmp(search_tag, sd_taglist[i].tag) == 0) {
-            if(req_param != NULL)
-                *req_param = sd_taglist[i].has_param;
-            if(tag != NULL)
-                *tag = sd_taglist[i].tag;
-            if(desc != NULL)
-                *desc = sd_taglist[i].description;
-            return SD_SUCCESS;
+            return i;
         }
     }
-    return SD_INVALID_INPUT;
+    return -1;
+}
+
+int sd_tag_info(const char *search_tag, int *req_param, const char **tag, const char **desc) {
+    int i = sd_tag_find(search_tag);
+    if(i < 0) {
+        return SD_INVALID_INPUT;
+    }
+    if(req_param != NULL)
+        *req_param = sd_taglist[i].has_param;
+    if(tag != NULL)
+        *tag = sd_taglist[i].tag;
+    if(desc != NULL)
+        *desc = sd_taglist[i].description;
+    return SD_SUCCESS;
 }
@@ -19,14 +19,18 @@
 #include "game/scenes/openomf.h"
 #include "game/scenes/scoreboard.h"
 #include "game/scenes/vs.h"
+#include "game/utils/phase_timings.h"
+#include "game/utils/render_queue.h"
+#include "game/utils/rollback.h"
 #include "game/utils/serial.h"
 #include "game/utils/settings.h"
 #include "game/utils/ticktimer.h"
 #include "resources/pilots.h"
+#include "resources/resource_cache.h"
 #include "utils/allocator.h"
 #include "utils/log.h"
 #include "utils/miscmath.h"
-#include "video/tcache.h"
+#include "utils/random.h"
 #include "video/video.h"
 #include <SDL.h>
 #include <math.h>
@@ -43,6 +47,11 @@ enum
 
 static void _setup_rec_controller(game_state *gs, int player_id, sd_rec_file *rec);
 
+// Objects are pooled in slabs of this many items. Userdata of up to USERDATA_POOL_ITEM_SIZE
+// bytes is pooled as well, anything larger is allocated separately.
+#define OBJECT_POOL_SLAB_ITEMS 64
+#define USERDATA_POOL_ITEM_SIZE 64
+
 // How long the scene waits after order to move to another scene
 // Used for crossfades
 #define FRAME_WAIT_TICKS 30
@@ -64,7 +73,13 @@ int game_state_create(game_state *gs, engine_init_flags *init_flags) {
     gs->net_mode = init_flags->net_mode;
     gs->speed = settings_get()->gameplay.speed + 5;
     gs->init_flags = init_flags;
-    vector_create(&gs->objects, sizeof(render_obj));
+    gs->timings = NULL;
+    gs->rollback = NULL;
+    random_seed(&gs->rand, (init_flags->seed != 0) ? init_flags->seed : rand_intmax());
+    slotmap_create(&gs->objects, sizeof(render_obj));
+    render_queue_create(&gs->render_queue);
+    pool_create(&gs->object_pool, sizeof(object), OBJECT_POOL_SLAB_ITEMS);
+    pool_create(&gs->userdata_pool, USERDATA_POOL_ITEM_SIZE, OBJECT_POOL_SLAB_ITEMS);
 
     // For screen shake
     gs->screen_shake_horizontal = 0;
@@ -88,7 +103,10 @@ int game_state_create(game_state *gs, engine_init_flags *init_flags) {
         game_player_create(gs->players[i]);
     }
 
-    reconfigure_controller(gs);
+    // Headless runs get their controllers below, and must not touch the input devices
+    if(!init_flags->headless) {
+        reconfigure_controller(gs);
+    }
     int nscene;
     if(strlen(init_flags->rec_file) > 0 && init_flags->record == 0) {
         sd_rec_file rec;
@@ -122,6 +140,24 @@ int game_state_create(game_state *gs, engine_init_flags *init_flags) {
             PERROR("Error while creating arena scene.");
             goto error_1;
         }
+    } else if(init_flags->headless) {
+        // Without a recording, headless runs simulate a single AI vs. AI match
+        if(init_flags->match != NULL) {
+            game_state_init_match(gs, init_flags->match);
+            nscene = SCENE_ARENA0 + init_flags->match->arena;
+        } else {
+            game_state_init_demo(gs);
+            nscene = rand_arena(&gs->rand);
+        }
+        DEBUG("running headless demo match in arena scene %d", nscene);
+        if(scene_create(gs->sc, gs, nscene)) {
+            PERROR("Error while loading scene %d.", nscene);
+            goto error_0;
+        }
+        if(arena_create(gs->sc)) {
+            PERROR("Error while creating arena scene.");
+            goto error_1;
+        }
     } else {
         // Select correct starting scene and load resources
         nscene = (init_flags->net_mode == NET_MODE_NONE ? SCENE_OPENOMF : SCENE_MENU);
@@ -155,10 +191,62 @@ error_1:
     scene_free(gs->sc);
 error_0:
     omf_free(gs->sc);
-    vector_free(&gs->objects);
+    slotmap_free(&gs->objects);
+    render_queue_free(&gs->render_queue);
+    pool_free(&gs->userdata_pool);
+    pool_free(&gs->object_pool);
     return 1;
 }
 
+/*
+ * Objects and userdata that are spawned during play come from per game state pools, since
+ * destruction sequences spawn and remove hundreds of them per second. The release functions
+ * also accept memory from omf_calloc, so objects that are created once by the scenes do not
+ * need to care about this.
+ */
+object *game_state_alloc_object(game_state *gs) {
+    return pool_alloc(&gs->object_pool);
+}
+
+void game_state_release_object(game_state *gs, object *obj) {
+    if(pool_owns(&gs->object_pool, obj)) {
+        pool_release(&gs->object_pool, obj);
+    } else {
+        omf_free(obj);
+    }
+}
+
+void *game_state_alloc_userdata(game_state *gs, size_t size) {
+    if(size > USERDATA_POOL_ITEM_SIZE) {
+        return omf_calloc(1, size);
+    }
+    return pool_alloc(&gs->userdata_pool);
+}
+
+void game_state_release_userdata(game_state *gs, void *ptr) {
+    if(pool_owns(&gs->userdata_pool, ptr)) {
+        pool_release(&gs->userdata_pool, ptr);
+    } else {
+        omf_free(ptr);
+    }
+}
+
+/*
+ * Removes an object from the game state and frees it. Only a tombstone is left behind in the
+ * object table, so this is safe to do while iterating the objects. The tombstones are dropped
+ * when the objects are compacted in game_state_cleanup().
+ */
+static void game_state_remove_object(game_state *gs, slot_handle handle) {
+    render_obj *robj = slotmap_get(&gs->objects, handle);
+    if(robj == NULL) {
+        return;
+    }
+    object *obj = robj->obj;
+    slotmap_remove(&gs->objects, handle);
+    object_free(obj);
+    game_state_release_object(gs, obj);
+}
+
 /*
  * \param game_state gs Game state object
  * \param obj Object to add
@@ -176,7 +264,7 @@ int game_state_add_object(game_state *gs, object *obj, int layer, int singleton,
     if(singleton) {
         iterator it;
         render_obj *robj;
-        vector_iter_begin(&gs->objects, &it);
+        slotmap_iter_begin(&gs->objects, &it);
         while((robj = iter_next(&it)) != NULL) {
             animation *ani = object_get_animation(robj->obj);
             if(ani != NULL && ani->id == new_ani->id && robj->singleton) {
@@ -184,7 +272,12 @@ int game_state_add_object(game_state *gs, object *obj, int layer, int singleton,
             }
         }
     }
-    vector_append(&gs->objects, &o);
+    slot_handle handle = slotmap_insert(&gs->objects, &o);
+    if(handle == SLOT_HANDLE_NONE) {
+        PERROR("Unable to add object to game_state: no free slots left.");
+        return 1;
+    }
+    obj->handle = handle;
 
 #ifdef DEBUGMODE_STFU
     animation *ani = object_get_animation(obj);
@@ -216,13 +309,11 @@ unsigned int game_state_get_speed(game_state *gs) {
 void game_state_del_animation(game_state *gs, int anim_id) {
     iterator it;
     render_obj *robj;
-    vector_iter_begin(&gs->objects, &it);
+    slotmap_iter_begin(&gs->objects, &it);
     while((robj = iter_next(&it)) != NULL) {
         animation *ani = object_get_animation(robj->obj);
         if(ani != NULL && ani->id == anim_id) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, slotmap_iter_handle(&gs->objects, &it));
             DEBUG("Deleted animation %i from game_state.", anim_id);
             return;
         }
@@ -231,23 +322,27 @@ void game_state_del_animation(game_state *gs, int anim_id) {
 }
 
 void game_state_del_object(game_state *gs, object *target) {
-    iterator it;
-    render_obj *robj;
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
-        if(target == robj->obj) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
-            return;
-        }
+    if(target == NULL) {
+        return;
+    }
+    render_obj *robj = slotmap_get(&gs->objects, target->handle);
+    if(robj != NULL && robj->obj == target) {
+        game_state_remove_object(gs, target->handle);
+    }
+}
+
+object *game_state_find_object(game_state *gs, slot_handle handle) {
+    render_obj *robj = slotmap_get(&gs->objects, handle);
+    if(robj == NULL) {
+        return NULL;
     }
+    return robj->obj;
 }
 
 void game_state_get_projectiles(game_state *gs, vector *obj_proj) {
     iterator it;
     render_obj *robj;
-    vector_iter_begin(&gs->objects, &it);
+    slotmap_iter_begin(&gs->objects, &it);
     while((robj = iter_next(&it)) != NULL) {
         if(object_get_layers(robj->obj) & LAYER_PROJECTILE) {
             vector_append(obj_proj, &robj->obj);
@@ -258,12 +353,25 @@ void game_state_get_projectiles(game_state *gs, vector *obj_proj) {
 void game_state_clear_hazards_projectiles(game_state *gs) {
     iterator it;
     render_obj *robj;
-    vector_iter_begin(&gs->objects, &it);
+    slotmap_iter_begin(&gs->objects, &it);
     while((robj = iter_next(&it)) != NULL) {
         if(object_get_group(robj->obj) == GROUP_PROJECTILE) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, slotmap_iter_handle(&gs->objects, &it));
+        }
+    }
+}
+
+// Starts decoding the resources of the next scene on the loader thread, so that they are
+// ready by the time the crossfade is over. The HARs are already picked when we get to the
+// VS screen, so their AF files are fetched early too.
+static void game_state_prefetch(game_state *gs, unsigned int scene_id) {
+    if(scene_id == SCENE_NONE) {
+        return;
+    }
+    resource_cache_prefetch_bk(scene_to_resource(scene_id));
+    if(scene_id == SCENE_VS || (scene_id >= SCENE_ARENA0 && scene_id <= SCENE_ARENA4)) {
+        for(int i = 0; i < game_state_num_players(gs); i++) {
+            resource_cache_prefetch_af(har_to_resource(game_state_get_player(gs, i)->har_id));
         }
     }
 }
@@ -273,6 +381,7 @@ void game_state_set_next(game_state *gs, unsigned int next_scene_id) {
         gs->next_wait_ticks = FRAME_WAIT_TICKS;
         gs->next_next_id = SCENE_MENU;
         gs->next_id = next_scene_id;
+        game_state_prefetch(gs, next_scene_id);
     }
 }
 
@@ -300,25 +409,52 @@ int game_state_handle_event(game_state *gs, SDL_Event *event) {
     return 1;
 }
 
-void game_state_render(game_state *gs) {
+// Runs the palette transformations of all objects, and queues the objects for rendering while
+// at it. HARs are queued separately, depending on whether they are attacking or not.
+static int game_state_build_render_queue(game_state *gs, screen_palette *scr_pal) {
+    static const render_band layer_bands[RENDER_LAYER_COUNT] = {RENDER_BAND_BOTTOM, RENDER_BAND_MIDDLE,
+                                                                RENDER_BAND_TOP};
+    object *har[2];
+    har[0] = game_state_get_player(gs, 0)->har;
+    har[1] = game_state_get_player(gs, 1)->har;
+
     iterator it;
     render_obj *robj;
-
-    // Do palette transformations
-    screen_palette *scr_pal = video_get_pal_ref();
     int pal_changed = 0;
-    vector_iter_begin(&gs->objects, &it);
+    render_queue_clear(&gs->render_queue);
+    slotmap_iter_begin(&gs->objects, &it);
     while((robj = iter_next(&it)) != NULL) {
         if(object_palette_transform(robj->obj, scr_pal) == 1) {
             pal_changed = 1;
-            gs->next_requires_refresh = 1;
+        }
+        render_queue_add(&gs->render_queue, RENDER_BAND_SHADOWS, robj->obj);
+        if(robj->obj == har[0] || robj->obj == har[1]) {
+            continue;
+        }
+        if(robj->layer >= 0 && robj->layer < RENDER_LAYER_COUNT) {
+            render_queue_add(&gs->render_queue, layer_bands[robj->layer], robj->obj);
+        }
+    }
+
+    for(int i = 0; i < 2; i++) {
+        if(har[i] != NULL) {
+            render_band band = har_is_active(har[i]) ? RENDER_BAND_ACTIVE_HARS : RENDER_BAND_PASSIVE_HARS;
+            render_queue_add(&gs->render_queue, band, har[i]);
         }
     }
+    return pal_changed;
+}
 
-    // If changes were made to palette, then
-    // all resources that depend on it must be redrawn.
-    // This will take care of it.
-    if(pal_changed) {
+void game_state_render(game_state *gs) {
+    uint64_t phase_start = phase_timings_begin(gs->timings);
+
+    // Do palette transformations
+    screen_palette *scr_pal = video_get_pal_ref();
+    if(game_state_build_render_queue(gs, scr_pal)) {
+        gs->next_requires_refresh = 1;
+        // If changes were made to palette, then
+        // all resources that depend on it must be redrawn.
+        // This will take care of it.
         scr_pal->version++;
     } else if(gs->next_requires_refresh) {
         // Because of caching, we might sometimes get stuck to
@@ -330,63 +466,13 @@ void game_state_render(game_state *gs) {
     // Render scene background
     scene_render(gs->sc);
 
-    // Get har objects
-    object *har[2];
-    har[0] = game_state_get_player(gs, 0)->har;
-    har[1] = game_state_get_player(gs, 1)->har;
-
-    // Render BOTTOM layer
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
-        if(robj->layer == RENDER_LAYER_BOTTOM) {
-            if(robj->obj == har[0] || robj->obj == har[1])
-                continue;
-            object_render(robj->obj);
-        }
-    }
-
-    // cast object shadows (scrap, projectiles, etc)
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
-        object_render_shadow(robj->obj);
-    }
-
-    // Render passive HARs here
-    for(int i = 0; i < 2; i++) {
-        if(har[i] != NULL && !har_is_active(har[i])) {
-            object_render(har[i]);
-        }
-    }
-
-    // Render MIDDLE layer
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
-        if(robj->layer == RENDER_LAYER_MIDDLE) {
-            if(robj->obj == har[0] || robj->obj == har[1])
-                continue;
-            object_render(robj->obj);
-        }
-    }
-
-    // Render active HARs here
-    for(int i = 0; i < 2; i++) {
-        if(har[i] != NULL && har_is_active(har[i])) {
-            object_render(har[i]);
-        }
-    }
-
-    // Render TOP layer
-    vector_iter_begin(&gs->objects, &it);
-    while((robj = iter_next(&it)) != NULL) {
-        if(robj->layer == RENDER_LAYER_TOP) {
-            if(robj->obj == har[0] || robj->obj == har[1])
-                continue;
-            object_render(robj->obj);
-        }
-    }
+    // Render objects; bottom layer, shadows, passive HARs, middle layer, active HARs, top layer.
+    render_queue_render(&gs->render_queue);
 
     // Render scene overlay (menus, etc.)
     scene_render_overlay(gs->sc);
+
+    phase_timings_end(gs->timings, PHASE_RENDER, phase_start);
 }
 
 void game_state_debug(game_state *gs) {
@@ -406,20 +492,16 @@ int game_load_new(game_state *gs, int scene_id) {
     scene_free(gs->sc);
     omf_free(gs->sc);
 
-    // Clear up old video cache objects
-    tcache_clear();
-
     // Remove old objects
     render_obj *robj;
     iterator it;
-    vector_iter_begin(&gs->objects, &it);
+    slotmap_iter_begin(&gs->objects, &it);
     while((robj = iter_next(&it)) != NULL) {
         if(!robj->persistent) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, slotmap_iter_handle(&gs->objects, &it));
         }
     }
+    slotmap_compact(&gs->objects);
 
     // Initialize new scene with BK data etc.
     gs->sc = omf_calloc(1, sizeof(scene));
@@ -520,11 +602,26 @@ error_0:
 
 void game_state_call_collide(game_state *gs) {
     object *a, *b;
-    unsigned int size = vector_size(&gs->objects);
-    for(int i = 0; i < size; i++) {
-        a = ((render_obj *)vector_get(&gs->objects, i))->obj;
-        for(int k = i + 1; k < size; k++) {
-            b = ((render_obj *)vector_get(&gs->objects, k))->obj;
+    render_obj *robj;
+    unsigned int size = slotmap_span(&gs->objects);
+    for(unsigned int i = 0; i < size; i++) {
+        if((robj = slotmap_get_at(&gs->objects, i)) == NULL) {
+            continue;
+        }
+        a = robj->obj;
+
+        // object_collide() only ever runs the callback of the first object of the pair,
+        // so pairs starting with an object without one can never do anything. Only HARs
+        // have collision callbacks, so this turns the all-pairs scan into a linear one.
+        // Pair order is unchanged.
+        if(a->collide == NULL || a->layers == 0) {
+            continue;
+        }
+        for(unsigned int k = i + 1; k < size; k++) {
+            if((robj = slotmap_get_at(&gs->objects, k)) == NULL) {
+                continue;
+            }
+            b = robj->obj;
             if(a->group != b->group || a->group == OBJECT_NO_GROUP || b->group == OBJECT_NO_GROUP) {
                 if(a->layers & b->layers) {
                     object_collide(a, b);
@@ -537,21 +634,20 @@ void game_state_call_collide(game_state *gs) {
 void game_state_cleanup(game_state *gs) {
     render_obj *robj;
     iterator it;
-    vector_iter_begin(&gs->objects, &it);
+    slotmap_iter_begin(&gs->objects, &it);
     while((robj = iter_next(&it)) != NULL) {
         if(object_finished(robj->obj)) {
             /*DEBUG("Animation object %d is finished, removing.", robj->obj->cur_animation->id);*/
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
+            game_state_remove_object(gs, slotmap_iter_handle(&gs->objects, &it));
         }
     }
+    slotmap_compact(&gs->objects);
 }
 
 void game_state_call_move(game_state *gs) {
     render_obj *robj;
     iterator it;
-    vector_iter_begin(&gs->objects, &it);
+    slotmap_iter_begin(&gs->objects, &it);
     while((robj = iter_next(&it)) != NULL) {
         object_move(robj->obj);
     }
@@ -592,7 +688,7 @@ void game_state_ctrl_events_free(game_state *gs) {
 void game_state_call_tick(game_state *gs, int mode) {
     render_obj *robj;
     iterator it;
-    vector_iter_begin(&gs->objects, &it);
+    slotmap_iter_begin(&gs->objects, &it);
     while((robj = iter_next(&it)) != NULL) {
         if(mode == TICK_DYNAMIC) {
             object_dynamic_tick(robj->obj);
@@ -630,6 +726,33 @@ void game_state_static_tick(game_state *gs) {
     game_state_call_tick(gs, TICK_STATIC);
 }
 
+// Moves the objects of the scene forward by one tick
+static void game_state_simulate(game_state *gs) {
+    // Clean up objects
+    uint64_t phase_start = phase_timings_begin(gs->timings);
+    game_state_cleanup(gs);
+    phase_timings_end(gs->timings, PHASE_CLEANUP, phase_start);
+
+    // Call object_move for all objects
+    phase_start = phase_timings_begin(gs->timings);
+    game_state_call_move(gs);
+    phase_timings_end(gs->timings, PHASE_CALL_MOVE, phase_start);
+
+    // Handle physics for all pairs of objects
+    phase_start = phase_timings_begin(gs->timings);
+    game_state_call_collide(gs);
+    phase_timings_end(gs->timings, PHASE_CALL_COLLIDE, phase_start);
+
+    // Tick all objects
+    phase_start = phase_timings_begin(gs->timings);
+    game_state_call_tick(gs, TICK_DYNAMIC);
+    phase_timings_end(gs->timings, PHASE_CALL_TICK, phase_start);
+
+    // Increment tick
+    gs->tick++;
+    LOGTICK(gs->tick);
+}
+
 // This function is called when the game speed requires it
 void game_state_dynamic_tick(game_state *gs) {
     // We want to load another scene
@@ -684,30 +807,30 @@ void game_state_dynamic_tick(game_state *gs) {
 
     game_state_dyntick_controllers(gs);
 
+    // In a rollback game, the simulation waits when the peer falls too far behind. Otherwise the
+    // state is rolled back first if some earlier tick was run with the wrong input.
+    int paused = game_state_is_paused(gs);
+    int stalled = gs->rollback != NULL && !rollback_can_advance(gs->rollback);
+    if(gs->rollback != NULL && !paused && !stalled) {
+        rollback_update(gs->rollback, gs);
+        rollback_save(gs->rollback, gs);
+    }
+
     // Tick scene
-    scene_dynamic_tick(gs->sc, game_state_is_paused(gs));
+    uint64_t phase_start = phase_timings_begin(gs->timings);
+    scene_dynamic_tick(gs->sc, paused || stalled);
+    phase_timings_end(gs->timings, PHASE_SCENE_DYNAMIC_TICK, phase_start);
 
     // Poll input. If console is opened, do not poll the controllers.
-    if(!console_window_is_open()) {
+    if(!console_window_is_open() && !stalled) {
         scene_input_poll(gs->sc);
     }
 
-    if(!game_state_is_paused(gs)) {
-        // Clean up objects
-        game_state_cleanup(gs);
-
-        // Call object_move for all objects
-        game_state_call_move(gs);
-
-        // Handle physics for all pairs of objects
-        game_state_call_collide(gs);
-
-        // Tick all objects
-        game_state_call_tick(gs, TICK_DYNAMIC);
-
-        // Increment tick
-        gs->tick++;
-        LOGTICK(gs->tick);
+    if(!paused && !stalled) {
+        if(gs->rollback != NULL) {
+            rollback_apply_inputs(gs->rollback, gs);
+        }
+        game_state_simulate(gs);
     }
 
     // Free extra controller events
@@ -777,7 +900,7 @@ void _setup_ai(game_state *gs, int player_id) {
     controller_init(ctrl);
 
     sd_pilot *pilot = game_player_get_pilot(player);
-    ai_controller_create(ctrl, settings_get()->gameplay.difficulty, pilot, player->pilot_id);
+    ai_controller_create(ctrl, settings_get()->gameplay.difficulty, pilot, player->pilot_id, &gs->rand);
 
     game_player_set_ctrl(player, ctrl);
     game_player_set_selectable(player, 0);
@@ -819,6 +942,14 @@ void reconfigure_controller(game_state *gs) {
     _setup_keyboard(gs, 1);
 }
 
+static void _set_pilot_colors(game_player *player) {
+    pilot pilot_info;
+    pilot_get_info(&pilot_info, player->pilot_id);
+    player->colors[0] = pilot_info.colors[0];
+    player->colors[1] = pilot_info.colors[1];
+    player->colors[2] = pilot_info.colors[2];
+}
+
 void game_state_init_demo(game_state *gs) {
     // Set up player controller
     for(int i = 0; i < game_state_num_players(gs); i++) {
@@ -826,21 +957,31 @@ void game_state_init_demo(game_state *gs) {
         controller *ctrl = omf_calloc(1, sizeof(controller));
         controller_init(ctrl);
         sd_pilot *pl = game_player_get_pilot(player);
-        ai_controller_create(ctrl, 4, pl, player->pilot_id);
+        ai_controller_create(ctrl, 4, pl, player->pilot_id, &gs->rand);
         game_player_set_ctrl(player, ctrl);
         game_player_set_selectable(player, 1);
 
         // select random pilot and har
-        player->pilot_id = rand_int(10);
-        player->har_id = rand_int(11);
+        player->pilot_id = random_int(&gs->rand, 10);
+        player->har_id = random_int(&gs->rand, 11);
+        chr_score_reset(&player->score, 1);
+        _set_pilot_colors(player);
+    }
+}
+
+void game_state_init_match(game_state *gs, const engine_match_setup *match) {
+    for(int i = 0; i < game_state_num_players(gs); i++) {
+        game_player *player = game_state_get_player(gs, i);
+        player->pilot_id = match->pilot_id[i];
+        player->har_id = match->har_id[i];
         chr_score_reset(&player->score, 1);
+        _set_pilot_colors(player);
 
-        // set proper color
-        pilot pilot_info;
-        pilot_get_info(&pilot_info, player->pilot_id);
-        player->colors[0] = pilot_info.colors[0];
-        player->colors[1] = pilot_info.colors[1];
-        player->colors[2] = pilot_info.colors[2];
+        controller *ctrl = omf_calloc(1, sizeof(controller));
+        controller_init(ctrl);
+        ai_controller_create(ctrl, match->difficulty, game_player_get_pilot(player), player->pilot_id, &gs->rand);
+        game_player_set_ctrl(player, ctrl);
+        game_player_set_selectable(player, 1);
     }
 }
 
@@ -851,13 +992,12 @@ void game_state_free(game_state **_gs) {
     // Free objects
     render_obj *robj;
     iterator it;
-    vector_iter_begin(&gs->objects, &it);
+    slotmap_iter_begin(&gs->objects, &it);
     while((robj = iter_next(&it)) != NULL) {
-        object_free(robj->obj);
-        omf_free(robj->obj);
-        vector_delete(&gs->objects, &it);
+        game_state_remove_object(gs, slotmap_iter_handle(&gs->objects, &it));
     }
-    vector_free(&gs->objects);
+    slotmap_free(&gs->objects);
+    render_queue_free(&gs->render_queue);
 
     // Free scene
     scene_free(gs->sc);
@@ -869,6 +1009,14 @@ void game_state_free(game_state **_gs) {
         game_player_free(gs->players[i]);
         omf_free(gs->players[i]);
     }
+
+    // Free object pools. Everything allocated from them should be gone by now.
+    pool_stats stats;
+    pool_get_stats(&gs->object_pool, &stats);
+    DEBUG("Object pool: %u allocations, at most %u objects in use (%u slabs).", stats.allocs, stats.peak,
+          stats.slabs);
+    pool_free(&gs->userdata_pool);
+    pool_free(&gs->object_pool);
     omf_free(gs);
 }
 
@@ -891,10 +1039,48 @@ int game_state_ms_per_dyntick(game_state *gs) {
     return MS_PER_OMF_TICK;
 }
 
+unsigned int game_state_serialize_projectiles(game_state *gs, serial *ser) {
+    iterator it;
+    slotmap_iter_begin(&gs->objects, &it);
+    render_obj *robj;
+    unsigned int count = 0;
+    while((robj = iter_next(&it)) != NULL) {
+        if(robj->obj->group == GROUP_PROJECTILE) {
+            serial_write_int8(ser, robj->layer);
+            object_serialize(robj->obj, ser);
+            count++;
+        }
+    }
+    return count;
+}
+
+void game_state_unserialize_projectiles(game_state *gs, serial *ser, unsigned int count) {
+    // clean out any current projectiles/hazards
+    iterator it;
+    slotmap_iter_begin(&gs->objects, &it);
+    render_obj *robj;
+    while((robj = iter_next(&it)) != NULL) {
+        if(robj->obj->group == GROUP_PROJECTILE) {
+            game_state_remove_object(gs, slotmap_iter_handle(&gs->objects, &it));
+        }
+    }
+    slotmap_compact(&gs->objects);
+
+    for(unsigned int i = 0; i < count; i++) {
+        object *obj = game_state_alloc_object(gs);
+        int layer = serial_read_int8(ser);
+        object_create(obj, gs, vec2i_create(0, 0), vec2f_create(0, 0));
+        object_unserialize(obj, ser, gs);
+        DEBUG("newly added object finish status %d", object_finished(obj));
+
+        game_state_add_object(gs, obj, layer, 0, 0);
+    }
+}
+
 int game_state_serialize(game_state *gs, serial *ser) {
     // serialize tick time and random seed, so client can reply state from this point
     serial_write_int32(ser, game_state_get_tick(gs));
-    serial_write_int32(ser, rand_get_seed());
+    serial_write_int32(ser, random_get_seed(&gs->rand));
     serial_write_int32(ser, game_state_is_paused(gs));
 
     object *har[2];
@@ -906,22 +1092,9 @@ int game_state_serialize(game_state *gs, serial *ser) {
 
     serial objects;
     serial_create(&objects);
-
-    // serialize any HAZARD or PROJECTILE objects
-    iterator it;
-    vector_iter_begin(&gs->objects, &it);
-    render_obj *robj;
-    uint8_t count = 0;
-    while((robj = iter_next(&it)) != NULL) {
-        if(robj->obj->group == GROUP_PROJECTILE) {
-            serial_write_int8(&objects, robj->layer);
-            object_serialize(robj->obj, &objects);
-            count++;
-        }
-    }
+    uint8_t count = game_state_serialize_projectiles(gs, &objects);
     serial_write_int8(ser, count);
-
-    serial_write(ser, objects.data, objects.len);
+    serial_write(ser, objects.data, serial_len(&objects));
     serial_free(&objects);
 
     chr_score_serialize(game_player_get_score(game_state_get_player(gs, 0)), ser);
@@ -930,30 +1103,21 @@ int game_state_serialize(game_state *gs, serial *ser) {
     return 0;
 }
 
-int game_state_unserialize(game_state *gs, serial *ser, int rtt) {
-    int old_tick = gs->tick;
+int game_state_restore(game_state *gs, serial *ser) {
     gs->tick = serial_read_int32(ser);
-    int end_tick = gs->tick + ceilf(rtt / 2.0f);
-    rand_seed(serial_read_int32(ser));
+    uint32_t seed = serial_read_int32(ser);
     game_state_set_paused(gs, serial_read_int32(ser));
 
     for(int i = 0; i < 2; i++) {
-        // Declare some vars
+        // The HARs are rebuilt in the same object and slot, so that the objects are still
+        // ticked in the same order as on the peer.
         game_player *player = game_state_get_player(gs, i);
-        game_state_del_object(gs, player->har);
-        object *obj = omf_calloc(1, sizeof(object));
-
-        // Create object and specialize it as HAR.
-        // Errors are unlikely here, but check anyway.
-
+        object *obj = player->har;
+        slot_handle handle = obj->handle;
+        object_free(obj);
         object_create(obj, gs, vec2i_create(0, 0), vec2f_create(0, 0));
         object_unserialize(obj, ser, gs);
-
-        // Set HAR to controller and game_player
-        game_state_add_object(gs, obj, RENDER_LAYER_MIDDLE, 0, 0);
-
-        // Set HAR for player
-        game_player_set_har(player, obj);
+        obj->handle = handle;
         game_player_get_ctrl(player)->har = obj;
     }
 
@@ -965,44 +1129,35 @@ int game_state_unserialize(game_state *gs, serial *ser, int rtt) {
     obj_har1->animation_state.enemy = obj_har2;
     obj_har2->animation_state.enemy = obj_har1;
 
-    // clean out any current projectiles/hazards
-    iterator it;
-    vector_iter_begin(&gs->objects, &it);
-    render_obj *robj;
-    while((robj = iter_next(&it)) != NULL) {
-        if(robj->obj->group == GROUP_PROJECTILE) {
-            object_free(robj->obj);
-            omf_free(robj->obj);
-            vector_delete(&gs->objects, &it);
-        }
-    }
-
     uint8_t count = serial_read_int8(ser);
-
-    for(int i = 0; i < count; i++) {
-        object *obj = omf_calloc(1, sizeof(object));
-        int layer = serial_read_int8(ser);
-        object_create(obj, gs, vec2i_create(0, 0), vec2f_create(0, 0));
-        object_unserialize(obj, ser, gs);
-        DEBUG("newly added object finish status %d", object_finished(obj));
-
-        game_state_add_object(gs, obj, layer, 0, 0);
-    }
+    game_state_unserialize_projectiles(gs, ser, count);
 
     chr_score_unserialize(game_player_get_score(game_state_get_player(gs, 0)), ser);
     chr_score_unserialize(game_player_get_score(game_state_get_player(gs, 1)), ser);
 
+    // Creating the objects above took numbers from the generator
+    random_seed(&gs->rand, seed);
+    return 0;
+}
+
+int game_state_unserialize(game_state *gs, serial *ser, int rtt) {
+    int old_tick = gs->tick;
+    game_state_restore(gs, ser);
+    int end_tick = gs->tick + ceilf(rtt / 2.0f);
+
     // tick things back to the current time
     DEBUG("replaying %d ticks", end_tick - gs->tick);
     DEBUG("adjusting clock from %d to %d (%d)", old_tick, end_tick, ceilf(rtt / 2.0f));
     while(gs->tick <= end_tick) {
-        game_state_cleanup(gs);
-        game_state_call_move(gs);
-        game_state_call_collide(gs);
-        game_state_call_tick(gs, TICK_DYNAMIC);
-        gs->tick++;
+        game_state_simulate(gs);
     }
     DEBUG("replay done");
 
     return 0;
 }
+
+void game_state_resim_tick(game_state *gs) {
+    scene_dynamic_tick(gs->sc, 0);
+    rollback_apply_inputs(gs->rollback, gs);
+    game_state_simulate(gs);
+}
@@ -337,34 +337,34 @@ int har_is_blocking(har *h, af_move *move) {
 }
 
 int har_is_invincible(object *obj, af_move *move) {
-    if(player_frame_isset(obj, "zz")) {
+    if(player_frame_isset(obj, TAG_ZZ)) {
         // blocks everything
         return 1;
     }
     switch(move->category) {
         // XX 'zg' is not handled here, but the game doesn't use it...
         case CAT_LOW:
-            if(player_frame_isset(obj, "zl")) {
+            if(player_frame_isset(obj, TAG_ZL)) {
                 return 1;
             }
             break;
         case CAT_MEDIUM:
-            if(player_frame_isset(obj, "zm")) {
+            if(player_frame_isset(obj, TAG_ZM)) {
                 return 1;
             }
             break;
         case CAT_HIGH:
-            if(player_frame_isset(obj, "zh")) {
+            if(player_frame_isset(obj, TAG_ZH)) {
                 return 1;
             }
             break;
         case CAT_JUMPING:
-            if(player_frame_isset(obj, "zj")) {
+            if(player_frame_isset(obj, TAG_ZJ)) {
                 return 1;
             }
             break;
         case CAT_PROJECTILE:
-            if(player_frame_isset(obj, "zp")) {
+            if(player_frame_isset(obj, TAG_ZP)) {
                 return 1;
             }
             break;
@@ -395,7 +395,7 @@ void cb_har_spawn_object(object *parent, int id, vec2i pos, vec2f vel, uint8_t f
     // ... otherwise expect it is a projectile
     af_move *move = af_get_move(h->af_data, id);
     if(move != NULL) {
-        object *obj = omf_calloc(1, sizeof(object));
+        object *obj = game_state_alloc_object(parent->gs);
         object_create(obj, parent->gs, pos, vel);
         object_set_userdata(obj, h);
         object_set_stl(obj, object_get_stl(parent));
@@ -437,14 +437,14 @@ void cb_har_spawn_object(object *parent, int id, vec2i pos, vec2f vel, uint8_t f
 }
 
 void har_floor_landing_effects(object *obj) {
-    int amount = rand_int(2) + 1;
+    int amount = random_int(&obj->gs->rand, 2) + 1;
     for(int i = 0; i < amount; i++) {
-        int variance = rand_int(20) - 10;
+        int variance = random_int(&obj->gs->rand, 20) - 10;
         vec2i coord = vec2i_create(obj->pos.x + variance + i * 10, obj->pos.y);
-        object *dust = omf_calloc(1, sizeof(object));
+        object *dust = game_state_alloc_object(obj->gs);
         object_create(dust, obj->gs, coord, vec2f_create(0, 0));
         object_set_stl(dust, object_get_stl(obj));
-        object_set_animation(dust, &bk_get_info(&game_state_get_scene(obj->gs)->bk_data, 26)->ani);
+        object_set_animation(dust, &bk_get_info(game_state_get_scene(obj->gs)->bk_data, 26)->ani);
         game_state_add_object(obj->gs, dust, RENDER_LAYER_MIDDLE, 0, 0);
     }
 
@@ -647,7 +647,7 @@ void har_take_damage(object *obj, const str *string, float damage) {
         // XXX hack - if the first frame has the 'k' tag, treat it as some vertical knockback
         // we can't do this in player.c because it breaks the jaguar leap, which also uses the 'k' tag.
         const sd_script_frame *frame = sd_script_get_frame(&obj->animation_state.parser, 0);
-        if(frame != NULL && sd_script_isset(frame, "k")) {
+        if(frame != NULL && sd_script_isset_id(frame, TAG_K)) {
             obj->vel.y -= 7;
         }
     }
@@ -659,7 +659,7 @@ void har_spawn_oil(object *obj, vec2i pos, int amount, float gravity, int layer)
     // burning oil
     for(int i = 0; i < amount; i++) {
         // Calculate velocity etc.
-        float rv = rand_int(100) / 100.0f - 0.5;
+        float rv = random_int(&obj->gs->rand, 100) / 100.0f - 0.5;
         float velx = (5 * cos(90 + i - (amount) / 2 + rv)) * object_get_direction(obj);
         float vely = -12 * sin(i / amount + rv);
 
@@ -669,7 +669,7 @@ void har_spawn_oil(object *obj, vec2i pos, int amount, float gravity, int layer)
             vely += 0.21;
 
         // Create the object
-        object *scrap = omf_calloc(1, sizeof(object));
+        object *scrap = game_state_alloc_object(obj->gs);
         int anim_no = ANIM_BURNING_OIL;
         object_create(scrap, obj->gs, pos, vec2f_create(velx, vely));
         object_set_animation(scrap, &af_get_move(h->af_data, anim_no)->ani);
@@ -712,7 +712,7 @@ void har_spawn_scrap(object *obj, vec2i pos, int amount) {
     }
     for(int i = 0; i < scrap_amount; i++) {
         // Calculate velocity etc.
-        float rv = rand_int(100) / 100.0f - 0.5;
+        float rv = random_int(&obj->gs->rand, 100) / 100.0f - 0.5;
         float velx = (5 * cos(90 + i - (scrap_amount) / 2 + rv)) * object_get_direction(obj);
         float vely = -12 * sin(i / scrap_amount + rv);
 
@@ -728,8 +728,8 @@ void har_spawn_scrap(object *obj, vec2i pos, int amount) {
             vely += 0.21;
 
         // Create the object
-        object *scrap = omf_calloc(1, sizeof(object));
-        int anim_no = rand_int(3) + ANIM_SCRAP_METAL;
+        object *scrap = game_state_alloc_object(obj->gs);
+        int anim_no = random_int(&obj->gs->rand, 3) + ANIM_SCRAP_METAL;
         object_create(scrap, obj->gs, pos, vec2f_create(velx, vely));
         object_set_animation(scrap, &af_get_move(h->af_data, anim_no)->ani);
         object_set_stl(scrap, object_get_stl(obj));
@@ -759,7 +759,7 @@ void har_block(object *obj, vec2i hit_coord) {
         // don't make another scrape
         return;
     }
-    object *scrape = omf_calloc(1, sizeof(object));
+    object *scrape = game_state_alloc_object(obj->gs);
     object_create(scrape, obj->gs, hit_coord, vec2f_create(0, 0));
     object_set_animation(scrape, &af_get_move(h->af_data, ANIM_BLOCKING_SCRAPE)->ani);
     object_set_stl(scrape, object_get_stl(obj));
@@ -800,7 +800,7 @@ void har_check_closeness(object *obj_a, object *obj_b) {
 
     vec2i size_b = sprite_get_size(sprite_b);
 
-    // the 50 here is to reverse the damage done in har_fix_sprite_coords
+    // the 50 here is to reverse the damage done in load_af_file
     int y1 = pos_a.y + sprite_a->pos.y + 50;
     int y2 = pos_b.y - size_b.y;
 
@@ -980,7 +980,7 @@ void har_collide_with_har(object *obj_a, object *obj_b, int loop) {
     }
 
     // Check if collisions are switched off for the attacking HAR
-    if(player_frame_isset(obj_a, "n")) {
+    if(player_frame_isset(obj_a, TAG_N)) {
         DEBUG("COLLISIONS: Disabled for this frame.");
         return;
     }
@@ -996,11 +996,11 @@ void har_collide_with_har(object *obj_a, object *obj_b, int loop) {
     }
     if(a->damage_done == 0 &&
        (intersect_sprite_hitpoint(obj_a, obj_b, level, &hit_coord) || move->category == CAT_CLOSE ||
-        (player_frame_isset(obj_a, "ue") && b->state != STATE_JUMPING))) {
+        (player_frame_isset(obj_a, TAG_UE) && b->state != STATE_JUMPING))) {
 
         if(har_is_blocking(b, move) &&
            // earthquake smash is unblockable
-           !player_frame_isset(obj_a, "ue")) {
+           !player_frame_isset(obj_a, TAG_UE)) {
             har_event_enemy_block(a, move, false);
             har_event_block(b, move, false);
             har_block(obj_b, hit_coord);
@@ -1080,7 +1080,7 @@ void har_collide_with_projectile(object *o_har, object *o_pjt) {
     }
 
     // Check if collisions are switched off for the projectile
-    if(player_frame_isset(o_pjt, "n")) {
+    if(player_frame_isset(o_pjt, TAG_N)) {
         DEBUG("COLLISIONS: Disabled for this frame.");
         return;
     }
@@ -1131,7 +1131,7 @@ void har_collide_with_projectile(object *o_har, object *o_pjt) {
         object_set_vel(o_har, vel);
 
         // Exception case for chronos' time freeze
-        if(player_frame_isset(o_pjt, "af")) {
+        if(player_frame_isset(o_pjt, TAG_AF)) {
             h->in_stasis_ticks = 75;
         }
 
@@ -1173,7 +1173,7 @@ void har_collide_with_hazard(object *o_har, object *o_hzd) {
     }
 
     // Check if collisions are switched off for the hazard
-    if(player_frame_isset(o_hzd, "n")) {
+    if(player_frame_isset(o_hzd, TAG_N)) {
         return;
     }
 
@@ -1290,13 +1290,13 @@ void har_tick(object *obj) {
 
     // See if we are being grabbed. We detect this by checking the
     // "e" tag -- force to enemy position.
-    h->is_grabbed = player_frame_isset(obj, "e");
+    h->is_grabbed = player_frame_isset(obj, TAG_E);
 
     // Make sure HAR doesn't walk through walls
     // TODO: Roof!
     vec2i pos = object_get_pos(obj);
     if(h->state != STATE_DEFEAT) {
-        int wall_flag = player_frame_isset(obj, "aw");
+        int wall_flag = player_frame_isset(obj, TAG_AW);
         int wall = 0;
         int hit = 0;
         if(pos.x < ARENA_LEFT_WALL) {
@@ -1323,13 +1323,13 @@ void har_tick(object *obj) {
     }
 
     // Check for HAR specific palette tricks
-    if(player_frame_isset(obj, "ptr")) {
-        h->p_pal_ref = player_frame_isset(obj, "pd") ? player_frame_get(obj, "pd") : 0;
-        h->p_har_switch = player_frame_isset(obj, "pe");
-        h->p_color_ref = player_frame_get(obj, "ptr");
-        h->p_ticks_length = player_frame_isset(obj, "pp") ? player_frame_get(obj, "pp") : 0;
+    if(player_frame_isset(obj, TAG_PTR)) {
+        h->p_pal_ref = player_frame_isset(obj, TAG_PD) ? player_frame_get(obj, TAG_PD) : 0;
+        h->p_har_switch = player_frame_isset(obj, TAG_PE);
+        h->p_color_ref = player_frame_get(obj, TAG_PTR);
+        h->p_ticks_length = player_frame_isset(obj, TAG_PP) ? player_frame_get(obj, TAG_PP) : 0;
         h->p_ticks_left = h->p_ticks_length;
-        h->p_color_fn = player_frame_isset(obj, "pa");
+        h->p_color_fn = player_frame_isset(obj, TAG_PA);
     }
 
     // Object took walldamage, but has now landed
@@ -1406,7 +1406,7 @@ void har_tick(object *obj) {
     }
 
     // Flip tint effect flag
-    if(player_frame_isset(obj, "bt")) {
+    if(player_frame_isset(obj, TAG_BT)) {
         object_add_effects(obj, EFFECT_DARK_TINT);
     } else {
         object_del_effects(obj, EFFECT_DARK_TINT);
@@ -1417,9 +1417,9 @@ void har_tick(object *obj) {
     // to show the sprite with animation string that interpolates opacity down
     // Mark new object as the owner of the animation, so that the animation gets
     // removed when the object is finished.
-    if(player_frame_isset(obj, "ub") && obj->age % 2 == 0) {
+    if(player_frame_isset(obj, TAG_UB) && obj->age % 2 == 0) {
         sprite *nsp = sprite_copy(obj->cur_sprite);
-        object *nobj = omf_calloc(1, sizeof(object));
+        object *nobj = game_state_alloc_object(obj->gs);
         object_create(nobj, obj->gs, object_get_pos(obj), vec2f_create(0, 0));
         object_set_stl(nobj, object_get_stl(obj));
         object_set_animation(nobj, create_animation_from_single(nsp, obj->cur_animation->start_pos));
@@ -1522,113 +1522,105 @@ void add_input(char *buf, int act_type, int direction) {
 af_move *match_move(object *obj, char *inputs) {
     har *h = object_get_userdata(obj);
     af_move *move = NULL;
-    size_t len;
-    for(int i = 0; i < 70; i++) {
-        if((move = af_get_move(h->af_data, i))) {
-            len = move->move_string.len;
-            if(!strncmp(str_c(&move->move_string), inputs, len)) {
-                if(move->category == CAT_CLOSE && h->close != 1) {
-                    // not standing close enough
-                    continue;
-                }
-                if(move->category == CAT_JUMPING && h->state != STATE_JUMPING) {
-                    // not jumping
-                    continue;
-                }
-                if(move->category != CAT_JUMPING && h->state == STATE_JUMPING) {
-                    // jumping but this move is not a jumping move
-                    continue;
-                }
-                if(move->category == CAT_SCRAP && h->state != STATE_VICTORY) {
-                    continue;
-                }
+    uint32_t matches[AF_MOVE_MASK_WORDS] = {0};
+    af_match_moves(h->af_data, inputs, matches);
+    for(int i = af_next_move(matches, 0); i >= 0; i = af_next_move(matches, i + 1)) {
+        move = af_get_move(h->af_data, i);
+        if(move->category == CAT_CLOSE && h->close != 1) {
+            // not standing close enough
+            continue;
+        }
+        if(move->category == CAT_JUMPING && h->state != STATE_JUMPING) {
+            // not jumping
+            continue;
+        }
+        if(move->category != CAT_JUMPING && h->state == STATE_JUMPING) {
+            // jumping but this move is not a jumping move
+            continue;
+        }
+        if(move->category == CAT_SCRAP && h->state != STATE_VICTORY) {
+            continue;
+        }
 
-                if(move->category == CAT_DESTRUCTION && h->state != STATE_SCRAP) {
-                    continue;
-                }
+        if(move->category == CAT_DESTRUCTION && h->state != STATE_SCRAP) {
+            continue;
+        }
 
-                if(h->state != STATE_JUMPING && move->pos_constraints & 0x2) {
-                    DEBUG("Position contraint prevents move when not jumping!");
-                    // required to be jumping
-                    continue;
-                }
-                if(h->is_wallhugging != 1 && move->pos_constraints & 0x1) {
-                    DEBUG("Position contraint prevents move when not wallhugging!");
-                    // required to be wall hugging
-                    continue;
-                }
+        if(h->state != STATE_JUMPING && move->pos_constraints & 0x2) {
+            DEBUG("Position contraint prevents move when not jumping!");
+            // required to be jumping
+            continue;
+        }
+        if(h->is_wallhugging != 1 && move->pos_constraints & 0x1) {
+            DEBUG("Position contraint prevents move when not wallhugging!");
+            // required to be wall hugging
+            continue;
+        }
 
-                if(h->executing_move && !h->enqueued) {
-                    // check if the current frame allows chaining
-                    int allowed = 0;
-                    if(player_frame_isset(obj, "jn") && i == player_frame_get(obj, "jn")) {
-                        allowed = 1;
-                    } else {
-                        switch(move->category) {
-                            case CAT_LOW:
-                                if(player_frame_isset(obj, "jl")) {
-                                    allowed = 1;
-                                }
-                                break;
-                            case CAT_MEDIUM:
-                                if(player_frame_isset(obj, "jm")) {
-                                    allowed = 1;
-                                }
-                                break;
-                            case CAT_HIGH:
-                                if(player_frame_isset(obj, "jh")) {
-                                    allowed = 1;
-                                }
-                                break;
-                            case CAT_SCRAP:
-                                if(player_frame_isset(obj, "jf")) {
-                                    allowed = 1;
-                                }
-                                break;
-                            case CAT_DESTRUCTION:
-                                if(player_frame_isset(obj, "jf2")) {
-                                    allowed = 1;
-                                }
-                                break;
+        if(h->executing_move && !h->enqueued) {
+            // check if the current frame allows chaining
+            int allowed = 0;
+            if(player_frame_isset(obj, TAG_JN) && i == player_frame_get(obj, TAG_JN)) {
+                allowed = 1;
+            } else {
+                switch(move->category) {
+                    case CAT_LOW:
+                        if(player_frame_isset(obj, TAG_JL)) {
+                            allowed = 1;
                         }
-                    }
-                    if(player_get_current_tick(obj) >= player_get_len_ticks(obj)) {
-                        DEBUG("enqueueing %d %s", i, str_c(&move->move_string));
-                        h->enqueued = i;
-                        return NULL;
-                    }
-
-                    if(!allowed) {
-                        // not allowed
-                        continue;
-                    }
-                    DEBUG("CHAINING");
+                        break;
+                    case CAT_MEDIUM:
+                        if(player_frame_isset(obj, TAG_JM)) {
+                            allowed = 1;
+                        }
+                        break;
+                    case CAT_HIGH:
+                        if(player_frame_isset(obj, TAG_JH)) {
+                            allowed = 1;
+                        }
+                        break;
+                    case CAT_SCRAP:
+                        if(player_frame_isset(obj, TAG_JF)) {
+                            allowed = 1;
+                        }
+                        break;
+                    case CAT_DESTRUCTION:
+                        if(player_frame_isset(obj, TAG_JF2)) {
+                            allowed = 1;
+                        }
+                        break;
                 }
+            }
+            if(player_get_current_tick(obj) >= player_get_len_ticks(obj)) {
+                DEBUG("enqueueing %d %s", i, str_c(&move->move_string));
+                h->enqueued = i;
+                return NULL;
+            }
 
-                DEBUG("matched move %d with string %s", i, str_c(&move->move_string));
-                /*DEBUG("input was %s", h->inputs);*/
-                return move;
+            if(!allowed) {
+                // not allowed
+                continue;
             }
+            DEBUG("CHAINING");
         }
+
+        DEBUG("matched move %d with string %s", i, str_c(&move->move_string));
+        /*DEBUG("input was %s", h->inputs);*/
+        return move;
     }
     return NULL;
 }
 
 af_move *scrap_destruction_cheat(object *obj, char *inputs) {
     har *h = object_get_userdata(obj);
-    for(int i = 0; i < 70; i++) {
-        af_move *move;
-        if((move = af_get_move(h->af_data, i))) {
-            if(move->category == CAT_SCRAP && h->state == STATE_VICTORY && inputs[0] == 'K') {
-                return move;
-            }
-
-            if(move->category == CAT_DESTRUCTION && h->state == STATE_SCRAP && inputs[0] == 'P') {
-                return move;
-            }
-        }
-    }
-    return NULL;
+    uint32_t moves[AF_MOVE_MASK_WORDS] = {0};
+    if(h->state == STATE_VICTORY && inputs[0] == 'K') {
+        af_category_moves(h->af_data, CAT_SCRAP, moves);
+    } else if(h->state == STATE_SCRAP && inputs[0] == 'P') {
+        af_category_moves(h->af_data, CAT_DESTRUCTION, moves);
+    }
+    int id = af_next_move(moves, 0);
+    return (id >= 0) ? af_get_move(h->af_data, id) : NULL;
 }
 
 int maybe_har_change_state(int oldstate, int direction, int act_type) {
@@ -1842,7 +1834,7 @@ int har_act(object *obj, int act_type) {
     if(h->executing_move) {
         if(obj->pos.y < ARENA_FLOOR) {
             // XXX I think 'i' is for 'not interruptable'
-            if(h->state < STATE_JUMPING && !player_frame_isset(obj, "i")) {
+            if(h->state < STATE_JUMPING && !player_frame_isset(obj, TAG_I)) {
                 DEBUG("standing move led to airborne one");
                 h->state = STATE_JUMPING;
             } else if(h->state != STATE_JUMPING) {
@@ -2128,6 +2120,39 @@ void har_copy_actions(object *new, object *old) {
     memcpy(h_new->act_buf, h_old->act_buf, sizeof(action_buffer) * OBJECT_EVENT_BUFFER_SIZE);
 }
 
+void har_snapshot_create(har_snapshot *snap) {
+    object_snapshot_create(&snap->obj);
+}
+
+void har_snapshot_free(har_snapshot *snap) {
+    object_snapshot_free(&snap->obj);
+}
+
+void har_snapshot_save(const object *obj, har_snapshot *snap) {
+    object_snapshot_save(obj, &snap->obj);
+    snap->h = *(har *)object_get_userdata(obj);
+}
+
+void har_snapshot_restore(object *obj, const har_snapshot *snap) {
+    object_snapshot_restore(obj, &snap->obj);
+
+    // Hooks belong to whoever installed them, and are not part of the state
+    har *h = object_get_userdata(obj);
+    list har_hooks = h->har_hooks;
+    har_action_hook_cb action_hook_cb = h->action_hook_cb;
+    void *action_hook_cb_data = h->action_hook_cb_data;
+#ifdef DEBUGMODE
+    surface cd_debug = h->cd_debug;
+#endif
+    *h = snap->h;
+    h->har_hooks = har_hooks;
+    h->action_hook_cb = action_hook_cb;
+    h->action_hook_cb_data = action_hook_cb_data;
+#ifdef DEBUGMODE
+    h->cd_debug = cd_debug;
+#endif
+}
+
 int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int player_id) {
     // Create local data
     har *local = omf_calloc(1, sizeof(har));
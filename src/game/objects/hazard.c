@@ -34,7 +34,8 @@ void hazard_tick(object *obj) {
             float mag;
             int limit = 10;
             do {
-                obj->orbit_dest = vec2f_create(rand_float() * 320.0f, rand_float() * 200.0f);
+                obj->orbit_dest =
+                    vec2f_create(random_float(&obj->gs->rand) * 320.0f, random_float(&obj->gs->rand) * 200.0f);
                 obj->orbit_dest_dir = vec2f_sub(obj->orbit_dest, obj->orbit_pos);
                 mag = sqrtf(obj->orbit_dest_dir.x * obj->orbit_dest_dir.x +
                             obj->orbit_dest_dir.y * obj->orbit_dest_dir.y);
@@ -51,9 +52,9 @@ void hazard_spawn_cb(object *parent, int id, vec2i pos, vec2f vel, uint8_t flags
     scene *sc = (scene *)userdata;
 
     // Get next animation
-    bk_info *info = bk_get_info(&sc->bk_data, id);
+    bk_info *info = bk_get_info(sc->bk_data, id);
     if(info != NULL) {
-        object *obj = omf_calloc(1, sizeof(object));
+        object *obj = game_state_alloc_object(parent->gs);
         object_create(obj, parent->gs, vec2i_add(pos, info->ani.start_pos), vel);
         object_set_stl(obj, object_get_stl(parent));
         object_set_animation(obj, &info->ani);
@@ -106,10 +107,10 @@ int hazard_serialize(object *obj, serial *ser) {
 }
 
 int hazard_unserialize(object *obj, serial *ser, int animation_id, game_state *gs) {
-    bk *bk_data = &gs->sc->bk_data;
+    bk *bk_data = gs->sc->bk_data;
     hazard_create(obj, gs->sc);
     object_set_userdata(obj, bk_data);
-    object_set_stl(obj, bk_data->sound_translation_table);
+    object_set_stl(obj, gs->sc->stl);
     object_set_animation(obj, &bk_get_info(bk_data, animation_id)->ani);
     return 0;
 }
@@ -31,7 +31,7 @@ void projectile_tick(object *obj) {
     }
 
     // Set effect flags
-    if(player_frame_isset(obj, "bt")) {
+    if(player_frame_isset(obj, TAG_BT)) {
         object_add_effects(obj, EFFECT_DARK_TINT);
     } else {
         object_del_effects(obj, EFFECT_DARK_TINT);
@@ -40,8 +40,8 @@ void projectile_tick(object *obj) {
 
 void projectile_free(object *obj) {
     projectile_local *local = object_get_userdata(obj);
-    omf_free(local);
-    object_set_userdata(obj, local);
+    game_state_release_userdata(obj->gs, local);
+    object_set_userdata(obj, NULL);
 }
 
 void projectile_move(object *obj) {
@@ -125,7 +125,7 @@ void projectile_bootstrap(object *obj) {
 
 int projectile_create(object *obj) {
     // strore the HAR in local userdata instead
-    projectile_local *local = omf_calloc(1, sizeof(projectile_local));
+    projectile_local *local = game_state_alloc_userdata(obj->gs, sizeof(projectile_local));
     local->owner = obj;
     local->wall_bounce = 0;
     local->ground_freeze = 0;
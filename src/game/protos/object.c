@@ -22,6 +22,7 @@
 void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel) {
     // State
     obj->gs = gs;
+    obj->handle = SLOT_HANDLE_NONE;
 
     // Position related
     obj->pos = vec2i_to_f(pos);
@@ -67,7 +68,7 @@ void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel) {
 
     obj->custom_str = NULL;
 
-    random_seed(&obj->rand_state, rand_intmax());
+    random_seed(&obj->rand_state, random_intmax(&gs->rand));
 
     // For enabling hit on the current and the next n-1 frames
     obj->hit_frames = 0;
@@ -239,6 +240,74 @@ int object_unserialize(object *obj, serial *ser, game_state *gs) {
     return 0;
 }
 
+void object_snapshot_create(object_snapshot *snap) {
+    memset(snap, 0, sizeof(object_snapshot));
+}
+
+void object_snapshot_free(object_snapshot *snap) {
+    omf_free(snap->custom_str);
+    snap->custom_str_size = 0;
+}
+
+/**
+ * \brief Copies the state of an object into a snapshot.
+ *
+ * Nothing is allocated, unless the object has a custom animation string that is longer than
+ * any seen by the snapshot before.
+ *
+ * \param obj Object to take the snapshot of
+ * \param snap Snapshot to write into
+ */
+void object_snapshot_save(const object *obj, object_snapshot *snap) {
+    // The memory owned by the object (custom string, animation script) is copied as pointers
+    // only, and never used from the snapshot.
+    snap->obj = *obj;
+    snap->has_custom_str = (obj->custom_str != NULL);
+    if(obj->custom_str != NULL) {
+        size_t len = strlen(obj->custom_str) + 1;
+        if(len > snap->custom_str_size) {
+            snap->custom_str = omf_realloc(snap->custom_str, len);
+            snap->custom_str_size = len;
+        }
+        memcpy(snap->custom_str, obj->custom_str, len);
+    }
+}
+
+static int object_snapshot_script_matches(const object *obj, const object_snapshot *snap) {
+    if(obj->cur_animation != snap->obj.cur_animation || (obj->custom_str != NULL) != snap->has_custom_str) {
+        return 0;
+    }
+    return !snap->has_custom_str || strcmp(obj->custom_str, snap->custom_str) == 0;
+}
+
+/**
+ * \brief Restores the state of an object in place from a snapshot.
+ *
+ * The object keeps its memory. The animation script is only decoded again if the object has
+ * switched animations since the snapshot was taken. Only meant for objects that do not own
+ * their animation, such as HARs.
+ *
+ * \param obj Object to restore. Must be the object the snapshot was taken of.
+ * \param snap Snapshot to read from
+ */
+void object_snapshot_restore(object *obj, const object_snapshot *snap) {
+    if(!object_snapshot_script_matches(obj, snap)) {
+        omf_free(obj->custom_str);
+        obj->cur_animation = snap->obj.cur_animation;
+        if(snap->has_custom_str) {
+            obj->custom_str = strdup(snap->custom_str);
+            player_reload_with_str(obj, obj->custom_str);
+        } else {
+            player_reload(obj);
+        }
+    }
+    char *custom_str = obj->custom_str;
+    sd_script parser = obj->animation_state.parser;
+    *obj = snap->obj;
+    obj->custom_str = custom_str;
+    obj->animation_state.parser = parser;
+}
+
 void object_set_stride(object *obj, int stride) {
     if(stride < 1) {
         stride = 1;
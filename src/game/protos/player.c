@@ -144,16 +144,16 @@ void player_reset(object *obj) {
     obj->animation_state.previous = -1;
 }
 
-int player_frame_isset(const object *obj, const char *tag) {
+int player_frame_isset(const object *obj, sd_tag_id tag) {
     const sd_script_frame *frame =
         sd_script_get_frame_at(&obj->animation_state.parser, obj->animation_state.current_tick);
-    return sd_script_isset(frame, tag);
+    return sd_script_isset_id(frame, tag);
 }
 
-int player_frame_get(const object *obj, const char *tag) {
+int player_frame_get(const object *obj, sd_tag_id tag) {
     const sd_script_frame *frame =
         sd_script_get_frame_at(&obj->animation_state.parser, obj->animation_state.current_tick);
-    return sd_script_get(frame, tag);
+    return sd_script_get_id(frame, tag);
 }
 
 /*
@@ -161,7 +161,7 @@ int player_frame_get(const object *obj, const char *tag) {
  */
 void player_set_delay(object *obj, int delay) {
     // find the first frame that spawns a projectile, if any
-    int r = sd_script_next_frame_with_tag(&obj->animation_state.parser, "m", 0);
+    int r = sd_script_next_frame_with_tag_id(&obj->animation_state.parser, TAG_M, 0);
     int frames = (r >= 0) ? r : 99;
 
     // find the first frame with hit coordinates
@@ -254,19 +254,19 @@ void player_run(object *obj) {
     assert(frame != NULL);
 
     // Get MP flag content, set to 0 if not set.
-    uint8_t mp = sd_script_isset(frame, "mp") ? sd_script_get(frame, "mp") & 0xFF : 0;
+    uint8_t mp = sd_script_isset_id(frame, TAG_MP) ? sd_script_get_id(frame, TAG_MP) & 0xFF : 0;
 
     // See if x+/- or y+/- are set and save values
     int trans_x = 0, trans_y = 0;
-    if(sd_script_isset(frame, "y-")) {
-        trans_y = sd_script_get(frame, "y-") * -1;
-    } else if(sd_script_isset(frame, "y+")) {
-        trans_y = sd_script_get(frame, "y+");
+    if(sd_script_isset_id(frame, TAG_Y_MINUS)) {
+        trans_y = sd_script_get_id(frame, TAG_Y_MINUS) * -1;
+    } else if(sd_script_isset_id(frame, TAG_Y_PLUS)) {
+        trans_y = sd_script_get_id(frame, TAG_Y_PLUS);
     }
-    if(sd_script_isset(frame, "x-")) {
-        trans_x = sd_script_get(frame, "x-") * -1 * object_get_direction(obj);
-    } else if(sd_script_isset(frame, "x+")) {
-        trans_x = sd_script_get(frame, "x+") * object_get_direction(obj);
+    if(sd_script_isset_id(frame, TAG_X_MINUS)) {
+        trans_x = sd_script_get_id(frame, TAG_X_MINUS) * -1 * object_get_direction(obj);
+    } else if(sd_script_isset_id(frame, TAG_X_PLUS)) {
+        trans_x = sd_script_get_id(frame, TAG_X_PLUS) * object_get_direction(obj);
     }
 
     // Check if frame changed from the previous tick
@@ -280,7 +280,7 @@ void player_run(object *obj) {
 
         // Print out MP flags here (just once for this frame)
         if(mp != 0) {
-            DEBUG("mp flags set for new animation %d:", sd_script_get(frame, "m"));
+            DEBUG("mp flags set for new animation %d:", sd_script_get_id(frame, TAG_M));
             if(mp & 0x1)
                 DEBUG(" * 0x01: NON-HAR Sprite");
             if(mp & 0x2)
@@ -299,11 +299,11 @@ void player_run(object *obj) {
                 DEBUG(" * 0x80: Sprite timer related ?");
         }
 
-        if(sd_script_isset(frame, "ar")) {
+        if(sd_script_isset_id(frame, TAG_AR)) {
             rstate->dir_correction = -1;
         }
 
-        if(sd_script_isset(frame, "cf")) {
+        if(sd_script_isset_id(frame, TAG_CF)) {
             // shadow's scrap, position is in the corner behind shadow
             if(object_get_direction(obj) == OBJECT_FACE_RIGHT) {
                 obj->pos.x = 0;
@@ -314,7 +314,7 @@ void player_run(object *obj) {
             obj->animation_state.shadow_corner_hack = 1;
         }
 
-        if(sd_script_isset(frame, "ac")) {
+        if(sd_script_isset_id(frame, TAG_AC)) {
             // force the har to face the center of the arena
             if(obj->pos.x > 160) {
                 object_set_direction(obj, OBJECT_FACE_LEFT);
@@ -323,8 +323,8 @@ void player_run(object *obj) {
             }
         }
 
-        /*if (sd_script_isset(frame, "bm")) {
-            if (sd_script_isset(frame, "am") && sd_script_isset(frame, "e")) {
+        /*if (sd_script_isset_id(frame, TAG_BM)) {
+            if (sd_script_isset_id(frame, TAG_AM) && sd_script_isset_id(frame, TAG_E)) {
                 // destination is the enemy's position
                 DEBUG("BE tag with x/y offsets: %d %d %d %d", trans_x, trans_y, object_get_direction(obj),
         object_get_direction(state->enemy)); DEBUG("enemy x %d modified trans_x: %d (%d * %d * %d)",
@@ -336,7 +336,7 @@ void player_run(object *obj) {
                 // hack because we don't have 'walk to other HAR' implemented
                 obj->pos.x = state->enemy->pos.x + (trans_x * object_get_direction(obj) *
         object_get_direction(state->enemy)); obj->pos.y = state->enemy->pos.y + trans_y; } else if
-        (sd_script_isset(frame, "cf")) {
+        (sd_script_isset_id(frame, TAG_CF)) {
                 // shadow's scrap, position is in the corner behind shadow
                 if (object_get_direction(obj) == OBJECT_FACE_RIGHT) {
                     obj->pos.x = 0;
@@ -353,12 +353,12 @@ void player_run(object *obj) {
     }
 
     // Tick management
-    if(sd_script_isset(frame, "d") && !obj->animation_state.disable_d) {
-        state->previous_tick = sd_script_get(frame, "d") - 1;
-        state->current_tick = sd_script_get(frame, "d");
+    if(sd_script_isset_id(frame, TAG_D) && !obj->animation_state.disable_d) {
+        state->previous_tick = sd_script_get_id(frame, TAG_D) - 1;
+        state->current_tick = sd_script_get_id(frame, TAG_D);
     }
 
-    if(sd_script_isset(frame, "e")) {
+    if(sd_script_isset_id(frame, TAG_E)) {
         // Set speed to 0, since we're being controlled by animation tag system
         obj->vel.x = 0;
         obj->vel.y = 0;
@@ -371,18 +371,18 @@ void player_run(object *obj) {
     }
 
     // Set to ground
-    if(sd_script_isset(frame, "g")) {
+    if(sd_script_isset_id(frame, TAG_G)) {
         obj->vel.y = 0;
         obj->pos.y = ARENA_FLOOR;
     }
 
-    if(sd_script_isset(frame, "h")) {
+    if(sd_script_isset_id(frame, TAG_H)) {
         // Hover, reset all velocities to 0 on every frame
         obj->vel.x = 0;
         obj->vel.y = 0;
     }
 
-    if(sd_script_isset(frame, "at")) {
+    if(sd_script_isset_id(frame, TAG_AT)) {
         // set the object's X position to be behind the opponent
         if(obj->pos.x > state->enemy->pos.x) { // From right to left
             obj->pos.x = state->enemy->pos.x - object_get_size(obj).x / 2;
@@ -394,7 +394,7 @@ void player_run(object *obj) {
 
     // Handle vx+/-, vy+/-, x+/-. y+/-
     if(trans_x || trans_y) {
-        if(sd_script_isset(frame, "v")) {
+        if(sd_script_isset_id(frame, TAG_V)) {
             obj->vel.x = trans_x * (mp & 0x20 ? -1 : 1);
             obj->vel.y = trans_y;
             // DEBUG("vel x+%d, y+%d to x=%f, y=%f", trans_x * (mp & 0x20 ? -1 : 1), trans_y, obj->vel.x, obj->vel.y);
@@ -423,125 +423,125 @@ void player_run(object *obj) {
     // If frame changed, do something
     if(state->entered_frame) {
         // Animation creation command
-        if(sd_script_isset(frame, "m") && state->spawn != NULL) {
+        if(sd_script_isset_id(frame, TAG_M) && state->spawn != NULL) {
             int mx = 0;
             int my = 0;
             float vx = 0;
             float vy = 0;
 
-            if(obj->animation_state.shadow_corner_hack && sd_script_get(frame, "m") == 65) {
+            if(obj->animation_state.shadow_corner_hack && sd_script_get_id(frame, TAG_M) == 65) {
                 mx = state->enemy->pos.x;
                 my = state->enemy->pos.y;
             }
 
             // Staring X coordinate for new animation
-            if(sd_script_isset(frame, "mrx")) {
-                int mrx = sd_script_get(frame, "mrx");
-                int mm = sd_script_isset(frame, "mm") ? sd_script_get(frame, "mm") : mrx;
+            if(sd_script_isset_id(frame, TAG_MRX)) {
+                int mrx = sd_script_get_id(frame, TAG_MRX);
+                int mm = sd_script_isset_id(frame, TAG_MM) ? sd_script_get_id(frame, TAG_MM) : mrx;
                 mx = random_int(&obj->rand_state, 320 - 2 * mm) + mrx;
                 DEBUG("randomized mx as %d", mx);
-            } else if(sd_script_isset(frame, "mx")) {
-                mx = obj->start.x + (sd_script_get(frame, "mx") * object_get_direction(obj));
+            } else if(sd_script_isset_id(frame, TAG_MX)) {
+                mx = obj->start.x + (sd_script_get_id(frame, TAG_MX) * object_get_direction(obj));
             }
 
             // Staring Y coordinate for new animation
-            if(sd_script_isset(frame, "mry")) {
-                int mry = sd_script_get(frame, "mry");
-                int mm = sd_script_isset(frame, "mm") ? sd_script_get(frame, "mm") : mry;
+            if(sd_script_isset_id(frame, TAG_MRY)) {
+                int mry = sd_script_get_id(frame, TAG_MRY);
+                int mm = sd_script_isset_id(frame, TAG_MM) ? sd_script_get_id(frame, TAG_MM) : mry;
                 my = random_int(&obj->rand_state, 320 - 2 * mm) + mry;
                 DEBUG("randomized my as %d", my);
-            } else if(sd_script_isset(frame, "my")) {
-                my = obj->start.y + sd_script_get(frame, "my");
+            } else if(sd_script_isset_id(frame, TAG_MY)) {
+                my = obj->start.y + sd_script_get_id(frame, TAG_MY);
             }
 
             // Angle/speed for new animation
-            if(sd_script_isset(frame, "ma")) {
-                int ma = sd_script_get(frame, "ma");
+            if(sd_script_isset_id(frame, TAG_MA)) {
+                int ma = sd_script_get_id(frame, TAG_MA);
                 vx = cosf(ma);
                 vy = sinf(ma);
                 DEBUG("MA is set! angle = %d, vx = %f, vy = %f", ma, vx, vy);
             }
 
             // Special positioning for certain desert arena sprites
-            int ms = sd_script_isset(frame, "ms");
+            int ms = sd_script_isset_id(frame, TAG_MS);
 
             // Gravity for new object
-            int mg = sd_script_isset(frame, "mg") ? sd_script_get(frame, "mg") : 0;
+            int mg = sd_script_isset_id(frame, TAG_MG) ? sd_script_get_id(frame, TAG_MG) : 0;
 
-            state->spawn(obj, sd_script_get(frame, "m"), vec2i_create(mx, my), vec2f_create(vx, vy), mp, ms, mg,
+            state->spawn(obj, sd_script_get_id(frame, TAG_M), vec2i_create(mx, my), vec2f_create(vx, vy), mp, ms, mg,
                          state->spawn_userdata);
         }
 
         // Animation deletion
-        if(sd_script_isset(frame, "md") && state->destroy != NULL) {
-            state->destroy(obj, sd_script_get(frame, "md"), state->destroy_userdata);
+        if(sd_script_isset_id(frame, TAG_MD) && state->destroy != NULL) {
+            state->destroy(obj, sd_script_get_id(frame, TAG_MD), state->destroy_userdata);
         }
 
         // Music playback
-        if(sd_script_isset(frame, "smo")) {
-            if(sd_script_get(frame, "smo") == 0) {
+        if(sd_script_isset_id(frame, TAG_SMO)) {
+            if(sd_script_get_id(frame, TAG_SMO) == 0) {
                 music_stop();
                 return;
             }
-            music_play(PSM_END + (sd_script_get(frame, "smo") - 1));
+            music_play(PSM_END + (sd_script_get_id(frame, TAG_SMO) - 1));
         }
-        if(sd_script_isset(frame, "smf")) {
+        if(sd_script_isset_id(frame, TAG_SMF)) {
             music_stop();
         }
 
         // Sound playback
-        if(sd_script_isset(frame, "s")) {
+        if(sd_script_isset_id(frame, TAG_S)) {
             float pitch = PITCH_DEFAULT;
             float volume = VOLUME_DEFAULT * (settings_get()->sound.sound_vol / 10.0f);
             float panning = PANNING_DEFAULT;
-            if(sd_script_isset(frame, "sf")) {
-                int p = clamp(sd_script_get(frame, "sf"), -16, 239);
+            if(sd_script_isset_id(frame, TAG_SF)) {
+                int p = clamp(sd_script_get_id(frame, TAG_SF), -16, 239);
                 pitch = clampf((p / 239.0f) * 3.0f + 1.0f, PITCH_MIN, PITCH_MAX);
             }
-            if(sd_script_isset(frame, "l")) {
-                int v = clamp(sd_script_get(frame, "l"), 0, 100);
+            if(sd_script_isset_id(frame, TAG_L)) {
+                int v = clamp(sd_script_get_id(frame, TAG_L), 0, 100);
                 volume = (v / 100.0f) * (settings_get()->sound.sound_vol / 10.0f);
             }
-            if(sd_script_isset(frame, "sb")) {
-                panning = clamp(sd_script_get(frame, "sb"), -100, 100) / 100.0f;
+            if(sd_script_isset_id(frame, TAG_SB)) {
+                panning = clamp(sd_script_get_id(frame, TAG_SB), -100, 100) / 100.0f;
             }
-            int sound_id = obj->sound_translation_table[sd_script_get(frame, "s")] - 1;
+            int sound_id = obj->sound_translation_table[sd_script_get_id(frame, TAG_S)] - 1;
             sound_play(sound_id, volume, panning, pitch);
         }
 
         // Blend mode stuff
-        if(sd_script_isset(frame, "bb")) {
-            rstate->blend_finish = sd_script_get(frame, "bb");
-            rstate->screen_shake_vertical = sd_script_get(frame, "bb");
+        if(sd_script_isset_id(frame, TAG_BB)) {
+            rstate->blend_finish = sd_script_get_id(frame, TAG_BB);
+            rstate->screen_shake_vertical = sd_script_get_id(frame, TAG_BB);
         }
-        if(sd_script_isset(frame, "bf")) {
-            rstate->blend_finish = sd_script_get(frame, "bf");
+        if(sd_script_isset_id(frame, TAG_BF)) {
+            rstate->blend_finish = sd_script_get_id(frame, TAG_BF);
         }
-        if(sd_script_isset(frame, "bl")) {
-            rstate->blend_finish = sd_script_get(frame, "bl");
-            rstate->screen_shake_horizontal = sd_script_get(frame, "bl");
+        if(sd_script_isset_id(frame, TAG_BL)) {
+            rstate->blend_finish = sd_script_get_id(frame, TAG_BL);
+            rstate->screen_shake_horizontal = sd_script_get_id(frame, TAG_BL);
         }
-        if(sd_script_isset(frame, "bm")) {
-            rstate->blend_finish = sd_script_get(frame, "bm");
+        if(sd_script_isset_id(frame, TAG_BM)) {
+            rstate->blend_finish = sd_script_get_id(frame, TAG_BM);
         }
-        if(sd_script_isset(frame, "bj")) {
-            rstate->blend_finish = sd_script_get(frame, "bj");
+        if(sd_script_isset_id(frame, TAG_BJ)) {
+            rstate->blend_finish = sd_script_get_id(frame, TAG_BJ);
         }
-        if(sd_script_isset(frame, "bs")) {
-            rstate->blend_start = sd_script_get(frame, "bs");
+        if(sd_script_isset_id(frame, TAG_BS)) {
+            rstate->blend_start = sd_script_get_id(frame, TAG_BS);
         }
 
         // Palette tricks
-        if(sd_script_isset(frame, "bpd")) {
-            rstate->pal_ref_index = sd_script_get(frame, "bpd");
+        if(sd_script_isset_id(frame, TAG_BPD)) {
+            rstate->pal_ref_index = sd_script_get_id(frame, TAG_BPD);
         }
-        if(sd_script_isset(frame, "bpn")) {
-            rstate->pal_entry_count = sd_script_get(frame, "bpn");
+        if(sd_script_isset_id(frame, TAG_BPN)) {
+            rstate->pal_entry_count = sd_script_get_id(frame, TAG_BPN);
         }
-        if(sd_script_isset(frame, "bps")) {
-            rstate->pal_start_index = sd_script_get(frame, "bps");
+        if(sd_script_isset_id(frame, TAG_BPS)) {
+            rstate->pal_start_index = sd_script_get_id(frame, TAG_BPS);
         }
-        if(sd_script_isset(frame, "bpf")) {
+        if(sd_script_isset_id(frame, TAG_BPF)) {
             // Exact values come from master.dat
             if(game_state_get_player(obj->gs, 0)->har == obj) {
                 rstate->pal_start_index = 1;
@@ -551,43 +551,43 @@ void player_run(object *obj) {
                 rstate->pal_entry_count = 48;
             }
         }
-        if(sd_script_isset(frame, "bpp")) {
-            rstate->pal_end = sd_script_get(frame, "bpp") * 4;
-            rstate->pal_begin = sd_script_get(frame, "bpp") * 4;
+        if(sd_script_isset_id(frame, TAG_BPP)) {
+            rstate->pal_end = sd_script_get_id(frame, TAG_BPP) * 4;
+            rstate->pal_begin = sd_script_get_id(frame, TAG_BPP) * 4;
         }
-        if(sd_script_isset(frame, "bpb")) {
-            rstate->pal_begin = sd_script_get(frame, "bpb") * 4;
+        if(sd_script_isset_id(frame, TAG_BPB)) {
+            rstate->pal_begin = sd_script_get_id(frame, TAG_BPB) * 4;
         }
-        if(sd_script_isset(frame, "bz")) {
+        if(sd_script_isset_id(frame, TAG_BZ)) {
             rstate->pal_tint = 1;
         }
 
         // Handle position correction
-        if(sd_script_isset(frame, "ox")) {
-            DEBUG("O_CORRECTION: X = %d", sd_script_get(frame, "ox"));
-            rstate->o_correction.x = sd_script_get(frame, "ox");
+        if(sd_script_isset_id(frame, TAG_OX)) {
+            DEBUG("O_CORRECTION: X = %d", sd_script_get_id(frame, TAG_OX));
+            rstate->o_correction.x = sd_script_get_id(frame, TAG_OX);
         } else {
             rstate->o_correction.x = 0;
         }
-        if(sd_script_isset(frame, "oy")) {
-            DEBUG("O_CORRECTION: Y = %d", sd_script_get(frame, "oy"));
-            rstate->o_correction.y = sd_script_get(frame, "oy");
+        if(sd_script_isset_id(frame, TAG_OY)) {
+            DEBUG("O_CORRECTION: Y = %d", sd_script_get_id(frame, TAG_OY));
+            rstate->o_correction.y = sd_script_get_id(frame, TAG_OY);
         } else {
             rstate->o_correction.y = 0;
         }
 
         // If UA is set, force other HAR to damage animation
-        if(sd_script_isset(frame, "ua") && state->enemy->cur_animation->id != 9) {
+        if(sd_script_isset_id(frame, TAG_UA) && state->enemy->cur_animation->id != 9) {
             har_set_ani(state->enemy, 9, 0);
         }
 
         // BJ sets new animation for our HAR
-        if(sd_script_isset(frame, "bj")) {
-            int new_ani = sd_script_get(frame, "bj");
+        if(sd_script_isset_id(frame, TAG_BJ)) {
+            int new_ani = sd_script_get_id(frame, TAG_BJ);
             har_set_ani(obj, new_ani, 0);
         }
 
-        if(sd_script_isset(frame, "bu") && obj->vel.y < 0.0f) {
+        if(sd_script_isset_id(frame, TAG_BU) && obj->vel.y < 0.0f) {
             float x_dist = dist(obj->pos.x, 160);
             // assume that bu is used in conjunction with 'vy-X' and that we want to land in the center of the arena
             obj->slide_state.vel.x = x_dist / (obj->vel.y * -2);
@@ -595,25 +595,25 @@ void player_run(object *obj) {
         }
 
         // handle scaling on the Y axis
-        if(sd_script_isset(frame, "y")) {
-            obj->y_percent = sd_script_get(frame, "y") / 100.0f;
+        if(sd_script_isset_id(frame, TAG_Y)) {
+            obj->y_percent = sd_script_get_id(frame, TAG_Y) / 100.0f;
         }
 
         // Handle slides
-        if(sd_script_isset(frame, "x=") || sd_script_isset(frame, "y=")) {
+        if(sd_script_isset_id(frame, TAG_X_EQ) || sd_script_isset_id(frame, TAG_Y_EQ)) {
             obj->slide_state.vel = vec2f_create(0, 0);
         }
-        if(sd_script_isset(frame, "x=")) {
-            obj->pos.x = obj->start.x + (sd_script_get(frame, "x=") * object_get_direction(obj));
+        if(sd_script_isset_id(frame, TAG_X_EQ)) {
+            obj->pos.x = obj->start.x + (sd_script_get_id(frame, TAG_X_EQ) * object_get_direction(obj));
 
             // Find frame ID by tick
-            int frame_id = sd_script_next_frame_with_tag(&state->parser, "x=", state->current_tick);
+            int frame_id = sd_script_next_frame_with_tag_id(&state->parser, TAG_X_EQ, state->current_tick);
 
             // Handle it!
             if(frame_id >= 0) {
                 int mr = sd_script_get_tick_pos_at_frame(&state->parser, frame_id);
                 int r = mr - state->current_tick - frame->tick_len;
-                int next_x = sd_script_get(sd_script_get_frame(&state->parser, frame_id), "x=");
+                int next_x = sd_script_get_id(sd_script_get_frame(&state->parser, frame_id), TAG_X_EQ);
                 int slide = obj->start.x + (next_x * object_get_direction(obj));
                 if(slide != obj->pos.x) {
                     obj->slide_state.vel.x = dist(obj->pos.x, slide) / (float)(frame->tick_len + r);
@@ -627,17 +627,17 @@ void player_run(object *obj) {
                 }
             }
         }
-        if(sd_script_isset(frame, "y=")) {
-            obj->pos.y = obj->start.y + sd_script_get(frame, "y=");
+        if(sd_script_isset_id(frame, TAG_Y_EQ)) {
+            obj->pos.y = obj->start.y + sd_script_get_id(frame, TAG_Y_EQ);
 
             // Find frame ID by tick
-            int frame_id = sd_script_next_frame_with_tag(&state->parser, "y=", state->current_tick);
+            int frame_id = sd_script_next_frame_with_tag_id(&state->parser, TAG_Y_EQ, state->current_tick);
 
             // handle it!
             if(frame_id >= 0) {
                 int mr = sd_script_get_tick_pos_at_frame(&state->parser, frame_id);
                 int r = mr - state->current_tick - frame->tick_len;
-                int next_y = sd_script_get(sd_script_get_frame(&state->parser, frame_id), "y=");
+                int next_y = sd_script_get_id(sd_script_get_frame(&state->parser, frame_id), TAG_Y_EQ);
                 int slide = next_y + obj->start.y;
                 if(slide != obj->pos.y) {
                     obj->slide_state.vel.y = dist(obj->pos.y, slide) / (float)(frame->tick_len + r);
@@ -651,15 +651,15 @@ void player_run(object *obj) {
                 }
             }
         }
-        if(sd_script_isset(frame, "as")) {
+        if(sd_script_isset_id(frame, TAG_AS)) {
             // make the object move around the screen in a circular motion until end of frame
             obj->orbit = 1;
         } else {
             obj->orbit = 0;
         }
-        if(sd_script_isset(frame, "q")) {
+        if(sd_script_isset_id(frame, TAG_Q)) {
             // Enable hit on the current and the next n-1 frames.
-            obj->hit_frames = sd_script_get(frame, "q");
+            obj->hit_frames = sd_script_get_id(frame, TAG_Q);
         }
         if(obj->hit_frames > 0) {
             obj->can_hit = 1;
@@ -667,7 +667,7 @@ void player_run(object *obj) {
         }
 
         // CREDITS scene moving titles & names
-        if(sd_script_isset(frame, "bd")) {
+        if(sd_script_isset_id(frame, TAG_BD)) {
             int cur_anim = obj->cur_animation->id;
             int cur_frame = sd_script_get_frame_index(&obj->animation_state.parser, frame);
 
@@ -692,11 +692,11 @@ void player_run(object *obj) {
             object_select_sprite(obj, frame->sprite);
             if(obj->cur_sprite != NULL) {
                 rstate->duration = frame->tick_len;
-                rstate->blendmode = sd_script_isset(frame, "br") ? BLEND_ADDITIVE : BLEND_ALPHA;
-                if(sd_script_isset(frame, "r") || obj->animation_state.shadow_corner_hack) {
+                rstate->blendmode = sd_script_isset_id(frame, TAG_BR) ? BLEND_ADDITIVE : BLEND_ALPHA;
+                if(sd_script_isset_id(frame, TAG_R) || obj->animation_state.shadow_corner_hack) {
                     rstate->flipmode ^= FLIP_HORIZONTAL;
                 }
-                if(sd_script_isset(frame, "f")) {
+                if(sd_script_isset_id(frame, TAG_F)) {
                     rstate->flipmode ^= FLIP_VERTICAL;
                 }
             }
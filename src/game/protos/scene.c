@@ -1,14 +1,14 @@
 #include "game/protos/scene.h"
 #include "game/game_player.h"
 #include "game/game_state_type.h"
-#include "resources/af_loader.h"
-#include "resources/bk_loader.h"
 #include "resources/ids.h"
+#include "resources/resource_cache.h"
 #include "utils/allocator.h"
 #include "utils/log.h"
 #include "utils/vec.h"
 #include "video/video.h"
 #include <stdlib.h>
+#include <string.h>
 
 // Some internal functions
 void cb_scene_spawn_object(object *parent, int id, vec2i pos, vec2f vel, uint8_t flags, int s, int g, void *userdata);
@@ -22,12 +22,17 @@ int scene_create(scene *scene, game_state *gs, int scene_id) {
 
     // Load BK
     int resource_id = scene_to_resource(scene_id);
-    if(load_bk_file(&scene->bk_data, resource_id)) {
+    scene->bk_data = resource_cache_get_bk(resource_id);
+    if(scene->bk_data == NULL) {
         PERROR("Unable to load scene %s (%s)!", scene_get_name(scene_id), get_resource_name(resource_id));
         return 1;
     }
     scene->id = scene_id;
     scene->gs = gs;
+
+    // Scenes edit their sound table and background, so they get their own copies
+    memcpy(scene->stl, scene->bk_data->sound_translation_table, sizeof(scene->stl));
+    surface_copy(&scene->background, &scene->bk_data->background);
     scene->af_data[0] = NULL;
     scene->af_data[1] = NULL;
 
@@ -42,49 +47,30 @@ int scene_create(scene *scene, game_state *gs, int scene_id) {
     scene->input_poll = NULL;
     scene->startup = NULL;
     scene->prio_override = NULL;
+    scene->serialize = NULL;
+    scene->unserialize = NULL;
 
-    // Set base palette
-    video_set_base_palette(bk_get_palette(&scene->bk_data, 0));
+    // Set base palette. Headless game states leave the video state alone, so that they
+    // can run on any thread.
+    if(!gs->init_flags->headless) {
+        video_set_base_palette(bk_get_palette(scene->bk_data, 0));
+    }
 
     // All done.
     DEBUG("Loaded scene %s (%s).", scene_get_name(scene_id), get_resource_name(resource_id));
     return 0;
 }
 
-void har_fix_sprite_coords(animation *ani, int fix_x, int fix_y) {
-    iterator it;
-    sprite *s;
-    // Fix sprite positions
-    vector_iter_begin(&ani->sprites, &it);
-    while((s = iter_next(&it)) != NULL) {
-        s->pos.x += fix_x;
-        s->pos.y += fix_y;
-    }
-    // Fix collisions coordinates
-    collision_coord *c;
-    vector_iter_begin(&ani->collision_coords, &it);
-    while((c = iter_next(&it)) != NULL) {
-        c->pos.x += fix_x;
-        c->pos.y += fix_y;
-    }
-}
-
 int scene_load_har(scene *scene, int player_id, int har_id) {
-    if(scene->af_data[player_id]) {
-        af_free(scene->af_data[player_id]);
-        omf_free(scene->af_data[player_id]);
-    }
-    scene->af_data[player_id] = omf_calloc(1, sizeof(af));
+    resource_cache_release_af(scene->af_data[player_id]);
 
     int resource_id = har_to_resource(har_id);
-    if(load_af_file(scene->af_data[player_id], resource_id)) {
+    scene->af_data[player_id] = resource_cache_get_af(resource_id);
+    if(scene->af_data[player_id] == NULL) {
         PERROR("Unable to load HAR %s (%s)!", har_get_name(har_id), get_resource_name(resource_id));
         return 1;
     }
 
-    // Fix some coordinates on jump sprites
-    har_fix_sprite_coords(&af_get_move(scene->af_data[player_id], ANIM_JUMPING)->ani, 0, -50);
-
     DEBUG("Loaded HAR %s (%s).", har_get_name(har_id), get_resource_name(resource_id));
     return 0;
 }
@@ -95,7 +81,7 @@ void scene_init(scene *scene) {
 
     // Bootstrap animations
     iterator it;
-    hashmap_iter_begin(&scene->bk_data.infos, &it);
+    hashmap_iter_begin(&scene->bk_data->infos, &it);
     hashmap_pair *pair = NULL;
     while((pair = iter_next(&it)) != NULL) {
         bk_info *info = (bk_info *)pair->val;
@@ -105,9 +91,9 @@ void scene_init(scene *scene) {
 
         // Start up animations
         if(m_load) {
-            object *obj = omf_calloc(1, sizeof(object));
+            object *obj = game_state_alloc_object(scene->gs);
             object_create(obj, scene->gs, info->ani.start_pos, vec2f_create(0, 0));
-            object_set_stl(obj, scene->bk_data.sound_translation_table);
+            object_set_stl(obj, scene->stl);
             object_set_animation(obj, &info->ani);
             object_set_repeat(obj, m_repeat);
             object_set_spawn_cb(obj, cb_scene_spawn_object, (void *)scene);
@@ -129,7 +115,9 @@ void scene_init(scene *scene) {
  * serialization data.
  */
 int scene_serialize(scene *s, serial *ser) {
-    game_state_serialize(s->gs, ser);
+    if(s->serialize != NULL) {
+        s->serialize(s, ser);
+    }
 
     // Return success
     return 0;
@@ -141,8 +129,9 @@ int scene_serialize(scene *s, serial *ser) {
  * Serial reder position should be set to correct position before calling this.
  */
 int scene_unserialize(scene *s, serial *ser) {
-    // TODO: Read attributes
-    s->id = serial_read_int8(ser);
+    if(s->unserialize != NULL) {
+        s->unserialize(s, ser);
+    }
 
     // Return success
     return 0;
@@ -179,7 +168,7 @@ void scene_render_overlay(scene *scene) {
 }
 
 void scene_render(scene *scene) {
-    video_render_background(&scene->bk_data.background);
+    video_render_background(&scene->background);
 
     if(scene->render != NULL) {
         scene->render(scene);
@@ -220,15 +209,10 @@ void scene_free(scene *scene) {
     if(scene->free != NULL) {
         scene->free(scene);
     }
-    bk_free(&scene->bk_data);
-    if(scene->af_data[0]) {
-        af_free(scene->af_data[0]);
-        omf_free(scene->af_data[0]);
-    }
-    if(scene->af_data[1]) {
-        af_free(scene->af_data[1]);
-        omf_free(scene->af_data[1]);
-    }
+    resource_cache_release_bk(scene->bk_data);
+    surface_free(&scene->background);
+    resource_cache_release_af(scene->af_data[0]);
+    resource_cache_release_af(scene->af_data[1]);
     ticktimer_close(&scene->tick_timer);
 }
 
@@ -264,6 +248,14 @@ void scene_set_anim_prio_override_cb(scene *scene, scene_anim_prio_override_cb c
     scene->prio_override = cbfunc;
 }
 
+void scene_set_serialize_cb(scene *scene, scene_serialize_cb cbfunc) {
+    scene->serialize = cbfunc;
+}
+
+void scene_set_unserialize_cb(scene *scene, scene_unserialize_cb cbfunc) {
+    scene->unserialize = cbfunc;
+}
+
 void scene_set_input_poll_cb(scene *scene, scene_input_poll_cb cbfunc) {
     scene->input_poll = cbfunc;
 }
@@ -272,9 +264,9 @@ void cb_scene_spawn_object(object *parent, int id, vec2i pos, vec2f vel, uint8_t
     scene *sc = (scene *)userdata;
 
     // Get next animation
-    bk_info *info = bk_get_info(&sc->bk_data, id);
+    bk_info *info = bk_get_info(sc->bk_data, id);
     if(info != NULL) {
-        object *obj = omf_calloc(1, sizeof(object));
+        object *obj = game_state_alloc_object(parent->gs);
         object_create(obj, parent->gs, vec2i_add(pos, info->ani.start_pos), vel);
         object_set_stl(obj, object_get_stl(parent));
         object_set_animation(obj, &info->ani);
@@ -29,9 +29,9 @@
 #include "game/objects/scrap.h"
 #include "game/protos/object.h"
 #include "game/scenes/arena.h"
+#include "game/utils/rollback.h"
 #include "game/utils/score.h"
 #include "game/utils/settings.h"
-#include "game/utils/ticktimer.h"
 #include "resources/ids.h"
 #include "resources/languages.h"
 #include "utils/allocator.h"
@@ -45,6 +45,11 @@
 #define HAR1_START_POS 110
 #define HAR2_START_POS 211
 
+// Ticks from the end of the READY/ROUND animation to the FIGHT animation, and from there to the
+// HARs being released
+#define FIGHT_START_DELAY 10
+#define FIGHT_ANIM_TICKS 24
+
 typedef struct arena_local_t {
     guiframe *game_menu;
 
@@ -52,6 +57,8 @@ typedef struct arena_local_t {
     int menu_visible;
     unsigned int state;
     int ending_ticks;
+    int fight_start_ticks; ///< Ticks left until the FIGHT animation, or 0 if it is not coming
+    int fight_done_ticks;  ///< Ticks left until the HARs are released, or 0 if not counting
 
     component *health_bars[2];
     component *endurance_bars[2];
@@ -105,36 +112,41 @@ void arena_speed_slide(component *c, void *userdata, int pos) {
     game_state_set_speed(sc->gs, pos + 5);
 }
 
-void scene_fight_anim_done(void *userdata) {
-    object *parent = userdata;
-    scene *scene = game_state_get_scene(parent->gs);
+void scene_fight_anim_done(scene *scene) {
     arena_local *arena = scene_get_userdata(scene);
 
     // This will release HARs for action
     arena->state = ARENA_STATE_FIGHTING;
-
-    // Custom object finisher callback requires that we
-    // mark object as finished manually, if necessary.
-    // parent->animation_state.finished = 1;
 }
 
-void scene_fight_anim_start(void *userdata) {
+void scene_fight_anim_start(scene *scene) {
     // Start FIGHT animation
-    game_state *gs = userdata;
-    scene *scene = game_state_get_scene(gs);
-    animation *fight_ani = &bk_get_info(&scene->bk_data, 10)->ani;
+    arena_local *arena = scene_get_userdata(scene);
+    animation *fight_ani = &bk_get_info(scene->bk_data, 10)->ani;
     object *fight = omf_calloc(1, sizeof(object));
-    object_create(fight, gs, fight_ani->start_pos, vec2f_create(0, 0));
-    object_set_stl(fight, bk_get_stl(&scene->bk_data));
+    object_create(fight, scene->gs, fight_ani->start_pos, vec2f_create(0, 0));
+    object_set_stl(fight, scene->stl);
     object_set_animation(fight, fight_ani);
-    // object_set_finish_cb(fight, scene_fight_anim_done);
-    game_state_add_object(gs, fight, RENDER_LAYER_TOP, 0, 0);
-    ticktimer_add(&scene->tick_timer, 24, scene_fight_anim_done, fight);
+    game_state_add_object(scene->gs, fight, RENDER_LAYER_TOP, 0, 0);
+    arena->fight_done_ticks = FIGHT_ANIM_TICKS;
+}
+
+// The round start is timed with counters in the arena state instead of the scene ticktimer, so
+// that it is part of the rollback snapshots.
+static void arena_round_start_tick(scene *scene) {
+    arena_local *arena = scene_get_userdata(scene);
+    if(arena->fight_start_ticks > 0 && --arena->fight_start_ticks == 0) {
+        scene_fight_anim_start(scene);
+    }
+    if(arena->fight_done_ticks > 0 && --arena->fight_done_ticks == 0) {
+        scene_fight_anim_done(scene);
+    }
 }
 
 void scene_ready_anim_done(object *parent) {
     // Wait a moment before loading FIGHT animation
-    ticktimer_add(&game_state_get_scene(parent->gs)->tick_timer, 10, scene_fight_anim_start, parent->gs);
+    arena_local *arena = scene_get_userdata(game_state_get_scene(parent->gs));
+    arena->fight_start_ticks = FIGHT_START_DELAY;
 
     // Custom object finisher callback requires that we
     // mark object as finished manually, if necessary.
@@ -151,10 +163,10 @@ void scene_youwin_anim_start(void *userdata) {
     // Start FIGHT animation
     game_state *gs = userdata;
     scene *scene = game_state_get_scene(gs);
-    animation *youwin_ani = &bk_get_info(&scene->bk_data, 9)->ani;
+    animation *youwin_ani = &bk_get_info(scene->bk_data, 9)->ani;
     object *youwin = omf_calloc(1, sizeof(object));
     object_create(youwin, gs, youwin_ani->start_pos, vec2f_create(0, 0));
-    object_set_stl(youwin, bk_get_stl(&scene->bk_data));
+    object_set_stl(youwin, scene->stl);
     object_set_animation(youwin, youwin_ani);
     object_set_finish_cb(youwin, scene_youwin_anim_done);
     game_state_add_object(gs, youwin, RENDER_LAYER_MIDDLE, 0, 0);
@@ -173,10 +185,10 @@ void scene_youlose_anim_start(void *userdata) {
     // Start FIGHT animation
     game_state *gs = userdata;
     scene *scene = game_state_get_scene(gs);
-    animation *youlose_ani = &bk_get_info(&scene->bk_data, 8)->ani;
+    animation *youlose_ani = &bk_get_info(scene->bk_data, 8)->ani;
     object *youlose = omf_calloc(1, sizeof(object));
     object_create(youlose, gs, youlose_ani->start_pos, vec2f_create(0, 0));
-    object_set_stl(youlose, bk_get_stl(&scene->bk_data));
+    object_set_stl(youlose, scene->stl);
     object_set_animation(youlose, youlose_ani);
     object_set_finish_cb(youlose, scene_youlose_anim_done);
     game_state_add_object(gs, youlose, RENDER_LAYER_MIDDLE, 0, 0);
@@ -199,6 +211,11 @@ int is_netplay(scene *scene) {
     return 0;
 }
 
+// Netplay clients without rollback follow the state sent by the server, and leave scoring to it
+static int is_synced_client(scene *scene) {
+    return is_netplay(scene) && scene->gs->role == ROLE_CLIENT && scene->gs->rollback == NULL;
+}
+
 int is_singleplayer(scene *scene) {
     if(game_state_get_player(scene->gs, 1)->ctrl->type == CTRL_TYPE_AI) {
         return 1;
@@ -240,9 +257,12 @@ void arena_end(scene *sc) {
     int next_id;
 
     // Switch scene
-    if(is_demoplay(sc)) {
+    if(gs->init_flags->headless) {
+        // Headless runs only ever simulate a single match
+        game_state_set_next(gs, SCENE_NONE);
+    } else if(is_demoplay(sc)) {
         do {
-            next_id = rand_arena();
+            next_id = rand_arena(&gs->rand);
         } while(next_id == sc->id);
         game_state_set_next(gs, next_id);
     } else if(is_singleplayer(sc)) {
@@ -258,6 +278,8 @@ void arena_reset(scene *sc) {
     arena_local *local = scene_get_userdata(sc);
     local->round++;
     local->state = ARENA_STATE_STARTING;
+    local->fight_start_ticks = 0;
+    local->fight_done_ticks = 0;
 
     // Kill all hazards and projectiles
     game_state_clear_hazards_projectiles(sc->gs);
@@ -286,21 +308,21 @@ void arena_reset(scene *sc) {
         chr_score_clear_done(&player->score);
     }
 
-    sc->bk_data.sound_translation_table[3] = 23 + local->round; // NUMBER
+    sc->stl[3] = 23 + local->round; // NUMBER
     // ROUND animation
-    animation *round_ani = &bk_get_info(&sc->bk_data, 6)->ani;
+    animation *round_ani = &bk_get_info(sc->bk_data, 6)->ani;
     object *round = omf_calloc(1, sizeof(object));
     object_create(round, sc->gs, round_ani->start_pos, vec2f_create(0, 0));
-    object_set_stl(round, sc->bk_data.sound_translation_table);
+    object_set_stl(round, sc->stl);
     object_set_animation(round, round_ani);
     object_set_finish_cb(round, scene_ready_anim_done);
     game_state_add_object(sc->gs, round, RENDER_LAYER_TOP, 0, 0);
 
     // Round number
-    animation *number_ani = &bk_get_info(&sc->bk_data, 7)->ani;
+    animation *number_ani = &bk_get_info(sc->bk_data, 7)->ani;
     object *number = omf_calloc(1, sizeof(object));
     object_create(number, sc->gs, number_ani->start_pos, vec2f_create(0, 0));
-    object_set_stl(number, sc->bk_data.sound_translation_table);
+    object_set_stl(number, sc->stl);
     object_set_animation(number, number_ani);
     object_select_sprite(number, local->round);
     object_set_sprite_override(number, 1);
@@ -312,17 +334,21 @@ void arena_maybe_sync(scene *scene, int need_sync) {
     game_player *player1 = game_state_get_player(gs, 0);
     game_player *player2 = game_state_get_player(gs, 1);
 
-    if(need_sync && gs->role == ROLE_SERVER &&
+    if(need_sync && gs->role == ROLE_SERVER && gs->rollback == NULL &&
        (player1->ctrl->type == CTRL_TYPE_NETWORK || player2->ctrl->type == CTRL_TYPE_NETWORK)) {
 
         // some of the moves did something interesting and we should synchronize the peer
         serial ser;
         serial_create(&ser);
+        uint64_t start = SDL_GetPerformanceCounter();
         game_state_serialize(scene->gs, &ser);
+        uint64_t serialize_time = SDL_GetPerformanceCounter() - start;
         if(player1->ctrl->type == CTRL_TYPE_NETWORK) {
+            net_controller_add_serialize_time(player1->ctrl, serialize_time);
             controller_update(player1->ctrl, &ser);
         }
         if(player2->ctrl->type == CTRL_TYPE_NETWORK) {
+            net_controller_add_serialize_time(player2->ctrl, serialize_time);
             controller_update(player2->ctrl, &ser);
         }
         serial_free(&ser);
@@ -335,7 +361,7 @@ void arena_har_take_hit_hook(int hittee, af_move *move, scene *scene) {
     object *hit_har;
     har *h;
 
-    if(is_netplay(scene) && scene->gs->role == ROLE_CLIENT) {
+    if(is_synced_client(scene)) {
         return; // netplay clients do not keep score
     }
 
@@ -361,7 +387,7 @@ void arena_har_recover_hook(int player_id, scene *scene) {
     chr_score *score;
     object *o_har;
 
-    if(is_netplay(scene) && scene->gs->role == ROLE_CLIENT) {
+    if(is_synced_client(scene)) {
         return; // netplay clients do not keep score
     }
 
@@ -408,19 +434,19 @@ void arena_har_hit_wall_hook(int player_id, int wall, scene *scene) {
         h->state = STATE_WALLDAMAGE;
 
         // Spawn wall animation
-        bk_info *info = bk_get_info(&scene->bk_data, 20 + wall);
+        bk_info *info = bk_get_info(scene->bk_data, 20 + wall);
         object *obj = omf_calloc(1, sizeof(object));
         object_create(obj, scene->gs, info->ani.start_pos, vec2f_create(0, 0));
-        object_set_stl(obj, scene->bk_data.sound_translation_table);
+        object_set_stl(obj, scene->stl);
         object_set_animation(obj, &info->ani);
         if(game_state_add_object(scene->gs, obj, RENDER_LAYER_BOTTOM, 1, 0) == 0) {
 
             // spawn the electricity on top of the HAR
             // TODO this doesn't track the har's position well...
-            info = bk_get_info(&scene->bk_data, 22);
+            info = bk_get_info(scene->bk_data, 22);
             object *obj2 = omf_calloc(1, sizeof(object));
             object_create(obj2, scene->gs, vec2i_create(o_har->pos.x, o_har->pos.y), vec2f_create(0, 0));
-            object_set_stl(obj2, scene->bk_data.sound_translation_table);
+            object_set_stl(obj2, scene->stl);
             object_set_animation(obj2, &info->ani);
             object_attach_to(obj2, o_har);
             // object_dynamic_tick(obj2);
@@ -440,10 +466,10 @@ void arena_har_hit_wall_hook(int player_id, int wall, scene *scene) {
         h->state = STATE_WALLDAMAGE;
 
         // desert always shows the 'hit' animation when you touch the wall
-        bk_info *info = bk_get_info(&scene->bk_data, 20 + wall);
+        bk_info *info = bk_get_info(scene->bk_data, 20 + wall);
         object *obj = omf_calloc(1, sizeof(object));
         object_create(obj, scene->gs, info->ani.start_pos, vec2f_create(0, 0));
-        object_set_stl(obj, scene->bk_data.sound_translation_table);
+        object_set_stl(obj, scene->stl);
         object_set_animation(obj, &info->ani);
         object_set_custom_string(obj, "brwA1-brwB1-brwD1-brwE0-brwD4-brwC2-brwB2-brwA2");
         if(game_state_add_object(scene->gs, obj, RENDER_LAYER_BOTTOM, 1, 0) != 0) {
@@ -460,17 +486,17 @@ void arena_har_hit_wall_hook(int player_id, int wall, scene *scene) {
         DEBUG("hit dusty wall %d", wall);
         h->state = STATE_WALLDAMAGE;
 
-        int amount = rand_int(2) + 3;
+        int amount = random_int(&scene->gs->rand, 2) + 3;
         for(int i = 0; i < amount; i++) {
-            int variance = rand_int(20) - 10;
-            int anim_no = rand_int(2) + 24;
+            int variance = random_int(&scene->gs->rand, 20) - 10;
+            int anim_no = random_int(&scene->gs->rand, 2) + 24;
             DEBUG("XXX anim = %d, variance = %d", anim_no, variance);
             int pos_y = o_har->pos.y - object_get_size(o_har).y + variance + i * 25;
             vec2i coord = vec2i_create(o_har->pos.x, pos_y);
             object *dust = omf_calloc(1, sizeof(object));
             object_create(dust, scene->gs, coord, vec2f_create(0, 0));
-            object_set_stl(dust, scene->bk_data.sound_translation_table);
-            object_set_animation(dust, &bk_get_info(&scene->bk_data, anim_no)->ani);
+            object_set_stl(dust, scene->stl);
+            object_set_animation(dust, &bk_get_info(scene->bk_data, anim_no)->ani);
             game_state_add_object(scene->gs, dust, RENDER_LAYER_MIDDLE, 0, 0);
         }
 
@@ -666,7 +692,7 @@ void maybe_install_har_hooks(scene *scene) {
     har1 = obj_har1->userdata;
     har2 = obj_har2->userdata;
 
-    if(scene->gs->role == ROLE_CLIENT) {
+    if(scene->gs->role == ROLE_CLIENT && scene->gs->rollback == NULL) {
         game_player *_player[2];
         for(int i = 0; i < 2; i++) {
             _player[i] = game_state_get_player(scene->gs, i);
@@ -690,6 +716,17 @@ void arena_free(scene *scene) {
 
     game_state_set_paused(scene->gs, 0);
 
+    if(scene->gs->rollback != NULL) {
+        for(int i = 0; i < 2; i++) {
+            controller *ctrl = game_player_get_ctrl(game_state_get_player(scene->gs, i));
+            if(ctrl->type == CTRL_TYPE_NETWORK) {
+                net_controller_set_rollback(ctrl, NULL);
+            }
+        }
+        rollback_free(scene->gs->rollback);
+        omf_free(scene->gs->rollback);
+    }
+
     if(local->rec) {
         write_rec_move(scene, game_state_get_player(scene->gs, 0), ACT_STOP);
         sd_rec_save(local->rec, scene->gs->init_flags->rec_file);
@@ -801,6 +838,13 @@ int arena_handle_events(scene *scene, game_player *player, ctrl_event *i) {
                 DEBUG("menu event %d", i->event_data.action);
                 // menu events
                 guiframe_action(local->game_menu, i->event_data.action);
+            } else if(i->type == EVENT_TYPE_ACTION && scene->gs->rollback != NULL) {
+                // The rollback buffer applies the inputs of both players at once, and gets the
+                // inputs of the remote player from the peer.
+                if(player == game_state_get_player(scene->gs, rollback_get_local(scene->gs->rollback))) {
+                    rollback_add_local_action(scene->gs->rollback, i->event_data.action);
+                    write_rec_move(scene, player, i->event_data.action);
+                }
             } else if(i->type == EVENT_TYPE_ACTION) {
                 if(player->ctrl->type == CTRL_TYPE_NETWORK) {
                     do {
@@ -841,10 +885,10 @@ int arena_handle_events(scene *scene, game_player *player, ctrl_event *i) {
 
 void arena_spawn_hazard(scene *scene) {
     iterator it;
-    hashmap_iter_begin(&scene->bk_data.infos, &it);
+    hashmap_iter_begin(&scene->bk_data->infos, &it);
     hashmap_pair *pair = NULL;
 
-    if(is_netplay(scene) && scene->gs->role == ROLE_CLIENT) {
+    if(is_synced_client(scene)) {
         // only the server spawns hazards
         return;
     }
@@ -854,11 +898,11 @@ void arena_spawn_hazard(scene *scene) {
     while((pair = iter_next(&it)) != NULL) {
         bk_info *info = (bk_info *)pair->val;
         if(info->probability > 1) {
-            if(rand_int(info->probability) == 1) {
+            if(random_int(&scene->gs->rand, info->probability) == 1) {
                 // TODO don't spawn it if we already have this animation running
                 object *obj = omf_calloc(1, sizeof(object));
                 object_create(obj, scene->gs, info->ani.start_pos, vec2f_create(0, 0));
-                object_set_stl(obj, scene->bk_data.sound_translation_table);
+                object_set_stl(obj, scene->stl);
                 object_set_animation(obj, &info->ani);
                 if(scene->id == SCENE_ARENA3 && info->ani.id == 0) {
                     // XXX fire pit orb has a bug whwre it double spawns. Use a custom animation string to avoid it
@@ -871,13 +915,13 @@ void arena_spawn_hazard(scene *scene) {
                 if(game_state_add_object(scene->gs, obj, RENDER_LAYER_BOTTOM, 1, 0) == 0) {
                     object_set_layers(obj, LAYER_HAZARD | LAYER_HAR);
                     object_set_group(obj, GROUP_PROJECTILE);
-                    object_set_userdata(obj, &scene->bk_data);
+                    object_set_userdata(obj, scene->bk_data);
                     if(info->ani.extra_string_count > 0) {
                         // For the desert, there's a bunch of extra animation strgins for
                         // the different plane formations.
                         // Pick one, rather than always use the first
 
-                        int r = rand_int(info->ani.extra_string_count);
+                        int r = random_int(&scene->gs->rand, info->ani.extra_string_count);
                         if(r > 0) {
                             str *s = vector_get(&info->ani.extra_strings, r);
                             object_set_custom_string(obj, str_c(s));
@@ -907,6 +951,8 @@ void arena_dynamic_tick(scene *scene, int paused) {
     game_player *player2 = game_state_get_player(gs, 1);
 
     if(!paused) {
+        arena_round_start_tick(scene);
+
         object *obj_har[2];
         har *hars[2];
         for(int i = 0; i < 2; i++) {
@@ -929,9 +975,11 @@ void arena_dynamic_tick(scene *scene, int paused) {
             component_tick(local->endurance_bars[i]);
         }
 
-        // RTT stuff
-        hars[0]->delay = ceil(player2->ctrl->rtt / 2.0f);
-        hars[1]->delay = ceil(player1->ctrl->rtt / 2.0f);
+        // RTT stuff. Rollback games do not delay the moves, since both ends run the same ticks.
+        if(gs->rollback == NULL) {
+            hars[0]->delay = ceil(player2->ctrl->rtt / 2.0f);
+            hars[1]->delay = ceil(player1->ctrl->rtt / 2.0f);
+        }
 
         // Endings and beginnings
         if(local->state != ARENA_STATE_ENDING && local->state != ARENA_STATE_STARTING) {
@@ -943,8 +991,8 @@ void arena_dynamic_tick(scene *scene, int paused) {
         if(local->state == ARENA_STATE_ENDING) {
             chr_score *s1 = game_player_get_score(game_state_get_player(scene->gs, 0));
             chr_score *s2 = game_player_get_score(game_state_get_player(scene->gs, 1));
-            if(player_frame_isset(obj_har[0], "be") || player_frame_isset(obj_har[1], "be") || chr_score_onscreen(s1) ||
-               chr_score_onscreen(s2)) {
+            if(player_frame_isset(obj_har[0], TAG_BE) || player_frame_isset(obj_har[1], TAG_BE) ||
+               chr_score_onscreen(s1) || chr_score_onscreen(s2)) {
             } else {
                 local->ending_ticks++;
             }
@@ -962,13 +1010,13 @@ void arena_dynamic_tick(scene *scene, int paused) {
 
         // Pour some rein!
         if(local->rein_enabled) {
-            if(rand_float() > 0.65f) {
-                vec2i pos = vec2i_create(rand_int(NATIVE_W), -10);
+            if(random_float(&scene->gs->rand) > 0.65f) {
+                vec2i pos = vec2i_create(random_int(&scene->gs->rand, NATIVE_W), -10);
                 for(int harnum = 0; harnum < game_state_num_players(gs); harnum++) {
                     object *h_obj = game_state_get_player(gs, harnum)->har;
                     har *h = object_get_userdata(h_obj);
                     // Calculate velocity etc.
-                    float rv = rand_float() - 0.5f;
+                    float rv = random_float(&scene->gs->rand) - 0.5f;
                     float velx = rv;
                     float vely = -12 * sin(0 / 2 + rv);
 
@@ -978,8 +1026,8 @@ void arena_dynamic_tick(scene *scene, int paused) {
                         vely += 0.21;
 
                     // Create the object
-                    object *scrap = omf_calloc(1, sizeof(object));
-                    int anim_no = rand_int(3) + ANIM_SCRAP_METAL;
+                    object *scrap = game_state_alloc_object(gs);
+                    int anim_no = random_int(&scene->gs->rand, 3) + ANIM_SCRAP_METAL;
                     object_create(scrap, gs, pos, vec2f_create(velx, vely));
                     object_set_animation(scrap, &af_get_move(h->af_data, anim_no)->ani);
                     object_set_gravity(scrap, 0.4f);
@@ -1001,6 +1049,29 @@ void arena_dynamic_tick(scene *scene, int paused) {
     arena_maybe_sync(scene, need_sync);
 }
 
+// Arena state for the rollback snapshots
+void arena_serialize(scene *scene, serial *ser) {
+    arena_local *local = scene_get_userdata(scene);
+    serial_write_int8(ser, local->state);
+    serial_write_int32(ser, local->ending_ticks);
+    serial_write_int32(ser, local->fight_start_ticks);
+    serial_write_int32(ser, local->fight_done_ticks);
+    serial_write_int8(ser, local->round);
+    serial_write_int8(ser, local->over);
+    serial_write_int8(ser, local->rein_enabled);
+}
+
+void arena_unserialize(scene *scene, serial *ser) {
+    arena_local *local = scene_get_userdata(scene);
+    local->state = serial_read_int8(ser);
+    local->ending_ticks = serial_read_int32(ser);
+    local->fight_start_ticks = serial_read_int32(ser);
+    local->fight_done_ticks = serial_read_int32(ser);
+    local->round = serial_read_int8(ser);
+    local->over = serial_read_int8(ser);
+    local->rein_enabled = serial_read_int8(ser);
+}
+
 void arena_static_tick(scene *scene, int paused) {
     arena_local *local = scene_get_userdata(scene);
     guiframe_tick(local->game_menu);
@@ -1041,7 +1112,7 @@ void arena_render_overlay(scene *scene) {
 #ifdef DEBUGMODE
     snprintf(buf, 40, "%u", game_state_get_tick(scene->gs));
     font_render(&font_small, buf, 160, 0, TEXT_COLOR);
-    snprintf(buf, 40, "%u", rand_get_seed());
+    snprintf(buf, 40, "%u", random_get_seed(&scene->gs->rand));
     font_render(&font_small, buf, 130, 8, TEXT_COLOR);
 #endif
     for(int i = 0; i < 2; i++) {
@@ -1118,7 +1189,7 @@ void arena_toggle_rein(scene *scene) {
 }
 
 void arena_startup(scene *scene, int id, int *m_load, int *m_repeat) {
-    if(scene->bk_data.file_id == 64) {
+    if(scene->bk_data->file_id == 64) {
         // Start up & repeat torches on arena startup
         switch(id) {
             case 1:
@@ -1139,13 +1210,13 @@ int arena_create(scene *scene) {
     // Load up settings
     setting = settings_get();
 
-    // Initialize Demo
-    if(is_demoplay(scene)) {
+    // Initialize Demo. Headless matches have their HARs and pilots picked already.
+    if(is_demoplay(scene) && scene->gs->init_flags->match == NULL) {
         game_state_init_demo(scene->gs);
     }
 
     // Handle music playback
-    switch(scene->bk_data.file_id) {
+    switch(scene->bk_data->file_id) {
         case 8:
             music_play(PSM_ARENA0);
             break;
@@ -1192,6 +1263,18 @@ int arena_create(scene *scene) {
     }
     local->over = 0;
 
+    // In rollback netplay both ends run the whole game, so the peer only needs to send its inputs
+    // The setting and the seed are agreed on with the peer when connecting
+    uint32_t rollback_seed;
+    int local_player = (game_state_get_player(scene->gs, 0)->ctrl->type == CTRL_TYPE_NETWORK) ? 1 : 0;
+    controller *net_ctrl = game_state_get_player(scene->gs, !local_player)->ctrl;
+    if(is_netplay(scene) && net_controller_get_rollback(net_ctrl, &rollback_seed)) {
+        scene->gs->rollback = omf_calloc(1, sizeof(rollback));
+        rollback_create(scene->gs->rollback, local_player);
+        net_controller_set_rollback(net_ctrl, scene->gs->rollback);
+        random_seed(&scene->gs->rand, rollback_seed);
+    }
+
     // Initial har data
     vec2i pos[2];
     int dir[2] = {OBJECT_FACE_RIGHT, OBJECT_FACE_LEFT};
@@ -1205,11 +1288,13 @@ int arena_create(scene *scene) {
         object *obj = omf_calloc(1, sizeof(object));
 
         // load the player's colors into the palette
-        palette *base_pal = video_get_base_palette();
-        palette_set_player_color(base_pal, i, player->colors[2], 0);
-        palette_set_player_color(base_pal, i, player->colors[1], 1);
-        palette_set_player_color(base_pal, i, player->colors[0], 2);
-        video_force_pal_refresh();
+        if(!scene->gs->init_flags->headless) {
+            palette *base_pal = video_get_base_palette();
+            palette_set_player_color(base_pal, i, player->colors[2], 0);
+            palette_set_player_color(base_pal, i, player->colors[1], 1);
+            palette_set_player_color(base_pal, i, player->colors[0], 2);
+            video_force_pal_refresh();
+        }
 
         // Create object and specialize it as HAR.
         // Errors are unlikely here, but check anyway.
@@ -1239,7 +1324,7 @@ int arena_create(scene *scene) {
                 if(i == 1) {
                     xoff = 210 - 9 * j - 3 - j;
                 }
-                animation *ani = &bk_get_info(&scene->bk_data, 27)->ani;
+                animation *ani = &bk_get_info(scene->bk_data, 27)->ani;
                 object_create(local->player_rounds[i][j], scene->gs, vec2i_create(xoff, 9), vec2f_create(0, 0));
                 object_set_animation(local->player_rounds[i][j], ani);
                 object_select_sprite(local->player_rounds[i][j], 1);
@@ -1341,39 +1426,39 @@ int arena_create(scene *scene) {
     har_screencaps_reset(&_player[1]->screencaps);
 
     // Set correct sounds for ready, round and number STL fields
-    scene->bk_data.sound_translation_table[14] = 10;               // READY
-    scene->bk_data.sound_translation_table[15] = 16;               // ROUND
-    scene->bk_data.sound_translation_table[3] = 23 + local->round; // NUMBER
+    scene->stl[14] = 10;               // READY
+    scene->stl[15] = 16;               // ROUND
+    scene->stl[3] = 23 + local->round; // NUMBER
 
     // Disable the floating ball disappearence sound in fire arena
     if(scene->id == SCENE_ARENA3) {
-        scene->bk_data.sound_translation_table[20] = 0;
+        scene->stl[20] = 0;
     }
 
     if(local->rounds == 1) {
         // Start READY animation
-        animation *ready_ani = &bk_get_info(&scene->bk_data, 11)->ani;
+        animation *ready_ani = &bk_get_info(scene->bk_data, 11)->ani;
         object *ready = omf_calloc(1, sizeof(object));
         object_create(ready, scene->gs, ready_ani->start_pos, vec2f_create(0, 0));
-        object_set_stl(ready, scene->bk_data.sound_translation_table);
+        object_set_stl(ready, scene->stl);
         object_set_animation(ready, ready_ani);
         object_set_finish_cb(ready, scene_ready_anim_done);
         game_state_add_object(scene->gs, ready, RENDER_LAYER_TOP, 0, 0);
     } else {
         // ROUND
-        animation *round_ani = &bk_get_info(&scene->bk_data, 6)->ani;
+        animation *round_ani = &bk_get_info(scene->bk_data, 6)->ani;
         object *round = omf_calloc(1, sizeof(object));
         object_create(round, scene->gs, round_ani->start_pos, vec2f_create(0, 0));
-        object_set_stl(round, scene->bk_data.sound_translation_table);
+        object_set_stl(round, scene->stl);
         object_set_animation(round, round_ani);
         object_set_finish_cb(round, scene_ready_anim_done);
         game_state_add_object(scene->gs, round, RENDER_LAYER_TOP, 0, 0);
 
         // Number
-        animation *number_ani = &bk_get_info(&scene->bk_data, 7)->ani;
+        animation *number_ani = &bk_get_info(scene->bk_data, 7)->ani;
         object *number = omf_calloc(1, sizeof(object));
         object_create(number, scene->gs, number_ani->start_pos, vec2f_create(0, 0));
-        object_set_stl(number, scene->bk_data.sound_translation_table);
+        object_set_stl(number, scene->stl);
         object_set_animation(number, number_ani);
         object_select_sprite(number, local->round);
         game_state_add_object(scene->gs, number, RENDER_LAYER_TOP, 0, 0);
@@ -1387,6 +1472,8 @@ int arena_create(scene *scene) {
     scene_set_startup_cb(scene, arena_startup);
     scene_set_input_poll_cb(scene, arena_input_tick);
     scene_set_render_overlay_cb(scene, arena_render_overlay);
+    scene_set_serialize_cb(scene, arena_serialize);
+    scene_set_unserialize_cb(scene, arena_unserialize);
 
     // initalize recording, if enabled
     if(scene->gs->init_flags->record == 1) {
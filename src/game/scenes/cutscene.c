@@ -118,7 +118,7 @@ int cutscene_create(scene *scene) {
             local->text_conf.cforeground = COLOR_RED;
 
             // Pilot face
-            animation *ani = &bk_get_info(&scene->bk_data, 3)->ani;
+            animation *ani = &bk_get_info(scene->bk_data, 3)->ani;
             object *obj = omf_calloc(1, sizeof(object));
             object_create(obj, scene->gs, vec2i_create(0, 0), vec2f_create(0, 0));
             object_set_animation(obj, ani);
@@ -127,7 +127,7 @@ int cutscene_create(scene *scene) {
             game_state_add_object(scene->gs, obj, RENDER_LAYER_TOP, 0, 0);
 
             // Face effects
-            ani = &bk_get_info(&scene->bk_data, 10 + p1->pilot_id)->ani;
+            ani = &bk_get_info(scene->bk_data, 10 + p1->pilot_id)->ani;
             obj = omf_calloc(1, sizeof(object));
             object_create(obj, scene->gs, vec2i_create(0, 0), vec2f_create(0, 0));
             object_set_animation(obj, ani);
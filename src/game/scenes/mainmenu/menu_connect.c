@@ -98,10 +98,6 @@ void menu_connect_tick(component *c) {
                 continue;
             }
 
-            ENetPacket *packet = enet_packet_create("0", 2, ENET_PACKET_FLAG_RELIABLE);
-            enet_peer_send(event.peer, 0, packet);
-            enet_host_flush(local->host);
-
             DEBUG("connected to server!");
             controller *player1_ctrl, *player2_ctrl;
             keyboard_keys *keys;
@@ -159,7 +155,19 @@ void menu_connect_tick(component *c) {
 
         game_player *p1 = game_state_get_player(gs, 0);
         controller *c1 = game_player_get_ctrl(p1);
-        if(c1->type == CTRL_TYPE_NETWORK && net_controller_ready(c1) == 1) {
+        if(c1->type == CTRL_TYPE_NETWORK && net_controller_ready(c1) == -1) {
+            // The peer has different settings, drop the connection along with the controllers
+            DEBUG("network peer was refused");
+            for(int i = 0; i < 2; i++) {
+                game_player_set_ctrl(game_state_get_player(gs, i), NULL);
+            }
+            reconfigure_controller(gs);
+            local->host = NULL;
+            local->controllers_created = 0;
+            local->connect_start = 0;
+            menu *m = sizer_get_obj(c);
+            m->finished = 1;
+        } else if(c1->type == CTRL_TYPE_NETWORK && net_controller_ready(c1) == 1) {
             DEBUG("network peer is ready, tick offset is %d and rtt is %d", net_controller_tick_offset(c1), c1->rtt);
             local->host = NULL;
             local->controllers_created = 0;
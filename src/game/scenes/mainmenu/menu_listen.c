@@ -38,10 +38,6 @@ void menu_listen_tick(component *c) {
                 continue;
             }
 
-            ENetPacket *packet = enet_packet_create("0", 2, ENET_PACKET_FLAG_RELIABLE);
-            enet_peer_send(event.peer, 0, packet);
-            enet_host_flush(local->host);
-
             DEBUG("client connected!");
             controller *player1_ctrl, *player2_ctrl;
             keyboard_keys *keys;
@@ -93,7 +89,18 @@ void menu_listen_tick(component *c) {
         }
         game_player *p2 = game_state_get_player(gs, 1);
         controller *c2 = game_player_get_ctrl(p2);
-        if(c2->type == CTRL_TYPE_NETWORK && net_controller_ready(c2) == 1) {
+        if(c2->type == CTRL_TYPE_NETWORK && net_controller_ready(c2) == -1) {
+            // The peer has different settings, drop the connection along with the controllers
+            DEBUG("network peer was refused");
+            for(int i = 0; i < 2; i++) {
+                game_player_set_ctrl(game_state_get_player(gs, i), NULL);
+            }
+            reconfigure_controller(gs);
+            local->host = NULL;
+            local->controllers_created = 0;
+            menu *m = sizer_get_obj(c);
+            m->finished = 1;
+        } else if(c2->type == CTRL_TYPE_NETWORK && net_controller_ready(c2) == 1) {
             DEBUG("network peer is ready, tick offset is %d and rtt is %d", net_controller_tick_offset(c2), c2->rtt);
             local->host = NULL;
             local->controllers_created = 0;
@@ -312,12 +312,12 @@ void handle_action(scene *scene, int player, int action) {
                         } else {
                             // pick an opponent we have not yet beaten
                             while(1) {
-                                int i = rand_int(10);
+                                int i = random_int(&scene->gs->rand, 10);
                                 if((2 << i) & player1->sp_wins || i == player1->pilot_id) {
                                     continue;
                                 }
                                 player2->pilot_id = i;
-                                player2->har_id = rand_int(10);
+                                player2->har_id = random_int(&scene->gs->rand, 10);
                                 break;
                             }
                         }
@@ -599,12 +599,12 @@ int melee_create(scene *scene) {
     animation *ani;
     sprite *spr;
     for(int i = 0; i < 10; i++) {
-        ani = &bk_get_info(&scene->bk_data, 3)->ani;
+        ani = &bk_get_info(scene->bk_data, 3)->ani;
         object_create(&local->pilots[i], scene->gs, vec2i_create(0, 0), vec2f_create(0, 0));
         object_set_animation(&local->pilots[i], ani);
         object_select_sprite(&local->pilots[i], i);
 
-        ani = &bk_get_info(&scene->bk_data, 18 + i)->ani;
+        ani = &bk_get_info(scene->bk_data, 18 + i)->ani;
         object_create(&local->har_player1[i], scene->gs, vec2i_create(110, 95), vec2f_create(0, 0));
         object_set_animation(&local->har_player1[i], ani);
         object_select_sprite(&local->har_player1[i], 0);
@@ -612,7 +612,7 @@ int melee_create(scene *scene) {
 
         int row = i / 5;
         int col = i % 5;
-        spr = sprite_copy(animation_get_sprite(&bk_get_info(&scene->bk_data, 1)->ani, 0));
+        spr = sprite_copy(animation_get_sprite(&bk_get_info(scene->bk_data, 1)->ani, 0));
         mask_sprite(spr->data, 62 * col, 42 * row, 51, 36);
         ani = create_animation_from_single(spr, spr->pos);
         object_create(&local->harportraits_player1[i], scene->gs, vec2i_create(0, 0), vec2f_create(0, 0));
@@ -620,7 +620,7 @@ int melee_create(scene *scene) {
         object_select_sprite(&local->harportraits_player1[i], 0);
         object_set_animation_owner(&local->harportraits_player1[i], OWNER_OBJECT);
         if(player2->selectable) {
-            spr = sprite_copy(animation_get_sprite(&bk_get_info(&scene->bk_data, 1)->ani, 0));
+            spr = sprite_copy(animation_get_sprite(&bk_get_info(scene->bk_data, 1)->ani, 0));
             mask_sprite(spr->data, 62 * col, 42 * row, 51, 36);
             ani = create_animation_from_single(spr, spr->pos);
             object_create(&local->harportraits_player2[i], scene->gs, vec2i_create(0, 0), vec2f_create(0, 0));
@@ -629,7 +629,7 @@ int melee_create(scene *scene) {
             object_set_animation_owner(&local->harportraits_player2[i], OWNER_OBJECT);
             object_set_pal_offset(&local->harportraits_player2[i], 48);
 
-            ani = &bk_get_info(&scene->bk_data, 18 + i)->ani;
+            ani = &bk_get_info(scene->bk_data, 18 + i)->ani;
             object_create(&local->har_player2[i], scene->gs, vec2i_create(210, 95), vec2f_create(0, 0));
             object_set_animation(&local->har_player2[i], ani);
             object_select_sprite(&local->har_player2[i], 0);
@@ -639,7 +639,7 @@ int melee_create(scene *scene) {
         }
     }
 
-    ani = &bk_get_info(&scene->bk_data, 4)->ani;
+    ani = &bk_get_info(scene->bk_data, 4)->ani;
     object_create(&local->bigportrait1, scene->gs, vec2i_create(0, 0), vec2f_create(0, 0));
     object_set_animation(&local->bigportrait1, ani);
     object_select_sprite(&local->bigportrait1, 0);
@@ -651,7 +651,7 @@ int melee_create(scene *scene) {
         object_set_direction(&local->bigportrait2, OBJECT_FACE_LEFT);
     }
 
-    ani = &bk_get_info(&scene->bk_data, 5)->ani;
+    ani = &bk_get_info(scene->bk_data, 5)->ani;
     object_create(&local->player2_placeholder, scene->gs, vec2i_create(0, 0), vec2f_create(0, 0));
     object_set_animation(&local->player2_placeholder, ani);
     if(player2->selectable) {
@@ -660,7 +660,7 @@ int melee_create(scene *scene) {
         object_select_sprite(&local->player2_placeholder, 1);
     }
 
-    spr = sprite_copy(animation_get_sprite(&bk_get_info(&scene->bk_data, 1)->ani, 0));
+    spr = sprite_copy(animation_get_sprite(&bk_get_info(scene->bk_data, 1)->ani, 0));
     surface_convert_to_rgba(spr->data, video_get_pal_ref(), 0);
     ani = create_animation_from_single(spr, spr->pos);
     object_create(&local->unselected_har_portraits, scene->gs, vec2i_create(0, 0), vec2f_create(0, 0));
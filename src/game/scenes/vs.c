@@ -7,6 +7,7 @@
 #include "game/protos/scene.h"
 #include "game/utils/settings.h"
 #include "resources/languages.h"
+#include "resources/resource_cache.h"
 #include "utils/allocator.h"
 #include "utils/random.h"
 #include "video/video.h"
@@ -44,14 +45,14 @@ int vs_is_singleplayer(scene *scene) {
     return 0;
 }
 
-vec2i spawn_position(int index, int scientist) {
+vec2i spawn_position(struct random_t *rand, int index, int scientist) {
     switch(index) {
         case 0:
             // top left gantry
             if(scientist) {
                 return vec2i_create(90, 80);
             }
-            switch(rand_int(3)) {
+            switch(random_int(rand, 3)) {
                 case 0:
                     // middle
                     return vec2i_create(90, 80);
@@ -68,7 +69,7 @@ vec2i spawn_position(int index, int scientist) {
             if(scientist) {
                 return vec2i_create(230, 80);
             }
-            switch(rand_int(3)) {
+            switch(random_int(rand, 3)) {
                 case 0:
                     // middle
                     return vec2i_create(230, 80);
@@ -105,7 +106,7 @@ void cb_vs_spawn_object(object *parent, int id, vec2i pos, vec2f vel, uint8_t fl
     scene *sc = (scene *)userdata;
 
     // Get next animation
-    bk_info *info = bk_get_info(&sc->bk_data, id);
+    bk_info *info = bk_get_info(sc->bk_data, id);
     if(info != NULL) {
         object *obj = omf_calloc(1, sizeof(object));
         object_create(obj, parent->gs, vec2i_add(pos, vec2f_to_i(parent->pos)), vel);
@@ -139,6 +140,11 @@ void vs_free(scene *scene) {
     scene_set_userdata(scene, local);
 }
 
+// Start loading the selected arena while the player is still looking at this screen
+static void vs_prefetch_arena(vs_local *local) {
+    resource_cache_prefetch_bk(scene_to_resource(SCENE_ARENA0 + local->arena));
+}
+
 void vs_handle_action(scene *scene, int action) {
     vs_local *local = scene_get_userdata(scene);
     if(dialog_is_visible(&local->too_pathetic_dialog)) {
@@ -159,6 +165,7 @@ void vs_handle_action(scene *scene, int action) {
                         local->arena = 4;
                     }
                     object_select_sprite(&local->arena_select, local->arena);
+                    vs_prefetch_arena(local);
                 }
                 break;
             case ACT_DOWN:
@@ -169,6 +176,7 @@ void vs_handle_action(scene *scene, int action) {
                         local->arena = 0;
                     }
                     object_select_sprite(&local->arena_select, local->arena);
+                    vs_prefetch_arena(local);
                 }
                 break;
         }
@@ -322,7 +330,7 @@ int vs_create(scene *scene) {
     video_force_pal_refresh();
 
     // HAR
-    ani = &bk_get_info(&scene->bk_data, 5)->ani;
+    ani = &bk_get_info(scene->bk_data, 5)->ani;
     object_create(&local->player1_har, scene->gs, vec2i_create(160, 0), vec2f_create(0, 0));
     object_set_animation(&local->player1_har, ani);
     object_select_sprite(&local->player1_har, player1->har_id);
@@ -334,7 +342,7 @@ int vs_create(scene *scene) {
     object_set_pal_offset(&local->player2_har, 48);
 
     // PLAYER
-    ani = &bk_get_info(&scene->bk_data, 4)->ani;
+    ani = &bk_get_info(scene->bk_data, 4)->ani;
     object_create(&local->player1_portrait, scene->gs, vec2i_create(-10, 150), vec2f_create(0, 0));
     object_set_animation(&local->player1_portrait, ani);
     object_select_sprite(&local->player1_portrait, player1->pilot_id);
@@ -345,13 +353,12 @@ int vs_create(scene *scene) {
     object_set_direction(&local->player2_portrait, OBJECT_FACE_LEFT);
 
     // clone the left side of the background image
-    // Note! We are touching the scene-wide background surface!
-    surface_sub(&scene->bk_data.background, // DST Surface
-                &scene->bk_data.background, // SRC Surface
-                160, 0,                     // DST
-                0, 0,                       // SRC
-                160, 200,                   // Size
-                SUB_METHOD_MIRROR);         // Flip the right side horizontally
+    surface_sub(&scene->background, // DST Surface
+                &scene->background, // SRC Surface
+                160, 0,             // DST
+                0, 0,               // SRC
+                160, 200,           // Size
+                SUB_METHOD_MIRROR); // Flip the right side horizontally
 
     if(player2->selectable) {
         // player1 gets to choose, start at arena 0
@@ -361,27 +368,28 @@ int vs_create(scene *scene) {
         local->arena = 0;
     } else {
         // pick a random arena for 1 player mode
-        local->arena = rand_int(5); // srand was done in melee
+        local->arena = random_int(&scene->gs->rand, 5); // srand was done in melee
     }
+    vs_prefetch_arena(local);
 
     // Arena
     if(player2->selectable) {
-        ani = &bk_get_info(&scene->bk_data, 3)->ani;
+        ani = &bk_get_info(scene->bk_data, 3)->ani;
         object_create(&local->arena_select, scene->gs, vec2i_create(59, 155), vec2f_create(0, 0));
         object_set_animation(&local->arena_select, ani);
         object_select_sprite(&local->arena_select, local->arena);
     }
 
     // SCIENTIST
-    int scientistpos = rand_int(4);
-    vec2i scientistcoord = spawn_position(scientistpos, 1);
+    int scientistpos = random_int(&scene->gs->rand, 4);
+    vec2i scientistcoord = spawn_position(&scene->gs->rand, scientistpos, 1);
     if(scientistpos % 2) {
         scientistcoord.x += 50;
     } else {
         scientistcoord.x -= 50;
     }
     object *o_scientist = omf_calloc(1, sizeof(object));
-    ani = &bk_get_info(&scene->bk_data, 8)->ani;
+    ani = &bk_get_info(scene->bk_data, 8)->ani;
     object_create(o_scientist, scene->gs, scientistcoord, vec2f_create(0, 0));
     object_set_animation(o_scientist, ani);
     object_select_sprite(o_scientist, 0);
@@ -389,17 +397,17 @@ int vs_create(scene *scene) {
     game_state_add_object(scene->gs, o_scientist, RENDER_LAYER_MIDDLE, 0, 0);
 
     // WELDER
-    int welderpos = rand_int(6);
+    int welderpos = random_int(&scene->gs->rand, 6);
     // welder can't be on the same gantry or the same *side* as the scientist
     // he also can't be on the same 'level'
     // but he has 10 possible starting positions
     while((welderpos % 2) == (scientistpos % 2) || (scientistpos < 2 && welderpos < 2) ||
           (scientistpos > 1 && welderpos > 1 && welderpos < 4)) {
-        welderpos = rand_int(6);
+        welderpos = random_int(&scene->gs->rand, 6);
     }
     object *o_welder = omf_calloc(1, sizeof(object));
-    ani = &bk_get_info(&scene->bk_data, 7)->ani;
-    object_create(o_welder, scene->gs, spawn_position(welderpos, 0), vec2f_create(0, 0));
+    ani = &bk_get_info(scene->bk_data, 7)->ani;
+    object_create(o_welder, scene->gs, spawn_position(&scene->gs->rand, welderpos, 0), vec2f_create(0, 0));
     object_set_animation(o_welder, ani);
     object_select_sprite(o_welder, 0);
     object_set_spawn_cb(o_welder, cb_vs_spawn_object, (void *)scene);
@@ -409,7 +417,7 @@ int vs_create(scene *scene) {
 
     // GANTRIES
     object *o_gantry_a = omf_calloc(1, sizeof(object));
-    ani = &bk_get_info(&scene->bk_data, 11)->ani;
+    ani = &bk_get_info(scene->bk_data, 11)->ani;
     object_create(o_gantry_a, scene->gs, vec2i_create(0, 0), vec2f_create(0, 0));
     object_set_animation(o_gantry_a, ani);
     object_select_sprite(o_gantry_a, 0);
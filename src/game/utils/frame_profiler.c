@@ -0,0 +1,260 @@
+#include "game/utils/frame_profiler.h"
+#include "game/gui/text_render.h"
+#include "utils/log.h"
+#include "video/draw_list.h"
+#include "video/surface.h"
+#include "video/tcache.h"
+#include "video/video.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_FRAMES 600
+#define AVERAGE_FRAMES 60
+
+// The graph shows one frame per pixel column, and 2 pixels per millisecond
+#define GRAPH_W 120
+#define GRAPH_H 40
+#define GRAPH_PX_PER_MS 2
+#define GRAPH_X (NATIVE_W - GRAPH_W - 2)
+#define GRAPH_Y 2
+
+typedef struct profiler_frame_t {
+    uint64_t start;                      ///< Performance counter at the start of the frame
+    uint64_t end;                        ///< Performance counter at the end of the frame
+    uint64_t first[FRAME_SECTION_COUNT]; ///< Performance counter at the first run of each section
+    uint64_t total[FRAME_SECTION_COUNT]; ///< Accumulated performance counter ticks per section
+    tcache_stats tex;                    ///< Texture cache counters for this frame alone
+    draw_list_stats draw;                ///< Sprite draw and batch counters of this frame
+} profiler_frame;
+
+typedef struct frame_profiler_t {
+    profiler_frame frames[MAX_FRAMES];
+    unsigned int head;  ///< Slot of the frame being recorded
+    unsigned int count; ///< Finished frames in the buffer
+    tcache_stats tex_start;
+    int overlay;
+    surface graph;
+} frame_profiler;
+
+static frame_profiler prof;
+
+static const char *section_names[] = {
+    "events", "controllers", "static_tick", "dynamic_tick", "audio", "render", "console", "present",
+};
+
+static const unsigned char section_colors[][3] = {
+    {128, 128, 128}, {0, 160, 255}, {0, 200, 0}, {255, 220, 0},
+    {255, 128, 0},   {255, 0, 0},   {200, 0, 255}, {255, 255, 255},
+};
+
+void frame_profiler_close() {
+    if(prof.graph.data != NULL) {
+        surface_free(&prof.graph);
+    }
+    prof.overlay = 0;
+    prof.count = 0;
+}
+
+// Returns the nth newest finished frame; 0 is the newest one.
+static const profiler_frame *get_frame(unsigned int n) {
+    return &prof.frames[(prof.head + MAX_FRAMES - 1 - n) % MAX_FRAMES];
+}
+
+static double ticks_to_ms(uint64_t ticks) {
+    return (double)ticks * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void frame_profiler_begin_frame() {
+    profiler_frame *frame = &prof.frames[prof.head];
+    memset(frame, 0, sizeof(profiler_frame));
+    tcache_get_stats(&prof.tex_start);
+    frame->start = SDL_GetPerformanceCounter();
+}
+
+void frame_profiler_end_frame() {
+    profiler_frame *frame = &prof.frames[prof.head];
+    tcache_stats now;
+    tcache_get_stats(&now);
+    frame->tex.hits = now.hits - prof.tex_start.hits;
+    frame->tex.misses = now.misses - prof.tex_start.misses;
+    frame->tex.uploads = now.uploads - prof.tex_start.uploads;
+    draw_list_get_stats(&frame->draw);
+    frame->end = SDL_GetPerformanceCounter();
+    prof.head = (prof.head + 1) % MAX_FRAMES;
+    if(prof.count < MAX_FRAMES) {
+        prof.count++;
+    }
+}
+
+uint64_t frame_profiler_begin() {
+    return SDL_GetPerformanceCounter();
+}
+
+void frame_profiler_end(frame_section section, uint64_t start) {
+    profiler_frame *frame = &prof.frames[prof.head];
+    if(frame->first[section] == 0) {
+        frame->first[section] = start;
+    }
+    frame->total[section] += SDL_GetPerformanceCounter() - start;
+}
+
+void frame_profiler_toggle_overlay() {
+    prof.overlay = !prof.overlay;
+    if(prof.overlay && prof.graph.data == NULL) {
+        surface_create(&prof.graph, SURFACE_TYPE_RGBA, GRAPH_W, GRAPH_H);
+    }
+}
+
+static void graph_put(int x, int y, const unsigned char *rgb, unsigned char a) {
+    char *px = prof.graph.data + (y * GRAPH_W + x) * 4;
+    px[0] = rgb[0];
+    px[1] = rgb[1];
+    px[2] = rgb[2];
+    px[3] = a;
+}
+
+// Draws the newest frame in the rightmost column, with the sections stacked from the bottom up.
+static void draw_graph() {
+    static const unsigned char black[3] = {0, 0, 0};
+    static const unsigned char grey[3] = {96, 96, 96};
+    int budget_y = GRAPH_H - 1 - (1000 * GRAPH_PX_PER_MS) / 60;
+    for(int x = 0; x < GRAPH_W; x++) {
+        for(int y = 0; y < GRAPH_H; y++) {
+            graph_put(x, y, (y == budget_y) ? grey : black, 160);
+        }
+        unsigned int n = GRAPH_W - 1 - x;
+        if(n >= prof.count) {
+            continue;
+        }
+        const profiler_frame *frame = get_frame(n);
+        double ms = 0;
+        int y = GRAPH_H;
+        for(int s = 0; s < FRAME_SECTION_COUNT && y > 0; s++) {
+            ms += ticks_to_ms(frame->total[s]);
+            int top = GRAPH_H - (int)(ms * GRAPH_PX_PER_MS);
+            for(; y > top && y > 0; y--) {
+                graph_put(x, y - 1, section_colors[s], 255);
+            }
+        }
+    }
+    surface_force_refresh(&prof.graph);
+}
+
+void frame_profiler_render() {
+    if(!prof.overlay) {
+        return;
+    }
+
+    draw_graph();
+    video_render_sprite(&prof.graph, GRAPH_X, GRAPH_Y, BLEND_ALPHA, 0);
+
+    // Averages over the last second or so, in the same colors as the graph
+    char buf[32];
+    double total[FRAME_SECTION_COUNT] = {0};
+    double frame_ms = 0;
+    tcache_stats tex = {0, 0, 0};
+    draw_list_stats draw = {0, 0, 0};
+    unsigned int n = (prof.count < AVERAGE_FRAMES) ? prof.count : AVERAGE_FRAMES;
+    for(unsigned int i = 0; i < n; i++) {
+        const profiler_frame *frame = get_frame(i);
+        for(int s = 0; s < FRAME_SECTION_COUNT; s++) {
+            total[s] += ticks_to_ms(frame->total[s]);
+        }
+        frame_ms += ticks_to_ms(frame->end - frame->start);
+        tex.hits += frame->tex.hits;
+        tex.misses += frame->tex.misses;
+        tex.uploads += frame->tex.uploads;
+        draw.draws += frame->draw.draws;
+        draw.submissions += frame->draw.submissions;
+    }
+    if(n == 0) {
+        return;
+    }
+
+    int y = GRAPH_Y + GRAPH_H + 2;
+    snprintf(buf, sizeof(buf), "frame %6.2f ms", frame_ms / n);
+    font_render_shadowed(&font_small, buf, GRAPH_X, y, COLOR_WHITE, TEXT_SHADOW_RIGHT | TEXT_SHADOW_BOTTOM);
+    y += font_small.h + 1;
+    for(int s = 0; s < FRAME_SECTION_COUNT; s++) {
+        color c = color_create(section_colors[s][0], section_colors[s][1], section_colors[s][2], 255);
+        snprintf(buf, sizeof(buf), "%-12s %6.2f", section_names[s], total[s] / n);
+        font_render_shadowed(&font_small, buf, GRAPH_X, y, c, TEXT_SHADOW_RIGHT | TEXT_SHADOW_BOTTOM);
+        y += font_small.h + 1;
+    }
+    snprintf(buf, sizeof(buf), "tex %u/%u/%u", tex.hits / n, tex.misses / n, tex.uploads / n);
+    font_render_shadowed(&font_small, buf, GRAPH_X, y, COLOR_WHITE, TEXT_SHADOW_RIGHT | TEXT_SHADOW_BOTTOM);
+    y += font_small.h + 1;
+    snprintf(buf, sizeof(buf), "draw %u/%u", draw.draws / n, draw.submissions / n);
+    font_render_shadowed(&font_small, buf, GRAPH_X, y, COLOR_WHITE, TEXT_SHADOW_RIGHT | TEXT_SHADOW_BOTTOM);
+}
+
+int frame_profiler_write_csv(const char *filename) {
+    FILE *fp = fopen(filename, "w");
+    if(fp == NULL) {
+        PERROR("Unable to open profile file %s for writing", filename);
+        return 1;
+    }
+    fprintf(fp, "frame,start_ms,frame_ms");
+    for(int s = 0; s < FRAME_SECTION_COUNT; s++) {
+        fprintf(fp, ",%s_ms", section_names[s]);
+    }
+    fprintf(fp, ",tex_hits,tex_misses,tex_uploads,draws,draw_submissions,draw_flushes\n");
+
+    uint64_t base = (prof.count > 0) ? get_frame(prof.count - 1)->start : 0;
+    for(unsigned int i = 0; i < prof.count; i++) {
+        const profiler_frame *frame = get_frame(prof.count - 1 - i);
+        fprintf(fp, "%u,%.3f,%.3f", i, ticks_to_ms(frame->start - base), ticks_to_ms(frame->end - frame->start));
+        for(int s = 0; s < FRAME_SECTION_COUNT; s++) {
+            fprintf(fp, ",%.3f", ticks_to_ms(frame->total[s]));
+        }
+        fprintf(fp, ",%u,%u,%u,%u,%u,%u\n", frame->tex.hits, frame->tex.misses, frame->tex.uploads, frame->draw.draws,
+                frame->draw.submissions, frame->draw.flushes);
+    }
+    fclose(fp);
+    INFO("Wrote %u frames of profile data to %s", prof.count, filename);
+    return 0;
+}
+
+// Writes the frames in the Chrome trace event format, which can be opened in chrome://tracing or
+// Perfetto. Each section becomes a single event per frame, starting from its first run.
+int frame_profiler_write_trace(const char *filename) {
+    FILE *fp = fopen(filename, "w");
+    if(fp == NULL) {
+        PERROR("Unable to open profile file %s for writing", filename);
+        return 1;
+    }
+    fprintf(fp, "{\"traceEvents\":[\n");
+
+    uint64_t base = (prof.count > 0) ? get_frame(prof.count - 1)->start : 0;
+    const char *sep = "";
+    for(unsigned int i = 0; i < prof.count; i++) {
+        const profiler_frame *frame = get_frame(prof.count - 1 - i);
+        double ts = ticks_to_ms(frame->start - base) * 1000.0;
+        fprintf(fp, "%s{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"dur\":%.1f}", sep, ts,
+                ticks_to_ms(frame->end - frame->start) * 1000.0);
+        sep = ",\n";
+        for(int s = 0; s < FRAME_SECTION_COUNT; s++) {
+            if(frame->first[s] == 0) {
+                continue;
+            }
+            fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"dur\":%.1f}", sep,
+                    section_names[s], ticks_to_ms(frame->first[s] - base) * 1000.0,
+                    ticks_to_ms(frame->total[s]) * 1000.0);
+        }
+        fprintf(fp, "%s{\"name\":\"tcache\",\"ph\":\"C\",\"pid\":1,\"ts\":%.1f,", sep, ts);
+        fprintf(fp, "\"args\":{\"hits\":%u,\"misses\":%u,\"uploads\":%u}}", frame->tex.hits, frame->tex.misses,
+                frame->tex.uploads);
+    }
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+    INFO("Wrote %u frames of trace data to %s", prof.count, filename);
+    return 0;
+}
+
+const char *frame_profiler_get_name(frame_section section) {
+    if(section < 0 || section >= FRAME_SECTION_COUNT) {
+        return NULL;
+    }
+    return section_names[section];
+}
@@ -0,0 +1,38 @@
+#include "game/utils/phase_timings.h"
+#include <SDL.h>
+#include <string.h>
+
+static const char *phase_names[] = {
+    "cleanup", "call_move", "call_collide", "call_tick", "scene_dynamic_tick", "render",
+};
+
+void phase_timings_reset(phase_timings *t) {
+    memset(t, 0, sizeof(phase_timings));
+}
+
+uint64_t phase_timings_begin(const phase_timings *t) {
+    // Don't bother querying the counter if nobody is listening
+    if(t == NULL) {
+        return 0;
+    }
+    return SDL_GetPerformanceCounter();
+}
+
+void phase_timings_end(phase_timings *t, phase_id phase, uint64_t start) {
+    if(t == NULL) {
+        return;
+    }
+    t->total[phase] += SDL_GetPerformanceCounter() - start;
+    t->calls[phase]++;
+}
+
+double phase_timings_get_ms(const phase_timings *t, phase_id phase) {
+    return (double)t->total[phase] * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+const char *phase_timings_get_name(phase_id phase) {
+    if(phase < 0 || phase >= PHASE_COUNT) {
+        return NULL;
+    }
+    return phase_names[phase];
+}
@@ -0,0 +1,47 @@
+#include "game/utils/render_queue.h"
+#include "game/protos/object.h"
+
+void render_queue_create(render_queue *queue) {
+    for(int i = 0; i < RENDER_BAND_COUNT; i++) {
+        vector_create(&queue->bands[i], sizeof(object *));
+    }
+}
+
+void render_queue_free(render_queue *queue) {
+    for(int i = 0; i < RENDER_BAND_COUNT; i++) {
+        vector_free(&queue->bands[i]);
+    }
+}
+
+void render_queue_clear(render_queue *queue) {
+    for(int i = 0; i < RENDER_BAND_COUNT; i++) {
+        vector_clear(&queue->bands[i]);
+    }
+}
+
+void render_queue_add(render_queue *queue, render_band band, object *obj) {
+    vector_append(&queue->bands[band], &obj);
+}
+
+unsigned int render_queue_size(const render_queue *queue) {
+    unsigned int size = 0;
+    for(int i = 0; i < RENDER_BAND_COUNT; i++) {
+        size += vector_size(&queue->bands[i]);
+    }
+    return size;
+}
+
+void render_queue_render(const render_queue *queue) {
+    iterator it;
+    object **obj;
+    for(int i = 0; i < RENDER_BAND_COUNT; i++) {
+        vector_iter_begin(&queue->bands[i], &it);
+        while((obj = iter_next(&it)) != NULL) {
+            if(i == RENDER_BAND_SHADOWS) {
+                object_render_shadow(*obj);
+            } else {
+                object_render(*obj);
+            }
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#include "game/utils/rollback.h"
+#include "controller/controller.h"
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/protos/object.h"
+#include "utils/log.h"
+#include <SDL.h>
+#include <string.h>
+
+static rollback_frame *get_frame(rollback *rb, unsigned int tick) {
+    return &rb->frames[tick % ROLLBACK_FRAMES];
+}
+
+static int input_equal(const rollback_input *a, const rollback_input *b) {
+    return a->count == b->count && memcmp(a->actions, b->actions, a->count * sizeof(uint16_t)) == 0;
+}
+
+void rollback_create(rollback *rb, int local_player) {
+    memset(rb, 0, sizeof(rollback));
+    rb->local = local_player;
+    for(int i = 0; i < ROLLBACK_FRAMES; i++) {
+        snapshot_create(&rb->frames[i].snapshot);
+    }
+}
+
+void rollback_free(rollback *rb) {
+    for(int i = 0; i < ROLLBACK_FRAMES; i++) {
+        snapshot_free(&rb->frames[i].snapshot);
+    }
+}
+
+int rollback_get_local(const rollback *rb) {
+    return rb->local;
+}
+
+unsigned int rollback_get_tick(const rollback *rb) {
+    return rb->tick;
+}
+
+int rollback_can_advance(const rollback *rb) {
+    // The snapshot of the first unconfirmed tick must stay in the buffer. The inputs of the peer may
+    // also be ahead of the simulation, eg. when it entered the game first.
+    return rb->tick < rb->confirmed_tick || rb->tick - rb->confirmed_tick < ROLLBACK_FRAMES;
+}
+
+void rollback_add_local_action(rollback *rb, int action) {
+    rollback_input *input = &rb->local_input;
+    if(input->count < ROLLBACK_MAX_ACTIONS) {
+        input->actions[input->count++] = action;
+    }
+}
+
+int rollback_get_local_input(const rollback *rb, unsigned int tick, rollback_input *input) {
+    if(tick >= rb->tick || rb->tick - tick > ROLLBACK_FRAMES) {
+        return 1;
+    }
+    *input = rb->frames[tick % ROLLBACK_FRAMES].input[rb->local];
+    return 0;
+}
+
+int rollback_add_remote_input(rollback *rb, unsigned int tick, const rollback_input *input) {
+    // The peer never runs further ahead than the buffer, since it waits for our inputs as well
+    if(tick != rb->confirmed_tick || (tick > rb->tick && tick - rb->tick >= ROLLBACK_FRAMES) ||
+       input->count > ROLLBACK_MAX_ACTIONS) {
+        return 1;
+    }
+    rb->remote[tick % ROLLBACK_REMOTE_FRAMES] = *input;
+    rb->confirmed_tick++;
+
+    // Ticks that have been simulated already were run with a guess
+    if(tick < rb->tick && !input_equal(&get_frame(rb, tick)->input[!rb->local], input)) {
+        rb->stats.mispredictions++;
+        if(!rb->mispredicted || tick < rb->rollback_tick) {
+            rb->rollback_tick = tick;
+            rb->mispredicted = 1;
+        }
+    }
+    return 0;
+}
+
+// Guesses the remote input of a tick by holding the direction of the last known input. Punches
+// and kicks are one-off presses, so they are not repeated.
+static void predict_input(const rollback *rb, rollback_input *input) {
+    memset(input, 0, sizeof(rollback_input));
+    if(rb->confirmed_tick == 0) {
+        return;
+    }
+    const rollback_input *last = &rb->remote[(rb->confirmed_tick - 1) % ROLLBACK_REMOTE_FRAMES];
+    for(int i = 0; i < last->count; i++) {
+        if(!(last->actions[i] & (ACT_PUNCH | ACT_KICK | ACT_ESC))) {
+            input->actions[input->count++] = last->actions[i];
+        }
+    }
+}
+
+void rollback_save(rollback *rb, game_state *gs) {
+    uint64_t start = SDL_GetPerformanceCounter();
+    unsigned int tick = rb->resimulating ? rb->resim_tick : rb->tick;
+    rollback_frame *frame = get_frame(rb, tick);
+    frame->tick = tick;
+    snapshot_save(&frame->snapshot, gs);
+    rb->stats.saves++;
+    rb->stats.save_time += SDL_GetPerformanceCounter() - start;
+}
+
+static void restore(rollback *rb, game_state *gs, unsigned int tick) {
+    uint64_t start = SDL_GetPerformanceCounter();
+    snapshot_restore(&get_frame(rb, tick)->snapshot, gs);
+    rb->stats.restore_time += SDL_GetPerformanceCounter() - start;
+}
+
+void rollback_update(rollback *rb, game_state *gs) {
+    if(!rb->mispredicted) {
+        return;
+    }
+    unsigned int from = rb->rollback_tick;
+    unsigned int depth = rb->tick - from;
+    restore(rb, gs, from);
+
+    uint64_t start = SDL_GetPerformanceCounter();
+    rb->resimulating = 1;
+    for(rb->resim_tick = from; rb->resim_tick < rb->tick; rb->resim_tick++) {
+        // The snapshot of the first tick is the one that was just restored
+        if(rb->resim_tick != from) {
+            rollback_save(rb, gs);
+        }
+        game_state_resim_tick(gs);
+    }
+    rb->resimulating = 0;
+    rb->mispredicted = 0;
+    rb->stats.resim_time += SDL_GetPerformanceCounter() - start;
+
+    rb->stats.rollbacks++;
+    rb->stats.resim_ticks += depth;
+    if(depth > rb->stats.max_depth) {
+        rb->stats.max_depth = depth;
+    }
+}
+
+void rollback_apply_inputs(rollback *rb, game_state *gs) {
+    unsigned int tick = rb->resimulating ? rb->resim_tick : rb->tick;
+    rollback_frame *frame = get_frame(rb, tick);
+    if(!rb->resimulating) {
+        frame->input[rb->local] = rb->local_input;
+        memset(&rb->local_input, 0, sizeof(rollback_input));
+    }
+    if(tick < rb->confirmed_tick) {
+        frame->input[!rb->local] = rb->remote[tick % ROLLBACK_REMOTE_FRAMES];
+    } else {
+        predict_input(rb, &frame->input[!rb->local]);
+    }
+
+    // Both players are handled in the same order on both ends
+    for(int i = 0; i < 2; i++) {
+        object *har = game_player_get_har(game_state_get_player(gs, i));
+        for(int k = 0; k < frame->input[i].count; k++) {
+            object_act(har, frame->input[i].actions[k]);
+        }
+    }
+    if(!rb->resimulating) {
+        rb->tick++;
+    }
+}
+
+const rollback_stats *rollback_get_stats(const rollback *rb) {
+    return &rb->stats;
+}
@@ -318,3 +318,54 @@ void chr_score_unserialize(chr_score *score, serial *ser) {
         chr_score_add(score, text, points, vec2i_create(x, y), pos);
     }
 }
+
+void chr_score_snapshot_create(chr_score_snapshot *snap) {
+    memset(snap, 0, sizeof(chr_score_snapshot));
+    serial_create(&snap->texts);
+}
+
+void chr_score_snapshot_free(chr_score_snapshot *snap) {
+    serial_free(&snap->texts);
+}
+
+void chr_score_snapshot_save(const chr_score *score, chr_score_snapshot *snap) {
+    snap->score = *score;
+    snap->text_count = list_size(&score->texts);
+    serial_write_reset(&snap->texts);
+
+    iterator it;
+    score_text *t;
+    list_iter_begin(&score->texts, &it);
+    while((t = iter_next(&it)) != NULL) {
+        serial_write(&snap->texts, (const char *)t, sizeof(score_text));
+        serial_write_int16(&snap->texts, strlen(t->text) + 1);
+        serial_write(&snap->texts, t->text, strlen(t->text) + 1);
+    }
+}
+
+void chr_score_snapshot_restore(chr_score *score, chr_score_snapshot *snap) {
+    list texts = score->texts;
+    *score = snap->score;
+    score->texts = texts;
+
+    // Texts only show up after hits, so there usually are none on either side
+    if(snap->text_count == 0 && list_size(&score->texts) == 0) {
+        return;
+    }
+    iterator it;
+    score_text *t;
+    list_iter_begin(&score->texts, &it);
+    while((t = iter_next(&it)) != NULL) {
+        omf_free(t->text);
+        list_delete(&score->texts, &it);
+    }
+    serial_read_reset(&snap->texts);
+    for(unsigned int i = 0; i < snap->text_count; i++) {
+        score_text s;
+        serial_read(&snap->texts, (char *)&s, sizeof(score_text));
+        uint16_t text_len = serial_read_int16(&snap->texts);
+        s.text = omf_calloc(text_len, 1);
+        serial_read(&snap->texts, s.text, text_len);
+        list_append(&score->texts, &s, sizeof(score_text));
+    }
+}
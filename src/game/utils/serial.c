@@ -103,6 +103,12 @@ void serial_read_reset(serial *s) {
     s->rpos = 0;
 }
 
+// Empties the buffer, but keeps the memory around for the next writes
+void serial_write_reset(serial *s) {
+    s->wpos = 0;
+    s->rpos = 0;
+}
+
 void serial_read(serial *s, char *buf, size_t len) {
     if(len + s->rpos > s->wpos) {
         len = s->wpos - s->rpos;
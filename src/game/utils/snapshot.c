@@ -0,0 +1,57 @@
+#include "game/utils/snapshot.h"
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/protos/scene.h"
+#include "utils/random.h"
+#include <string.h>
+
+void snapshot_create(snapshot *snap) {
+    memset(snap, 0, sizeof(snapshot));
+    for(int i = 0; i < 2; i++) {
+        har_snapshot_create(&snap->hars[i]);
+        chr_score_snapshot_create(&snap->scores[i]);
+    }
+    serial_create(&snap->projectiles);
+    serial_create(&snap->scene);
+}
+
+void snapshot_free(snapshot *snap) {
+    for(int i = 0; i < 2; i++) {
+        har_snapshot_free(&snap->hars[i]);
+        chr_score_snapshot_free(&snap->scores[i]);
+    }
+    serial_free(&snap->projectiles);
+    serial_free(&snap->scene);
+}
+
+void snapshot_save(snapshot *snap, game_state *gs) {
+    snap->tick = gs->tick;
+    snap->seed = random_get_seed(&gs->rand);
+    snap->paused = game_state_is_paused(gs);
+    for(int i = 0; i < 2; i++) {
+        game_player *player = game_state_get_player(gs, i);
+        har_snapshot_save(player->har, &snap->hars[i]);
+        chr_score_snapshot_save(game_player_get_score(player), &snap->scores[i]);
+    }
+    serial_write_reset(&snap->projectiles);
+    snap->projectile_count = game_state_serialize_projectiles(gs, &snap->projectiles);
+    serial_write_reset(&snap->scene);
+    scene_serialize(game_state_get_scene(gs), &snap->scene);
+}
+
+void snapshot_restore(snapshot *snap, game_state *gs) {
+    gs->tick = snap->tick;
+    game_state_set_paused(gs, snap->paused);
+    for(int i = 0; i < 2; i++) {
+        game_player *player = game_state_get_player(gs, i);
+        har_snapshot_restore(player->har, &snap->hars[i]);
+        chr_score_snapshot_restore(game_player_get_score(player), &snap->scores[i]);
+    }
+    serial_read_reset(&snap->projectiles);
+    game_state_unserialize_projectiles(gs, &snap->projectiles, snap->projectile_count);
+    serial_read_reset(&snap->scene);
+    scene_unserialize(game_state_get_scene(gs), &snap->scene);
+
+    // Creating the projectiles above took numbers from the generator
+    random_seed(&gs->rand, snap->seed);
+}
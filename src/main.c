@@ -34,6 +34,9 @@ int main(int argc, char *argv[]) {
     engine_init_flags init_flags;
     init_flags.net_mode = NET_MODE_NONE;
     init_flags.record = 0;
+    init_flags.headless = 0;
+    init_flags.seed = 0;
+    init_flags.match = NULL;
     memset(init_flags.rec_file, 0, 255);
     int ret = 0;
 
@@ -51,8 +54,9 @@ int main(int argc, char *argv[]) {
     struct arg_int *port = arg_int0("p", "port", "<port>", "Port to connect or listen (default: 2097)");
     struct arg_file *play = arg_file0("P", "play", "<file>", "Play an existing recfile");
     struct arg_file *rec = arg_file0("R", "rec", "<file>", "Record a new recfile");
+    struct arg_lit *headless = arg_lit0(NULL, "headless", "Run the simulation without video or audio output");
     struct arg_end *end = arg_end(30);
-    void *argtable[] = {help, vers, listen, connect, port, play, rec, end};
+    void *argtable[] = {help, vers, listen, connect, port, play, rec, headless, end};
     const char *progname = "openomf";
 
     // Make sure everything got allocated
@@ -107,6 +111,13 @@ int main(int argc, char *argv[]) {
         init_flags.record = 1;
         strncpy(init_flags.rec_file, rec->filename[0], 254);
     }
+    if(headless->count > 0) {
+        if(init_flags.net_mode != NET_MODE_NONE || init_flags.record) {
+            fprintf(stderr, "Error: --headless can not be combined with network play or recording.\n");
+            goto exit_0;
+        }
+        init_flags.headless = 1;
+    }
 
     // Init log
 #if defined(DEBUGMODE)
@@ -164,8 +175,12 @@ int main(int argc, char *argv[]) {
         settings_get()->net.net_listen_port = listen_port;
     }
 
-    // Init SDL2
-    if(SDL_Init(SDL_INIT_TIMER | SDL_INIT_VIDEO)) {
+    // Init SDL2. Headless runs don't need a video subsystem at all.
+    Uint32 sdl_flags = SDL_INIT_TIMER;
+    if(!init_flags.headless) {
+        sdl_flags |= SDL_INIT_VIDEO;
+    }
+    if(SDL_Init(sdl_flags)) {
         err_msgbox("SDL2 Initialization failed: %s", SDL_GetError());
         goto exit_2;
     }
@@ -223,7 +238,7 @@ int main(int argc, char *argv[]) {
     }
 
     // Initialize engine
-    if(engine_init()) {
+    if(engine_init(&init_flags)) {
         err_msgbox("Failed to initialize game engine.");
         goto exit_4;
     }
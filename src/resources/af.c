@@ -1,7 +1,44 @@
 #include "formats/af.h"
 #include "resources/af.h"
+#include "utils/allocator.h"
 #include <string.h>
 
+#define MASK_WORD(id) ((id) / 32)
+#define MASK_BIT(id) (1U << ((id) % 32))
+
+static int af_add_move_node(af *a, char c) {
+    a->move_nodes = omf_realloc(a->move_nodes, (a->move_node_count + 1) * sizeof(af_move_node));
+    af_move_node *node = &a->move_nodes[a->move_node_count];
+    memset(node, 0, sizeof(af_move_node));
+    node->c = c;
+    node->child = -1;
+    node->sibling = -1;
+    return a->move_node_count++;
+}
+
+static void af_index_move(af *a, const af_move *move) {
+    const char *str = str_c(&move->move_string);
+    size_t len = move->move_string.len;
+    int node = 0;
+    for(size_t i = 0; i < len; i++) {
+        int next = a->move_nodes[node].child;
+        while(next != -1 && a->move_nodes[next].c != str[i]) {
+            next = a->move_nodes[next].sibling;
+        }
+        if(next == -1) {
+            next = af_add_move_node(a, str[i]);
+            a->move_nodes[next].sibling = a->move_nodes[node].child;
+            a->move_nodes[node].child = next;
+        }
+        node = next;
+    }
+    a->move_nodes[node].moves[MASK_WORD(move->id)] |= MASK_BIT(move->id);
+
+    if(move->category < AF_MOVE_CATEGORIES) {
+        a->category_moves[move->category][MASK_WORD(move->id)] |= MASK_BIT(move->id);
+    }
+}
+
 void af_create(af *a, void *src) {
     sd_af_file *sdaf = (sd_af_file *)src;
 
@@ -23,10 +60,17 @@ void af_create(af *a, void *src) {
     a->sound_translation_table[26] = 0;
     a->sound_translation_table[27] = 0;
 
+    // Move lookup tables; node 0 is the root of the trie, and holds the moves with an empty string.
+    a->move_nodes = NULL;
+    a->move_node_count = 0;
+    memset(a->category_moves, 0, sizeof(a->category_moves));
+    af_add_move_node(a, '\0');
+
     // Moves
-    for(int i = 0; i < 70; i++) {
+    for(int i = 0; i < AF_MOVE_COUNT; i++) {
         if(sdaf->moves[i] != NULL) {
             af_move_create(&a->moves[i], (void *)sdaf->moves[i], i);
+            af_index_move(a, &a->moves[i]);
         } else {
             a->moves[i].id = -1;
         }
@@ -40,10 +84,56 @@ af_move *af_get_move(af *a, int id) {
     return &a->moves[id];
 }
 
+void af_match_moves(const af *a, const char *inputs, uint32_t mask[AF_MOVE_MASK_WORDS]) {
+    // Every node on the path walked by the inputs is a move string that prefixes the inputs.
+    int node = 0;
+    for(int i = 0;; i++) {
+        for(int w = 0; w < AF_MOVE_MASK_WORDS; w++) {
+            mask[w] |= a->move_nodes[node].moves[w];
+        }
+        if(inputs[i] == '\0') {
+            return;
+        }
+        node = a->move_nodes[node].child;
+        while(node != -1 && a->move_nodes[node].c != inputs[i]) {
+            node = a->move_nodes[node].sibling;
+        }
+        if(node == -1) {
+            return;
+        }
+    }
+}
+
+void af_category_moves(const af *a, int category, uint32_t mask[AF_MOVE_MASK_WORDS]) {
+    if(category < 0 || category >= AF_MOVE_CATEGORIES) {
+        return;
+    }
+    for(int w = 0; w < AF_MOVE_MASK_WORDS; w++) {
+        mask[w] |= a->category_moves[category][w];
+    }
+}
+
+int af_next_move(const uint32_t mask[AF_MOVE_MASK_WORDS], int from) {
+    for(int id = from; id < AF_MOVE_COUNT; id++) {
+        uint32_t word = mask[MASK_WORD(id)];
+        if(word == 0) {
+            // Skip the rest of an empty word
+            id |= 31;
+            continue;
+        }
+        if(word & MASK_BIT(id)) {
+            return id;
+        }
+    }
+    return -1;
+}
+
 void af_free(af *a) {
-    for(int i = 0; i < 70; i++) {
+    for(int i = 0; i < AF_MOVE_COUNT; i++) {
         if(a->moves[i].id != -1) {
             af_move_free(&a->moves[i]);
         }
     }
+    omf_free(a->move_nodes);
+    a->move_node_count = 0;
 }
@@ -1,12 +1,36 @@
 #include "resources/af_loader.h"
 #include "formats/af.h"
 #include "formats/error.h"
+#include "resources/asset_pack.h"
 #include "resources/pathmanager.h"
 
+static void fix_sprite_coords(animation *ani, int fix_x, int fix_y) {
+    iterator it;
+    sprite *s;
+    // Fix sprite positions
+    vector_iter_begin(&ani->sprites, &it);
+    while((s = iter_next(&it)) != NULL) {
+        s->pos.x += fix_x;
+        s->pos.y += fix_y;
+    }
+    // Fix collisions coordinates
+    collision_coord *c;
+    vector_iter_begin(&ani->collision_coords, &it);
+    while((c = iter_next(&it)) != NULL) {
+        c->pos.x += fix_x;
+        c->pos.y += fix_y;
+    }
+}
+
 int load_af_file(af *a, int id) {
-    // Get directory + filename
-    const char *filename = pm_get_resource_path(id);
+    // Asset packs hold the already converted data, with the sprite coordinates below fixed
+    if(asset_pack_load_af(a, id) == 0) {
+        return 0;
+    }
+    return load_af_path(a, pm_get_resource_path(id));
+}
 
+int load_af_path(af *a, const char *filename) {
     // Load up AF file from libSD
     sd_af_file tmp;
     if(sd_af_create(&tmp) != SD_SUCCESS) {
@@ -20,5 +44,8 @@ int load_af_file(af *a, int id) {
     // Convert
     af_create(a, &tmp);
     sd_af_free(&tmp);
+
+    // Fix some coordinates on jump sprites
+    fix_sprite_coords(&af_get_move(a, ANIM_JUMPING)->ani, 0, -50);
     return 0;
 }
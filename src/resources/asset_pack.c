@@ -0,0 +1,628 @@
+#include "resources/asset_pack.h"
+#include "formats/internal/memwriter.h"
+#include "formats/internal/writer.h"
+#include "resources/ids.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include "utils/vector.h"
+#include <stdio.h>
+#include <string.h>
+
+#define ASSET_PACK_MAGIC "OPAK"
+#define ASSET_PACK_HEADER_SIZE 12
+#define ASSET_PACK_INDEX_ENTRY_SIZE 12
+
+typedef struct asset_pack_entry_t {
+    uint32_t resource_id;
+    uint32_t offset; ///< Offset from the start of the pack file
+    uint32_t size;   ///< Size of the resource data; 0 if the resource is not in the pack
+} asset_pack_entry;
+
+typedef struct asset_pack_t {
+    char *filename;
+    asset_pack_entry entries[NUMBER_OF_RESOURCES];
+} asset_pack;
+
+struct asset_pack_writer_t {
+    char *filename;
+    memwriter *data;
+    vector entries;
+};
+
+// Bounds checked cursor over the data of a single resource. Once a read fails, every following read
+// fails too and returns zeroes, so the structures being loaded stay consistent and can be freed as usual.
+typedef struct pack_reader_t {
+    const char *buf;
+    long len;
+    long pos;
+    int failed;
+} pack_reader;
+
+static asset_pack *pack = NULL;
+
+// Reading --------------------------------------------------------------------------------------------
+
+static int can_read(pack_reader *r, long len) {
+    if(r->failed || len < 0 || r->pos + len > r->len) {
+        r->failed = 1;
+        return 0;
+    }
+    return 1;
+}
+
+static void read_buf(pack_reader *r, void *dst, long len) {
+    if(!can_read(r, len)) {
+        memset(dst, 0, len);
+        return;
+    }
+    memcpy(dst, r->buf + r->pos, len);
+    r->pos += len;
+}
+
+static uint8_t read_ubyte(pack_reader *r) {
+    uint8_t value;
+    read_buf(r, &value, sizeof(value));
+    return value;
+}
+
+static uint16_t read_uword(pack_reader *r) {
+    uint16_t value;
+    read_buf(r, &value, sizeof(value));
+    return value;
+}
+
+static uint32_t read_udword(pack_reader *r) {
+    uint32_t value;
+    read_buf(r, &value, sizeof(value));
+    return value;
+}
+
+static int32_t read_dword(pack_reader *r) {
+    int32_t value;
+    read_buf(r, &value, sizeof(value));
+    return value;
+}
+
+static float read_float(pack_reader *r) {
+    float value;
+    read_buf(r, &value, sizeof(value));
+    return value;
+}
+
+static void read_str(pack_reader *r, str *dst) {
+    uint16_t len = read_uword(r);
+    if(!can_read(r, len)) {
+        str_create(dst);
+        return;
+    }
+    str_from_buf(dst, r->buf + r->pos, len);
+    r->pos += len;
+}
+
+static void read_surface(pack_reader *r, surface *sur) {
+    int w = read_dword(r);
+    int h = read_dword(r);
+    int type = read_ubyte(r);
+    long pixels = (long)w * h;
+    long size = (type == SURFACE_TYPE_RGBA) ? pixels * 4 : pixels * 2;
+    if(w < 0 || h < 0 || (type != SURFACE_TYPE_RGBA && type != SURFACE_TYPE_PALETTE) || !can_read(r, size)) {
+        r->failed = 1;
+        memset(sur, 0, sizeof(surface));
+        return;
+    }
+    surface_create(sur, type, w, h);
+    if(type == SURFACE_TYPE_RGBA) {
+        read_buf(r, sur->data, pixels * 4);
+    } else {
+        read_buf(r, sur->data, pixels);
+        read_buf(r, sur->stencil, pixels);
+    }
+}
+
+static void read_animation(pack_reader *r, animation *ani) {
+    vector_create(&ani->collision_coords, sizeof(collision_coord));
+    vector_create(&ani->extra_strings, sizeof(str));
+    vector_create(&ani->sprites, sizeof(sprite));
+
+    ani->id = read_dword(r);
+    ani->start_pos.x = read_dword(r);
+    ani->start_pos.y = read_dword(r);
+    read_str(r, &ani->animation_string);
+
+    int coord_count = read_uword(r);
+    for(int i = 0; i < coord_count && !r->failed; i++) {
+        collision_coord coord;
+        coord.pos.x = read_dword(r);
+        coord.pos.y = read_dword(r);
+        coord.frame_index = read_dword(r);
+        vector_append(&ani->collision_coords, &coord);
+    }
+
+    ani->extra_string_count = read_ubyte(r);
+    for(int i = 0; i < ani->extra_string_count && !r->failed; i++) {
+        str extra;
+        read_str(r, &extra);
+        vector_append(&ani->extra_strings, &extra);
+    }
+
+    int sprite_count = read_uword(r);
+    for(int i = 0; i < sprite_count && !r->failed; i++) {
+        sprite sp;
+        sp.id = read_dword(r);
+        sp.pos.x = read_dword(r);
+        sp.pos.y = read_dword(r);
+        sp.data = omf_calloc(1, sizeof(surface));
+        read_surface(r, sp.data);
+        vector_append(&ani->sprites, &sp);
+    }
+}
+
+// Reads the data of a resource from the pack. The file is opened separately for each resource,
+// so that resources may be loaded from several threads at once.
+static int read_entry(int resource_id, pack_reader *r) {
+    if(pack == NULL || resource_id < 0 || resource_id >= NUMBER_OF_RESOURCES) {
+        return 1;
+    }
+    const asset_pack_entry *entry = &pack->entries[resource_id];
+    if(entry->size == 0) {
+        return 1;
+    }
+
+    FILE *handle = fopen(pack->filename, "rb");
+    if(handle == NULL) {
+        PERROR("Asset pack: unable to open %s", pack->filename);
+        return 1;
+    }
+    char *buf = omf_calloc(1, entry->size);
+    if(fseek(handle, entry->offset, SEEK_SET) != 0 || fread(buf, 1, entry->size, handle) != entry->size) {
+        PERROR("Asset pack: unable to read resource %d", resource_id);
+        omf_free(buf);
+        fclose(handle);
+        return 1;
+    }
+    fclose(handle);
+
+    memset(r, 0, sizeof(pack_reader));
+    r->buf = buf;
+    r->len = entry->size;
+    return 0;
+}
+
+// Releases the buffer of the reader, and checks that the whole resource was consumed.
+static int finish_entry(int resource_id, pack_reader *r) {
+    char *buf = (char *)r->buf;
+    omf_free(buf);
+    if(r->failed || r->pos != r->len) {
+        PERROR("Asset pack: resource %d is corrupted", resource_id);
+        return 1;
+    }
+    return 0;
+}
+
+int asset_pack_open(const char *filename) {
+    FILE *handle = fopen(filename, "rb");
+    if(handle == NULL) {
+        DEBUG("Asset pack %s not found, decoding resources from the game files.", filename);
+        return 1;
+    }
+
+    char header[ASSET_PACK_HEADER_SIZE];
+    char *index = NULL;
+    if(fread(header, 1, sizeof(header), handle) != sizeof(header)) {
+        PERROR("Asset pack %s could not be read.", filename);
+        goto error_0;
+    }
+    pack_reader r = {.buf = header, .len = sizeof(header)};
+    char magic[4];
+    read_buf(&r, magic, sizeof(magic));
+    uint32_t version = read_udword(&r);
+    uint32_t count = read_udword(&r);
+    if(memcmp(magic, ASSET_PACK_MAGIC, sizeof(magic)) != 0 || version != ASSET_PACK_VERSION ||
+       count > NUMBER_OF_RESOURCES) {
+        INFO("Asset pack %s is not compatible with this version, ignoring it.", filename);
+        goto error_0;
+    }
+
+    long index_size = count * ASSET_PACK_INDEX_ENTRY_SIZE;
+    index = omf_calloc(1, index_size + 1);
+    if(fread(index, 1, index_size, handle) != (size_t)index_size) {
+        PERROR("Asset pack %s could not be read.", filename);
+        goto error_1;
+    }
+
+    // The entries are checked against the file size here, so that a corrupt size can't make a load
+    // allocate more than there is to read
+    long file_size;
+    if(fseek(handle, 0, SEEK_END) != 0 || (file_size = ftell(handle)) < 0) {
+        PERROR("Asset pack %s could not be read.", filename);
+        goto error_1;
+    }
+    fclose(handle);
+    unsigned long pack_size = file_size;
+
+    asset_pack *new_pack = omf_calloc(1, sizeof(asset_pack));
+    r = (pack_reader){.buf = index, .len = index_size};
+    for(uint32_t i = 0; i < count; i++) {
+        asset_pack_entry entry;
+        entry.resource_id = read_udword(&r);
+        entry.offset = read_udword(&r);
+        entry.size = read_udword(&r);
+        if(entry.size > 0 && (entry.size > pack_size || entry.offset > pack_size - entry.size)) {
+            PERROR("Asset pack %s is corrupt, ignoring it.", filename);
+            omf_free(new_pack);
+            omf_free(index);
+            return 1;
+        }
+        if(entry.resource_id < NUMBER_OF_RESOURCES) {
+            new_pack->entries[entry.resource_id] = entry;
+        }
+    }
+    omf_free(index);
+
+    new_pack->filename = strdup(filename);
+    asset_pack_close();
+    pack = new_pack;
+    INFO("Loaded asset pack %s with %u resources.", filename, count);
+    return 0;
+
+error_1:
+    omf_free(index);
+error_0:
+    fclose(handle);
+    return 1;
+}
+
+void asset_pack_close() {
+    if(pack == NULL) {
+        return;
+    }
+    omf_free(pack->filename);
+    omf_free(pack);
+}
+
+int asset_pack_load_bk(bk *b, int resource_id) {
+    pack_reader r;
+    if(read_entry(resource_id, &r)) {
+        return 1;
+    }
+
+    vector_create(&b->palettes, sizeof(palette));
+    hashmap_create(&b->infos, 7);
+
+    b->file_id = read_dword(&r);
+    read_surface(&r, &b->background);
+    read_buf(&r, b->sound_translation_table, sizeof(b->sound_translation_table));
+
+    int palette_count = read_ubyte(&r);
+    for(int i = 0; i < palette_count && !r.failed; i++) {
+        palette pal;
+        read_buf(&r, &pal, sizeof(palette));
+        vector_append(&b->palettes, &pal);
+    }
+
+    int info_count = read_ubyte(&r);
+    for(int i = 0; i < info_count && !r.failed; i++) {
+        bk_info info;
+        info.chain_hit = read_udword(&r);
+        info.chain_no_hit = read_udword(&r);
+        info.load_on_start = read_udword(&r);
+        info.probability = read_udword(&r);
+        info.hazard_damage = read_udword(&r);
+        read_str(&r, &info.footer_string);
+        read_animation(&r, &info.ani);
+        hashmap_iput(&b->infos, info.ani.id, &info, sizeof(bk_info));
+    }
+
+    if(finish_entry(resource_id, &r)) {
+        bk_free(b);
+        return 1;
+    }
+    return 0;
+}
+
+// Move masks may only point at the moves that were loaded
+static int check_move_mask(const af *a, const uint32_t mask[AF_MOVE_MASK_WORDS]) {
+    for(int id = 0; id < AF_MOVE_MASK_WORDS * 32; id++) {
+        if((mask[id / 32] & (1U << (id % 32))) && (id >= AF_MOVE_COUNT || a->moves[id].id == -1)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// The move tables are used as they are, so they are checked before anybody walks them. Nodes are
+// always added after their parent and before their older siblings, which also rules out loops.
+static int check_move_tables(const af *a) {
+    if(a->move_node_count < 1) {
+        return 1;
+    }
+    for(int i = 0; i < a->move_node_count; i++) {
+        const af_move_node *node = &a->move_nodes[i];
+        if(node->child != -1 && (node->child <= i || node->child >= a->move_node_count)) {
+            return 1;
+        }
+        if(node->sibling != -1 && (node->sibling < 0 || node->sibling >= i)) {
+            return 1;
+        }
+        if(check_move_mask(a, node->moves)) {
+            return 1;
+        }
+    }
+    for(int c = 0; c < AF_MOVE_CATEGORIES; c++) {
+        if(check_move_mask(a, a->category_moves[c])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int asset_pack_load_af(af *a, int resource_id) {
+    pack_reader r;
+    if(read_entry(resource_id, &r)) {
+        return 1;
+    }
+
+    for(int i = 0; i < AF_MOVE_COUNT; i++) {
+        a->moves[i].id = -1;
+    }
+
+    a->id = read_udword(&r);
+    a->endurance = read_float(&r);
+    a->health = read_udword(&r);
+    a->forward_speed = read_float(&r);
+    a->reverse_speed = read_float(&r);
+    a->jump_speed = read_float(&r);
+    a->fall_speed = read_float(&r);
+    read_buf(&r, a->sound_translation_table, sizeof(a->sound_translation_table));
+
+    int move_count = read_ubyte(&r);
+    for(int i = 0; i < move_count && !r.failed; i++) {
+        int id = read_ubyte(&r);
+        if(id >= AF_MOVE_COUNT || a->moves[id].id != -1) {
+            r.failed = 1;
+            break;
+        }
+        af_move *move = &a->moves[id];
+        move->id = id;
+        move->pos_constraints = read_ubyte(&r);
+        move->next_move = read_ubyte(&r);
+        move->successor_id = read_ubyte(&r);
+        move->category = read_ubyte(&r);
+        move->points = read_uword(&r);
+        move->scrap_amount = read_ubyte(&r);
+        move->collision_opts = read_ubyte(&r);
+        move->damage = read_float(&r);
+        read_str(&r, &move->move_string);
+        read_str(&r, &move->footer_string);
+        read_animation(&r, &move->ani);
+    }
+
+    // Move lookup tables
+    a->move_node_count = read_uword(&r);
+    if(!can_read(&r, (long)a->move_node_count * (5 + AF_MOVE_MASK_WORDS * 4))) {
+        a->move_node_count = 0;
+    }
+    a->move_nodes = omf_calloc(a->move_node_count + 1, sizeof(af_move_node));
+    for(int i = 0; i < a->move_node_count; i++) {
+        af_move_node *node = &a->move_nodes[i];
+        node->c = read_ubyte(&r);
+        node->child = (int16_t)read_uword(&r);
+        node->sibling = (int16_t)read_uword(&r);
+        for(int w = 0; w < AF_MOVE_MASK_WORDS; w++) {
+            node->moves[w] = read_udword(&r);
+        }
+    }
+    for(int c = 0; c < AF_MOVE_CATEGORIES; c++) {
+        for(int w = 0; w < AF_MOVE_MASK_WORDS; w++) {
+            a->category_moves[c][w] = read_udword(&r);
+        }
+    }
+    if(!r.failed && check_move_tables(a)) {
+        r.failed = 1;
+    }
+
+    if(finish_entry(resource_id, &r)) {
+        af_free(a);
+        return 1;
+    }
+    return 0;
+}
+
+// Writing --------------------------------------------------------------------------------------------
+
+static void write_str(memwriter *w, const str *src) {
+    memwrite_uword(w, src->len);
+    memwrite_buf(w, str_c(src), src->len);
+}
+
+static void write_surface(memwriter *w, const surface *sur) {
+    if(sur == NULL) {
+        memwrite_dword(w, 0);
+        memwrite_dword(w, 0);
+        memwrite_ubyte(w, SURFACE_TYPE_PALETTE);
+        return;
+    }
+    memwrite_dword(w, sur->w);
+    memwrite_dword(w, sur->h);
+    memwrite_ubyte(w, sur->type);
+    if(sur->type == SURFACE_TYPE_RGBA) {
+        memwrite_buf(w, sur->data, sur->w * sur->h * 4);
+    } else {
+        memwrite_buf(w, sur->data, sur->w * sur->h);
+        memwrite_buf(w, sur->stencil, sur->w * sur->h);
+    }
+}
+
+static void write_animation(memwriter *w, const animation *ani) {
+    iterator it;
+    memwrite_dword(w, ani->id);
+    memwrite_dword(w, ani->start_pos.x);
+    memwrite_dword(w, ani->start_pos.y);
+    write_str(w, &ani->animation_string);
+
+    collision_coord *coord;
+    memwrite_uword(w, vector_size(&ani->collision_coords));
+    vector_iter_begin(&ani->collision_coords, &it);
+    while((coord = iter_next(&it)) != NULL) {
+        memwrite_dword(w, coord->pos.x);
+        memwrite_dword(w, coord->pos.y);
+        memwrite_dword(w, coord->frame_index);
+    }
+
+    str *extra;
+    memwrite_ubyte(w, vector_size(&ani->extra_strings));
+    vector_iter_begin(&ani->extra_strings, &it);
+    while((extra = iter_next(&it)) != NULL) {
+        write_str(w, extra);
+    }
+
+    sprite *sp;
+    memwrite_uword(w, vector_size(&ani->sprites));
+    vector_iter_begin(&ani->sprites, &it);
+    while((sp = iter_next(&it)) != NULL) {
+        memwrite_dword(w, sp->id);
+        memwrite_dword(w, sp->pos.x);
+        memwrite_dword(w, sp->pos.y);
+        write_surface(w, sp->data);
+    }
+}
+
+static void add_entry(asset_pack_writer *writer, int resource_id, long start) {
+    asset_pack_entry entry;
+    entry.resource_id = resource_id;
+    entry.offset = start;
+    entry.size = memwriter_pos(writer->data) - start;
+    vector_append(&writer->entries, &entry);
+}
+
+asset_pack_writer *asset_pack_writer_open(const char *filename) {
+    asset_pack_writer *writer = omf_calloc(1, sizeof(asset_pack_writer));
+    writer->filename = strdup(filename);
+    writer->data = memwriter_open();
+    vector_create(&writer->entries, sizeof(asset_pack_entry));
+    return writer;
+}
+
+void asset_pack_write_bk(asset_pack_writer *writer, int resource_id, const bk *b) {
+    memwriter *w = writer->data;
+    long start = memwriter_pos(w);
+
+    memwrite_dword(w, b->file_id);
+    write_surface(w, &b->background);
+    memwrite_buf(w, b->sound_translation_table, sizeof(b->sound_translation_table));
+
+    iterator it;
+    palette *pal;
+    memwrite_ubyte(w, vector_size(&b->palettes));
+    vector_iter_begin(&b->palettes, &it);
+    while((pal = iter_next(&it)) != NULL) {
+        memwrite_buf(w, (const char *)pal, sizeof(palette));
+    }
+
+    hashmap_pair *pair;
+    memwrite_ubyte(w, hashmap_reserved(&b->infos));
+    hashmap_iter_begin(&b->infos, &it);
+    while((pair = iter_next(&it)) != NULL) {
+        const bk_info *info = pair->val;
+        memwrite_udword(w, info->chain_hit);
+        memwrite_udword(w, info->chain_no_hit);
+        memwrite_udword(w, info->load_on_start);
+        memwrite_udword(w, info->probability);
+        memwrite_udword(w, info->hazard_damage);
+        write_str(w, &info->footer_string);
+        write_animation(w, &info->ani);
+    }
+
+    add_entry(writer, resource_id, start);
+}
+
+void asset_pack_write_af(asset_pack_writer *writer, int resource_id, const af *a) {
+    memwriter *w = writer->data;
+    long start = memwriter_pos(w);
+
+    memwrite_udword(w, a->id);
+    memwrite_float(w, a->endurance);
+    memwrite_udword(w, a->health);
+    memwrite_float(w, a->forward_speed);
+    memwrite_float(w, a->reverse_speed);
+    memwrite_float(w, a->jump_speed);
+    memwrite_float(w, a->fall_speed);
+    memwrite_buf(w, a->sound_translation_table, sizeof(a->sound_translation_table));
+
+    int move_count = 0;
+    for(int i = 0; i < AF_MOVE_COUNT; i++) {
+        if(a->moves[i].id != -1) {
+            move_count++;
+        }
+    }
+    memwrite_ubyte(w, move_count);
+    for(int i = 0; i < AF_MOVE_COUNT; i++) {
+        const af_move *move = &a->moves[i];
+        if(move->id == -1) {
+            continue;
+        }
+        memwrite_ubyte(w, i);
+        memwrite_ubyte(w, move->pos_constraints);
+        memwrite_ubyte(w, move->next_move);
+        memwrite_ubyte(w, move->successor_id);
+        memwrite_ubyte(w, move->category);
+        memwrite_uword(w, move->points);
+        memwrite_ubyte(w, move->scrap_amount);
+        memwrite_ubyte(w, move->collision_opts);
+        memwrite_float(w, move->damage);
+        write_str(w, &move->move_string);
+        write_str(w, &move->footer_string);
+        write_animation(w, &move->ani);
+    }
+
+    memwrite_uword(w, a->move_node_count);
+    for(int i = 0; i < a->move_node_count; i++) {
+        const af_move_node *node = &a->move_nodes[i];
+        memwrite_ubyte(w, node->c);
+        memwrite_uword(w, node->child);
+        memwrite_uword(w, node->sibling);
+        for(int k = 0; k < AF_MOVE_MASK_WORDS; k++) {
+            memwrite_udword(w, node->moves[k]);
+        }
+    }
+    for(int c = 0; c < AF_MOVE_CATEGORIES; c++) {
+        for(int k = 0; k < AF_MOVE_MASK_WORDS; k++) {
+            memwrite_udword(w, a->category_moves[c][k]);
+        }
+    }
+
+    add_entry(writer, resource_id, start);
+}
+
+int asset_pack_writer_close(asset_pack_writer *writer) {
+    int ret = 1;
+    sd_writer *w = sd_writer_open(writer->filename);
+    if(w == NULL) {
+        goto exit_0;
+    }
+
+    // Header and index. Resource offsets are relative to the end of the index until here.
+    long data_start = ASSET_PACK_HEADER_SIZE + vector_size(&writer->entries) * ASSET_PACK_INDEX_ENTRY_SIZE;
+    sd_write_buf(w, ASSET_PACK_MAGIC, 4);
+    sd_write_udword(w, ASSET_PACK_VERSION);
+    sd_write_udword(w, vector_size(&writer->entries));
+    iterator it;
+    asset_pack_entry *entry;
+    vector_iter_begin(&writer->entries, &it);
+    while((entry = iter_next(&it)) != NULL) {
+        sd_write_udword(w, entry->resource_id);
+        sd_write_udword(w, entry->offset + data_start);
+        sd_write_udword(w, entry->size);
+    }
+
+    memwriter_save(writer->data, w);
+    ret = sd_writer_errno(w) ? 1 : 0;
+    sd_writer_close(w);
+
+exit_0:
+    vector_free(&writer->entries);
+    memwriter_close(writer->data);
+    omf_free(writer->filename);
+    omf_free(writer);
+    return ret;
+}
@@ -1,12 +1,18 @@
 #include "resources/bk_loader.h"
 #include "formats/bk.h"
 #include "formats/error.h"
+#include "resources/asset_pack.h"
 #include "resources/pathmanager.h"
 
 int load_bk_file(bk *b, int id) {
-    // Get directory + filename
-    const char *filename = pm_get_resource_path(id);
+    // Asset packs hold the already converted data
+    if(asset_pack_load_bk(b, id) == 0) {
+        return 0;
+    }
+    return load_bk_path(b, pm_get_resource_path(id));
+}
 
+int load_bk_path(bk *b, const char *filename) {
     // Load up BK file from libSD
     sd_bk_file tmp;
     if(sd_bk_create(&tmp) != SD_SUCCESS) {
@@ -20,6 +20,7 @@ static const char *logfile_name = "openomf.log";
 static const char *configfile_name = "openomf.conf";
 static const char *scorefile_name = "SCORES.DAT";
 static const char *savegamedir_name = "save/";
+static const char *assetpack_name = "openomf.pak";
 static char errormessage[128];
 
 // Lists
@@ -136,6 +137,9 @@ int pm_init() {
         local_path_build(PLUGIN_PATH, plugin_env, ext);
     }
 
+    // Optional pack of baked resources lives next to the game files
+    local_path_build(ASSET_PACK_PATH, pm_get_local_path(RESOURCE_PATH), assetpack_name);
+
     // Set resource paths
     for(int i = 0; i < NUMBER_OF_RESOURCES; i++) {
         resource_path_build(i, pm_get_local_path(RESOURCE_PATH), get_resource_file(i));
@@ -262,6 +266,8 @@ const char *pm_get_local_path_type_name(unsigned int path_id) {
             return "SCORE_PATH";
         case SAVE_PATH:
             return "SAVE_PATH";
+        case ASSET_PACK_PATH:
+            return "ASSET_PACK_PATH";
     }
     return "UNKNOWN";
 }
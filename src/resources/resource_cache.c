@@ -0,0 +1,514 @@
+#include "resources/resource_cache.h"
+#include "resources/af_loader.h"
+#include "resources/bk_loader.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include "utils/vector.h"
+#include <SDL.h>
+#include <string.h>
+
+// Maximum number of prefetch requests that may be waiting for, or held by the loader thread
+#define PREFETCH_MAX_JOBS 8
+
+enum
+{
+    RESOURCE_TYPE_BK,
+    RESOURCE_TYPE_AF
+};
+
+typedef struct resource_entry_t {
+    int type;
+    int resource_id;
+    void *data; ///< NULL while a user of the cache is still decoding the resource
+    unsigned int refs;
+    unsigned int last_used;
+    size_t bytes;
+} resource_entry;
+
+enum
+{
+    PREFETCH_FREE = 0,
+    PREFETCH_QUEUED,
+    PREFETCH_LOADING,
+    PREFETCH_DONE
+};
+
+typedef struct prefetch_job_t {
+    int state;
+    int type;
+    int resource_id;
+    unsigned int seq; ///< Jobs are picked up in the order they were queued
+    void *data;       ///< Decoded resource, or NULL if loading failed
+    size_t bytes;
+} prefetch_job;
+
+typedef struct resource_cache_t {
+    // Game states ticking on separate threads share the cache, so the entries and the stats
+    // are only touched with entries_lock held. Resources are decoded without the lock; the
+    // entry is added up front, and others asking for it wait for entry_loaded.
+    SDL_mutex *entries_lock;
+    SDL_cond *entry_loaded;
+    vector entries;
+    size_t budget;
+    unsigned int clock;
+    resource_cache_stats stats;
+
+    // Loader thread. Only the jobs table is shared with it; the entries are never touched
+    // by it. Finished jobs are adopted into the cache by the users of the cache.
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *job_queued;
+    SDL_cond *job_done;
+    prefetch_job jobs[PREFETCH_MAX_JOBS];
+    unsigned int seq;
+    int quit;
+} resource_cache;
+
+static resource_cache *cache = NULL;
+
+static size_t surface_bytes(const surface *sur) {
+    if(sur == NULL) {
+        return 0;
+    }
+    return sur->w * sur->h * ((sur->type == SURFACE_TYPE_RGBA) ? 4 : 2);
+}
+
+static size_t animation_bytes(animation *ani) {
+    size_t bytes = sizeof(animation);
+    iterator it;
+    sprite *s;
+    vector_iter_begin(&ani->sprites, &it);
+    while((s = iter_next(&it)) != NULL) {
+        bytes += sizeof(sprite) + surface_bytes(s->data);
+    }
+    return bytes;
+}
+
+static size_t bk_bytes(bk *b) {
+    size_t bytes = sizeof(bk) + surface_bytes(&b->background) + vector_size(&b->palettes) * sizeof(palette);
+    iterator it;
+    hashmap_pair *pair;
+    hashmap_iter_begin(&b->infos, &it);
+    while((pair = iter_next(&it)) != NULL) {
+        bytes += animation_bytes(&((bk_info *)pair->val)->ani);
+    }
+    return bytes;
+}
+
+static size_t af_bytes(af *a) {
+    size_t bytes = sizeof(af) + a->move_node_count * sizeof(af_move_node);
+    for(int i = 0; i < AF_MOVE_COUNT; i++) {
+        af_move *move = af_get_move(a, i);
+        if(move != NULL) {
+            bytes += animation_bytes(&move->ani);
+        }
+    }
+    return bytes;
+}
+
+static void free_data(int type, void *data) {
+    if(type == RESOURCE_TYPE_BK) {
+        bk_free(data);
+    } else {
+        af_free(data);
+    }
+    omf_free(data);
+}
+
+// Drops least recently used resources that are not in use, until we are within the budget.
+static void evict() {
+    while(cache->stats.bytes > cache->budget) {
+        iterator it;
+        resource_entry *entry;
+        resource_entry *oldest = NULL;
+        vector_iter_begin(&cache->entries, &it);
+        while((entry = iter_next(&it)) != NULL) {
+            if(entry->refs == 0 && entry->data != NULL && (oldest == NULL || entry->last_used < oldest->last_used)) {
+                oldest = entry;
+            }
+        }
+        if(oldest == NULL) {
+            return;
+        }
+
+        vector_iter_begin(&cache->entries, &it);
+        while((entry = iter_next(&it)) != NULL) {
+            if(entry == oldest) {
+                DEBUG("Resource cache: evicting resource %d (%zu bytes)", entry->resource_id, entry->bytes);
+                cache->stats.bytes -= entry->bytes;
+                cache->stats.evictions++;
+                free_data(entry->type, entry->data);
+                vector_delete(&cache->entries, &it);
+                break;
+            }
+        }
+    }
+}
+
+// Decodes a resource from disk. This is called from both the main and the loader thread,
+// so it must not touch the cache itself.
+static void *load(int type, int resource_id, size_t *bytes) {
+    if(type == RESOURCE_TYPE_BK) {
+        bk *b = omf_calloc(1, sizeof(bk));
+        if(load_bk_file(b, resource_id)) {
+            omf_free(b);
+            return NULL;
+        }
+        *bytes = bk_bytes(b);
+        return b;
+    }
+    af *a = omf_calloc(1, sizeof(af));
+    if(load_af_file(a, resource_id)) {
+        omf_free(a);
+        return NULL;
+    }
+    *bytes = af_bytes(a);
+    return a;
+}
+
+static resource_entry *find_entry(int type, int resource_id) {
+    iterator it;
+    resource_entry *entry;
+    vector_iter_begin(&cache->entries, &it);
+    while((entry = iter_next(&it)) != NULL) {
+        if(entry->type == type && entry->resource_id == resource_id) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void add_entry(int type, int resource_id, void *data, size_t bytes, unsigned int refs) {
+    resource_entry new_entry;
+    new_entry.type = type;
+    new_entry.resource_id = resource_id;
+    new_entry.data = data;
+    new_entry.refs = refs;
+    new_entry.last_used = ++cache->clock;
+    new_entry.bytes = bytes;
+    vector_append(&cache->entries, &new_entry);
+    cache->stats.bytes += bytes;
+}
+
+static int prefetch_thread(void *userdata) {
+    SDL_LockMutex(cache->lock);
+    while(!cache->quit) {
+        prefetch_job *job = NULL;
+        for(int i = 0; i < PREFETCH_MAX_JOBS; i++) {
+            prefetch_job *j = &cache->jobs[i];
+            if(j->state == PREFETCH_QUEUED && (job == NULL || j->seq < job->seq)) {
+                job = j;
+            }
+        }
+        if(job == NULL) {
+            SDL_CondWait(cache->job_queued, cache->lock);
+            continue;
+        }
+        job->state = PREFETCH_LOADING;
+        SDL_UnlockMutex(cache->lock);
+
+        size_t bytes = 0;
+        void *data = load(job->type, job->resource_id, &bytes);
+
+        SDL_LockMutex(cache->lock);
+        job->data = data;
+        job->bytes = bytes;
+        job->state = PREFETCH_DONE;
+        SDL_CondBroadcast(cache->job_done);
+    }
+    SDL_UnlockMutex(cache->lock);
+    return 0;
+}
+
+// Moves resources that the loader thread has finished into the cache. They stay unreferenced
+// until somebody asks for them, so they may be evicted like any other unused resource.
+static void adopt_prefetched() {
+    if(cache->thread == NULL) {
+        return;
+    }
+    SDL_LockMutex(cache->lock);
+    for(int i = 0; i < PREFETCH_MAX_JOBS; i++) {
+        prefetch_job *job = &cache->jobs[i];
+        if(job->state != PREFETCH_DONE) {
+            continue;
+        }
+        if(job->data == NULL) {
+            PERROR("Resource cache: unable to prefetch resource %d!", job->resource_id);
+        } else if(find_entry(job->type, job->resource_id) != NULL) {
+            // Somebody asked for it in the meanwhile and decoded it themselves
+            free_data(job->type, job->data);
+        } else {
+            DEBUG("Resource cache: prefetched resource %d (%zu bytes)", job->resource_id, job->bytes);
+            add_entry(job->type, job->resource_id, job->data, job->bytes, 0);
+            cache->stats.prefetches++;
+        }
+        job->state = PREFETCH_FREE;
+        job->data = NULL;
+    }
+    SDL_UnlockMutex(cache->lock);
+    evict();
+}
+
+// Makes sure that the loader thread is not working on the given resource. A job that has not
+// been started yet is cancelled, because loading it right away is faster than waiting for the
+// jobs queued before it. A job that is already being loaded is waited for.
+static void wait_prefetched(int type, int resource_id) {
+    if(cache->thread == NULL) {
+        return;
+    }
+    SDL_LockMutex(cache->lock);
+    for(int i = 0; i < PREFETCH_MAX_JOBS; i++) {
+        prefetch_job *job = &cache->jobs[i];
+        if(job->state == PREFETCH_FREE || job->type != type || job->resource_id != resource_id) {
+            continue;
+        }
+        if(job->state == PREFETCH_QUEUED) {
+            job->state = PREFETCH_FREE;
+        }
+        while(job->state == PREFETCH_LOADING) {
+            SDL_CondWait(cache->job_done, cache->lock);
+        }
+    }
+    SDL_UnlockMutex(cache->lock);
+}
+
+static void prefetch(int type, int resource_id) {
+    adopt_prefetched();
+
+    // Already decoded, just make sure it does not get evicted before it is used
+    resource_entry *entry = find_entry(type, resource_id);
+    if(entry != NULL) {
+        entry->last_used = ++cache->clock;
+        return;
+    }
+
+    if(cache->thread == NULL) {
+        cache->thread = SDL_CreateThread(prefetch_thread, "resource loader", NULL);
+        if(cache->thread == NULL) {
+            PERROR("Resource cache: unable to start the loader thread: %s", SDL_GetError());
+            return;
+        }
+    }
+
+    SDL_LockMutex(cache->lock);
+    prefetch_job *free_job = NULL;
+    for(int i = 0; i < PREFETCH_MAX_JOBS; i++) {
+        prefetch_job *job = &cache->jobs[i];
+        if(job->state == PREFETCH_FREE) {
+            if(free_job == NULL) {
+                free_job = job;
+            }
+        } else if(job->type == type && job->resource_id == resource_id) {
+            SDL_UnlockMutex(cache->lock);
+            return;
+        }
+    }
+    if(free_job != NULL) {
+        free_job->state = PREFETCH_QUEUED;
+        free_job->type = type;
+        free_job->resource_id = resource_id;
+        free_job->seq = cache->seq++;
+        SDL_CondSignal(cache->job_queued);
+    } else {
+        DEBUG("Resource cache: prefetch queue is full, skipping resource %d", resource_id);
+    }
+    SDL_UnlockMutex(cache->lock);
+}
+
+static void delete_entry(resource_entry *target) {
+    iterator it;
+    resource_entry *entry;
+    vector_iter_begin(&cache->entries, &it);
+    while((entry = iter_next(&it)) != NULL) {
+        if(entry == target) {
+            vector_delete(&cache->entries, &it);
+            return;
+        }
+    }
+}
+
+// Called with entries_lock held, which is let go while the resource is decoded.
+static void *get(int type, int resource_id) {
+    adopt_prefetched();
+
+    resource_entry *entry = find_entry(type, resource_id);
+    if(entry != NULL) {
+        entry->refs++;
+        entry->last_used = ++cache->clock;
+        cache->stats.hits++;
+
+        // Somebody else is decoding it. The entry may move while we wait, so look it up again.
+        while(entry != NULL && entry->data == NULL) {
+            SDL_CondWait(cache->entry_loaded, cache->entries_lock);
+            entry = find_entry(type, resource_id);
+        }
+        return (entry != NULL) ? entry->data : NULL;
+    }
+
+    add_entry(type, resource_id, NULL, 0, 1);
+    cache->stats.misses++;
+    SDL_UnlockMutex(cache->entries_lock);
+    size_t bytes = 0;
+    void *data = load(type, resource_id, &bytes);
+    SDL_LockMutex(cache->entries_lock);
+
+    // The entry can not have been evicted while it was being decoded, since it is in use
+    entry = find_entry(type, resource_id);
+    if(data == NULL) {
+        delete_entry(entry);
+    } else {
+        entry->data = data;
+        entry->bytes = bytes;
+        cache->stats.bytes += bytes;
+    }
+    SDL_CondBroadcast(cache->entry_loaded);
+    evict();
+    return data;
+}
+
+static void release(void *data) {
+    iterator it;
+    resource_entry *entry;
+    vector_iter_begin(&cache->entries, &it);
+    while((entry = iter_next(&it)) != NULL) {
+        if(entry->data == data) {
+            if(entry->refs > 0) {
+                entry->refs--;
+            }
+            evict();
+            return;
+        }
+    }
+    PERROR("Resource cache: released an unknown resource!");
+}
+
+void resource_cache_init(size_t budget) {
+    cache = omf_calloc(1, sizeof(resource_cache));
+    vector_create(&cache->entries, sizeof(resource_entry));
+    cache->budget = budget;
+    cache->entries_lock = SDL_CreateMutex();
+    cache->entry_loaded = SDL_CreateCond();
+    cache->lock = SDL_CreateMutex();
+    cache->job_queued = SDL_CreateCond();
+    cache->job_done = SDL_CreateCond();
+    DEBUG("Resource cache initialized with a budget of %zu bytes.", budget);
+}
+
+void resource_cache_close() {
+    if(cache == NULL) {
+        return;
+    }
+    DEBUG("Resource cache:");
+    DEBUG(" * Hits:      %u", cache->stats.hits);
+    DEBUG(" * Misses:    %u", cache->stats.misses);
+    DEBUG(" * Evictions: %u", cache->stats.evictions);
+    DEBUG(" * Prefetch:  %u", cache->stats.prefetches);
+    DEBUG(" * Bytes:     %zu", cache->stats.bytes);
+
+    // Stop the loader thread. A resource that it is still working on is finished and freed below.
+    if(cache->thread != NULL) {
+        SDL_LockMutex(cache->lock);
+        cache->quit = 1;
+        SDL_CondSignal(cache->job_queued);
+        SDL_UnlockMutex(cache->lock);
+        SDL_WaitThread(cache->thread, NULL);
+    }
+    for(int i = 0; i < PREFETCH_MAX_JOBS; i++) {
+        if(cache->jobs[i].state == PREFETCH_DONE && cache->jobs[i].data != NULL) {
+            free_data(cache->jobs[i].type, cache->jobs[i].data);
+        }
+    }
+    SDL_DestroyCond(cache->job_done);
+    SDL_DestroyCond(cache->job_queued);
+    SDL_DestroyMutex(cache->lock);
+    SDL_DestroyCond(cache->entry_loaded);
+    SDL_DestroyMutex(cache->entries_lock);
+
+    iterator it;
+    resource_entry *entry;
+    vector_iter_begin(&cache->entries, &it);
+    while((entry = iter_next(&it)) != NULL) {
+        if(entry->refs > 0) {
+            DEBUG("Resource cache: resource %d still has %u users", entry->resource_id, entry->refs);
+        }
+        if(entry->data != NULL) {
+            free_data(entry->type, entry->data);
+        }
+    }
+    vector_free(&cache->entries);
+    omf_free(cache);
+}
+
+// The cache is created on first use if nobody did it before. When game states run on several
+// threads, resource_cache_init() must be called before they are started.
+static void init_once() {
+    if(cache == NULL) {
+        resource_cache_init(RESOURCE_CACHE_BUDGET);
+    }
+}
+
+static void lock_entries() {
+    init_once();
+    SDL_LockMutex(cache->entries_lock);
+}
+
+static void *get_locked(int type, int resource_id) {
+    // The loader thread may be busy with the same resource. Waiting for it does not need the entries.
+    init_once();
+    wait_prefetched(type, resource_id);
+
+    lock_entries();
+    void *data = get(type, resource_id);
+    SDL_UnlockMutex(cache->entries_lock);
+    return data;
+}
+
+static void prefetch_locked(int type, int resource_id) {
+    lock_entries();
+    prefetch(type, resource_id);
+    SDL_UnlockMutex(cache->entries_lock);
+}
+
+static void release_locked(void *data) {
+    if(data == NULL || cache == NULL) {
+        return;
+    }
+    SDL_LockMutex(cache->entries_lock);
+    release(data);
+    SDL_UnlockMutex(cache->entries_lock);
+}
+
+bk *resource_cache_get_bk(int resource_id) {
+    return get_locked(RESOURCE_TYPE_BK, resource_id);
+}
+
+af *resource_cache_get_af(int resource_id) {
+    return get_locked(RESOURCE_TYPE_AF, resource_id);
+}
+
+void resource_cache_prefetch_bk(int resource_id) {
+    prefetch_locked(RESOURCE_TYPE_BK, resource_id);
+}
+
+void resource_cache_prefetch_af(int resource_id) {
+    prefetch_locked(RESOURCE_TYPE_AF, resource_id);
+}
+
+void resource_cache_release_bk(bk *b) {
+    release_locked(b);
+}
+
+void resource_cache_release_af(af *a) {
+    release_locked(a);
+}
+
+void resource_cache_get_stats(resource_cache_stats *stats) {
+    if(cache == NULL) {
+        memset(stats, 0, sizeof(resource_cache_stats));
+        return;
+    }
+    SDL_LockMutex(cache->entries_lock);
+    *stats = cache->stats;
+    stats->entries = vector_size(&cache->entries);
+    SDL_UnlockMutex(cache->entries_lock);
+}
@@ -0,0 +1,170 @@
+#include "utils/delta.h"
+#include <stdint.h>
+#include <string.h>
+
+#define BLOCK_SIZE 8
+
+// Bits per block: the changed bit, the byte mask, and every byte of the block
+#define BLOCK_MAX_BITS (1 + BLOCK_SIZE + BLOCK_SIZE * 8)
+
+// Longest run or literal stretch of the run-length compressor
+#define RUN_MAX 128
+
+typedef struct bitstream_t {
+    uint8_t *data;
+    size_t len; // in bytes
+    size_t pos; // in bits
+} bitstream;
+
+static void put_bits(bitstream *bs, unsigned int value, int count) {
+    for(int i = count - 1; i >= 0; i--) {
+        if(bs->pos % 8 == 0) {
+            bs->data[bs->pos / 8] = 0;
+        }
+        if((value >> i) & 1) {
+            bs->data[bs->pos / 8] |= 0x80 >> (bs->pos % 8);
+        }
+        bs->pos++;
+    }
+}
+
+// Returns the bits read, or -1 if the stream ends before them
+static int get_bits(bitstream *bs, int count) {
+    if(bs->pos + count > bs->len * 8) {
+        return -1;
+    }
+    int value = 0;
+    for(int i = 0; i < count; i++) {
+        value = (value << 1) | ((bs->data[bs->pos / 8] >> (7 - bs->pos % 8)) & 1);
+        bs->pos++;
+    }
+    return value;
+}
+
+static uint8_t base_at(const char *base, size_t base_len, size_t pos) {
+    return (pos < base_len) ? (uint8_t)base[pos] : 0;
+}
+
+size_t delta_encode_bound(size_t len) {
+    size_t blocks = (len + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    return (blocks * BLOCK_MAX_BITS + 7) / 8;
+}
+
+size_t delta_encode(const char *base, size_t base_len, const char *data, size_t len, char *out) {
+    bitstream bs = {(uint8_t *)out, 0, 0};
+    for(size_t start = 0; start < len; start += BLOCK_SIZE) {
+        uint8_t diff[BLOCK_SIZE];
+        unsigned int mask = 0;
+        for(size_t i = 0; i < BLOCK_SIZE && start + i < len; i++) {
+            diff[i] = (uint8_t)data[start + i] ^ base_at(base, base_len, start + i);
+            if(diff[i]) {
+                mask |= 0x80 >> i;
+            }
+        }
+        put_bits(&bs, mask != 0, 1);
+        if(mask == 0) {
+            continue;
+        }
+        put_bits(&bs, mask, BLOCK_SIZE);
+        for(int i = 0; i < BLOCK_SIZE; i++) {
+            if(mask & (0x80 >> i)) {
+                put_bits(&bs, diff[i], 8);
+            }
+        }
+    }
+    return (bs.pos + 7) / 8;
+}
+
+int delta_decode(const char *base, size_t base_len, const char *in, size_t in_len, char *out, size_t len) {
+    bitstream bs = {(uint8_t *)in, in_len, 0};
+    for(size_t start = 0; start < len; start += BLOCK_SIZE) {
+        size_t block_len = (len - start < BLOCK_SIZE) ? len - start : BLOCK_SIZE;
+        for(size_t i = 0; i < block_len; i++) {
+            out[start + i] = base_at(base, base_len, start + i);
+        }
+        int changed = get_bits(&bs, 1);
+        if(changed < 0) {
+            return 1;
+        }
+        if(!changed) {
+            continue;
+        }
+        int mask = get_bits(&bs, BLOCK_SIZE);
+        if(mask <= 0 || (mask & (0xFF >> block_len))) {
+            return 1;
+        }
+        for(size_t i = 0; i < block_len; i++) {
+            if(mask & (0x80 >> i)) {
+                int diff = get_bits(&bs, 8);
+                if(diff < 0) {
+                    return 1;
+                }
+                out[start + i] ^= diff;
+            }
+        }
+    }
+    return 0;
+}
+
+size_t delta_compress_bound(size_t len) {
+    return len + (len + RUN_MAX - 1) / RUN_MAX;
+}
+
+// PackBits: a header byte of 0 to 127 is followed by 1 to 128 literal bytes, and a header of -1
+// to -127 by a single byte that is repeated 2 to 128 times.
+size_t delta_compress(const char *in, size_t len, char *out) {
+    size_t rpos = 0;
+    size_t wpos = 0;
+    while(rpos < len) {
+        size_t run = 1;
+        while(rpos + run < len && run < RUN_MAX && in[rpos + run] == in[rpos]) {
+            run++;
+        }
+        if(run > 1) {
+            out[wpos++] = (char)(1 - (int)run);
+            out[wpos++] = in[rpos];
+            rpos += run;
+            continue;
+        }
+
+        // Gather literals up to the next run of at least 3 bytes, which are worth a header
+        size_t lit = 1;
+        while(rpos + lit < len && lit < RUN_MAX) {
+            if(rpos + lit + 2 < len && in[rpos + lit] == in[rpos + lit + 1] &&
+               in[rpos + lit] == in[rpos + lit + 2]) {
+                break;
+            }
+            lit++;
+        }
+        out[wpos++] = (char)(lit - 1);
+        memcpy(out + wpos, in + rpos, lit);
+        wpos += lit;
+        rpos += lit;
+    }
+    return wpos;
+}
+
+size_t delta_decompress(const char *in, size_t in_len, char *out, size_t out_len) {
+    size_t rpos = 0;
+    size_t wpos = 0;
+    while(rpos < in_len) {
+        int header = (int8_t)in[rpos++];
+        if(header >= 0) {
+            size_t lit = header + 1;
+            if(rpos + lit > in_len || wpos + lit > out_len) {
+                return 0;
+            }
+            memcpy(out + wpos, in + rpos, lit);
+            rpos += lit;
+            wpos += lit;
+        } else if(header != -128) {
+            size_t run = 1 - header;
+            if(rpos >= in_len || wpos + run > out_len) {
+                return 0;
+            }
+            memset(out + wpos, in[rpos++], run);
+            wpos += run;
+        }
+    }
+    return wpos;
+}
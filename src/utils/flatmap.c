@@ -0,0 +1,260 @@
+#include "utils/flatmap.h"
+#include "utils/allocator.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN_CAPACITY 16
+
+// An entry with hash 0 is empty; real hashes are never 0. Keys and values are kept 8 byte aligned,
+// so that they may hold structs with pointers in them.
+#define KEY_OFFSET 8
+#define ENTRY(map, index) ((map)->data + (size_t)(index) * (map)->entry_size)
+#define ENTRY_HASH(entry) (*(uint32_t *)(entry))
+#define ENTRY_KEY(entry) ((entry) + KEY_OFFSET)
+#define ENTRY_VAL(map, entry) ((entry) + (map)->val_offset)
+
+// Distance of the entry at index from the slot its hash points to
+#define PROBE_DISTANCE(map, index, hash) (((index) - ((hash) & ((map)->capacity - 1))) & ((map)->capacity - 1))
+
+static unsigned int align8(unsigned int size) {
+    return (size + 7) & ~7u;
+}
+
+// Keys are short and fixed size, so they are hashed a word at a time, and the result is then
+// mixed with the murmur3 finalizer.
+static uint32_t hash_key(const void *key, unsigned int len) {
+    const unsigned char *p = key;
+    uint32_t h = len;
+    uint32_t w;
+    while(len >= sizeof(uint32_t)) {
+        memcpy(&w, p, sizeof(uint32_t));
+        h = (h ^ w) * 0x9E3779B1u;
+        h = (h << 13) | (h >> 19);
+        p += sizeof(uint32_t);
+        len -= sizeof(uint32_t);
+    }
+    while(len > 0) {
+        h = (h ^ *p++) * 0x01000193u;
+        len--;
+    }
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return (h != 0) ? h : 1;
+}
+
+static void alloc_table(flatmap *map, unsigned int capacity) {
+    map->capacity = capacity;
+    map->count = 0;
+    map->data = omf_calloc(capacity, map->entry_size);
+}
+
+// Places an entry that is known not to be in the map yet. Entries that are closer to their
+// home slot than the entry being placed give up their slot, and are placed further on instead.
+// Returns the slot where the given entry ended up.
+static char *place_entry(flatmap *map, char *entry) {
+    char *carry = map->scratch;
+    char *tmp = map->scratch + map->entry_size;
+    char *result = NULL;
+    unsigned int mask = map->capacity - 1;
+    uint32_t hash = ENTRY_HASH(entry);
+    unsigned int index = hash & mask;
+    unsigned int dist = 0;
+
+    memcpy(carry, entry, map->entry_size);
+    while(1) {
+        char *slot = ENTRY(map, index);
+        uint32_t slot_hash = ENTRY_HASH(slot);
+        if(slot_hash == 0) {
+            memcpy(slot, carry, map->entry_size);
+            map->count++;
+            return (result != NULL) ? result : slot;
+        }
+        unsigned int slot_dist = PROBE_DISTANCE(map, index, slot_hash);
+        if(slot_dist < dist) {
+            memcpy(tmp, slot, map->entry_size);
+            memcpy(slot, carry, map->entry_size);
+            memcpy(carry, tmp, map->entry_size);
+            if(result == NULL) {
+                result = slot;
+            }
+            dist = slot_dist;
+        }
+        index = (index + 1) & mask;
+        dist++;
+    }
+}
+
+static void grow(flatmap *map) {
+    char *old = map->data;
+    unsigned int old_capacity = map->capacity;
+    alloc_table(map, old_capacity * 2);
+    for(unsigned int i = 0; i < old_capacity; i++) {
+        char *entry = old + (size_t)i * map->entry_size;
+        if(ENTRY_HASH(entry) != 0) {
+            place_entry(map, entry);
+        }
+    }
+    omf_free(old);
+}
+
+static char *find_entry(const flatmap *map, const void *key, uint32_t hash) {
+    unsigned int mask = map->capacity - 1;
+    unsigned int index = hash & mask;
+    unsigned int dist = 0;
+    while(1) {
+        char *slot = ENTRY(map, index);
+        uint32_t slot_hash = ENTRY_HASH(slot);
+
+        // With robin hood probing, the key would have been placed before any entry that is
+        // closer to its own home slot.
+        if(slot_hash == 0 || PROBE_DISTANCE(map, index, slot_hash) < dist) {
+            return NULL;
+        }
+        if(slot_hash == hash && memcmp(ENTRY_KEY(slot), key, map->key_size) == 0) {
+            return slot;
+        }
+        index = (index + 1) & mask;
+        dist++;
+    }
+}
+
+// Removes the entry, and shifts the entries after it back by one until an entry that is
+// in its home slot (or an empty slot) is found.
+static void remove_entry(flatmap *map, char *entry) {
+    unsigned int mask = map->capacity - 1;
+    unsigned int index = (entry - map->data) / map->entry_size;
+    while(1) {
+        unsigned int next = (index + 1) & mask;
+        char *next_entry = ENTRY(map, next);
+        uint32_t next_hash = ENTRY_HASH(next_entry);
+        if(next_hash == 0 || PROBE_DISTANCE(map, next, next_hash) == 0) {
+            break;
+        }
+        memcpy(ENTRY(map, index), next_entry, map->entry_size);
+        index = next;
+    }
+    ENTRY_HASH(ENTRY(map, index)) = 0;
+    map->count--;
+}
+
+void flatmap_create(flatmap *map, unsigned int key_size, unsigned int val_size) {
+    map->key_size = key_size;
+    map->val_size = val_size;
+    map->val_offset = align8(KEY_OFFSET + key_size);
+    map->entry_size = align8(map->val_offset + val_size);
+    map->scratch = omf_calloc(2, map->entry_size);
+    alloc_table(map, MIN_CAPACITY);
+}
+
+void flatmap_free(flatmap *map) {
+    omf_free(map->data);
+    omf_free(map->scratch);
+    map->capacity = 0;
+    map->count = 0;
+}
+
+void flatmap_clear(flatmap *map) {
+    memset(map->data, 0, (size_t)map->capacity * map->entry_size);
+    map->count = 0;
+}
+
+unsigned int flatmap_size(const flatmap *map) {
+    return map->count;
+}
+
+unsigned int flatmap_capacity(const flatmap *map) {
+    return map->capacity;
+}
+
+void *flatmap_put(flatmap *map, const void *key, const void *val) {
+    uint32_t hash = hash_key(key, map->key_size);
+    char *entry = find_entry(map, key, hash);
+    if(entry != NULL) {
+        memcpy(ENTRY_VAL(map, entry), val, map->val_size);
+        return ENTRY_VAL(map, entry);
+    }
+
+    // Keep the load factor under 3/4, so that probe sequences stay short
+    if((map->count + 1) * 4 > map->capacity * 3) {
+        grow(map);
+    }
+
+    // Build the entry in the second scratch half; place_entry() carries it in the first one.
+    char *new_entry = map->scratch + map->entry_size;
+    memset(new_entry, 0, map->entry_size);
+    ENTRY_HASH(new_entry) = hash;
+    memcpy(ENTRY_KEY(new_entry), key, map->key_size);
+    memcpy(ENTRY_VAL(map, new_entry), val, map->val_size);
+    entry = place_entry(map, new_entry);
+    return ENTRY_VAL(map, entry);
+}
+
+void *flatmap_get(const flatmap *map, const void *key) {
+    char *entry = find_entry(map, key, hash_key(key, map->key_size));
+    if(entry == NULL) {
+        return NULL;
+    }
+    return ENTRY_VAL(map, entry);
+}
+
+int flatmap_del(flatmap *map, const void *key) {
+    char *entry = find_entry(map, key, hash_key(key, map->key_size));
+    if(entry == NULL) {
+        return 1;
+    }
+    remove_entry(map, entry);
+    return 0;
+}
+
+// Iteration runs downwards from an empty slot, and ends when it gets back to it. Deleting an
+// entry only shifts entries from above it, up to the next empty slot at most, so the entries
+// that move have already been visited and none are skipped or visited twice.
+static void *flatmap_iter_next(iterator *iter) {
+    const flatmap *map = iter->data;
+    unsigned int mask = map->capacity - 1;
+    unsigned int start = iter->inow;
+    unsigned int index = (iter->vnow == NULL) ? start : ((char *)iter->vnow - map->data) / map->entry_size;
+    while(1) {
+        index = (index - 1) & mask;
+        if(index == start) {
+            iter->ended = 1;
+            return NULL;
+        }
+        char *entry = ENTRY(map, index);
+        if(ENTRY_HASH(entry) != 0) {
+            iter->vnow = entry;
+            return ENTRY_VAL(map, entry);
+        }
+    }
+}
+
+void flatmap_iter_begin(const flatmap *map, iterator *iter) {
+    iter->data = map;
+    iter->vnow = NULL;
+    iter->inow = 0;
+    iter->next = flatmap_iter_next;
+    iter->prev = NULL;
+    iter->ended = (map->count == 0);
+    while(ENTRY_HASH(ENTRY(map, iter->inow)) != 0) {
+        iter->inow++;
+    }
+}
+
+const void *flatmap_iter_key(const flatmap *map, const iterator *iter) {
+    if(iter->vnow == NULL) {
+        return NULL;
+    }
+    return ENTRY_KEY((char *)iter->vnow);
+}
+
+// Removes the entry last returned by the iterator
+int flatmap_delete(flatmap *map, iterator *iter) {
+    if(iter->vnow == NULL || ENTRY_HASH((char *)iter->vnow) == 0) {
+        return 1;
+    }
+    remove_entry(map, iter->vnow);
+    return 0;
+}
@@ -3,7 +3,7 @@
 #include <stdio.h>
 
 FILE *handle = 0;
-unsigned int _log_tick = 0;
+LOG_THREAD_LOCAL unsigned int _log_tick = 0;
 
 int log_init(const char *filename) {
     if(handle)
@@ -32,15 +32,23 @@ void log_hide(char mode, const char *fn, const char *fmt, ...) {
 void log_print(char mode, const char *fn, const char *fmt, ...) {
     if(handle == 0)
         return;
+
+    // Format the whole line first, so that lines logged from several threads at once
+    // don't get mixed up.
+    char line[1024];
+    int len;
     if(fn != NULL) {
-        fprintf(handle, "[%7u][%c] %s(): ", _log_tick, mode, fn);
+        len = snprintf(line, sizeof(line), "[%7u][%c] %s(): ", _log_tick, mode, fn);
     } else {
-        fprintf(handle, "[%7u][%c] ", _log_tick, mode);
+        len = snprintf(line, sizeof(line), "[%7u][%c] ", _log_tick, mode);
+    }
+    if(len < 0 || len >= (int)sizeof(line)) {
+        len = 0;
     }
     va_list args;
     va_start(args, fmt);
-    vfprintf(handle, fmt, args);
+    vsnprintf(line + len, sizeof(line) - len, fmt, args);
     va_end(args);
-    fprintf(handle, "\n");
+    fprintf(handle, "%s\n", line);
     fflush(handle);
 }
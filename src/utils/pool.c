@@ -0,0 +1,136 @@
+#include "utils/pool.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include <stdint.h>
+#include <string.h>
+
+// Items are kept aligned for any type that might be stored in them
+#define POOL_ALIGN 16
+#define POOL_POISON 0xDD
+
+// Released items are linked together through their first bytes
+typedef struct pool_link_t {
+    struct pool_link_t *next;
+} pool_link;
+
+#ifdef DEBUGMODE
+static void poison(pool *p, void *item) {
+    memset((char *)item + sizeof(pool_link), POOL_POISON, p->item_size - sizeof(pool_link));
+}
+
+static int is_poisoned(pool *p, void *item) {
+    const unsigned char *data = (const unsigned char *)item + sizeof(pool_link);
+    for(unsigned int i = 0; i < p->item_size - sizeof(pool_link); i++) {
+        if(data[i] != POOL_POISON) {
+            return 0;
+        }
+    }
+    return 1;
+}
+#endif
+
+static void push_free(pool *p, void *item) {
+    pool_link *link = item;
+    link->next = p->free_list;
+    p->free_list = link;
+}
+
+static void add_slab(pool *p) {
+    char *slab = omf_calloc(p->slab_items, p->item_size);
+    vector_append(&p->slabs, &slab);
+    p->stats.slabs++;
+
+    // Push in reverse, so that items are handed out in address order
+    for(int i = p->slab_items - 1; i >= 0; i--) {
+        void *item = slab + (size_t)i * p->item_size;
+#ifdef DEBUGMODE
+        poison(p, item);
+#endif
+        push_free(p, item);
+    }
+}
+
+void pool_create(pool *p, unsigned int item_size, unsigned int slab_items) {
+    if(item_size < sizeof(pool_link)) {
+        item_size = sizeof(pool_link);
+    }
+    p->item_size = (item_size + POOL_ALIGN - 1) / POOL_ALIGN * POOL_ALIGN;
+    p->slab_items = (slab_items > 0) ? slab_items : 1;
+    p->free_list = NULL;
+    memset(&p->stats, 0, sizeof(pool_stats));
+    vector_create(&p->slabs, sizeof(char *));
+}
+
+void pool_free(pool *p) {
+    if(p->stats.in_use > 0) {
+        DEBUG("Pool: %u items of %u bytes still in use when freed", p->stats.in_use, p->item_size);
+    }
+    iterator it;
+    char **slab;
+    vector_iter_begin(&p->slabs, &it);
+    while((slab = iter_next(&it)) != NULL) {
+        omf_free(*slab);
+    }
+    vector_free(&p->slabs);
+    p->free_list = NULL;
+}
+
+void *pool_alloc(pool *p) {
+    if(p->free_list == NULL) {
+        add_slab(p);
+    }
+    pool_link *item = p->free_list;
+    p->free_list = item->next;
+#ifdef DEBUGMODE
+    if(!is_poisoned(p, item)) {
+        PERROR("Pool: item %p was written to after it was released!", (void *)item);
+    }
+#endif
+    memset(item, 0, p->item_size);
+
+    p->stats.allocs++;
+    p->stats.in_use++;
+    if(p->stats.in_use > p->stats.peak) {
+        p->stats.peak = p->stats.in_use;
+    }
+    return item;
+}
+
+void pool_release(pool *p, void *ptr) {
+    if(ptr == NULL) {
+        return;
+    }
+#ifdef DEBUGMODE
+    if(!pool_owns(p, ptr)) {
+        PERROR("Pool: released item %p does not belong to the pool!", ptr);
+        return;
+    }
+    if(is_poisoned(p, ptr)) {
+        PERROR("Pool: item %p is probably released twice!", ptr);
+        return;
+    }
+    poison(p, ptr);
+#endif
+    push_free(p, ptr);
+    p->stats.releases++;
+    p->stats.in_use--;
+}
+
+int pool_owns(const pool *p, const void *ptr) {
+    uintptr_t addr = (uintptr_t)ptr;
+    size_t slab_size = (size_t)p->slab_items * p->item_size;
+    iterator it;
+    char **slab;
+    vector_iter_begin(&p->slabs, &it);
+    while((slab = iter_next(&it)) != NULL) {
+        uintptr_t start = (uintptr_t)*slab;
+        if(addr >= start && addr < start + slab_size) {
+            return (addr - start) % p->item_size == 0;
+        }
+    }
+    return 0;
+}
+
+void pool_get_stats(const pool *p, pool_stats *stats) {
+    *stats = p->stats;
+}
@@ -0,0 +1,214 @@
+#include "utils/slotmap.h"
+#include "utils/allocator.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Handles are made of the slot index in the low bits, and the slot generation in the high bits.
+// Generations start from 1, so a valid handle is never SLOT_HANDLE_NONE.
+#define INDEX_BITS 16
+#define MAX_SLOTS (1u << INDEX_BITS)
+#define NO_SLOT 0xFFFFFFFFu
+
+#define MAKE_HANDLE(index, generation) (((slot_handle)(generation) << INDEX_BITS) | (index))
+#define HANDLE_INDEX(handle) ((handle) & (MAX_SLOTS - 1))
+#define HANDLE_GENERATION(handle) ((handle) >> INDEX_BITS)
+
+struct slotmap_slot_t {
+    uint16_t generation; ///< Generation of the slot; bumped every time the item is removed
+    uint8_t in_use;      ///< 1 if the slot holds an item
+    unsigned int pos;    ///< Item position if the slot is in use, next free slot otherwise
+};
+
+void slotmap_create(slotmap *map, unsigned int item_size) {
+    map->item_size = item_size;
+    map->count = 0;
+    map->reserved = 32;
+    map->removed = 0;
+    map->items = omf_calloc(map->reserved, item_size);
+    map->owners = omf_calloc(map->reserved, sizeof(unsigned int));
+    map->slot_count = 0;
+    map->slot_reserved = 32;
+    map->slots = omf_calloc(map->slot_reserved, sizeof(slotmap_slot));
+    map->free_slot = NO_SLOT;
+}
+
+void slotmap_free(slotmap *map) {
+    omf_free(map->items);
+    omf_free(map->owners);
+    omf_free(map->slots);
+    map->count = 0;
+    map->reserved = 0;
+    map->removed = 0;
+    map->slot_count = 0;
+    map->slot_reserved = 0;
+    map->free_slot = NO_SLOT;
+}
+
+void slotmap_clear(slotmap *map) {
+    for(unsigned int i = 0; i < map->count; i++) {
+        if(map->owners[i] != NO_SLOT) {
+            slotmap_remove(map, MAKE_HANDLE(map->owners[i], map->slots[map->owners[i]].generation));
+        }
+    }
+    slotmap_compact(map);
+}
+
+static unsigned int take_slot(slotmap *map) {
+    if(map->free_slot != NO_SLOT) {
+        unsigned int index = map->free_slot;
+        map->free_slot = map->slots[index].pos;
+        return index;
+    }
+    if(map->slot_count >= MAX_SLOTS) {
+        return NO_SLOT;
+    }
+    if(map->slot_count >= map->slot_reserved) {
+        map->slot_reserved *= 2;
+        map->slots = omf_realloc(map->slots, map->slot_reserved * sizeof(slotmap_slot));
+    }
+    map->slots[map->slot_count].generation = 1;
+    return map->slot_count++;
+}
+
+slot_handle slotmap_insert(slotmap *map, const void *item) {
+    unsigned int index = take_slot(map);
+    if(index == NO_SLOT) {
+        return SLOT_HANDLE_NONE;
+    }
+    if(map->count >= map->reserved) {
+        map->reserved *= 2;
+        map->items = omf_realloc(map->items, (size_t)map->reserved * map->item_size);
+        map->owners = omf_realloc(map->owners, map->reserved * sizeof(unsigned int));
+    }
+    memcpy(map->items + (size_t)map->count * map->item_size, item, map->item_size);
+    map->owners[map->count] = index;
+
+    slotmap_slot *slot = &map->slots[index];
+    slot->in_use = 1;
+    slot->pos = map->count++;
+    return MAKE_HANDLE(index, slot->generation);
+}
+
+static slotmap_slot *find_slot(const slotmap *map, slot_handle handle) {
+    unsigned int index = HANDLE_INDEX(handle);
+    if(index >= map->slot_count) {
+        return NULL;
+    }
+    slotmap_slot *slot = &map->slots[index];
+    if(!slot->in_use || slot->generation != HANDLE_GENERATION(handle)) {
+        return NULL;
+    }
+    return slot;
+}
+
+void *slotmap_get(const slotmap *map, slot_handle handle) {
+    slotmap_slot *slot = find_slot(map, handle);
+    if(slot == NULL) {
+        return NULL;
+    }
+    return map->items + (size_t)slot->pos * map->item_size;
+}
+
+int slotmap_remove(slotmap *map, slot_handle handle) {
+    slotmap_slot *slot = find_slot(map, handle);
+    if(slot == NULL) {
+        return 1;
+    }
+    unsigned int index = HANDLE_INDEX(handle);
+    map->owners[slot->pos] = NO_SLOT;
+    map->removed++;
+
+    // Skip generation 0, so that handles are never SLOT_HANDLE_NONE
+    slot->generation++;
+    if(slot->generation == 0) {
+        slot->generation = 1;
+    }
+    slot->in_use = 0;
+    slot->pos = map->free_slot;
+    map->free_slot = index;
+    return 0;
+}
+
+void slotmap_compact(slotmap *map) {
+    if(map->removed == 0) {
+        return;
+    }
+    unsigned int dst = 0;
+    for(unsigned int src = 0; src < map->count; src++) {
+        unsigned int index = map->owners[src];
+        if(index == NO_SLOT) {
+            continue;
+        }
+        if(dst != src) {
+            memcpy(map->items + (size_t)dst * map->item_size, map->items + (size_t)src * map->item_size,
+                   map->item_size);
+            map->owners[dst] = index;
+            map->slots[index].pos = dst;
+        }
+        dst++;
+    }
+    map->count = dst;
+    map->removed = 0;
+}
+
+unsigned int slotmap_size(const slotmap *map) {
+    return map->count - map->removed;
+}
+
+unsigned int slotmap_span(const slotmap *map) {
+    return map->count;
+}
+
+void *slotmap_get_at(const slotmap *map, unsigned int pos) {
+    if(pos >= map->count || map->owners[pos] == NO_SLOT) {
+        return NULL;
+    }
+    return map->items + (size_t)pos * map->item_size;
+}
+
+// Finds the next item that has not been removed, starting from pos
+static unsigned int next_live(const slotmap *map, unsigned int pos) {
+    while(pos < map->count && map->owners[pos] == NO_SLOT) {
+        pos++;
+    }
+    return pos;
+}
+
+// inow holds the position of the last visited item. The iterator is ended right away when there
+// is nothing after it, so items inserted while visiting the last one are not visited.
+static void *slotmap_iter_next(iterator *iter) {
+    const slotmap *map = iter->data;
+    unsigned int pos = next_live(map, iter->inow + 1);
+    if(pos >= map->count) {
+        iter->ended = 1;
+        return NULL;
+    }
+    iter->inow = pos;
+    iter->vnow = map->items + (size_t)pos * map->item_size;
+    if(next_live(map, pos + 1) >= map->count) {
+        iter->ended = 1;
+    }
+    return iter->vnow;
+}
+
+void slotmap_iter_begin(const slotmap *map, iterator *iter) {
+    iter->data = map;
+    iter->vnow = NULL;
+    iter->inow = -1;
+    iter->next = slotmap_iter_next;
+    iter->prev = NULL;
+    iter->ended = (slotmap_size(map) == 0);
+}
+
+slot_handle slotmap_iter_handle(const slotmap *map, const iterator *iter) {
+    if(iter->inow < 0 || (unsigned int)iter->inow >= map->count || map->owners[iter->inow] == NO_SLOT) {
+        return SLOT_HANDLE_NONE;
+    }
+    unsigned int index = map->owners[iter->inow];
+    return MAKE_HANDLE(index, map->slots[index].generation);
+}
+
+// Removes the item last visited by the iterator
+int slotmap_delete(slotmap *map, iterator *iter) {
+    return slotmap_remove(map, slotmap_iter_handle(map, iter));
+}
@@ -0,0 +1,235 @@
+#include "video/draw_list.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include <string.h>
+
+// Render geometry appeared in SDL 2.0.18; older versions fall back to copying quads one by one.
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#define HAVE_RENDER_GEOMETRY
+#endif
+
+typedef struct draw_quad_t {
+    SDL_Rect src;
+    SDL_Rect dst;
+    SDL_RendererFlip flip;
+    SDL_Color color;
+} draw_quad;
+
+typedef struct draw_batch_t {
+    SDL_Texture *target;
+    SDL_Texture *tex;
+    SDL_BlendMode blend_mode;
+    int first;
+    int count;
+} draw_batch;
+
+typedef struct draw_list_t {
+    SDL_Renderer *renderer;
+
+    draw_quad *quads;
+    int quad_count;
+    int quad_capacity;
+
+    draw_batch *batches;
+    int batch_count;
+    int batch_capacity;
+
+#ifdef HAVE_RENDER_GEOMETRY
+    SDL_Vertex *vertices;
+    int *indices;
+    int vertex_capacity; // In quads
+#endif
+
+    draw_list_stats frame;
+    draw_list_stats last_frame;
+} draw_list;
+
+static draw_list *list = NULL;
+
+void draw_list_init(SDL_Renderer *renderer) {
+    list = omf_calloc(1, sizeof(draw_list));
+    list->renderer = renderer;
+    DEBUG("Draw list initialized.");
+}
+
+void draw_list_reinit(SDL_Renderer *renderer) {
+    draw_list_discard();
+    list->renderer = renderer;
+}
+
+void draw_list_close() {
+    if(list == NULL) {
+        return;
+    }
+    omf_free(list->quads);
+    omf_free(list->batches);
+#ifdef HAVE_RENDER_GEOMETRY
+    omf_free(list->vertices);
+    omf_free(list->indices);
+#endif
+    omf_free(list);
+}
+
+void draw_list_add(SDL_Texture *target, SDL_Texture *tex, SDL_BlendMode blend_mode, const SDL_Rect *src,
+                   const SDL_Rect *dst, SDL_RendererFlip flip, SDL_Color color) {
+    if(list->quad_count >= list->quad_capacity) {
+        list->quad_capacity = (list->quad_capacity == 0) ? 256 : list->quad_capacity * 2;
+        list->quads = omf_realloc(list->quads, list->quad_capacity * sizeof(draw_quad));
+    }
+    draw_quad *quad = &list->quads[list->quad_count];
+    quad->src = *src;
+    quad->dst = *dst;
+    quad->flip = flip;
+    quad->color = color;
+
+    // Only consecutive quads are merged, so that the painter's order stays intact.
+    draw_batch *batch = (list->batch_count > 0) ? &list->batches[list->batch_count - 1] : NULL;
+    if(batch == NULL || batch->target != target || batch->tex != tex || batch->blend_mode != blend_mode) {
+        if(list->batch_count >= list->batch_capacity) {
+            list->batch_capacity = (list->batch_capacity == 0) ? 64 : list->batch_capacity * 2;
+            list->batches = omf_realloc(list->batches, list->batch_capacity * sizeof(draw_batch));
+        }
+        batch = &list->batches[list->batch_count++];
+        batch->target = target;
+        batch->tex = tex;
+        batch->blend_mode = blend_mode;
+        batch->first = list->quad_count;
+        batch->count = 0;
+    }
+    batch->count++;
+    list->quad_count++;
+    list->frame.draws++;
+}
+
+#ifdef HAVE_RENDER_GEOMETRY
+static void draw_list_reserve_vertices(int quads) {
+    if(quads <= list->vertex_capacity) {
+        return;
+    }
+    int old = list->vertex_capacity;
+    list->vertex_capacity = quads;
+    list->vertices = omf_realloc(list->vertices, quads * 4 * sizeof(SDL_Vertex));
+    list->indices = omf_realloc(list->indices, quads * 6 * sizeof(int));
+
+    // Index pattern is the same for every batch, since batches are submitted from the start of the vertex buffer
+    for(int q = old; q < quads; q++) {
+        int *idx = &list->indices[q * 6];
+        idx[0] = q * 4 + 0;
+        idx[1] = q * 4 + 1;
+        idx[2] = q * 4 + 2;
+        idx[3] = q * 4 + 2;
+        idx[4] = q * 4 + 1;
+        idx[5] = q * 4 + 3;
+    }
+}
+
+static void draw_list_submit(const draw_batch *batch) {
+    int tex_w, tex_h;
+    SDL_QueryTexture(batch->tex, NULL, NULL, &tex_w, &tex_h);
+
+    draw_list_reserve_vertices(batch->count);
+    for(int i = 0; i < batch->count; i++) {
+        const draw_quad *quad = &list->quads[batch->first + i];
+        SDL_Vertex *v = &list->vertices[i * 4];
+
+        float u0 = (float)quad->src.x / tex_w;
+        float v0 = (float)quad->src.y / tex_h;
+        float u1 = (float)(quad->src.x + quad->src.w) / tex_w;
+        float v1 = (float)(quad->src.y + quad->src.h) / tex_h;
+        if(quad->flip & SDL_FLIP_HORIZONTAL) {
+            float tmp = u0;
+            u0 = u1;
+            u1 = tmp;
+        }
+        if(quad->flip & SDL_FLIP_VERTICAL) {
+            float tmp = v0;
+            v0 = v1;
+            v1 = tmp;
+        }
+
+        float x0 = quad->dst.x;
+        float y0 = quad->dst.y;
+        float x1 = quad->dst.x + quad->dst.w;
+        float y1 = quad->dst.y + quad->dst.h;
+
+        // Top left, top right, bottom left, bottom right
+        v[0].position.x = x0;
+        v[0].position.y = y0;
+        v[0].tex_coord.x = u0;
+        v[0].tex_coord.y = v0;
+        v[1].position.x = x1;
+        v[1].position.y = y0;
+        v[1].tex_coord.x = u1;
+        v[1].tex_coord.y = v0;
+        v[2].position.x = x0;
+        v[2].position.y = y1;
+        v[2].tex_coord.x = u0;
+        v[2].tex_coord.y = v1;
+        v[3].position.x = x1;
+        v[3].position.y = y1;
+        v[3].tex_coord.x = u1;
+        v[3].tex_coord.y = v1;
+        for(int k = 0; k < 4; k++) {
+            v[k].color = quad->color;
+        }
+    }
+    SDL_RenderGeometry(list->renderer, batch->tex, list->vertices, batch->count * 4, list->indices, batch->count * 6);
+    list->frame.submissions++;
+}
+#else
+static void draw_list_submit(const draw_batch *batch) {
+    for(int i = 0; i < batch->count; i++) {
+        const draw_quad *quad = &list->quads[batch->first + i];
+        SDL_SetTextureColorMod(batch->tex, quad->color.r, quad->color.g, quad->color.b);
+        SDL_SetTextureAlphaMod(batch->tex, quad->color.a);
+        SDL_RenderCopyEx(list->renderer, batch->tex, &quad->src, &quad->dst, 0, NULL, quad->flip);
+        list->frame.submissions++;
+    }
+}
+#endif
+
+void draw_list_flush() {
+    if(list == NULL || list->batch_count == 0) {
+        return;
+    }
+
+    SDL_Texture *target = NULL;
+    for(int i = 0; i < list->batch_count; i++) {
+        const draw_batch *batch = &list->batches[i];
+        if(i == 0 || batch->target != target) {
+            SDL_SetRenderTarget(list->renderer, batch->target);
+            target = batch->target;
+        }
+        // Tinting and opacity are carried by the vertex colors
+        SDL_SetTextureColorMod(batch->tex, 0xFF, 0xFF, 0xFF);
+        SDL_SetTextureAlphaMod(batch->tex, 0xFF);
+        SDL_SetTextureBlendMode(batch->tex, batch->blend_mode);
+        draw_list_submit(batch);
+    }
+    list->frame.flushes++;
+    draw_list_discard();
+}
+
+void draw_list_discard() {
+    if(list == NULL) {
+        return;
+    }
+    list->quad_count = 0;
+    list->batch_count = 0;
+}
+
+void draw_list_end_frame() {
+    if(list == NULL) {
+        return;
+    }
+    list->last_frame = list->frame;
+    memset(&list->frame, 0, sizeof(draw_list_stats));
+}
+
+void draw_list_get_stats(draw_list_stats *stats) {
+    if(list == NULL) {
+        memset(stats, 0, sizeof(draw_list_stats));
+        return;
+    }
+    *stats = list->last_frame;
+}
@@ -4,6 +4,17 @@
 #include <string.h>
 #include <utils/log.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SURFACE_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SURFACE_USE_NEON
+#endif
+
+// Surfaces are created on the resource loader thread too
+static SDL_atomic_t next_guid;
+
 void surface_create(surface *sur, int type, int w, int h) {
     if(type == SURFACE_TYPE_RGBA) {
         sur->data = omf_calloc(1, w * h * 4);
@@ -16,6 +27,7 @@ void surface_create(surface *sur, int type, int w, int h) {
     sur->h = h;
     sur->type = type;
     sur->force_refresh = 0;
+    sur->guid = SDL_AtomicAdd(&next_guid, 1) + 1;
 }
 
 void surface_force_refresh(surface *sur) {
@@ -241,7 +253,8 @@ void surface_convert_to_rgba(surface *sur, screen_palette *pal, int pal_offset)
 }
 
 // Creates a new RGBA surface
-void surface_to_rgba(surface *sur, char *dst, screen_palette *pal, char *remap_table, uint8_t pal_offset) {
+// Straightforward per-pixel conversion. Kept as the reference for the LUT path.
+void surface_to_rgba_scalar(surface *sur, char *dst, screen_palette *pal, char *remap_table, uint8_t pal_offset) {
 
     if(sur->type == SURFACE_TYPE_RGBA) {
         memcpy(dst, sur->data, sur->w * sur->h * 4);
@@ -270,6 +283,115 @@ void surface_to_rgba(surface *sur, char *dst, screen_palette *pal, char *remap_t
     }
 }
 
+// Pre-resolved lookup tables from palette index to RGB, with remapping and palette offset already applied.
+// The screen palette is rewritten in place without always bumping the version, so cached tables
+// are validated against the palette and remap contents before use.
+#define RGBA_LUT_CACHE_SIZE 4
+
+// Headless game states convert surfaces on their own threads, so every thread keeps its own tables
+#if defined(_MSC_VER)
+#define RGBA_LUT_THREAD_LOCAL __declspec(thread)
+#else
+#define RGBA_LUT_THREAD_LOCAL _Thread_local
+#endif
+
+typedef struct rgba_lut_t {
+    const screen_palette *pal;
+    const char *remap_table;
+    uint8_t pal_offset;
+    uint8_t pal_data[256][3];
+    char remap_data[256];
+    uint32_t lut[256];
+} rgba_lut;
+
+static RGBA_LUT_THREAD_LOCAL rgba_lut lut_cache[RGBA_LUT_CACHE_SIZE];
+static RGBA_LUT_THREAD_LOCAL int lut_cache_next = 0;
+
+static int rgba_lut_matches(const rgba_lut *l, const screen_palette *pal, const char *remap_table, uint8_t pal_offset) {
+    if(l->pal != pal || l->remap_table != remap_table || l->pal_offset != pal_offset) {
+        return 0;
+    }
+    if(memcmp(l->pal_data, pal->data, sizeof(l->pal_data)) != 0) {
+        return 0;
+    }
+    if(remap_table != NULL && memcmp(l->remap_data, remap_table, sizeof(l->remap_data)) != 0) {
+        return 0;
+    }
+    return 1;
+}
+
+static const uint32_t *surface_rgba_lut(const screen_palette *pal, const char *remap_table, uint8_t pal_offset) {
+    for(int i = 0; i < RGBA_LUT_CACHE_SIZE; i++) {
+        if(rgba_lut_matches(&lut_cache[i], pal, remap_table, pal_offset)) {
+            return lut_cache[i].lut;
+        }
+    }
+
+    rgba_lut *l = &lut_cache[lut_cache_next];
+    lut_cache_next = (lut_cache_next + 1) % RGBA_LUT_CACHE_SIZE;
+    l->pal = pal;
+    l->remap_table = remap_table;
+    l->pal_offset = pal_offset;
+    memcpy(l->pal_data, pal->data, sizeof(l->pal_data));
+    if(remap_table != NULL) {
+        memcpy(l->remap_data, remap_table, sizeof(l->remap_data));
+    }
+    for(int i = 0; i < 256; i++) {
+        uint8_t idx = (remap_table != NULL) ? (uint8_t)remap_table[i] : (uint8_t)i;
+        // See surface_to_rgba_scalar for the reasoning
+        if(idx < 48) {
+            idx += pal_offset;
+        }
+        uint8_t px[4] = {pal->data[idx][0], pal->data[idx][1], pal->data[idx][2], 0};
+        memcpy(&l->lut[i], px, 4);
+    }
+    return l->lut;
+}
+
+// Converts n pixels; the stencil is folded into the alpha channel, which is zero in the table.
+static void rgba_lut_convert(const uint32_t *lut, const uint8_t *src, const uint8_t *stencil, uint8_t *dst, int n) {
+    int i = 0;
+#if defined(SURFACE_USE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    for(; i + 16 <= n; i += 16) {
+        __m128i mask = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(stencil + i)), one);
+        __m128i mask_lo = _mm_unpacklo_epi8(zero, mask);
+        __m128i mask_hi = _mm_unpackhi_epi8(zero, mask);
+        __m128i alpha[4] = {_mm_unpacklo_epi16(zero, mask_lo), _mm_unpackhi_epi16(zero, mask_lo),
+                            _mm_unpacklo_epi16(zero, mask_hi), _mm_unpackhi_epi16(zero, mask_hi)};
+        for(int k = 0; k < 4; k++) {
+            const uint8_t *p = src + i + k * 4;
+            __m128i rgb = _mm_set_epi32(lut[p[3]], lut[p[2]], lut[p[1]], lut[p[0]]);
+            _mm_storeu_si128((__m128i *)(dst + (i + k * 4) * 4), _mm_or_si128(rgb, alpha[k]));
+        }
+    }
+#elif defined(SURFACE_USE_NEON)
+    uint32_t tmp[16];
+    for(; i + 16 <= n; i += 16) {
+        for(int k = 0; k < 16; k++) {
+            tmp[k] = lut[src[i + k]];
+        }
+        uint8x16x4_t px = vld4q_u8((const uint8_t *)tmp);
+        px.val[3] = vceqq_u8(vld1q_u8(stencil + i), vdupq_n_u8(1));
+        vst4q_u8(dst + i * 4, px);
+    }
+#endif
+    for(; i < n; i++) {
+        memcpy(dst + i * 4, &lut[src[i]], 4);
+        dst[i * 4 + 3] = (stencil[i] == 1) ? 0xFF : 0;
+    }
+}
+
+void surface_to_rgba(surface *sur, char *dst, screen_palette *pal, char *remap_table, uint8_t pal_offset) {
+    if(sur->type == SURFACE_TYPE_RGBA) {
+        memcpy(dst, sur->data, sur->w * sur->h * 4);
+        return;
+    }
+    const uint32_t *lut = surface_rgba_lut(pal, remap_table, pal_offset);
+    rgba_lut_convert(lut, (const uint8_t *)sur->data, (const uint8_t *)sur->stencil, (uint8_t *)dst, sur->w * sur->h);
+}
+
 // Copies surface to an existing texture.
 // Note, texture has to be streaming type
 int surface_to_texture(surface *src, SDL_Texture *tex, screen_palette *pal, char *remap_table, uint8_t pal_offset) {
@@ -1,29 +1,94 @@
 #include "video/tcache.h"
 #include "utils/allocator.h"
-#include "utils/hashmap.h"
+#include "utils/flatmap.h"
 #include "utils/log.h"
+#include "utils/vector.h"
+#include "video/draw_list.h"
 #include <stdlib.h>
 
-#define CACHE_LIFETIME 300
+// Textures are kept until the texture memory used by the cache goes over the budget. The least
+// recently used textures are then evicted, until the cache is down to 3/4 of the budget. Sweeps
+// are rate limited, so that a working set that does not fit the budget does not cause one every frame.
+// Atlas pages count against the budget as a whole, and are only ever evicted as a whole.
+#define DEFAULT_BUDGET (64 * 1024 * 1024)
+#define SWEEP_INTERVAL 60
 
+// Sprites are packed into a few large atlas pages, so that they share textures and can be
+// addressed by a sub-rect. Surfaces that are too large for the atlas (eg. upscaled backgrounds) still
+// get a texture of their own. Once all pages are full, the page that has gone unused the longest
+// is emptied and packed again.
+#define ATLAS_PAGE_SIZE 2048
+#define ATLAS_MAX_PAGES 8
+#define ATLAS_MAX_SHELVES 128
+#define ATLAS_PADDING 1
+
+// Palettes whose per-color change history is tracked (screen and additive palettes, mostly)
+#define TRACKED_PALETTES 4
+#define COLOR_MASK_WORDS (256 / 32)
+
+// Surfaces are identified by their guid as well as the pointer, so that a surface allocated at the
+// address of an old one never hits the textures of the old one.
 typedef struct tcache_entry_key_t {
     surface *c_surface;
     char *c_remap_table;
+    uint32_t c_guid;
     uint16_t w, h;
     uint8_t c_pal_offset;
 } tcache_entry_key;
 
 typedef struct tcache_entry_value_t {
     SDL_Texture *tex;
-    unsigned int age;
-    unsigned int pal_version;
+    SDL_Rect rect;                     ///< Area of the texture holding the surface
+    int page;                          ///< Atlas page index, or -1 if the entry owns its texture
+    unsigned int last_used;            ///< Frame the texture was last requested on
+    unsigned int bytes;                ///< Texture memory held by the entry, if it is not on a page
+    const screen_palette *pal;         ///< Palette the texture was converted with
+    unsigned int pal_version;          ///< Version of the palette at the time of the last check
+    unsigned int pal_epoch;            ///< Palette epoch at the time of the conversion
+    uint32_t colors[COLOR_MASK_WORDS]; ///< Palette indexes used by the texture
 } tcache_entry_value;
 
+// Palette versions are bumped whenever anything in the palette may have changed. Keep a copy of
+// each palette, and record when each color actually changed, so that textures only get converted
+// again if one of the colors they use is different.
+typedef struct tcache_palette_t {
+    const screen_palette *pal;
+    unsigned int version;
+    unsigned int last_used;
+    uint8_t data[256][3];
+    unsigned int changed[256]; ///< Epoch of the last change of each color
+} tcache_palette;
+
+typedef struct tcache_shelf_t {
+    uint16_t x, y, h;
+} tcache_shelf;
+
+typedef struct tcache_page_t {
+    SDL_Texture *tex;
+    tcache_shelf shelves[ATLAS_MAX_SHELVES];
+    int shelf_count;
+    int next_y;
+    unsigned int entries;
+    unsigned int last_used; ///< Frame any of the entries on the page was last requested on
+} tcache_page;
+
 typedef struct tcache_t {
-    hashmap entries;
+    flatmap entries;
+    tcache_page pages[ATLAS_MAX_PAGES];
+    tcache_palette palettes[TRACKED_PALETTES];
+    unsigned int pal_epoch;
+    int page_size;
+    unsigned int frame;
+    unsigned int last_sweep;
+    size_t bytes;
+    size_t budget;
+    char *scratch;
+    size_t scratch_size;
     unsigned int hits;
     unsigned int misses;
-    unsigned int old_frees;
+    unsigned int uploads;
+    unsigned int evictions;
+    unsigned int pal_skips;
     uint8_t scale_factor;
     scaler_plugin *scaler;
     SDL_Renderer *renderer;
@@ -33,26 +98,246 @@ static tcache *cache = NULL;
 
 // Helper method for getting cache entry
 tcache_entry_value *tcache_add_entry(tcache_entry_key *key, tcache_entry_value *val) {
-    return hashmap_put(&cache->entries, (void *)key, sizeof(tcache_entry_key), (void *)val, sizeof(tcache_entry_value));
+    return flatmap_put(&cache->entries, key, val);
 }
 
 // Helper method for setting cache entry
 tcache_entry_value *tcache_get_entry(tcache_entry_key *key) {
-    tcache_entry_value *val = NULL;
-    unsigned int tmp_size;
-    hashmap_get(&cache->entries, (void *)key, sizeof(tcache_entry_key), (void **)&val, &tmp_size);
-    return val;
+    return flatmap_get(&cache->entries, key);
+}
+
+static void tcache_set_page_size() {
+    cache->page_size = ATLAS_PAGE_SIZE;
+    SDL_RendererInfo rinfo;
+    if(cache->renderer != NULL && SDL_GetRendererInfo(cache->renderer, &rinfo) == 0) {
+        if(rinfo.max_texture_width > 0 && rinfo.max_texture_width < cache->page_size) {
+            cache->page_size = rinfo.max_texture_width;
+        }
+        if(rinfo.max_texture_height > 0 && rinfo.max_texture_height < cache->page_size) {
+            cache->page_size = rinfo.max_texture_height;
+        }
+    }
+}
+
+static size_t tcache_page_bytes() {
+    return (size_t)cache->page_size * cache->page_size * 4;
+}
+
+// Shelf packing; each shelf is a row of sprites of roughly the same height. Pages are reset
+// once all of their entries have been freed, which keeps the allocator trivial.
+static int tcache_page_alloc(tcache_page *page, int page_size, int w, int h, SDL_Rect *rect) {
+    int pw = w + ATLAS_PADDING;
+    int ph = h + ATLAS_PADDING;
+    tcache_shelf *best = NULL;
+    for(int i = 0; i < page->shelf_count; i++) {
+        tcache_shelf *shelf = &page->shelves[i];
+        if(shelf->h >= ph && shelf->x + pw <= page_size && (best == NULL || shelf->h < best->h)) {
+            best = shelf;
+        }
+    }
+    if(best == NULL || best->h > ph * 2) {
+        if(page->shelf_count < ATLAS_MAX_SHELVES && page->next_y + ph <= page_size) {
+            best = &page->shelves[page->shelf_count++];
+            best->x = 0;
+            best->y = page->next_y;
+            best->h = ph;
+            page->next_y += ph;
+        } else if(best == NULL) {
+            return 1;
+        }
+    }
+    rect->x = best->x;
+    rect->y = best->y;
+    rect->w = w;
+    rect->h = h;
+    best->x += pw;
+    return 0;
+}
+
+static void tcache_free_entry(tcache_entry_value *entry) {
+    if(entry->page < 0) {
+        cache->bytes -= entry->bytes;
+        SDL_DestroyTexture(entry->tex);
+        return;
+    }
+    tcache_page *page = &cache->pages[entry->page];
+    if(--page->entries == 0) {
+        page->shelf_count = 0;
+        page->next_y = 0;
+    }
+}
+
+// Drops all the entries on the page, which leaves it empty. The texture of the page is kept.
+static void tcache_empty_page(int index) {
+    iterator it;
+    tcache_entry_value *entry;
+    flatmap_iter_begin(&cache->entries, &it);
+    while((entry = iter_next(&it)) != NULL) {
+        if(entry->page == index) {
+            tcache_free_entry(entry);
+            flatmap_delete(&cache->entries, &it);
+            cache->evictions++;
+        }
+    }
+}
+
+static int tcache_atlas_alloc(int w, int h, SDL_Rect *rect) {
+    if(w > cache->page_size / 4 || h > cache->page_size / 4) {
+        return -1;
+    }
+    for(int i = 0; i < ATLAS_MAX_PAGES; i++) {
+        tcache_page *page = &cache->pages[i];
+        if(page->tex == NULL) {
+            page->tex = SDL_CreateTexture(cache->renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING,
+                                          cache->page_size, cache->page_size);
+            if(page->tex == NULL) {
+                PERROR("Failed to create atlas page: %s", SDL_GetError());
+                return -1;
+            }
+            SDL_SetTextureBlendMode(page->tex, SDL_BLENDMODE_BLEND);
+            cache->bytes += tcache_page_bytes();
+            DEBUG("Created atlas page %d (%dx%d)", i, cache->page_size, cache->page_size);
+        }
+        if(tcache_page_alloc(page, cache->page_size, w, h, rect) == 0) {
+            page->entries++;
+            return i;
+        }
+    }
+
+    // All pages are full. Start over on the one that has gone unused the longest, unless it is
+    // in use on this frame, in which case recorded draws may still need its contents.
+    int oldest = -1;
+    for(int i = 0; i < ATLAS_MAX_PAGES; i++) {
+        tcache_page *page = &cache->pages[i];
+        if(page->last_used < cache->frame && (oldest < 0 || page->last_used < cache->pages[oldest].last_used)) {
+            oldest = i;
+        }
+    }
+    if(oldest < 0) {
+        return -1;
+    }
+    tcache_empty_page(oldest);
+    if(tcache_page_alloc(&cache->pages[oldest], cache->page_size, w, h, rect) == 0) {
+        cache->pages[oldest].entries++;
+        return oldest;
+    }
+    return -1;
+}
+
+static void tcache_destroy_pages() {
+    for(int i = 0; i < ATLAS_MAX_PAGES; i++) {
+        if(cache->pages[i].tex != NULL) {
+            SDL_DestroyTexture(cache->pages[i].tex);
+            cache->bytes -= tcache_page_bytes();
+        }
+    }
+    memset(cache->pages, 0, sizeof(cache->pages));
+}
+
+// Atlas pages can not be locked per entry, so pixels are converted to a scratch buffer first
+static char *tcache_scratch(size_t size) {
+    if(cache->scratch_size < size) {
+        cache->scratch = omf_realloc(cache->scratch, size);
+        cache->scratch_size = size;
+    }
+    return cache->scratch;
+}
+
+// Brings the change history of the palette up to date, and returns it.
+static tcache_palette *tcache_sync_palette(const screen_palette *pal) {
+    tcache_palette *slot = NULL;
+    for(int i = 0; i < TRACKED_PALETTES; i++) {
+        if(cache->palettes[i].pal == pal) {
+            slot = &cache->palettes[i];
+            break;
+        }
+        if(slot == NULL || cache->palettes[i].last_used < slot->last_used) {
+            slot = &cache->palettes[i];
+        }
+    }
+
+    if(slot->pal != pal) {
+        // Not tracked yet; everything counts as changed.
+        cache->pal_epoch++;
+        slot->pal = pal;
+        slot->version = pal->version;
+        memcpy(slot->data, pal->data, sizeof(slot->data));
+        for(int i = 0; i < 256; i++) {
+            slot->changed[i] = cache->pal_epoch;
+        }
+    } else if(slot->version != pal->version) {
+        cache->pal_epoch++;
+        slot->version = pal->version;
+        for(int i = 0; i < 256; i++) {
+            if(memcmp(slot->data[i], pal->data[i], 3) != 0) {
+                memcpy(slot->data[i], pal->data[i], 3);
+                slot->changed[i] = cache->pal_epoch;
+            }
+        }
+    }
+    slot->last_used = cache->pal_epoch;
+    return slot;
+}
+
+// Collects the palette indexes the converted texture will use, as done by surface_to_rgba()
+static void tcache_used_colors(const surface *sur, const char *remap_table, uint8_t pal_offset,
+                               uint32_t colors[COLOR_MASK_WORDS]) {
+    memset(colors, 0, COLOR_MASK_WORDS * sizeof(uint32_t));
+    for(int i = 0; i < sur->w * sur->h; i++) {
+        uint8_t idx = (uint8_t)sur->data[i];
+        if(remap_table != NULL) {
+            idx = (uint8_t)remap_table[idx];
+        }
+        if(idx < 48) {
+            idx += pal_offset;
+        }
+        colors[idx / 32] |= 1U << (idx % 32);
+    }
+}
+
+// Tells if the texture of the entry still matches what the surface would convert to
+static int tcache_entry_valid(tcache_entry_value *val, surface *sur, const screen_palette *pal) {
+    if(sur->force_refresh) {
+        return 0;
+    }
+    if(sur->type == SURFACE_TYPE_RGBA) {
+        return 1;
+    }
+    if(val->pal != pal) {
+        return 0;
+    }
+    if(val->pal_version == pal->version) {
+        return 1;
+    }
+
+    const tcache_palette *slot = tcache_sync_palette(pal);
+    for(int w = 0; w < COLOR_MASK_WORDS; w++) {
+        uint32_t bits = val->colors[w];
+        for(int b = 0; bits != 0; b++, bits >>= 1) {
+            if((bits & 1) && slot->changed[w * 32 + b] > val->pal_epoch) {
+                return 0;
+            }
+        }
+    }
+
+    // None of the colors used by the texture changed, so it can be kept as is.
+    val->pal_version = pal->version;
+    cache->pal_skips++;
+    return 1;
 }
 
 void tcache_init(SDL_Renderer *renderer, int scale_factor, scaler_plugin *scaler) {
     cache = omf_calloc(1, sizeof(tcache));
-    hashmap_create(&cache->entries, 6);
+    flatmap_create(&cache->entries, sizeof(tcache_entry_key), sizeof(tcache_entry_value));
     cache->renderer = renderer;
     cache->scaler = scaler;
     cache->scale_factor = scale_factor;
+    tcache_set_page_size();
+    cache->budget = DEFAULT_BUDGET;
     cache->hits = 0;
-    cache->old_frees = 0;
+    cache->evictions = 0;
     cache->misses = 0;
+    cache->uploads = 0;
     DEBUG("Texture cache initialized.");
 }
 
@@ -61,45 +346,124 @@ void tcache_reinit(SDL_Renderer *renderer, int scale_factor, scaler_plugin *scal
     cache->scaler = scaler;
     cache->scale_factor = scale_factor;
     tcache_clear();
+    tcache_set_page_size();
 }
 
 void tcache_clear() {
+    if(cache == NULL) {
+        return;
+    }
+    draw_list_discard();
     iterator it;
-    hashmap_iter_begin(&cache->entries, &it);
-    hashmap_pair *pair;
-    while((pair = iter_next(&it)) != NULL) {
-        tcache_entry_value *entry = pair->val;
-        SDL_DestroyTexture(entry->tex);
+    tcache_entry_value *entry;
+    flatmap_iter_begin(&cache->entries, &it);
+    while((entry = iter_next(&it)) != NULL) {
+        tcache_free_entry(entry);
     }
-    hashmap_clear(&cache->entries);
+    flatmap_clear(&cache->entries);
+    tcache_destroy_pages();
 }
 
-void tcache_tick() {
+typedef struct tcache_lru_t {
+    unsigned int last_used;
+    int page; ///< Atlas page to evict, or -1 to evict the entry of the key
+    tcache_entry_key key;
+} tcache_lru;
+
+static int tcache_lru_compare(const void *a, const void *b) {
+    unsigned int la = ((const tcache_lru *)a)->last_used;
+    unsigned int lb = ((const tcache_lru *)b)->last_used;
+    return (la > lb) - (la < lb);
+}
+
+// Evicts the least recently used textures until the cache is down to the target size. Textures
+// that were used on the last frame are left alone. Atlas pages are evicted with all of their entries.
+static void tcache_evict(size_t target) {
+    vector lru;
+    vector_create(&lru, sizeof(tcache_lru));
+    tcache_lru item;
     iterator it;
-    hashmap_iter_begin(&cache->entries, &it);
-    hashmap_pair *pair;
-    while((pair = iter_next(&it)) != NULL) {
-        tcache_entry_value *entry = pair->val;
-        entry->age++;
-        if(entry->age > CACHE_LIFETIME) {
-            SDL_DestroyTexture(entry->tex);
-            hashmap_delete(&cache->entries, &it);
-            cache->old_frees++;
+    tcache_entry_value *entry;
+    flatmap_iter_begin(&cache->entries, &it);
+    while((entry = iter_next(&it)) != NULL) {
+        if(entry->page < 0 && entry->last_used + 1 < cache->frame) {
+            item.last_used = entry->last_used;
+            item.page = -1;
+            item.key = *(const tcache_entry_key *)flatmap_iter_key(&cache->entries, &it);
+            vector_append(&lru, &item);
+        }
+    }
+    memset(&item.key, 0, sizeof(tcache_entry_key));
+    for(int i = 0; i < ATLAS_MAX_PAGES; i++) {
+        if(cache->pages[i].tex != NULL && cache->pages[i].last_used + 1 < cache->frame) {
+            item.last_used = cache->pages[i].last_used;
+            item.page = i;
+            vector_append(&lru, &item);
+        }
+    }
+    vector_sort(&lru, tcache_lru_compare);
+
+    tcache_lru *next;
+    vector_iter_begin(&lru, &it);
+    while(cache->bytes > target && (next = iter_next(&it)) != NULL) {
+        if(next->page >= 0) {
+            tcache_empty_page(next->page);
+            SDL_DestroyTexture(cache->pages[next->page].tex);
+            cache->pages[next->page].tex = NULL;
+            cache->bytes -= tcache_page_bytes();
+            continue;
         }
+        entry = tcache_get_entry(&next->key);
+        tcache_free_entry(entry);
+        flatmap_del(&cache->entries, &next->key);
+        cache->evictions++;
+    }
+    vector_free(&lru);
+}
+
+void tcache_set_budget(size_t bytes) {
+    cache->budget = bytes;
+}
+
+void tcache_end_frame() {
+    cache->frame++;
+    if(cache->bytes > cache->budget && cache->frame - cache->last_sweep >= SWEEP_INTERVAL) {
+        cache->last_sweep = cache->frame;
+        tcache_evict(cache->budget / 4 * 3);
+    }
+}
+
+void tcache_get_stats(tcache_stats *stats) {
+    if(cache == NULL) {
+        memset(stats, 0, sizeof(tcache_stats));
+        return;
     }
+    stats->hits = cache->hits;
+    stats->misses = cache->misses;
+    stats->uploads = cache->uploads;
 }
 
 void tcache_close() {
     DEBUG("Texture cache:");
     DEBUG(" * Misses:    %d", cache->misses);
     DEBUG(" * Hits:      %d", cache->hits);
-    DEBUG(" * Old frees: %d", cache->old_frees);
+    DEBUG(" * Uploads:   %d", cache->uploads);
+    DEBUG(" * Evictions: %d", cache->evictions);
+    DEBUG(" * Texture memory: %u kB of %u kB", (unsigned int)(cache->bytes / 1024),
+          (unsigned int)(cache->budget / 1024));
+    DEBUG(" * Palette change skips: %d", cache->pal_skips);
+    int pages = 0;
+    for(int i = 0; i < ATLAS_MAX_PAGES; i++) {
+        pages += (cache->pages[i].tex != NULL);
+    }
+    DEBUG(" * Atlas pages: %d", pages);
     tcache_clear();
-    hashmap_free(&cache->entries);
+    flatmap_free(&cache->entries);
+    omf_free(cache->scratch);
     omf_free(cache);
 }
 
-SDL_Texture *tcache_get(surface *sur, screen_palette *pal, char *remap_table, uint8_t pal_offset) {
+SDL_Texture *tcache_get(surface *sur, screen_palette *pal, char *remap_table, uint8_t pal_offset, SDL_Rect *rect) {
     if(sur == NULL) {
         DEBUG("Invalid surface requested from tcache: surface is NULL.");
         return NULL;
@@ -116,31 +480,55 @@ SDL_Texture *tcache_get(surface *sur, screen_palette *pal, char *remap_table, ui
     key.c_pal_offset = (sur->type == SURFACE_TYPE_RGBA) ? 0 : pal_offset;
     key.c_remap_table = (sur->type == SURFACE_TYPE_RGBA) ? 0 : remap_table;
     key.c_surface = sur;
+    key.c_guid = sur->guid;
     key.w = sur->w;
     key.h = sur->h;
 
     // Attempt to find appropriate surface
     // If surface is cacheable and hasn't changed, just return here.
     tcache_entry_value *val = tcache_get_entry(&key);
-    if(val != NULL && (val->pal_version == pal->version || sur->type == SURFACE_TYPE_RGBA) && !sur->force_refresh) {
-        val->age = 0;
+    if(val != NULL && tcache_entry_valid(val, sur, pal)) {
+        val->last_used = cache->frame;
+        if(val->page >= 0) {
+            cache->pages[val->page].last_used = cache->frame;
+        }
         cache->hits++;
+        *rect = val->rect;
         return val->tex;
     }
 
     // Reset refresh flag here
     sur->force_refresh = 0;
 
+    // The old contents may still be referenced by recorded draws, so those must go out first.
+    if(val != NULL) {
+        draw_list_flush();
+    }
+
     // If there was no fitting surface tex in the cache at all,
     // then we need to create one
+    int tex_w = sur->w * cache->scale_factor;
+    int tex_h = sur->h * cache->scale_factor;
     if(val == NULL) {
         tcache_entry_value new_entry;
-        new_entry.age = 0;
+        new_entry.bytes = 0;
         new_entry.pal_version = pal->version;
-        new_entry.tex = SDL_CreateTexture(cache->renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING,
-                                          sur->w * cache->scale_factor, sur->h * cache->scale_factor);
-        SDL_SetTextureBlendMode(new_entry.tex, SDL_BLENDMODE_BLEND);
+        new_entry.page = tcache_atlas_alloc(tex_w, tex_h, &new_entry.rect);
+        if(new_entry.page >= 0) {
+            new_entry.tex = cache->pages[new_entry.page].tex;
+        } else {
+            new_entry.bytes = tex_w * tex_h * 4;
+            new_entry.tex = SDL_CreateTexture(cache->renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING,
+                                              tex_w, tex_h);
+            SDL_SetTextureBlendMode(new_entry.tex, SDL_BLENDMODE_BLEND);
+            new_entry.rect.x = 0;
+            new_entry.rect.y = 0;
+            new_entry.rect.w = tex_w;
+            new_entry.rect.h = tex_h;
+        }
         val = tcache_add_entry(&key, &new_entry);
+        cache->bytes += new_entry.bytes;
+        cache->misses++;
     }
 
     // We have a texture either from the cache, or we just created one.
@@ -149,22 +537,40 @@ SDL_Texture *tcache_get(surface *sur, screen_palette *pal, char *remap_table, ui
     if(cache->scale_factor > 1) {
         char *raw = omf_calloc(1, sur->w * sur->h * 4);
         surface scaled;
-        surface_create(&scaled, SURFACE_TYPE_RGBA, sur->w * cache->scale_factor, sur->h * cache->scale_factor);
+        surface_create(&scaled, SURFACE_TYPE_RGBA, tex_w, tex_h);
 
         surface_to_rgba(sur, raw, pal, remap_table, pal_offset);
         scaler_scale(cache->scaler, raw, scaled.data, sur->w, sur->h, cache->scale_factor);
-        surface_to_texture(&scaled, val->tex, pal, remap_table, pal_offset);
+        if(val->page >= 0) {
+            SDL_UpdateTexture(val->tex, &val->rect, scaled.data, tex_w * 4);
+        } else {
+            surface_to_texture(&scaled, val->tex, pal, remap_table, pal_offset);
+        }
         surface_free(&scaled);
         omf_free(raw);
+    } else if(val->page >= 0) {
+        char *pixels = tcache_scratch(tex_w * tex_h * 4);
+        surface_to_rgba(sur, pixels, pal, remap_table, pal_offset);
+        SDL_UpdateTexture(val->tex, &val->rect, pixels, tex_w * 4);
     } else {
         surface_to_texture(sur, val->tex, pal, remap_table, pal_offset);
     }
 
-    // Set correct age and palette version
-    val->age = 0;
+    // Mark the entry used, and set the palette version
+    val->last_used = cache->frame;
+    if(val->page >= 0) {
+        cache->pages[val->page].last_used = cache->frame;
+    }
+    val->pal = pal;
     val->pal_version = pal->version;
+    if(sur->type != SURFACE_TYPE_RGBA) {
+        tcache_sync_palette(pal);
+        val->pal_epoch = cache->pal_epoch;
+        tcache_used_colors(sur, remap_table, pal_offset, val->colors);
+    }
 
     // Do some statistics stuff
-    cache->misses++;
+    cache->uploads++;
+    *rect = val->rect;
     return val->tex;
 }
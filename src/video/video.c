@@ -8,6 +8,7 @@
 #include "utils/allocator.h"
 #include "utils/list.h"
 #include "utils/log.h"
+#include "video/draw_list.h"
 #include "video/image.h"
 #include "video/tcache.h"
 #include "video/video.h"
@@ -44,6 +45,14 @@ int video_load_scaler(const char *name, int scale_factor) {
     return 0;
 }
 
+static void video_init_palettes() {
+    state.base_palette = omf_calloc(1, sizeof(palette));
+    state.extra_palette = omf_calloc(1, sizeof(screen_palette));
+    state.screen_palette = omf_calloc(1, sizeof(screen_palette));
+    state.extra_palette->version = 0;
+    state.screen_palette->version = 1;
+}
+
 int video_init(int window_w, int window_h, int fullscreen, int vsync, const char *scaler_name, int scale_factor) {
     state.w = window_w;
     state.h = window_h;
@@ -68,11 +77,7 @@ int video_init(int window_w, int window_h, int fullscreen, int vsync, const char
     }
 
     // Clear palettes
-    state.base_palette = omf_calloc(1, sizeof(palette));
-    state.extra_palette = omf_calloc(1, sizeof(screen_palette));
-    state.screen_palette = omf_calloc(1, sizeof(screen_palette));
-    state.extra_palette->version = 0;
-    state.screen_palette->version = 1;
+    video_init_palettes();
 
     // Form title string
     char title[32];
@@ -119,8 +124,9 @@ int video_init(int window_w, int window_h, int fullscreen, int vsync, const char
     // Set rendertargets
     reset_targets();
 
-    // Init texture cache
+    // Init texture cache and sprite draw list
     tcache_init(state.renderer, state.scale_factor, &state.scaler);
+    draw_list_init(state.renderer);
 
     // Get renderer data
     SDL_RendererInfo rinfo;
@@ -136,7 +142,31 @@ int video_init(int window_w, int window_h, int fullscreen, int vsync, const char
     return 0;
 }
 
+// Initializes the video subsystem without a window or a renderer. Palettes are still
+// set up so that palette calls keep working, but all rendering calls turn into no-ops.
+// Used for headless simulation runs.
+int video_init_null() {
+    memset(&state, 0, sizeof(video_state));
+    state.w = NATIVE_W;
+    state.h = NATIVE_H;
+    state.fade = 1.0f;
+    state.scale_factor = 1;
+    state.render_bg_separately = true;
+    scaler_init(&state.scaler);
+    video_init_palettes();
+    INFO("Video Init OK (null renderer)");
+    return 0;
+}
+
+int video_is_null() {
+    return state.renderer == NULL;
+}
+
 void video_reinit_renderer() {
+    if(video_is_null()) {
+        return;
+    }
+
     // Clear old texture cache entries
     tcache_clear();
 
@@ -151,12 +181,16 @@ void video_reinit_renderer() {
     state.renderer = SDL_CreateRenderer(state.window, -1, renderer_flags);
     SDL_RenderSetLogicalSize(state.renderer, NATIVE_W * state.scale_factor, NATIVE_H * state.scale_factor);
     tcache_reinit(state.renderer, state.scale_factor, &state.scaler);
+    draw_list_reinit(state.renderer);
 
     // Reset rendertarget
     reset_targets();
 }
 
 int video_reinit(int window_w, int window_h, int fullscreen, int vsync, const char *scaler_name, int scale_factor) {
+    if(video_is_null()) {
+        return 0;
+    }
 
     // Tells if something has changed in video settings
     int changed = 0;
@@ -246,6 +280,9 @@ void video_set_fade(float fade) {
 }
 
 int video_screenshot(image *img) {
+    if(video_is_null()) {
+        return 1;
+    }
     image_create(img, state.w, state.h);
     int ret = SDL_RenderReadPixels(state.renderer, NULL, SDL_PIXELFORMAT_ABGR8888, img->data, img->w * 4);
     if(ret != 0) {
@@ -256,6 +293,11 @@ int video_screenshot(image *img) {
 }
 
 int video_area_capture(surface *sur, int x, int y, int w, int h) {
+    if(video_is_null()) {
+        return 1;
+    }
+    draw_list_flush();
+
     float scale_x = (float)state.w / NATIVE_W;
     float scale_y = (float)state.h / NATIVE_H;
 
@@ -314,6 +356,10 @@ static void clear_render_target(SDL_Texture *target) {
 void video_render_prepare() {
     // Reset palette
     memcpy(state.screen_palette->data, state.base_palette->data, 768);
+    if(video_is_null()) {
+        return;
+    }
+    draw_list_flush();
     clear_render_target(state.fg_target);
 }
 
@@ -322,20 +368,24 @@ void video_render_bg_separately(bool separate) {
 }
 
 void video_render_background(surface *sur) {
-    SDL_Texture *tex = tcache_get(sur, state.screen_palette, NULL, 0);
-    if(tex == NULL) {
+    if(video_is_null()) {
         return;
     }
 
-    if(state.render_bg_separately) {
-        SDL_SetRenderTarget(state.renderer, state.bg_target);
-    } else {
-        SDL_SetRenderTarget(state.renderer, state.fg_target);
+    SDL_Rect src;
+    SDL_Texture *tex = tcache_get(sur, state.screen_palette, NULL, 0, &src);
+    if(tex == NULL) {
+        return;
     }
-    SDL_SetTextureColorMod(tex, 0xFF, 0xFF, 0xFF);
-    SDL_SetTextureAlphaMod(tex, 0xFF);
-    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_NONE);
-    SDL_RenderCopy(state.renderer, tex, NULL, NULL);
+
+    SDL_Rect dst;
+    dst.x = 0;
+    dst.y = 0;
+    dst.w = NATIVE_W * state.scale_factor;
+    dst.h = NATIVE_H * state.scale_factor;
+    SDL_Color c = {0xFF, 0xFF, 0xFF, 0xFF};
+    SDL_Texture *target = state.render_bg_separately ? state.bg_target : state.fg_target;
+    draw_list_add(target, tex, SDL_BLENDMODE_NONE, &src, &dst, SDL_FLIP_NONE, c);
 }
 
 static void scale_rect(const video_state *state, SDL_Rect *rct) {
@@ -347,6 +397,10 @@ static void scale_rect(const video_state *state, SDL_Rect *rct) {
 
 static void render_sprite_fsot(video_state *state, surface *sur, SDL_Rect *dst, SDL_BlendMode blend_mode,
                                int pal_offset, SDL_RendererFlip flip_mode, uint8_t opacity, color color_mod) {
+    if(state->renderer == NULL) {
+        return;
+    }
+
     // Scale the object to actual screen size
     scale_rect(state, dst);
 
@@ -361,17 +415,16 @@ static void render_sprite_fsot(video_state *state, surface *sur, SDL_Rect *dst,
     // Fetch object from texture cache. Palettes are versioned, so
     // we if object does not yet exist with given palette, it will be rendered
     // and uploaded to videomem.
-    SDL_Texture *tex = tcache_get(sur, pal, NULL, pal_offset);
+    SDL_Rect src;
+    SDL_Texture *tex = tcache_get(sur, pal, NULL, pal_offset, &src);
     if(tex == NULL)
         return;
 
     // Always render objects to foreground rendertarget. This way we avoid
     // doing effects on the background (which is on another rendertarget).
-    SDL_SetRenderTarget(state->renderer, state->fg_target);
-    SDL_SetTextureAlphaMod(tex, opacity);
-    SDL_SetTextureColorMod(tex, color_mod.r, color_mod.g, color_mod.b);
-    SDL_SetTextureBlendMode(tex, blend_mode);
-    SDL_RenderCopyEx(state->renderer, tex, NULL, dst, 0, NULL, flip_mode);
+    // The draw is only recorded here, and submitted in batches by video_render_finish().
+    SDL_Color c = {color_mod.r, color_mod.g, color_mod.b, opacity};
+    draw_list_add(state->fg_target, tex, blend_mode, &src, dst, flip_mode, c);
 }
 
 void video_render_sprite_tint(surface *sur, int sx, int sy, color c, int pal_offset) {
@@ -437,13 +490,24 @@ void video_render_sprite_flip_scale_opacity_tint(surface *sur, int sx, int sy, u
     render_sprite_fsot(&state, sur, &dst, blend_mode, pal_offset, flip, opacity, tint);
 }
 
-// Called on every game tick
-void video_tick() {
-    tcache_tick();
+void video_set_texture_budget(unsigned int megabytes) {
+    if(video_is_null()) {
+        return;
+    }
+    tcache_set_budget((size_t)megabytes * 1024 * 1024);
 }
 
 // Called after frame has been rendered
 void video_render_finish() {
+    if(video_is_null()) {
+        return;
+    }
+
+    // Submit all sprites recorded during this frame
+    draw_list_flush();
+    draw_list_end_frame();
+    tcache_end_frame();
+
     // Set our rendertarget to screen buffer.
     SDL_SetRenderTarget(state.renderer, NULL);
 
@@ -478,11 +542,14 @@ void video_render_finish() {
 }
 
 void video_close() {
-    tcache_close();
-    SDL_DestroyTexture(state.fg_target);
-    SDL_DestroyTexture(state.bg_target);
-    SDL_DestroyRenderer(state.renderer);
-    SDL_DestroyWindow(state.window);
+    if(!video_is_null()) {
+        draw_list_close();
+        tcache_close();
+        SDL_DestroyTexture(state.fg_target);
+        SDL_DestroyTexture(state.bg_target);
+        SDL_DestroyRenderer(state.renderer);
+        SDL_DestroyWindow(state.window);
+    }
     omf_free(state.screen_palette);
     omf_free(state.extra_palette);
     omf_free(state.base_palette);
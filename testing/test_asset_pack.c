@@ -0,0 +1,295 @@
+#include "formats/af.h"
+#include "resources/af.h"
+#include "resources/asset_pack.h"
+#include "resources/bk.h"
+#include "resources/ids.h"
+#include "utils/allocator.h"
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Size of the move category tables and of a single trie node at the end of a packed AF
+#define PACKED_CATEGORIES_SIZE (AF_MOVE_CATEGORIES * AF_MOVE_MASK_WORDS * 4)
+#define PACKED_NODE_SIZE (5 + AF_MOVE_MASK_WORDS * 4)
+
+// Fields of the first index entry, after the 12 byte header
+#define PACK_FIRST_ENTRY_OFFSET 16
+#define PACK_FIRST_ENTRY_SIZE 20
+
+// Packs are written to the temp directory, so that the tests do not leave them lying around
+static void temp_path(char *buf, size_t len, const char *name) {
+    const char *dir = getenv("TMPDIR");
+    if(dir == NULL) {
+        dir = getenv("TEMP");
+    }
+#if defined(_WIN32)
+    if(dir == NULL) {
+        dir = ".";
+    }
+#else
+    if(dir == NULL) {
+        dir = "/tmp";
+    }
+#endif
+    snprintf(buf, len, "%s/%s", dir, name);
+}
+
+static void add_sd_move(sd_af_file *src, int id, const char *move_string, int category) {
+    sd_move move;
+    sd_animation ani;
+    sd_move_create(&move);
+    sd_move_set_move_string(&move, move_string);
+    sd_move_set_footer_string(&move, "A10-B10");
+    move.category = category;
+    move.damage_amount = 20;
+    sd_animation_create(&ani);
+    sd_animation_set_anim_string(&ani, "F10-G10-H10");
+    sd_animation_push_extra_string(&ani, "s10A100");
+    sd_move_set_animation(&move, &ani);
+    sd_af_set_move(src, id, &move);
+    sd_animation_free(&ani);
+    sd_move_free(&move);
+}
+
+static void create_test_bk(bk *b) {
+    memset(b, 0, sizeof(bk));
+    b->file_id = 5;
+    surface_create(&b->background, SURFACE_TYPE_PALETTE, 32, 20);
+    for(int i = 0; i < 32 * 20; i++) {
+        b->background.data[i] = i % 251;
+    }
+    memset(b->sound_translation_table, 3, sizeof(b->sound_translation_table));
+
+    vector_create(&b->palettes, sizeof(palette));
+    palette pal;
+    memset(&pal, 7, sizeof(palette));
+    vector_append(&b->palettes, &pal);
+
+    hashmap_create(&b->infos, 7);
+    bk_info info;
+    memset(&info, 0, sizeof(bk_info));
+    info.chain_hit = 2;
+    info.probability = 9;
+    str_from_c(&info.footer_string, "A1");
+    info.ani.id = 11;
+    info.ani.start_pos = vec2i_create(4, -8);
+    str_from_c(&info.ani.animation_string, "A5-B5");
+    vector_create(&info.ani.collision_coords, sizeof(collision_coord));
+    vector_create(&info.ani.extra_strings, sizeof(str));
+    vector_create(&info.ani.sprites, sizeof(sprite));
+    surface *sur = omf_calloc(1, sizeof(surface));
+    surface_create(sur, SURFACE_TYPE_PALETTE, 3, 2);
+    memcpy(sur->data, "abcdef", 6);
+    memcpy(sur->stencil, "\1\0\1\0\1\0", 6);
+    sprite sp;
+    sprite_create_custom(&sp, vec2i_create(-3, 6), sur);
+    sp.id = 0;
+    vector_append(&info.ani.sprites, &sp);
+    hashmap_iput(&b->infos, info.ani.id, &info, sizeof(bk_info));
+}
+
+static void create_test_af(af *a) {
+    sd_af_file sdaf;
+    sd_af_create(&sdaf);
+    sdaf.file_id = 3;
+    sdaf.health = 100;
+    sdaf.forward_speed = 1.5f;
+    add_sd_move(&sdaf, 10, "K2", 1);
+    add_sd_move(&sdaf, 12, "K236", 2);
+    af_create(a, &sdaf);
+    sd_af_free(&sdaf);
+}
+
+void test_asset_pack_roundtrip(void) {
+    // Source data
+    af src_af;
+    create_test_af(&src_af);
+    bk src_bk;
+    create_test_bk(&src_bk);
+
+    char path[256];
+    temp_path(path, sizeof(path), "openomf_test.pak");
+    asset_pack_writer *writer = asset_pack_writer_open(path);
+    asset_pack_write_bk(writer, BK_ARENA0, &src_bk);
+    asset_pack_write_af(writer, AF_JAGUAR, &src_af);
+    CU_ASSERT(asset_pack_writer_close(writer) == 0);
+
+    // Load it back
+    int opened = asset_pack_open(path);
+    bk loaded_bk;
+    af loaded_af;
+    memset(&loaded_af, 0, sizeof(af));
+    CU_ASSERT(asset_pack_load_bk(&loaded_bk, BK_MENU) == 1);
+    int bk_loaded = asset_pack_load_bk(&loaded_bk, BK_ARENA0);
+    int af_loaded = asset_pack_load_af(&loaded_af, AF_JAGUAR);
+    asset_pack_close();
+    remove(path);
+    CU_ASSERT_FATAL(opened == 0);
+    CU_ASSERT_FATAL(bk_loaded == 0);
+    CU_ASSERT_FATAL(af_loaded == 0);
+
+    // BK contents
+    CU_ASSERT(loaded_bk.file_id == 5);
+    CU_ASSERT(loaded_bk.background.w == 32 && loaded_bk.background.h == 20);
+    CU_ASSERT(memcmp(loaded_bk.background.data, src_bk.background.data, 32 * 20) == 0);
+    CU_ASSERT(memcmp(loaded_bk.background.stencil, src_bk.background.stencil, 32 * 20) == 0);
+    CU_ASSERT(memcmp(loaded_bk.sound_translation_table, src_bk.sound_translation_table, 30) == 0);
+    CU_ASSERT(memcmp(bk_get_palette(&loaded_bk, 0), bk_get_palette(&src_bk, 0), sizeof(palette)) == 0);
+    bk_info *info = bk_get_info(&loaded_bk, 11);
+    CU_ASSERT_FATAL(info != NULL);
+    CU_ASSERT(info->chain_hit == 2 && info->probability == 9);
+    CU_ASSERT_STRING_EQUAL(str_c(&info->footer_string), "A1");
+    CU_ASSERT_STRING_EQUAL(str_c(&info->ani.animation_string), "A5-B5");
+    CU_ASSERT(info->ani.start_pos.x == 4 && info->ani.start_pos.y == -8);
+    sprite *sp = animation_get_sprite(&info->ani, 0);
+    CU_ASSERT_FATAL(sp != NULL);
+    CU_ASSERT(sp->pos.x == -3 && sp->pos.y == 6);
+    CU_ASSERT(sp->data->w == 3 && sp->data->h == 2);
+    CU_ASSERT(memcmp(sp->data->data, "abcdef", 6) == 0);
+    CU_ASSERT(memcmp(sp->data->stencil, "\1\0\1\0\1\0", 6) == 0);
+
+    // AF contents, including the move lookup tables
+    CU_ASSERT(loaded_af.id == 3 && loaded_af.health == 100);
+    CU_ASSERT(loaded_af.forward_speed == 1.5f);
+    CU_ASSERT(af_get_move(&loaded_af, 11) == NULL);
+    af_move *move = af_get_move(&loaded_af, 12);
+    CU_ASSERT_FATAL(move != NULL);
+    CU_ASSERT_STRING_EQUAL(str_c(&move->move_string), "K236");
+    CU_ASSERT_STRING_EQUAL(str_c(&move->footer_string), "A10-B10");
+    CU_ASSERT(move->damage == src_af.moves[12].damage);
+    CU_ASSERT(move->ani.extra_string_count == 1);
+    uint32_t mask[AF_MOVE_MASK_WORDS] = {0};
+    af_match_moves(&loaded_af, "K2369", mask);
+    CU_ASSERT(af_next_move(mask, 0) == 10);
+    CU_ASSERT(af_next_move(mask, 11) == 12);
+    CU_ASSERT(af_next_move(mask, 13) == -1);
+    memset(mask, 0, sizeof(mask));
+    af_category_moves(&loaded_af, 2, mask);
+    CU_ASSERT(af_next_move(mask, 0) == 12);
+
+    af_free(&loaded_af);
+    bk_free(&loaded_bk);
+    af_free(&src_af);
+    bk_free(&src_bk);
+}
+
+void test_asset_pack_missing(void) {
+    bk b;
+    CU_ASSERT(asset_pack_open("missing.pak") == 1);
+    CU_ASSERT(asset_pack_load_bk(&b, BK_ARENA0) == 1);
+}
+
+static char *read_file(const char *path, long *len) {
+    FILE *handle = fopen(path, "rb");
+    if(handle == NULL) {
+        return NULL;
+    }
+    fseek(handle, 0, SEEK_END);
+    *len = ftell(handle);
+    fseek(handle, 0, SEEK_SET);
+    char *buf = omf_calloc(1, *len);
+    if(fread(buf, 1, *len, handle) != (size_t)*len) {
+        omf_free(buf);
+        buf = NULL;
+    }
+    fclose(handle);
+    return buf;
+}
+
+static void write_file(const char *path, const char *buf, long len) {
+    FILE *handle = fopen(path, "wb");
+    if(handle != NULL) {
+        fwrite(buf, 1, len, handle);
+        fclose(handle);
+    }
+}
+
+// Writes the pack with the given bytes of the original replaced, and tries to load the AF from it.
+// The AF is the only resource in the pack, so its data runs up to the end of the file.
+static int load_corrupt_af(const char *path, const char *orig, long len, long pos, const void *bytes, long count) {
+    char *buf = omf_calloc(1, len);
+    memcpy(buf, orig, len);
+    if(pos >= 0) {
+        memcpy(buf + pos, bytes, count);
+    }
+    write_file(path, buf, len);
+    omf_free(buf);
+
+    af a;
+    memset(&a, 0, sizeof(af));
+    if(asset_pack_open(path) != 0) {
+        return -1;
+    }
+    int ret = asset_pack_load_af(&a, AF_JAGUAR);
+    asset_pack_close();
+    if(ret == 0) {
+        af_free(&a);
+    }
+    return ret;
+}
+
+void test_asset_pack_corrupt(void) {
+    af src_af;
+    create_test_af(&src_af);
+    char path[256];
+    temp_path(path, sizeof(path), "openomf_test_corrupt.pak");
+    asset_pack_writer *writer = asset_pack_writer_open(path);
+    asset_pack_write_af(writer, AF_JAGUAR, &src_af);
+    CU_ASSERT(asset_pack_writer_close(writer) == 0);
+    af_free(&src_af);
+
+    long len = 0;
+    char *orig = read_file(path, &len);
+    CU_ASSERT_FATAL(orig != NULL);
+    long categories = len - PACKED_CATEGORIES_SIZE;
+    long last_node = categories - PACKED_NODE_SIZE;
+
+    // Unchanged pack loads
+    CU_ASSERT(load_corrupt_af(path, orig, len, -1, NULL, 0) == 0);
+
+    // Trie links that point out of the node table, or back up the trie
+    int16_t link = 0x7000;
+    CU_ASSERT(load_corrupt_af(path, orig, len, last_node + 1, &link, 2) == 1);
+    CU_ASSERT(load_corrupt_af(path, orig, len, last_node + 3, &link, 2) == 1);
+    link = 0;
+    CU_ASSERT(load_corrupt_af(path, orig, len, last_node + 1, &link, 2) == 1);
+
+    // Move masks that point at moves which are not in the file
+    uint32_t mask = 1U << 11;
+    CU_ASSERT(load_corrupt_af(path, orig, len, last_node + 5, &mask, 4) == 1);
+    CU_ASSERT(load_corrupt_af(path, orig, len, categories, &mask, 4) == 1);
+    mask = 1U << 31;
+    CU_ASSERT(load_corrupt_af(path, orig, len, len - 4, &mask, 4) == 1);
+
+    // Index entries that reach past the end of the file, without overflowing the check
+    uint32_t size = 0xFFFFFFFF;
+    CU_ASSERT(load_corrupt_af(path, orig, len, PACK_FIRST_ENTRY_SIZE, &size, 4) == -1);
+    uint32_t offset = 0xFFFFFFF0;
+    CU_ASSERT(load_corrupt_af(path, orig, len, PACK_FIRST_ENTRY_OFFSET, &offset, 4) == -1);
+
+    // Truncated data and index
+    char *buf = omf_calloc(1, len);
+    memcpy(buf, orig, len);
+    write_file(path, buf, len - 10);
+    CU_ASSERT(asset_pack_open(path) == 1);
+    write_file(path, buf, 16);
+    CU_ASSERT(asset_pack_open(path) == 1);
+    omf_free(buf);
+
+    omf_free(orig);
+    remove(path);
+}
+
+void asset_pack_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of asset pack roundtripping", test_asset_pack_roundtrip) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of missing asset pack", test_asset_pack_missing) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of corrupt asset pack", test_asset_pack_corrupt) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,116 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <string.h>
+#include <utils/delta.h>
+
+#define TEST_LEN 203
+
+static void fill(char *buf, size_t len, unsigned int seed) {
+    for(size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = (seed >> 16) & 0xFF;
+    }
+}
+
+static void check_round_trip(const char *base, size_t base_len, const char *data, size_t len) {
+    char enc[delta_encode_bound(TEST_LEN)];
+    char dec[TEST_LEN];
+    size_t enc_len = delta_encode(base, base_len, data, len, enc);
+    CU_ASSERT(enc_len <= delta_encode_bound(len));
+    CU_ASSERT(delta_decode(base, base_len, enc, enc_len, dec, len) == 0);
+    CU_ASSERT(memcmp(dec, data, len) == 0);
+}
+
+void test_delta_unchanged(void) {
+    char data[TEST_LEN];
+    fill(data, TEST_LEN, 1);
+    char enc[delta_encode_bound(TEST_LEN)];
+
+    // A bit per block and nothing else
+    size_t enc_len = delta_encode(data, TEST_LEN, data, TEST_LEN, enc);
+    CU_ASSERT(enc_len == ((TEST_LEN + 7) / 8 + 7) / 8);
+    check_round_trip(data, TEST_LEN, data, TEST_LEN);
+}
+
+void test_delta_changed(void) {
+    char base[TEST_LEN];
+    char data[TEST_LEN];
+    fill(base, TEST_LEN, 1);
+    memcpy(data, base, TEST_LEN);
+    data[0] ^= 0x01;
+    data[17] ^= 0x80;
+    data[TEST_LEN - 1] ^= 0x55;
+    check_round_trip(base, TEST_LEN, data, TEST_LEN);
+
+    // Everything changed
+    fill(data, TEST_LEN, 2);
+    check_round_trip(base, TEST_LEN, data, TEST_LEN);
+}
+
+void test_delta_no_base(void) {
+    char data[TEST_LEN];
+    memset(data, 0, TEST_LEN);
+    data[5] = 1;
+    data[100] = 2;
+    check_round_trip(NULL, 0, data, TEST_LEN);
+
+    // A base shorter than the data is padded with zeroes
+    char base[10];
+    fill(base, sizeof(base), 3);
+    check_round_trip(base, sizeof(base), data, TEST_LEN);
+    check_round_trip(data, TEST_LEN, base, sizeof(base));
+}
+
+void test_delta_corrupt(void) {
+    char base[TEST_LEN];
+    char data[TEST_LEN];
+    char enc[delta_encode_bound(TEST_LEN)];
+    char dec[TEST_LEN];
+    fill(base, TEST_LEN, 1);
+    fill(data, TEST_LEN, 2);
+    size_t enc_len = delta_encode(base, TEST_LEN, data, TEST_LEN, enc);
+    CU_ASSERT(delta_decode(base, TEST_LEN, enc, enc_len / 2, dec, TEST_LEN) == 1);
+    CU_ASSERT(delta_decode(base, TEST_LEN, enc, 0, dec, TEST_LEN) == 1);
+}
+
+void test_delta_compress(void) {
+    char data[TEST_LEN];
+    char comp[delta_compress_bound(TEST_LEN)];
+    char dec[TEST_LEN];
+
+    // Runs shrink
+    memset(data, 0, TEST_LEN);
+    memset(data + 50, 7, 60);
+    size_t comp_len = delta_compress(data, TEST_LEN, comp);
+    CU_ASSERT(comp_len < 16);
+    CU_ASSERT(delta_decompress(comp, comp_len, dec, TEST_LEN) == TEST_LEN);
+    CU_ASSERT(memcmp(dec, data, TEST_LEN) == 0);
+
+    // Noise stays within the bound
+    fill(data, TEST_LEN, 4);
+    comp_len = delta_compress(data, TEST_LEN, comp);
+    CU_ASSERT(comp_len <= delta_compress_bound(TEST_LEN));
+    CU_ASSERT(delta_decompress(comp, comp_len, dec, TEST_LEN) == TEST_LEN);
+    CU_ASSERT(memcmp(dec, data, TEST_LEN) == 0);
+
+    // Output that does not fit is refused
+    CU_ASSERT(delta_decompress(comp, comp_len, dec, TEST_LEN - 1) == 0);
+}
+
+void delta_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for delta of unchanged data", test_delta_unchanged) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for delta of changed data", test_delta_changed) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for delta without a base", test_delta_no_base) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for delta of corrupt data", test_delta_corrupt) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for delta compression", test_delta_compress) == NULL) {
+        return;
+    }
+}
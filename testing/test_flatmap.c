@@ -0,0 +1,154 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <utils/flatmap.h>
+#include <utils/iterator.h>
+
+#define TEST_VAL_COUNT 1000
+
+static flatmap test_map;
+static unsigned int test_values[TEST_VAL_COUNT];
+
+void test_flatmap_create(void) {
+    flatmap_create(&test_map, sizeof(unsigned int), sizeof(unsigned int));
+    CU_ASSERT_PTR_NOT_NULL(test_map.data);
+    CU_ASSERT(flatmap_size(&test_map) == 0);
+}
+
+void test_flatmap_insert(void) {
+    for(unsigned int i = 0; i < TEST_VAL_COUNT; i++) {
+        unsigned int k = TEST_VAL_COUNT - i;
+        unsigned int *v = flatmap_put(&test_map, &i, &k);
+        CU_ASSERT_PTR_NOT_NULL(v);
+        CU_ASSERT(*v == k);
+        test_values[i] = k;
+    }
+    CU_ASSERT(flatmap_size(&test_map) == TEST_VAL_COUNT);
+    CU_ASSERT(flatmap_capacity(&test_map) * 3 >= TEST_VAL_COUNT * 4);
+
+    // Putting an existing key replaces the value, size shouldn't change
+    unsigned int i = TEST_VAL_COUNT / 2;
+    unsigned int k = 12345;
+    CU_ASSERT(*(unsigned int *)flatmap_put(&test_map, &i, &k) == k);
+    CU_ASSERT(flatmap_size(&test_map) == TEST_VAL_COUNT);
+    test_values[i] = k;
+}
+
+void test_flatmap_get(void) {
+    for(unsigned int i = 0; i < TEST_VAL_COUNT; i++) {
+        unsigned int *val = flatmap_get(&test_map, &i);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(val);
+        CU_ASSERT(*val == test_values[i]);
+    }
+    unsigned int missing = TEST_VAL_COUNT + 1;
+    CU_ASSERT_PTR_NULL(flatmap_get(&test_map, &missing));
+}
+
+void test_flatmap_delete(void) {
+    int removed = 0;
+    for(unsigned int i = 0; i < TEST_VAL_COUNT; i += 10) {
+        CU_ASSERT(flatmap_del(&test_map, &i) == 0);
+        CU_ASSERT(flatmap_del(&test_map, &i) == 1);
+        CU_ASSERT_PTR_NULL(flatmap_get(&test_map, &i));
+        test_values[i] = 0;
+        removed++;
+    }
+    CU_ASSERT(flatmap_size(&test_map) == TEST_VAL_COUNT - removed);
+
+    // The rest must survive the entries being shifted around
+    for(unsigned int i = 0; i < TEST_VAL_COUNT; i++) {
+        unsigned int *val = flatmap_get(&test_map, &i);
+        if(test_values[i] == 0) {
+            CU_ASSERT_PTR_NULL(val);
+        } else {
+            CU_ASSERT_PTR_NOT_NULL_FATAL(val);
+            CU_ASSERT(*val == test_values[i]);
+        }
+    }
+}
+
+void test_flatmap_iterator(void) {
+    iterator it;
+    unsigned int *val;
+    int count = 0;
+    flatmap_iter_begin(&test_map, &it);
+    while((val = iter_next(&it)) != NULL) {
+        const unsigned int *key = flatmap_iter_key(&test_map, &it);
+        CU_ASSERT(test_values[*key] == *val);
+        CU_ASSERT(test_values[*key] > 0);
+        test_values[*key] = 0;
+        count++;
+    }
+    CU_ASSERT(count == flatmap_size(&test_map));
+    for(unsigned int i = 0; i < TEST_VAL_COUNT; i++) {
+        CU_ASSERT(test_values[i] == 0);
+    }
+}
+
+void test_flatmap_iter_del(void) {
+    iterator it;
+    unsigned int *val;
+    unsigned int seen[TEST_VAL_COUNT] = {0};
+    unsigned int before = flatmap_size(&test_map);
+    unsigned int visited = 0;
+
+    // Remove every other entry while iterating; every entry must still be visited exactly once
+    flatmap_iter_begin(&test_map, &it);
+    while((val = iter_next(&it)) != NULL) {
+        unsigned int key = *(const unsigned int *)flatmap_iter_key(&test_map, &it);
+        CU_ASSERT(seen[key] == 0);
+        seen[key] = 1;
+        if(visited++ % 2 == 0) {
+            CU_ASSERT(flatmap_delete(&test_map, &it) == 0);
+        }
+    }
+    CU_ASSERT(visited == before);
+    CU_ASSERT(flatmap_size(&test_map) == before / 2);
+
+    flatmap_iter_begin(&test_map, &it);
+    while(iter_next(&it) != NULL) {
+        CU_ASSERT(flatmap_delete(&test_map, &it) == 0);
+    }
+    CU_ASSERT(flatmap_size(&test_map) == 0);
+}
+
+void test_flatmap_clear(void) {
+    for(unsigned int i = 0; i < TEST_VAL_COUNT; i++) {
+        flatmap_put(&test_map, &i, &i);
+    }
+    flatmap_clear(&test_map);
+    CU_ASSERT(flatmap_size(&test_map) == 0);
+    unsigned int key = 5;
+    CU_ASSERT_PTR_NULL(flatmap_get(&test_map, &key));
+}
+
+void test_flatmap_free(void) {
+    flatmap_free(&test_map);
+    CU_ASSERT_PTR_NULL(test_map.data);
+}
+
+void flatmap_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for flatmap create", test_flatmap_create) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap insert operation", test_flatmap_insert) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap get operation", test_flatmap_get) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap delete operation", test_flatmap_delete) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap iterator", test_flatmap_iterator) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap iterator delete operation", test_flatmap_iter_del) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap clear operation", test_flatmap_clear) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for flatmap free operation", test_flatmap_free) == NULL) {
+        return;
+    }
+}
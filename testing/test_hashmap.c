@@ -1,6 +1,8 @@
 #include <CUnit/Basic.h>
 #include <CUnit/CUnit.h>
-#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <utils/flatmap.h>
 #include <utils/hashmap.h>
 #include <utils/iterator.h>
 
@@ -183,6 +185,96 @@ void hashmap_test_autoresize(void) {
     hashmap_free(&test_map);
 }
 
+// Keys shaped like the texture cache keys, which are looked up for every sprite draw
+typedef struct flat_key_t {
+    void *surface;
+    char *remap_table;
+    uint16_t w, h;
+    uint8_t pal_offset;
+} flat_key;
+
+#define FLAT_KEY_COUNT 4096
+
+static flat_key flat_keys[FLAT_KEY_COUNT];
+static char flat_surfaces[FLAT_KEY_COUNT];
+static char flat_remaps[17];
+
+static void flat_make_keys(void) {
+    memset(flat_keys, 0, sizeof(flat_keys));
+    for(int i = 0; i < FLAT_KEY_COUNT; i++) {
+        flat_keys[i].surface = &flat_surfaces[i];
+        flat_keys[i].remap_table = (i % 3) ? NULL : &flat_remaps[i % 17];
+        flat_keys[i].w = 16 + i % 64;
+        flat_keys[i].h = 32 + i % 48;
+        flat_keys[i].pal_offset = i % 4;
+    }
+}
+
+// Runs the same insert, lookup and delete workload through the chained hashmap and the flatmap,
+// and checks that both give the same answers.
+void test_hashmap_flatmap_match(void) {
+    hashmap hm;
+    flatmap fm;
+    unsigned int found_hm = 0;
+    unsigned int found_fm = 0;
+    unsigned int vlen;
+    int *val;
+
+    flat_make_keys();
+    hashmap_create(&hm, 6);
+    hashmap_set_opts(&hm, HASHMAP_AUTO_INC, 0.25, 0.75, 6, 16);
+    flatmap_create(&fm, sizeof(flat_key), sizeof(int));
+
+    // Insert every key twice, so that the second round overwrites the values in place
+    for(int r = 0; r < 2; r++) {
+        for(int i = 0; i < FLAT_KEY_COUNT; i++) {
+            hashmap_put(&hm, &flat_keys[i], sizeof(flat_key), &i, sizeof(int));
+            flatmap_put(&fm, &flat_keys[i], &i);
+        }
+    }
+    CU_ASSERT(hashmap_reserved(&hm) == FLAT_KEY_COUNT);
+    CU_ASSERT(flatmap_size(&fm) == FLAT_KEY_COUNT);
+
+    for(int i = 0; i < FLAT_KEY_COUNT; i++) {
+        if(hashmap_get(&hm, &flat_keys[i], sizeof(flat_key), (void **)&val, &vlen) == 0 && *val == i) {
+            found_hm++;
+        }
+        val = flatmap_get(&fm, &flat_keys[i]);
+        if(val != NULL && *val == i) {
+            found_fm++;
+        }
+    }
+    CU_ASSERT(found_hm == FLAT_KEY_COUNT);
+    CU_ASSERT(found_fm == found_hm);
+
+    // Delete every other key, and check that the rest are still found
+    for(int i = 0; i < FLAT_KEY_COUNT; i += 2) {
+        hashmap_del(&hm, &flat_keys[i], sizeof(flat_key));
+        flatmap_del(&fm, &flat_keys[i]);
+    }
+    CU_ASSERT(hashmap_reserved(&hm) == FLAT_KEY_COUNT / 2);
+    CU_ASSERT(flatmap_size(&fm) == FLAT_KEY_COUNT / 2);
+    for(int i = 0; i < FLAT_KEY_COUNT; i++) {
+        val = flatmap_get(&fm, &flat_keys[i]);
+        if(i % 2 == 0) {
+            CU_ASSERT(val == NULL);
+            CU_ASSERT(hashmap_get(&hm, &flat_keys[i], sizeof(flat_key), (void **)&val, &vlen) != 0);
+        } else {
+            CU_ASSERT(val != NULL && *val == i);
+        }
+    }
+
+    for(int i = 1; i < FLAT_KEY_COUNT; i += 2) {
+        hashmap_del(&hm, &flat_keys[i], sizeof(flat_key));
+        flatmap_del(&fm, &flat_keys[i]);
+    }
+    CU_ASSERT(hashmap_reserved(&hm) == 0);
+    CU_ASSERT(flatmap_size(&fm) == 0);
+
+    hashmap_free(&hm);
+    flatmap_free(&fm);
+}
+
 void hashmap_test_suite(CU_pSuite suite) {
     // Add tests
     if(CU_add_test(suite, "Test for hashmap create", test_hashmap_create) == NULL) {
@@ -218,4 +310,7 @@ void hashmap_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "Test for hashmap auto resize", hashmap_test_autoresize) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "Test for flatmap against hashmap", test_hashmap_flatmap_match) == NULL) {
+        return;
+    }
 }
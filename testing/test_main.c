@@ -9,10 +9,17 @@ void trn_test_suite(CU_pSuite suite);
 void script_test_suite(CU_pSuite suite);
 void str_test_suite(CU_pSuite suite);
 void hashmap_test_suite(CU_pSuite suite);
+void flatmap_test_suite(CU_pSuite suite);
 void vector_test_suite(CU_pSuite suite);
 void list_test_suite(CU_pSuite suite);
 void array_test_suite(CU_pSuite suite);
 void text_render_test_suite(CU_pSuite suite);
+void surface_test_suite(CU_pSuite suite);
+void asset_pack_test_suite(CU_pSuite suite);
+void pool_test_suite(CU_pSuite suite);
+void slotmap_test_suite(CU_pSuite suite);
+void delta_test_suite(CU_pSuite suite);
+void net_sync_test_suite(CU_pSuite suite);
 
 int main(int argc, char **argv) {
     CU_pSuite suite = NULL;
@@ -63,6 +70,11 @@ int main(int argc, char **argv) {
         goto end;
     hashmap_test_suite(hashmap_suite);
 
+    CU_pSuite flatmap_suite = CU_add_suite("Flatmap", NULL, NULL);
+    if(flatmap_suite == NULL)
+        goto end;
+    flatmap_test_suite(flatmap_suite);
+
     CU_pSuite vector_suite = CU_add_suite("Vector", NULL, NULL);
     if(vector_suite == NULL)
         goto end;
@@ -83,6 +95,36 @@ int main(int argc, char **argv) {
         goto end;
     text_render_test_suite(text_render_suite);
 
+    CU_pSuite surface_suite = CU_add_suite("Surface", NULL, NULL);
+    if(surface_suite == NULL)
+        goto end;
+    surface_test_suite(surface_suite);
+
+    CU_pSuite asset_pack_suite = CU_add_suite("Asset packs", NULL, NULL);
+    if(asset_pack_suite == NULL)
+        goto end;
+    asset_pack_test_suite(asset_pack_suite);
+
+    CU_pSuite pool_suite = CU_add_suite("Pool", NULL, NULL);
+    if(pool_suite == NULL)
+        goto end;
+    pool_test_suite(pool_suite);
+
+    CU_pSuite slotmap_suite = CU_add_suite("Slotmap", NULL, NULL);
+    if(slotmap_suite == NULL)
+        goto end;
+    slotmap_test_suite(slotmap_suite);
+
+    CU_pSuite delta_suite = CU_add_suite("Delta", NULL, NULL);
+    if(delta_suite == NULL)
+        goto end;
+    delta_test_suite(delta_suite);
+
+    CU_pSuite net_sync_suite = CU_add_suite("Net sync", NULL, NULL);
+    if(net_sync_suite == NULL)
+        goto end;
+    net_sync_test_suite(net_sync_suite);
+
     // Run tests
     CU_basic_set_mode(CU_BRM_VERBOSE);
     CU_basic_run_tests();
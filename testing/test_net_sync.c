@@ -0,0 +1,328 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <SDL.h>
+#include <enet/enet.h>
+#include <string.h>
+
+#include "controller/controller.h"
+#include "controller/net_controller.h"
+#include "game/game_state_type.h"
+#include "game/utils/serial.h"
+#include "game/utils/settings.h"
+#include "utils/delta.h"
+
+#define TEST_STATE_LEN 1000
+#define TEST_TIMEOUT_MS 1000
+
+// A server and a client network controller, connected over loopback
+typedef struct loopback_t {
+    ENetHost *server_host;
+    ENetHost *client_host;
+    ENetPeer *server_peer;
+    ENetPeer *client_peer;
+    controller server;
+    controller client;
+    int tick;
+} loopback;
+
+static void fill(serial *ser, size_t len, unsigned int seed) {
+    serial_create(ser);
+    for(size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245 + 12345;
+        serial_write_int8(ser, (seed >> 16) & 0xFF);
+    }
+}
+
+// The server listens on a port picked by the system, so that the test can't clash with anything
+static int loopback_open(loopback *lb) {
+    memset(lb, 0, sizeof(loopback));
+    if(enet_initialize() != 0) {
+        return 1;
+    }
+    ENetAddress address;
+    address.host = ENET_HOST_ANY;
+    address.port = 0;
+    lb->server_host = enet_host_create(&address, 1, 2, 0, 0);
+    lb->client_host = enet_host_create(NULL, 1, 2, 0, 0);
+    if(lb->server_host == NULL || lb->client_host == NULL ||
+       enet_socket_get_address(lb->server_host->socket, &address) != 0) {
+        goto error_0;
+    }
+    enet_address_set_host(&address, "127.0.0.1");
+    if(enet_host_connect(lb->client_host, &address, 2, 0) == NULL) {
+        goto error_0;
+    }
+
+    ENetEvent event;
+    Uint32 start = SDL_GetTicks();
+    while((lb->server_peer == NULL || lb->client_peer == NULL) && SDL_GetTicks() - start < TEST_TIMEOUT_MS) {
+        if(enet_host_service(lb->server_host, &event, 1) > 0 && event.type == ENET_EVENT_TYPE_CONNECT) {
+            lb->server_peer = event.peer;
+        }
+        if(enet_host_service(lb->client_host, &event, 1) > 0 && event.type == ENET_EVENT_TYPE_CONNECT) {
+            lb->client_peer = event.peer;
+        }
+    }
+    if(lb->server_peer == NULL || lb->client_peer == NULL) {
+        goto error_0;
+    }
+
+    // The controllers own the hosts from here on
+    controller_init(&lb->server);
+    controller_init(&lb->client);
+    net_controller_create(&lb->server, lb->server_host, lb->server_peer, ROLE_SERVER);
+    net_controller_create(&lb->client, lb->client_host, lb->client_peer, ROLE_CLIENT);
+    return 0;
+
+error_0:
+    if(lb->server_host != NULL) {
+        enet_host_destroy(lb->server_host);
+    }
+    if(lb->client_host != NULL) {
+        enet_host_destroy(lb->client_host);
+    }
+    enet_deinitialize();
+    return 1;
+}
+
+// Disconnects while both ends are serviced, so that freeing the controllers does not have to wait
+static void loopback_close(loopback *lb) {
+    int server_closed = 0;
+    int client_closed = 0;
+    enet_peer_disconnect(lb->server_peer, 0);
+    Uint32 start = SDL_GetTicks();
+    while((!server_closed || !client_closed) && SDL_GetTicks() - start < TEST_TIMEOUT_MS) {
+        ctrl_event *ev = NULL;
+        if(!client_closed) {
+            client_closed = controller_tick(&lb->client, lb->tick, &ev);
+            controller_free_chain(ev);
+        }
+        ev = NULL;
+        if(!server_closed) {
+            server_closed = controller_tick(&lb->server, lb->tick, &ev);
+            controller_free_chain(ev);
+        }
+        SDL_Delay(1);
+    }
+    net_controller_free(&lb->client);
+    net_controller_free(&lb->server);
+    enet_deinitialize();
+}
+
+// Services both ends until the client gets a sync of the expected state. The server gets the
+// acknowledgements on the way.
+static int wait_sync(loopback *lb, serial *expected) {
+    int found = 0;
+    Uint32 start = SDL_GetTicks();
+    while(!found && SDL_GetTicks() - start < TEST_TIMEOUT_MS) {
+        ctrl_event *ev = NULL;
+        controller_tick(&lb->client, lb->tick, &ev);
+        for(ctrl_event *i = ev; i != NULL; i = i->next) {
+            if(i->type == EVENT_TYPE_SYNC && serial_len(i->event_data.ser) == serial_len(expected) &&
+               memcmp(i->event_data.ser->data, expected->data, serial_len(expected)) == 0) {
+                found = 1;
+            }
+        }
+        controller_free_chain(ev);
+        ev = NULL;
+        controller_tick(&lb->server, lb->tick, &ev);
+        controller_free_chain(ev);
+        lb->tick++;
+        SDL_Delay(1);
+    }
+    return found;
+}
+
+// Services the server for a while, so that it gets the acknowledgements in flight
+static void wait_acks(loopback *lb) {
+    Uint32 start = SDL_GetTicks();
+    while(SDL_GetTicks() - start < 50) {
+        ctrl_event *ev = NULL;
+        controller_tick(&lb->server, lb->tick, &ev);
+        controller_free_chain(ev);
+        SDL_Delay(1);
+    }
+}
+
+void test_net_sync_delta(void) {
+    loopback lb;
+    serial a, b;
+    settings_get()->net.net_sync_compress = 0;
+    CU_ASSERT_FATAL(loopback_open(&lb) == 0);
+    const net_sync_stats *sent = net_controller_get_sync_stats(&lb.server);
+    const net_sync_stats *received = net_controller_get_sync_stats(&lb.client);
+
+    // Nothing has been acknowledged, so the first state goes in full
+    fill(&a, TEST_STATE_LEN, 1);
+    CU_ASSERT(controller_update(&lb.server, &a) == 0);
+    CU_ASSERT(sent->sent_full == 1);
+    CU_ASSERT(wait_sync(&lb, &a));
+    wait_acks(&lb);
+
+    // The next one goes against the acknowledged state. The first one may have been sent again if
+    // its acknowledgement was slow.
+    fill(&b, TEST_STATE_LEN, 1);
+    b.data[10] ^= 0x01;
+    b.data[500] ^= 0x80;
+    unsigned int sent_full = sent->sent_full;
+    uint64_t full_bytes = sent->sent_bytes / sent->sent;
+    uint64_t sent_bytes = sent->sent_bytes;
+    CU_ASSERT(controller_update(&lb.server, &b) == 0);
+    CU_ASSERT(sent->sent - sent->resent == 2);
+    CU_ASSERT(sent->sent_full == sent_full);
+    CU_ASSERT(sent->sent_bytes - sent_bytes < full_bytes / 4);
+    CU_ASSERT(wait_sync(&lb, &b));
+    CU_ASSERT(received->dropped == 0);
+
+    serial_free(&a);
+    serial_free(&b);
+    loopback_close(&lb);
+}
+
+void test_net_sync_fallback(void) {
+    loopback lb;
+    serial a, b;
+    settings_get()->net.net_sync_compress = 1;
+    CU_ASSERT_FATAL(loopback_open(&lb) == 0);
+    const net_sync_stats *sent = net_controller_get_sync_stats(&lb.server);
+    const net_sync_stats *received = net_controller_get_sync_stats(&lb.client);
+
+    fill(&a, TEST_STATE_LEN, 1);
+    CU_ASSERT(controller_update(&lb.server, &a) == 0);
+    CU_ASSERT(wait_sync(&lb, &a));
+    wait_acks(&lb);
+
+    // Without new acknowledgements the acknowledged state drops out of the history, and the
+    // server falls back to sending the whole state
+    fill(&b, TEST_STATE_LEN, 1);
+    unsigned int sent_full = sent->sent_full;
+    for(int i = 0; i < SYNC_HISTORY; i++) {
+        b.data[i] ^= 0x01;
+        CU_ASSERT(controller_update(&lb.server, &b) == 0);
+    }
+    CU_ASSERT(sent->sent_full == sent_full + 1);
+    CU_ASSERT(wait_sync(&lb, &b));
+    CU_ASSERT(received->dropped == 0);
+
+    serial_free(&a);
+    serial_free(&b);
+    settings_get()->net.net_sync_compress = 0;
+    loopback_close(&lb);
+}
+
+// Takes the next state sync off the client's connection before its controller sees it
+static int lose_sync(loopback *lb) {
+    ENetEvent event;
+    int lost = 0;
+    Uint32 start = SDL_GetTicks();
+    while(!lost && SDL_GetTicks() - start < TEST_TIMEOUT_MS) {
+        if(enet_host_service(lb->client_host, &event, 1) > 0 && event.type == ENET_EVENT_TYPE_RECEIVE) {
+            lost = event.packet->dataLength > 0 && event.packet->data[0] == EVENT_TYPE_SYNC;
+            enet_packet_destroy(event.packet);
+        }
+    }
+    return lost;
+}
+
+void test_net_sync_resend(void) {
+    loopback lb;
+    serial a;
+    settings_get()->net.net_sync_compress = 0;
+    CU_ASSERT_FATAL(loopback_open(&lb) == 0);
+    const net_sync_stats *sent = net_controller_get_sync_stats(&lb.server);
+
+    // The server sends the state again, since the lost sync never gets acknowledged
+    fill(&a, TEST_STATE_LEN, 1);
+    CU_ASSERT(controller_update(&lb.server, &a) == 0);
+    CU_ASSERT(lose_sync(&lb));
+    CU_ASSERT(wait_sync(&lb, &a));
+    CU_ASSERT(sent->resent >= 1);
+
+    // Nothing more goes out once the state has been acknowledged
+    wait_acks(&lb);
+    unsigned int resent = sent->resent;
+    for(int i = 0; i < 50; i++) {
+        ctrl_event *ev = NULL;
+        controller_tick(&lb.server, lb.tick++, &ev);
+        controller_free_chain(ev);
+    }
+    CU_ASSERT(sent->resent == resent);
+
+    serial_free(&a);
+    loopback_close(&lb);
+}
+
+void test_net_sync_base_gone(void) {
+    loopback lb;
+    CU_ASSERT_FATAL(loopback_open(&lb) == 0);
+    const net_sync_stats *received = net_controller_get_sync_stats(&lb.client);
+
+    // A delta against a state that the client does not have. The payload would decode fine without
+    // the base, so only the check of the base drops it.
+    serial state;
+    fill(&state, TEST_STATE_LEN, 1);
+    char encoded[delta_encode_bound(TEST_STATE_LEN)];
+    size_t encoded_len = delta_encode(NULL, 0, state.data, TEST_STATE_LEN, encoded);
+    serial ser;
+    serial_create(&ser);
+    serial_write_int8(&ser, EVENT_TYPE_SYNC);
+    serial_write_int32(&ser, 2);
+    serial_write_int32(&ser, 1);
+    serial_write_int32(&ser, TEST_STATE_LEN);
+    serial_write_int8(&ser, 0);
+    serial_write(&ser, encoded, encoded_len);
+    ENetPacket *packet = enet_packet_create(ser.data, serial_len(&ser), ENET_PACKET_FLAG_RELIABLE);
+    enet_peer_send(lb.server_peer, 1, packet);
+    enet_host_flush(lb.server_host);
+    serial_free(&ser);
+    serial_free(&state);
+
+    int got_sync = 0;
+    Uint32 start = SDL_GetTicks();
+    while(received->dropped == 0 && received->received == 0 && SDL_GetTicks() - start < TEST_TIMEOUT_MS) {
+        ctrl_event *ev = NULL;
+        controller_tick(&lb.client, lb.tick++, &ev);
+        for(ctrl_event *i = ev; i != NULL; i = i->next) {
+            got_sync |= (i->type == EVENT_TYPE_SYNC);
+        }
+        controller_free_chain(ev);
+        SDL_Delay(1);
+    }
+    CU_ASSERT(received->dropped == 1);
+    CU_ASSERT(received->received == 0);
+    CU_ASSERT(got_sync == 0);
+
+    loopback_close(&lb);
+}
+
+void test_net_sync_too_large(void) {
+    loopback lb;
+    serial big;
+    CU_ASSERT_FATAL(loopback_open(&lb) == 0);
+
+    // The client would drop it anyway
+    fill(&big, SYNC_MAX_LEN + 1, 1);
+    CU_ASSERT(controller_update(&lb.server, &big) == 1);
+    CU_ASSERT(net_controller_get_sync_stats(&lb.server)->sent == 0);
+
+    serial_free(&big);
+    loopback_close(&lb);
+}
+
+void net_sync_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for state syncs against acknowledged states", test_net_sync_delta) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for state syncs falling back to the full state", test_net_sync_fallback) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for state syncs that get lost", test_net_sync_resend) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for state syncs against a missing base", test_net_sync_base_gone) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for state syncs that are too large", test_net_sync_too_large) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,87 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <utils/pool.h>
+
+#define TEST_ITEM_COUNT 100
+
+typedef struct {
+    int a;
+    double b;
+    char c[20];
+} test_item;
+
+void test_pool_alloc(void) {
+    pool p;
+    pool_create(&p, sizeof(test_item), 16);
+    test_item *items[TEST_ITEM_COUNT];
+    for(int i = 0; i < TEST_ITEM_COUNT; i++) {
+        items[i] = pool_alloc(&p);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(items[i]);
+        CU_ASSERT(items[i]->a == 0);
+        CU_ASSERT(pool_owns(&p, items[i]));
+        items[i]->a = i;
+    }
+    for(int i = 0; i < TEST_ITEM_COUNT; i++) {
+        CU_ASSERT(items[i]->a == i);
+    }
+
+    pool_stats stats;
+    pool_get_stats(&p, &stats);
+    CU_ASSERT(stats.allocs == TEST_ITEM_COUNT);
+    CU_ASSERT(stats.in_use == TEST_ITEM_COUNT);
+    CU_ASSERT(stats.peak == TEST_ITEM_COUNT);
+    CU_ASSERT(stats.slabs == (TEST_ITEM_COUNT + 15) / 16);
+
+    for(int i = 0; i < TEST_ITEM_COUNT; i++) {
+        pool_release(&p, items[i]);
+    }
+    pool_get_stats(&p, &stats);
+    CU_ASSERT(stats.releases == TEST_ITEM_COUNT);
+    CU_ASSERT(stats.in_use == 0);
+    pool_free(&p);
+}
+
+void test_pool_recycle(void) {
+    pool p;
+    pool_create(&p, sizeof(test_item), 4);
+    test_item *first = pool_alloc(&p);
+    first->a = 42;
+    pool_release(&p, first);
+
+    // Released items are handed out again before new slabs are made, and come back zeroed
+    test_item *second = pool_alloc(&p);
+    CU_ASSERT_PTR_EQUAL(first, second);
+    CU_ASSERT(second->a == 0);
+
+    pool_stats stats;
+    pool_get_stats(&p, &stats);
+    CU_ASSERT(stats.slabs == 1);
+    CU_ASSERT(stats.peak == 1);
+    pool_release(&p, second);
+    pool_free(&p);
+}
+
+void test_pool_owns(void) {
+    pool p;
+    pool_create(&p, sizeof(test_item), 4);
+    test_item outside;
+    char *item = pool_alloc(&p);
+    CU_ASSERT(pool_owns(&p, item));
+    CU_ASSERT(!pool_owns(&p, item + 1));
+    CU_ASSERT(!pool_owns(&p, &outside));
+    CU_ASSERT(!pool_owns(&p, NULL));
+    pool_release(&p, item);
+    pool_free(&p);
+}
+
+void pool_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for pool alloc and release", test_pool_alloc) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for pool item recycling", test_pool_recycle) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for pool ownership", test_pool_owns) == NULL) {
+        return;
+    }
+}
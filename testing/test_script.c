@@ -169,6 +169,42 @@ void test_script_get(void) {
     CU_ASSERT(sd_script_get(sd_script_get_frame(&script, 0), "mp") == 0);
 }
 
+void test_script_isset_id(void) {
+    CU_ASSERT(sd_script_isset_id(NULL, TAG_BPS) == 0);
+    CU_ASSERT(sd_script_isset_id(sd_script_get_frame(&script, 0), TAG_BPS) == 1);
+    CU_ASSERT(sd_script_isset_id(sd_script_get_frame(&script, 0), TAG_BPD) == 1);
+    CU_ASSERT(sd_script_isset_id(sd_script_get_frame(&script, 0), TAG_MP) == 0);
+}
+
+void test_script_get_id(void) {
+    CU_ASSERT(sd_script_get_id(NULL, TAG_BPS) == 0);
+    CU_ASSERT(sd_script_get_id(sd_script_get_frame(&script, 0), TAG_BPS) == 1);
+    CU_ASSERT(sd_script_get_id(sd_script_get_frame(&script, 0), TAG_BPN) == 64);
+    CU_ASSERT(sd_script_get_id(sd_script_get_frame(&script, 0), TAG_MP) == 0);
+    CU_ASSERT(sd_script_get_id(sd_script_get_frame(&script, 1), TAG_SF) == 3);
+}
+
+void test_tag_id_after_modify(void) {
+    sd_script s;
+
+    // Create a test case
+    CU_ASSERT(sd_script_create(&s) == SD_SUCCESS);
+    CU_ASSERT(sd_script_append_frame(&s, 100, 0) == SD_SUCCESS);
+
+    // Tag IDs must follow tag additions and removals
+    CU_ASSERT(sd_script_set_tag(&s, 0, "x=", 10) == SD_SUCCESS);
+    CU_ASSERT(sd_script_isset_id(sd_script_get_frame(&s, 0), TAG_X_EQ) == 1);
+    CU_ASSERT(sd_script_get_id(sd_script_get_frame(&s, 0), TAG_X_EQ) == 10);
+    CU_ASSERT(sd_script_isset_id(sd_script_get_frame(&s, 0), TAG_X) == 0);
+    CU_ASSERT(sd_script_delete_tag(&s, 0, "x=") == SD_SUCCESS);
+    CU_ASSERT(sd_script_isset_id(sd_script_get_frame(&s, 0), TAG_X_EQ) == 0);
+    CU_ASSERT(sd_script_set_tag(&s, 0, "jf2", 0) == SD_SUCCESS);
+    CU_ASSERT(sd_script_clear_tags(&s, 0) == SD_SUCCESS);
+    CU_ASSERT(sd_script_isset_id(sd_script_get_frame(&s, 0), TAG_JF2) == 0);
+
+    sd_script_free(&s);
+}
+
 void test_script_tag_vars(void) {
     CU_ASSERT(sd_script_get(sd_script_get_frame(&script, 0), "s") == 5); // 05 -> 5 should work
 }
@@ -218,6 +254,17 @@ void test_next_frame_with_tag(void) {
     CU_ASSERT(sd_script_next_frame_with_tag(&script, "sf", 100) == -1); // Border case 2
 }
 
+void test_next_frame_with_tag_id(void) {
+    CU_ASSERT(sd_script_next_frame_with_tag_id(NULL, TAG_S, 0) == -1);       // script NULL
+    CU_ASSERT(sd_script_next_frame_with_tag_id(&script, TAG_M, 0) == -1);    // tag not in script
+    CU_ASSERT(sd_script_next_frame_with_tag_id(&script, TAG_S, 1000) == -1); // tick does not exist
+    CU_ASSERT(sd_script_next_frame_with_tag_id(&script, TAG_S, 0) == 1);     // Should be in frame 1
+    CU_ASSERT(sd_script_next_frame_with_tag_id(&script, TAG_BPD, 0) == -1);  // in frame 0, but should not be found
+    CU_ASSERT(sd_script_next_frame_with_tag_id(&script, TAG_BPD, -1) == 0);  // test negative tick
+    CU_ASSERT(sd_script_next_frame_with_tag_id(&script, TAG_SF, 99) == 1);   // Border case 1
+    CU_ASSERT(sd_script_next_frame_with_tag_id(&script, TAG_SF, 100) == -1); // Border case 2
+}
+
 void test_set_tag(void) {
     // Test value setting to existing tag
     CU_ASSERT(sd_script_set_tag(&script, 0, "bpd", 10) == SD_SUCCESS);
@@ -319,6 +366,32 @@ void test_set_tick_len_at_frame(void) {
     sd_script_free(&s);
 }
 
+void test_frame_at_after_modify(void) {
+    sd_script s;
+
+    // Create a test case, with a zero length frame in the middle
+    CU_ASSERT(sd_script_create(&s) == SD_SUCCESS);
+    CU_ASSERT(sd_script_decode(&s, "A10-B0-C5", NULL) == SD_SUCCESS);
+    CU_ASSERT(sd_script_get_frame_index_at(&s, 9) == 0);
+    CU_ASSERT(sd_script_get_frame_index_at(&s, 10) == 2);
+    CU_ASSERT(sd_script_get_frame_index_at(&s, 15) == -1);
+
+    // Lookups must follow frame length changes
+    CU_ASSERT(sd_script_set_tick_len_at_frame(&s, 1, 3) == SD_SUCCESS);
+    CU_ASSERT(sd_script_get_frame_index_at(&s, 10) == 1);
+    CU_ASSERT(sd_script_get_frame_index_at(&s, 13) == 2);
+    CU_ASSERT(sd_script_get_tick_pos_at_frame(&s, 2) == 13);
+    CU_ASSERT(sd_script_get_total_ticks(&s) == 18);
+
+    // ... and appended frames
+    CU_ASSERT(sd_script_append_frame(&s, 2, 3) == SD_SUCCESS);
+    CU_ASSERT(sd_script_get_frame_at(&s, 19) == sd_script_get_frame(&s, 3));
+    CU_ASSERT(sd_script_get_frame_at(&s, 20) == NULL);
+    CU_ASSERT(sd_script_get_total_ticks(&s) == 20);
+
+    sd_script_free(&s);
+}
+
 void test_set_sprite_at_frame(void) {
     sd_script s;
 
@@ -405,12 +478,24 @@ void script_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "test of sd_script_get", test_script_get) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "test of sd_script_isset_id", test_script_isset_id) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of sd_script_get_id", test_script_get_id) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of tag IDs after modification", test_tag_id_after_modify) == NULL) {
+        return;
+    }
     if(CU_add_test(suite, "test of sd_script_next_frame_with_sprite", test_next_frame_with_sprite) == NULL) {
         return;
     }
     if(CU_add_test(suite, "test of sd_script_next_frame_with_tag", test_next_frame_with_tag) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "test of sd_script_next_frame_with_tag_id", test_next_frame_with_tag_id) == NULL) {
+        return;
+    }
     if(CU_add_test(suite, "test of sd_script_set_tag", test_set_tag) == NULL) {
         return;
     }
@@ -426,6 +511,9 @@ void script_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "test of sd_script_set_tick_len_at_frame", test_set_tick_len_at_frame) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "test of frame lookups after modification", test_frame_at_after_modify) == NULL) {
+        return;
+    }
     if(CU_add_test(suite, "test of sd_script_set_sprite_at_frame", test_set_sprite_at_frame) == NULL) {
         return;
     }
@@ -0,0 +1,108 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <utils/iterator.h>
+#include <utils/slotmap.h>
+
+#define TEST_VAL_COUNT 100
+
+void test_slotmap_insert_get(void) {
+    slotmap map;
+    slot_handle handles[TEST_VAL_COUNT];
+    slotmap_create(&map, sizeof(int));
+    for(int i = 0; i < TEST_VAL_COUNT; i++) {
+        handles[i] = slotmap_insert(&map, &i);
+        CU_ASSERT(handles[i] != SLOT_HANDLE_NONE);
+    }
+    CU_ASSERT(slotmap_size(&map) == TEST_VAL_COUNT);
+    for(int i = 0; i < TEST_VAL_COUNT; i++) {
+        int *val = slotmap_get(&map, handles[i]);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(val);
+        CU_ASSERT(*val == i);
+    }
+    CU_ASSERT_PTR_NULL(slotmap_get(&map, SLOT_HANDLE_NONE));
+    slotmap_free(&map);
+}
+
+void test_slotmap_remove(void) {
+    slotmap map;
+    slot_handle handles[TEST_VAL_COUNT];
+    slotmap_create(&map, sizeof(int));
+    for(int i = 0; i < TEST_VAL_COUNT; i++) {
+        handles[i] = slotmap_insert(&map, &i);
+    }
+
+    // Remove every odd item; removed handles must stop resolving, others keep working
+    for(int i = 1; i < TEST_VAL_COUNT; i += 2) {
+        CU_ASSERT(slotmap_remove(&map, handles[i]) == 0);
+    }
+    CU_ASSERT(slotmap_remove(&map, handles[1]) == 1);
+    CU_ASSERT(slotmap_size(&map) == TEST_VAL_COUNT / 2);
+    CU_ASSERT(slotmap_span(&map) == TEST_VAL_COUNT);
+    CU_ASSERT_PTR_NULL(slotmap_get_at(&map, 1));
+
+    slotmap_compact(&map);
+    CU_ASSERT(slotmap_span(&map) == TEST_VAL_COUNT / 2);
+    for(int i = 0; i < TEST_VAL_COUNT; i++) {
+        int *val = slotmap_get(&map, handles[i]);
+        if(i % 2) {
+            CU_ASSERT_PTR_NULL(val);
+        } else {
+            CU_ASSERT_PTR_NOT_NULL_FATAL(val);
+            CU_ASSERT(*val == i);
+        }
+    }
+
+    // Reused slots must not bring back the stale handles
+    int val = 1000;
+    slot_handle reused = slotmap_insert(&map, &val);
+    CU_ASSERT(reused != handles[TEST_VAL_COUNT - 1]);
+    for(int i = 1; i < TEST_VAL_COUNT; i += 2) {
+        CU_ASSERT_PTR_NULL(slotmap_get(&map, handles[i]));
+    }
+    CU_ASSERT(*(int *)slotmap_get(&map, reused) == 1000);
+    slotmap_free(&map);
+}
+
+void test_slotmap_iterator(void) {
+    slotmap map;
+    slotmap_create(&map, sizeof(int));
+    for(int i = 0; i < TEST_VAL_COUNT; i++) {
+        slotmap_insert(&map, &i);
+    }
+
+    // Delete while iterating; order of the remaining items must be kept
+    iterator it;
+    int *val;
+    slotmap_iter_begin(&map, &it);
+    while((val = iter_next(&it)) != NULL) {
+        if(*val % 3 == 0) {
+            CU_ASSERT(slotmap_delete(&map, &it) == 0);
+        }
+    }
+    slotmap_compact(&map);
+
+    int last = -1;
+    int count = 0;
+    slotmap_iter_begin(&map, &it);
+    while((val = iter_next(&it)) != NULL) {
+        CU_ASSERT(*val % 3 != 0);
+        CU_ASSERT(*val > last);
+        CU_ASSERT(slotmap_get(&map, slotmap_iter_handle(&map, &it)) == val);
+        last = *val;
+        count++;
+    }
+    CU_ASSERT(count == slotmap_size(&map));
+    slotmap_free(&map);
+}
+
+void slotmap_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for slotmap insert and get", test_slotmap_insert_get) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for slotmap remove and compact", test_slotmap_remove) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for slotmap iterator", test_slotmap_iterator) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,76 @@
+#include "utils/allocator.h"
+#include "video/surface.h"
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <stdlib.h>
+#include <string.h>
+
+static screen_palette test_pal;
+static char test_remap[256];
+
+static void fill_surface(surface *sur, unsigned int seed) {
+    srand(seed);
+    for(int i = 0; i < sur->w * sur->h; i++) {
+        sur->data[i] = rand() % 256;
+        sur->stencil[i] = rand() % 3; // Only 1 is opaque
+    }
+}
+
+static int convert_matches(surface *sur, char *remap_table, uint8_t pal_offset) {
+    size_t size = sur->w * sur->h * 4;
+    char *expected = omf_calloc(1, size);
+    char *actual = omf_calloc(1, size);
+    surface_to_rgba_scalar(sur, expected, &test_pal, remap_table, pal_offset);
+    surface_to_rgba(sur, actual, &test_pal, remap_table, pal_offset);
+    int ret = memcmp(expected, actual, size) == 0;
+    omf_free(expected);
+    omf_free(actual);
+    return ret;
+}
+
+void test_surface_to_rgba(void) {
+    for(int i = 0; i < 256; i++) {
+        test_pal.data[i][0] = i;
+        test_pal.data[i][1] = 255 - i;
+        test_pal.data[i][2] = i * 7;
+        test_remap[i] = 255 - i;
+    }
+
+    // Odd sizes make sure that the tail of the vectorized loop is covered
+    int sizes[][2] = {{1, 1}, {15, 1}, {16, 1}, {17, 3}, {320, 200}, {33, 7}};
+    for(int s = 0; s < 6; s++) {
+        surface sur;
+        surface_create(&sur, SURFACE_TYPE_PALETTE, sizes[s][0], sizes[s][1]);
+        fill_surface(&sur, s);
+        CU_ASSERT(convert_matches(&sur, NULL, 0));
+        CU_ASSERT(convert_matches(&sur, NULL, 48));
+        CU_ASSERT(convert_matches(&sur, test_remap, 0));
+        CU_ASSERT(convert_matches(&sur, test_remap, 48));
+        surface_free(&sur);
+    }
+}
+
+void test_surface_to_rgba_pal_change(void) {
+    surface sur;
+    surface_create(&sur, SURFACE_TYPE_PALETTE, 64, 64);
+    fill_surface(&sur, 1234);
+    CU_ASSERT(convert_matches(&sur, test_remap, 0));
+
+    // Palette and remap contents change in place; cached lookup tables must not be reused.
+    test_pal.data[10][0] = 1;
+    test_pal.data[200][2] = 2;
+    CU_ASSERT(convert_matches(&sur, test_remap, 0));
+    test_remap[5] = 10;
+    CU_ASSERT(convert_matches(&sur, test_remap, 0));
+    CU_ASSERT(convert_matches(&sur, NULL, 0));
+    surface_free(&sur);
+}
+
+void surface_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of surface_to_rgba", test_surface_to_rgba) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of surface_to_rgba after palette change", test_surface_to_rgba_pal_change) == NULL) {
+        return;
+    }
+}
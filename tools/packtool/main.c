@@ -0,0 +1,105 @@
+/** @file main.c
+ * @brief Asset pack baking tool
+ * @license MIT
+ */
+
+#include "resources/af_loader.h"
+#include "resources/asset_pack.h"
+#include "resources/bk_loader.h"
+#include "resources/ids.h"
+#include <argtable2.h>
+#include <stdio.h>
+#include <string.h>
+
+// Builds the path of a game file in the resource directory
+static void resource_file_path(char *dst, size_t len, const char *dir, int resource_id) {
+    size_t dir_len = strlen(dir);
+    const char *sep = (dir_len > 0 && dir[dir_len - 1] != '/' && dir[dir_len - 1] != '\\') ? "/" : "";
+    snprintf(dst, len, "%s%s%s", dir, sep, get_resource_file(resource_id));
+}
+
+int main(int argc, char *argv[]) {
+    // commandline argument parser options
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_file *dir = arg_file1("d", "dir", "<dir>", "Directory with the game files");
+    struct arg_file *output = arg_file1("o", "output", "<file>", "Output asset pack file");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, dir, output, end};
+    const char *progname = "packtool";
+    int ret = 1;
+
+    // Make sure everything got allocated
+    if(arg_nullcheck(argtable) != 0) {
+        printf("%s: insufficient memory\n", progname);
+        goto exit_0;
+    }
+
+    // Parse arguments
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    // Handle help
+    if(help->count > 0) {
+        printf("Usage: %s", progname);
+        arg_print_syntax(stdout, argtable, "\n");
+        printf("\nArguments:\n");
+        arg_print_glossary(stdout, argtable, "%-25s %s\n");
+        ret = 0;
+        goto exit_0;
+    }
+
+    // Handle version
+    if(vers->count > 0) {
+        printf("%s v0.1\n", progname);
+        printf("Command line One Must Fall 2097 asset pack baker (pack format version %d).\n", ASSET_PACK_VERSION);
+        printf("Source code is available at https://github.com/omf2097 under MIT license.\n");
+        ret = 0;
+        goto exit_0;
+    }
+
+    // Handle errors
+    if(nerrors > 0) {
+        arg_print_errors(stdout, end, progname);
+        printf("Try '%s --help' for more information.\n", progname);
+        goto exit_0;
+    }
+
+    // Decode every BK and AF file, and write the results to the pack
+    asset_pack_writer *writer = asset_pack_writer_open(output->filename[0]);
+    char path[1024];
+    int count = 0;
+    for(int id = BK_INTRO; id <= AF_NOVA; id++) {
+        resource_file_path(path, sizeof(path), dir->filename[0], id);
+        if(id < AF_JAGUAR) {
+            bk b;
+            if(load_bk_path(&b, path)) {
+                printf("Skipping %s: file could not be loaded.\n", path);
+                continue;
+            }
+            asset_pack_write_bk(writer, id, &b);
+            bk_free(&b);
+        } else {
+            af a;
+            memset(&a, 0, sizeof(af));
+            if(load_af_path(&a, path)) {
+                printf("Skipping %s: file could not be loaded.\n", path);
+                continue;
+            }
+            asset_pack_write_af(writer, id, &a);
+            af_free(&a);
+        }
+        printf("Baked %s (%s)\n", get_resource_file(id), get_resource_name(id));
+        count++;
+    }
+
+    if(asset_pack_writer_close(writer)) {
+        printf("Failed to save asset pack to %s.\n", output->filename[0]);
+        goto exit_0;
+    }
+    printf("Wrote %d resources to %s.\n", count, output->filename[0]);
+    ret = 0;
+
+exit_0:
+    arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+    return ret;
+}